@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "utils.h"
+
+// Size of the result built with the string builder
+#define BENCH_RESULT_SIZE (100 * 1024 * 1024)
+// `insertInBuffer` is quadratic, it only builds results up to this size
+#define BENCH_BUFFER_MAX_SIZE (1024 * 1024)
+#define BENCH_PASSES 3
+
+
+static double now(){
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * Builds a select result the way `dbSelect` did, one formatted append per column
+ * @param size Length of the result
+ * @return Result
+ */
+static char *buildWithBuffer(size_t size){
+    char *result = createBuffer();
+    size_t len = 0;
+    for (size_t row = 0; len < size; ++row) {
+        insertInBuffer(&result, "%zu", row);
+        insertInBuffer(&result, ",");
+        insertInBuffer(&result, "%s", "user_name");
+        insertInBuffer(&result, ",");
+        insertInBuffer(&result, "%s", "2024-01-01 10:00:00 GMT+0");
+        insertInBuffer(&result, "\n");
+        len = strlen(result);
+    }
+    return result;
+}
+
+/**
+ * Builds a select result the way `dbSelect` does, column values are appended raw
+ * @param size Length of the result
+ * @return Result
+ */
+static char *buildWithBuilder(size_t size){
+    StringBuilder result = createStringBuilder();
+    for (size_t row = 0; result.len < size; ++row) {
+        appendToBuilder(&result, "%zu", row);
+        appendRawToBuilder(&result, ",", 1);
+        appendRawToBuilder(&result, "user_name", 9);
+        appendRawToBuilder(&result, ",", 1);
+        appendRawToBuilder(&result, "2024-01-01 10:00:00 GMT+0", 25);
+        appendRawToBuilder(&result, "\n", 1);
+    }
+    return detachStringBuilder(&result);
+}
+
+/**
+ * Best time of a few builds of a result
+ * @param build Build function
+ * @param size Length of the result
+ * @return Seconds
+ */
+static double timeBuild(char *(*build)(size_t), size_t size){
+    double best = 0;
+    for (int pass = 0; pass < BENCH_PASSES; ++pass) {
+        double start = now();
+        char *result = build(size);
+        double elapsed = now() - start;
+        free(result);
+        if(pass == 0 || elapsed < best){
+            best = elapsed;
+        }
+    }
+    return best;
+}
+
+int main(){
+    printf("Building select results, best of %d passes\n", BENCH_PASSES);
+    for (size_t size = 256 * 1024; size <= BENCH_BUFFER_MAX_SIZE; size *= 2) {
+        double elapsed = timeBuild(buildWithBuffer, size);
+        printf("insertInBuffer %5.1f MB %8.3f s %8.1f MB/s\n", (double)size / (1024 * 1024), elapsed,
+               (double)size / (1024 * 1024) / elapsed);
+    }
+    for (size_t size = 1024 * 1024; size <= BENCH_RESULT_SIZE; size *= 10) {
+        double elapsed = timeBuild(buildWithBuilder, size);
+        printf("StringBuilder  %5.1f MB %8.3f s %8.1f MB/s\n", (double)size / (1024 * 1024), elapsed,
+               (double)size / (1024 * 1024) / elapsed);
+    }
+    return 0;
+}
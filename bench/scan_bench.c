@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "simd.h"
+
+// Size of the generated table file
+#define BENCH_DATA_SIZE (64 * 1024 * 1024)
+#define BENCH_PASSES 5
+#define BENCH_COLUMNS 8
+
+
+static double now(){
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * Fills a buffer with rows in the text table format, values have different lengths and some hold an escaped comma
+ * @param size Size of the buffer
+ * @param rowCount Number of generated rows
+ * @return Buffer of rows
+ */
+static char *generateRows(size_t size, size_t *rowCount){
+    char *data = malloc(size + 1);
+    size_t used = 0;
+    *rowCount = 0;
+    srand(42);
+    while (data != NULL){
+        char row[512];
+        int len = snprintf(row, sizeof(row), "1,%zu,user_%d,%s,%d,%.*s,%s,2024-01-%02d 10:00:00 GMT+0\n",
+                           *rowCount + 1, rand() % 100000, rand() % 4 == 0 ? "Smith\\, John" : "Khan",
+                           rand() % 100, rand() % 120, "Lorem ipsum dolor sit amet consectetur adipiscing elit sed do eiusmod tempor "
+                           "incididunt ut labore et dolore magna aliqua", rand() % 2 ? "CS" : "Electrical Engineering", rand() % 28 + 1);
+        if(used + (size_t)len > size){
+            break;
+        }
+        memcpy(data + used, row, (size_t)len);
+        used += (size_t)len;
+        (*rowCount)++;
+    }
+    if(data != NULL){
+        data[used] = '\0';
+    }
+    return data;
+}
+
+/**
+ * Finds every row of the buffer and splits it into its columns, the way a full table scan does
+ * @param data Rows
+ * @param size Length of the rows
+ * @param checksum Sum of the field lengths, keeps the work from being optimized out
+ * @return Number of rows
+ */
+static size_t scanRows(const char *data, size_t size, size_t *checksum){
+    FieldSlice fields[BENCH_COLUMNS];
+    size_t rows = 0;
+    const char *cursor = data;
+    const char *end = data + size;
+    while (cursor < end){
+        const char *newLine = simdFindNewLine(cursor, (size_t)(end - cursor));
+        size_t length = newLine != NULL ? (size_t)(newLine - cursor) + 1 : (size_t)(end - cursor);
+        size_t count = simdSplitRow(cursor, length, fields, BENCH_COLUMNS);
+        for (size_t i = 0; i < count; ++i) {
+            *checksum += fields[i].len;
+        }
+        cursor += length;
+        rows++;
+    }
+    return rows;
+}
+
+int main(){
+    size_t rowCount;
+    char *data = generateRows(BENCH_DATA_SIZE, &rowCount);
+    if(data == NULL){
+        fprintf(stderr, "Unable to allocate the benchmark data\n");
+        return 1;
+    }
+    size_t size = strlen(data);
+    printf("Scanning %zu rows, %.1f MB, best of %d passes\n", rowCount, (double)size / (1024 * 1024), BENCH_PASSES);
+    size_t expected = 0;
+    const SimdLevel levels[] = {SIMD_SCALAR, SIMD_SSE2, SIMD_AVX2};
+    for (size_t l = 0; l < sizeof(levels) / sizeof(levels[0]); ++l) {
+        if(!simdSetLevel(levels[l])){
+            printf("%-8s not supported by this CPU\n", simdLevelName(levels[l]));
+            continue;
+        }
+        double best = 0;
+        size_t checksum = 0;
+        for (int pass = 0; pass < BENCH_PASSES; ++pass) {
+            checksum = 0;
+            double start = now();
+            scanRows(data, size, &checksum);
+            double elapsed = now() - start;
+            if(pass == 0 || elapsed < best){
+                best = elapsed;
+            }
+        }
+        if(expected == 0){
+            expected = checksum;
+        }
+        printf("%-8s %6.2f GB/s%s\n", simdLevelName(levels[l]), (double)size / best / 1e9,
+               checksum != expected ? " (fields differ from scalar)" : "");
+    }
+    free(data);
+    return 0;
+}
@@ -0,0 +1,624 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "aggregate.h"
+#include "const.h"
+
+static size_t memoryBudget = AGGREGATE_DEFAULT_BUDGET;
+// Numbers the partition files, every partition of the process has its own file, the threads
+// of a parallel aggregation spill at the same time
+static atomic_size_t spillId = 0;
+
+
+/**
+ * Sets the memory the groups of an aggregation can use before new groups are spilled
+ * @param budget Bytes, at least one group is always kept in memory
+ */
+void aggregateSetMemoryBudget(size_t budget){
+    memoryBudget = budget;
+}
+
+/**
+ * Name of an aggregate function, used in the header of a result
+ * @param func Aggregate function
+ * @return Lower case name
+ */
+const char *aggregateName(AggregateFunc func){
+    switch (func) {
+        case AGG_COUNT:
+            return "count";
+        case AGG_SUM:
+            return "sum";
+        case AGG_AVG:
+            return "avg";
+        case AGG_MIN:
+            return "min";
+        case AGG_MAX:
+            return "max";
+        default:
+            return "";
+    }
+}
+
+/**
+ * FNV-1a hash of a group key, the level changes the seed so a partition spreads over
+ * the partitions of the next level
+ * @param data Key
+ * @param len Length of the key
+ * @param level Partitioning depth
+ * @return Hash
+ */
+static uint64_t hashKey(const char *data, size_t len, int level){
+    uint64_t hash = 1469598103934665603ULL ^ ((uint64_t)level * 0x9E3779B97F4A7C15ULL);
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ULL;
+    }
+    // The partitions take the high bits, FNV leaves them poorly mixed for short keys
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+/**
+ * Reads a value of an aggregate as an integer
+ * @param field Value
+ * @param number Integer
+ * @return 1 if the value is an integer, 0 otherwise
+ */
+static int parseInteger(const FieldSlice *field, long long *number){
+    char buffer[32];
+    if(field->len == 0 || field->len >= sizeof(buffer)){
+        return 0;
+    }
+    memcpy(buffer, field->data, field->len);
+    buffer[field->len] = '\0';
+    char *end;
+    *number = strtoll(buffer, &end, 10);
+    return end != buffer && *end == '\0';
+}
+
+/**
+ * Reads a value of an aggregate as a float
+ * @param field Value
+ * @param number Float
+ * @return 1 if the value is a number, 0 otherwise
+ */
+static int parseFloat(const FieldSlice *field, double *number){
+    char buffer[64];
+    if(field->len == 0 || field->len >= sizeof(buffer)){
+        return 0;
+    }
+    memcpy(buffer, field->data, field->len);
+    buffer[field->len] = '\0';
+    char *end;
+    *number = strtod(buffer, &end);
+    return end != buffer && *end == '\0';
+}
+
+/**
+ * Creates an aggregation
+ * @param aggregator Aggregator to initialize, freed with `aggregatorFree`
+ * @param groupCount Number of group columns, 0 aggregates every row into one group
+ * @param specs Aggregates
+ * @param specCount Number of aggregates
+ */
+void aggregatorInit(Aggregator *aggregator, size_t groupCount, const AggregateSpec *specs, size_t specCount){
+    memset(aggregator, 0, sizeof(Aggregator));
+    aggregator->groupCount = groupCount;
+    aggregator->specs = specs;
+    aggregator->specCount = specCount;
+    aggregator->budget = memoryBudget;
+    aggregator->key = createStringBuilder();
+    aggregator->mergeRow = createStringBuilder();
+}
+
+/**
+ * Allocates the memory of the groups of a level
+ * @param aggregator Aggregator
+ * @return 1 if the memory is allocated, 0 otherwise
+ */
+static int prepareGroups(Aggregator *aggregator){
+    size_t fieldCount = aggregator->groupCount + aggregator->specCount;
+    if(aggregator->groupValues == NULL){
+        aggregator->groupValues = malloc(sizeof(FieldSlice) * (aggregator->groupCount > 0 ? aggregator->groupCount : 1));
+        aggregator->spillFields = malloc(sizeof(FieldSlice) * (fieldCount > 0 ? fieldCount : 1));
+    }
+    if(aggregator->arena == NULL){
+        aggregator->arena = arenaCreate(4096);
+    }
+    if(aggregator->slots == NULL){
+        aggregator->slotCount = 64;
+        aggregator->slots = calloc(aggregator->slotCount, sizeof(uint32_t));
+    }
+    return aggregator->groupValues != NULL && aggregator->spillFields != NULL && aggregator->arena != NULL && aggregator->slots != NULL;
+}
+
+/**
+ * Doubles the slots of the group table, the groups are placed again by their hash
+ * @param aggregator Aggregator
+ * @return 1 if the table grew, 0 if it is out of memory
+ */
+static int growSlots(Aggregator *aggregator){
+    size_t slotCount = aggregator->slotCount * 2;
+    uint32_t *slots = calloc(slotCount, sizeof(uint32_t));
+    if(slots == NULL){
+        return 0;
+    }
+    for (size_t i = 0; i < aggregator->size; ++i) {
+        size_t pos = aggregator->groups[i].hash & (slotCount - 1);
+        while (slots[pos] != 0){
+            pos = (pos + 1) & (slotCount - 1);
+        }
+        slots[pos] = (uint32_t)(i + 1);
+    }
+    free(aggregator->slots);
+    aggregator->slots = slots;
+    aggregator->slotCount = slotCount;
+    return 1;
+}
+
+/**
+ * Keeps the smaller or the larger of two texts as the value of a MIN or MAX
+ * @param aggregator Aggregator
+ * @param spec Aggregate
+ * @param acc Value of the aggregate in a group
+ * @param data Text
+ * @param len Length of the text
+ */
+static void accumulateText(Aggregator *aggregator, const AggregateSpec *spec, Accumulator *acc, const char *data, size_t len){
+    size_t common = len < acc->textLen ? len : acc->textLen;
+    int cmp = acc->count == 0 ? 0 : memcmp(data, acc->text, common);
+    if(cmp == 0 && acc->count > 0){
+        cmp = len < acc->textLen ? -1 : len > acc->textLen;
+    }
+    if(acc->count == 0 || (spec->func == AGG_MIN ? cmp < 0 : cmp > 0)){
+        char *text = realloc(acc->text, len);
+        if(text != NULL){
+            aggregator->memory += len > acc->textLen ? len - acc->textLen : 0;
+            memcpy(text, data, len);
+            acc->text = text;
+            acc->textLen = len;
+        }
+    }
+}
+
+/**
+ * Adds the accumulators of a group of another aggregation to the aggregates of its group,
+ * a field holds the count, the integer and the float of an accumulator followed by its text
+ * @param aggregator Aggregator
+ * @param group Group of the row
+ * @param fields Group columns then accumulators
+ */
+static void combine(Aggregator *aggregator, AggregateGroup *group, const FieldSlice *fields){
+    for (size_t i = 0; i < aggregator->specCount; ++i) {
+        const AggregateSpec *spec = &aggregator->specs[i];
+        const FieldSlice *field = &fields[aggregator->groupCount + i];
+        Accumulator *acc = &group->accumulators[i];
+        Accumulator other;
+        size_t header = sizeof(long long) * 2 + sizeof(double);
+        // The empty row of an aggregation without rows has no accumulators
+        if(field->len < header){
+            continue;
+        }
+        memcpy(&other.count, field->data, sizeof(long long));
+        memcpy(&other.integer, field->data + sizeof(long long), sizeof(long long));
+        memcpy(&other.number, field->data + sizeof(long long) * 2, sizeof(double));
+        if(other.count == 0){
+            continue;
+        }
+        if(spec->func == AGG_SUM || spec->func == AGG_AVG){
+            acc->integer += other.integer;
+            acc->number += other.number;
+        }
+        else if(spec->func != AGG_COUNT && spec->type == SORT_INTEGER){
+            if(acc->count == 0 || (spec->func == AGG_MIN ? other.integer < acc->integer : other.integer > acc->integer)){
+                acc->integer = other.integer;
+            }
+        }
+        else if(spec->func != AGG_COUNT && spec->type == SORT_FLOAT){
+            if(acc->count == 0 || (spec->func == AGG_MIN ? other.number < acc->number : other.number > acc->number)){
+                acc->number = other.number;
+            }
+        }
+        else if(spec->func != AGG_COUNT){
+            accumulateText(aggregator, spec, acc, field->data + header, field->len - header);
+        }
+        acc->count += other.count;
+    }
+}
+
+/**
+ * Adds the values of a row to the aggregates of its group
+ * @param aggregator Aggregator
+ * @param group Group of the row
+ * @param fields Group columns then arguments of the aggregates
+ */
+static void accumulate(Aggregator *aggregator, AggregateGroup *group, const FieldSlice *fields){
+    if(aggregator->isMerging){
+        combine(aggregator, group, fields);
+        return;
+    }
+    for (size_t i = 0; i < aggregator->specCount; ++i) {
+        const AggregateSpec *spec = &aggregator->specs[i];
+        const FieldSlice *field = &fields[aggregator->groupCount + i];
+        Accumulator *acc = &group->accumulators[i];
+        long long integer;
+        double number;
+        if(spec->func == AGG_COUNT){
+            acc->count += spec->isAllRows || field->len > 0;
+        }
+        else if(spec->type == SORT_INTEGER && parseInteger(field, &integer)){
+            if(spec->func == AGG_SUM || spec->func == AGG_AVG){
+                acc->integer += integer;
+            }
+            else if(acc->count == 0 || (spec->func == AGG_MIN ? integer < acc->integer : integer > acc->integer)){
+                acc->integer = integer;
+            }
+            acc->count++;
+        }
+        else if(spec->type != SORT_INTEGER && (spec->type == SORT_FLOAT || spec->func == AGG_SUM || spec->func == AGG_AVG)){
+            if(!parseFloat(field, &number)){
+                continue;
+            }
+            if(spec->func == AGG_SUM || spec->func == AGG_AVG){
+                acc->number += number;
+            }
+            else if(acc->count == 0 || (spec->func == AGG_MIN ? number < acc->number : number > acc->number)){
+                acc->number = number;
+            }
+            acc->count++;
+        }
+        else if(spec->type == SORT_TEXT && field->len > 0){
+            accumulateText(aggregator, spec, acc, field->data, field->len);
+            acc->count++;
+        }
+    }
+}
+
+/**
+ * Writes a row of a group that doesn't fit in memory to the partition file of its hash
+ * @param aggregator Aggregator
+ * @param hash Hash of the group
+ * @param fields Group columns then arguments of the aggregates
+ * @return 1 if the row is written, 0 on io error
+ */
+static int spillRow(Aggregator *aggregator, uint64_t hash, const FieldSlice *fields){
+    size_t p = (size_t)(hash >> 32) & (AGGREGATE_PARTITIONS - 1);
+    if(aggregator->spills[p] == NULL){
+        aggregator->spillNames[p] = createBuffer();
+        insertInBuffer(&aggregator->spillNames[p], "%s/aggregate_%zu.tmp", DATA_DIR, (size_t)atomic_fetch_add(&spillId, 1));
+        aggregator->spills[p] = fopen(aggregator->spillNames[p], "wb");
+        if(aggregator->spills[p] == NULL){
+            clearBuffer(&aggregator->spillNames[p]);
+            return 0;
+        }
+    }
+    FILE *file = aggregator->spills[p];
+    size_t fieldCount = aggregator->groupCount + aggregator->specCount;
+    size_t total = 0;
+    for (size_t i = 0; i < fieldCount; ++i) {
+        total += sizeof(size_t) + fields[i].len;
+    }
+    if(fwrite(&total, sizeof(total), 1, file) != 1){
+        return 0;
+    }
+    for (size_t i = 0; i < fieldCount; ++i) {
+        if(fwrite(&fields[i].len, sizeof(size_t), 1, file) != 1 || fwrite(fields[i].data, 1, fields[i].len, file) != fields[i].len){
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * Adds a row to the aggregation, a row of a new group is spilled once the groups exceed the memory budget
+ * @param aggregator Aggregator
+ * @param fields Group columns then arguments of the aggregates
+ * @return 1 if the row is added, 0 on memory or io error
+ */
+int aggregatorAdd(Aggregator *aggregator, const FieldSlice *fields){
+    if(!prepareGroups(aggregator)){
+        return 0;
+    }
+    StringBuilder *key = &aggregator->key;
+    resetStringBuilder(key);
+    for (size_t i = 0; i < aggregator->groupCount; ++i) {
+        appendRawToBuilder(key, (const char *)&fields[i].len, sizeof(size_t));
+        appendRawToBuilder(key, fields[i].data, fields[i].len);
+    }
+    aggregator->rowCount++;
+    // An aggregation without group columns has an empty key that is never allocated
+    const char *keyData = key->len > 0 ? key->data : "";
+    uint64_t hash = hashKey(keyData, key->len, aggregator->level);
+    size_t mask = aggregator->slotCount - 1;
+    size_t pos = hash & mask;
+    while (aggregator->slots[pos] != 0){
+        AggregateGroup *group = &aggregator->groups[aggregator->slots[pos] - 1];
+        if(group->hash == hash && group->keyLen == key->len && memcmp(group->key, keyData, key->len) == 0){
+            accumulate(aggregator, group, fields);
+            return 1;
+        }
+        pos = (pos + 1) & mask;
+    }
+    if(aggregator->memory > aggregator->budget && aggregator->size > 0){
+        return spillRow(aggregator, hash, fields);
+    }
+    if(aggregator->size == aggregator->capacity){
+        size_t capacity = aggregator->capacity == 0 ? 64 : aggregator->capacity * 2;
+        AggregateGroup *groups = realloc(aggregator->groups, sizeof(AggregateGroup) * capacity);
+        if(groups == NULL){
+            return 0;
+        }
+        aggregator->groups = groups;
+        aggregator->capacity = capacity;
+    }
+    AggregateGroup *group = &aggregator->groups[aggregator->size];
+    group->hash = hash;
+    group->keyLen = key->len;
+    group->key = arenaCopy(aggregator->arena, keyData, key->len);
+    group->accumulators = arenaAlloc(aggregator->arena, sizeof(Accumulator) * (aggregator->specCount > 0 ? aggregator->specCount : 1));
+    if(group->key == NULL || group->accumulators == NULL){
+        return 0;
+    }
+    memset(group->accumulators, 0, sizeof(Accumulator) * aggregator->specCount);
+    aggregator->slots[pos] = (uint32_t)(aggregator->size + 1);
+    aggregator->size++;
+    aggregator->memory += sizeof(AggregateGroup) + sizeof(uint32_t) * 2 + key->len + sizeof(Accumulator) * aggregator->specCount;
+    if(aggregator->size * 2 > aggregator->slotCount && !growSlots(aggregator)){
+        return 0;
+    }
+    accumulate(aggregator, group, fields);
+    return 1;
+}
+
+/**
+ * Adds a group of another aggregation with the same group columns and aggregates, used to combine
+ * the aggregations of the threads of a parallel scan. An aggregator either adds rows or merges groups,
+ * the merged groups are spilled with their accumulators once they exceed the memory budget
+ * @param aggregator Aggregator
+ * @param group Group returned by `aggregatorNext` of the other aggregation
+ * @param groupValues Values of the group columns of the group
+ * @return 1 if the group is added, 0 on memory or io error
+ */
+int aggregatorMerge(Aggregator *aggregator, const AggregateGroup *group, const FieldSlice *groupValues){
+    size_t fieldCount = aggregator->groupCount + aggregator->specCount;
+    size_t starts[fieldCount + 1];
+    FieldSlice fields[fieldCount + 1];
+    StringBuilder *row = &aggregator->mergeRow;
+    aggregator->isMerging = 1;
+    resetStringBuilder(row);
+    for (size_t i = 0; i < aggregator->specCount; ++i) {
+        const Accumulator *acc = &group->accumulators[i];
+        starts[i] = row->len;
+        appendRawToBuilder(row, (const char *)&acc->count, sizeof(long long));
+        appendRawToBuilder(row, (const char *)&acc->integer, sizeof(long long));
+        appendRawToBuilder(row, (const char *)&acc->number, sizeof(double));
+        if(acc->textLen > 0){
+            appendRawToBuilder(row, acc->text, acc->textLen);
+        }
+    }
+    starts[aggregator->specCount] = row->len;
+    // The fields point into the row once it is complete, appending can move it
+    for (size_t i = 0; i < fieldCount; ++i) {
+        if(i < aggregator->groupCount){
+            fields[i] = groupValues[i];
+            continue;
+        }
+        size_t spec = i - aggregator->groupCount;
+        fields[i].data = row->data + starts[spec];
+        fields[i].len = starts[spec + 1] - starts[spec];
+    }
+    return aggregatorAdd(aggregator, fields);
+}
+
+/**
+ * Queues the partition files written at the current level, they are aggregated at the next level
+ * @param aggregator Aggregator
+ * @return 1 if the files are queued, 0 on memory or io error
+ */
+static int queueSpills(Aggregator *aggregator){
+    for (size_t p = 0; p < AGGREGATE_PARTITIONS; ++p) {
+        if(aggregator->spills[p] == NULL){
+            continue;
+        }
+        int ok = fclose(aggregator->spills[p]) == 0;
+        aggregator->spills[p] = NULL;
+        char **pending = realloc(aggregator->pending, sizeof(char *) * (aggregator->pendingCount + 1));
+        if(pending != NULL){
+            aggregator->pending = pending;
+        }
+        int *levels = realloc(aggregator->pendingLevels, sizeof(int) * (aggregator->pendingCount + 1));
+        if(levels != NULL){
+            aggregator->pendingLevels = levels;
+        }
+        if(!ok || pending == NULL || levels == NULL){
+            remove(aggregator->spillNames[p]);
+            clearBuffer(&aggregator->spillNames[p]);
+            return 0;
+        }
+        aggregator->pending[aggregator->pendingCount] = aggregator->spillNames[p];
+        aggregator->pendingLevels[aggregator->pendingCount] = aggregator->level + 1;
+        aggregator->pendingCount++;
+        aggregator->spillNames[p] = NULL;
+    }
+    return 1;
+}
+
+/**
+ * Ends the input of the aggregation, an aggregation without group columns has a group even without rows
+ * @param aggregator Aggregator
+ * @return 1 if the groups can be read with `aggregatorNext`, 0 on memory or io error
+ */
+int aggregatorFinish(Aggregator *aggregator){
+    aggregator->isFinished = 1;
+    aggregator->next = 0;
+    if(aggregator->groupCount == 0 && aggregator->rowCount == 0){
+        FieldSlice empty[aggregator->specCount + 1];
+        memset(empty, 0, sizeof(empty));
+        for (size_t i = 0; i < aggregator->specCount + 1; ++i) {
+            empty[i].data = "";
+        }
+        if(!aggregatorAdd(aggregator, empty)){
+            return 0;
+        }
+        // The empty row is not a row of the table
+        memset(aggregator->groups[0].accumulators, 0, sizeof(Accumulator) * aggregator->specCount);
+    }
+    return queueSpills(aggregator);
+}
+
+/**
+ * Releases the groups of a level
+ * @param aggregator Aggregator
+ */
+static void resetGroups(Aggregator *aggregator){
+    for (size_t i = 0; i < aggregator->size; ++i) {
+        for (size_t s = 0; s < aggregator->specCount; ++s) {
+            free(aggregator->groups[i].accumulators[s].text);
+        }
+    }
+    arenaFree(aggregator->arena);
+    aggregator->arena = NULL;
+    if(aggregator->slots != NULL){
+        memset(aggregator->slots, 0, sizeof(uint32_t) * aggregator->slotCount);
+    }
+    aggregator->size = 0;
+    aggregator->memory = 0;
+    aggregator->next = 0;
+    aggregator->rowCount = 0;
+}
+
+/**
+ * Aggregates the rows of a partition file, the file is removed once it is read
+ * @param aggregator Aggregator with no group in memory
+ * @param name Partition file
+ * @return 1 if the partition is aggregated, 0 on memory or io error
+ */
+static int loadPartition(Aggregator *aggregator, char *name){
+    size_t fieldCount = aggregator->groupCount + aggregator->specCount;
+    FILE *file = fopen(name, "rb");
+    int ok = file != NULL && prepareGroups(aggregator);
+    size_t total;
+    while (ok && fread(&total, sizeof(total), 1, file) == 1){
+        if(total > aggregator->spillLineSize){
+            char *line = realloc(aggregator->spillLine, total);
+            if(line == NULL){
+                ok = 0;
+                break;
+            }
+            aggregator->spillLine = line;
+            aggregator->spillLineSize = total;
+        }
+        if(fread(aggregator->spillLine, 1, total, file) != total){
+            ok = 0;
+            break;
+        }
+        size_t offset = 0;
+        for (size_t i = 0; i < fieldCount; ++i) {
+            memcpy(&aggregator->spillFields[i].len, aggregator->spillLine + offset, sizeof(size_t));
+            offset += sizeof(size_t);
+            aggregator->spillFields[i].data = aggregator->spillLine + offset;
+            offset += aggregator->spillFields[i].len;
+        }
+        ok = aggregatorAdd(aggregator, aggregator->spillFields);
+    }
+    if(file != NULL){
+        fclose(file);
+    }
+    remove(name);
+    free(name);
+    return ok && queueSpills(aggregator);
+}
+
+/**
+ * Next group of a finished aggregation, the groups in memory come first then the groups of every partition
+ * @param aggregator Aggregator
+ * @return Group, its column values are in `groupValues` until the next call, NULL once every group is read
+ */
+const AggregateGroup *aggregatorNext(Aggregator *aggregator){
+    if(!aggregator->isFinished){
+        return NULL;
+    }
+    while (aggregator->next >= aggregator->size){
+        if(aggregator->pendingCount == 0){
+            return NULL;
+        }
+        aggregator->pendingCount--;
+        resetGroups(aggregator);
+        aggregator->level = aggregator->pendingLevels[aggregator->pendingCount];
+        if(!loadPartition(aggregator, aggregator->pending[aggregator->pendingCount])){
+            printError("Unable to read an aggregation partition");
+            return NULL;
+        }
+    }
+    const AggregateGroup *group = &aggregator->groups[aggregator->next++];
+    size_t offset = 0;
+    for (size_t i = 0; i < aggregator->groupCount; ++i) {
+        memcpy(&aggregator->groupValues[i].len, group->key + offset, sizeof(size_t));
+        offset += sizeof(size_t);
+        aggregator->groupValues[i].data = group->key + offset;
+        offset += aggregator->groupValues[i].len;
+    }
+    return group;
+}
+
+/**
+ * Appends the value of an aggregate to a result, an aggregate without values is empty
+ * @param spec Aggregate
+ * @param accumulator Value of the aggregate in a group
+ * @param out Result
+ */
+void aggregateFormat(const AggregateSpec *spec, const Accumulator *accumulator, StringBuilder *out){
+    if(spec->func == AGG_COUNT){
+        appendToBuilder(out, "%lld", accumulator->count);
+        return;
+    }
+    if(accumulator->count == 0){
+        return;
+    }
+    if(spec->func == AGG_AVG){
+        double sum = spec->type == SORT_INTEGER ? (double)accumulator->integer : accumulator->number;
+        appendToBuilder(out, "%.15g", sum / (double)accumulator->count);
+    }
+    else if(spec->type == SORT_INTEGER){
+        appendToBuilder(out, "%lld", accumulator->integer);
+    }
+    else if(spec->type == SORT_FLOAT || spec->func == AGG_SUM){
+        appendToBuilder(out, "%.15g", accumulator->number);
+    }
+    else{
+        appendRawToBuilder(out, accumulator->text, accumulator->textLen);
+    }
+}
+
+/**
+ * Frees the groups of an aggregation and removes its partition files
+ * @param aggregator Aggregator
+ */
+void aggregatorFree(Aggregator *aggregator){
+    resetGroups(aggregator);
+    for (size_t p = 0; p < AGGREGATE_PARTITIONS; ++p) {
+        if(aggregator->spills[p] != NULL){
+            fclose(aggregator->spills[p]);
+            remove(aggregator->spillNames[p]);
+            free(aggregator->spillNames[p]);
+        }
+    }
+    for (size_t i = 0; i < aggregator->pendingCount; ++i) {
+        remove(aggregator->pending[i]);
+        free(aggregator->pending[i]);
+    }
+    free(aggregator->pending);
+    free(aggregator->pendingLevels);
+    free(aggregator->groups);
+    free(aggregator->slots);
+    free(aggregator->groupValues);
+    free(aggregator->spillLine);
+    free(aggregator->spillFields);
+    clearStringBuilder(&aggregator->key);
+    clearStringBuilder(&aggregator->mergeRow);
+    memset(aggregator, 0, sizeof(Aggregator));
+}
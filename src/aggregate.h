@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "lexer.h"
+#include "arena.h"
+#include "simd.h"
+#include "sort.h"
+#include "utils.h"
+
+#ifndef MINISQL_AGGREGATE_H
+#define MINISQL_AGGREGATE_H
+
+// Memory the groups of an aggregation can use before new groups are spilled to partition files
+#define AGGREGATE_DEFAULT_BUDGET (64 * 1024 * 1024)
+// Partition files a spilled level is split into, each one is aggregated on its own afterwards
+#define AGGREGATE_PARTITIONS 8
+
+/*
+ * Aggregate of a select, its argument is read as its declared column type
+ */
+struct {
+    AggregateFunc func;
+    SortType type;
+    int isAllRows; // COUNT(*)
+} typedef AggregateSpec;
+
+/*
+ * Running value of an aggregate in a group, values that are empty or not numbers
+ * for a numeric aggregate are not counted
+ */
+struct {
+    long long count; // Rows, COUNT(*), or values seen
+    long long integer; // SUM, MIN and MAX of integer columns
+    double number; // SUM, MIN and MAX of float columns, AVG of every column
+    char *text; // MIN and MAX of text columns
+    size_t textLen;
+} typedef Accumulator;
+
+struct {
+    uint64_t hash;
+    char *key; // Length prefixed values of the group columns
+    size_t keyLen;
+    Accumulator *accumulators;
+} typedef AggregateGroup;
+
+/*
+ * Hash aggregation of the rows of a statement. Groups are found in an open addressing table,
+ * once the groups use more memory than the budget the rows of new groups are written to partition
+ * files by their hash and every partition is aggregated after the groups in memory are returned
+ */
+struct {
+    size_t groupCount; // Group columns, the first fields of every row
+    const AggregateSpec *specs; // Arguments of the aggregates, the fields after the group columns
+    size_t specCount;
+    size_t budget;
+    Arena *arena; // Keys and accumulators of the groups in memory
+    AggregateGroup *groups;
+    size_t size;
+    size_t capacity;
+    uint32_t *slots; // Group index + 1, 0 for an empty slot
+    size_t slotCount;
+    size_t memory;
+    StringBuilder key;
+    int level; // Partitioning depth, selects the bits of the hash used for the partitions
+    FILE *spills[AGGREGATE_PARTITIONS];
+    char *spillNames[AGGREGATE_PARTITIONS];
+    char **pending; // Partition files left to aggregate
+    int *pendingLevels;
+    size_t pendingCount;
+    size_t rowCount; // Rows added since the last reset
+    size_t next; // Next group to return
+    FieldSlice *groupValues; // Values of the group columns of the returned group
+    char *spillLine; // Row read back from a partition
+    size_t spillLineSize;
+    FieldSlice *spillFields;
+    int isMerging; // The rows hold the accumulators of the groups of other aggregations, see `aggregatorMerge`
+    StringBuilder mergeRow;
+    int isFinished;
+} typedef Aggregator;
+
+const char *aggregateName(AggregateFunc func);
+void aggregateSetMemoryBudget(size_t budget);
+void aggregatorInit(Aggregator *aggregator, size_t groupCount, const AggregateSpec *specs, size_t specCount);
+int aggregatorAdd(Aggregator *aggregator, const FieldSlice *fields);
+int aggregatorMerge(Aggregator *aggregator, const AggregateGroup *group, const FieldSlice *groupValues);
+int aggregatorFinish(Aggregator *aggregator);
+const AggregateGroup *aggregatorNext(Aggregator *aggregator);
+void aggregateFormat(const AggregateSpec *spec, const Accumulator *accumulator, StringBuilder *out);
+void aggregatorFree(Aggregator *aggregator);
+
+#endif //MINISQL_AGGREGATE_H
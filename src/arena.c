@@ -0,0 +1,111 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "arena.h"
+
+// Allocations are aligned for any type stored in the arena
+#define ARENA_ALIGN (sizeof(void *) * 2)
+
+
+/**
+ * Bytes to skip so an allocation starts on an aligned address
+ * @param address Next free byte of a block
+ * @return Padding
+ */
+static size_t getPadding(const char *address){
+    return (ARENA_ALIGN - (uintptr_t)address % ARENA_ALIGN) % ARENA_ALIGN;
+}
+
+/**
+ * Allocates a block of an arena
+ * @param size Usable bytes of the block
+ * @return Block or NULL if out of memory
+ */
+static ArenaBlock *createBlock(size_t size){
+    ArenaBlock *block = malloc(sizeof(ArenaBlock) + size);
+    if(block == NULL){
+        return NULL;
+    }
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+    return block;
+}
+
+/**
+ * Creates an arena
+ * @param size Size of the first block, ARENA_DEFAULT_SIZE if 0
+ * @return Arena or NULL if out of memory
+ */
+Arena *arenaCreate(size_t size){
+    Arena *arena = malloc(sizeof(Arena));
+    if(arena == NULL){
+        return NULL;
+    }
+    arena->head = createBlock(size > 0 ? size : ARENA_DEFAULT_SIZE);
+    if(arena->head == NULL){
+        free(arena);
+        return NULL;
+    }
+    return arena;
+}
+
+/**
+ * Allocates memory that lives until the arena is freed
+ * @param arena Arena
+ * @param size Bytes to allocate
+ * @return Memory or NULL if out of memory
+ */
+void *arenaAlloc(Arena *arena, size_t size){
+    ArenaBlock *block = arena->head;
+    size_t offset = block->used + getPadding(block->data + block->used);
+    if(offset + size > block->size){
+        size_t blockSize = block->size * 2;
+        while (blockSize < size + ARENA_ALIGN){
+            blockSize *= 2;
+        }
+        ArenaBlock *next = createBlock(blockSize);
+        if(next == NULL){
+            return NULL;
+        }
+        next->next = block;
+        arena->head = next;
+        block = next;
+        offset = getPadding(block->data);
+    }
+    block->used = offset + size;
+    return block->data + offset;
+}
+
+/**
+ * Copies a slice of text to the arena
+ * @param arena Arena
+ * @param data Text
+ * @param len Length of the text
+ * @return NUL terminated copy or NULL if out of memory
+ */
+char *arenaCopy(Arena *arena, const char *data, size_t len){
+    char *copy = arenaAlloc(arena, len + 1);
+    if(copy != NULL){
+        memcpy(copy, data, len);
+        copy[len] = '\0';
+    }
+    return copy;
+}
+
+/**
+ * Frees every block of an arena and the arena
+ * @param arena Arena, may be NULL
+ */
+void arenaFree(Arena *arena){
+    if(arena == NULL){
+        return;
+    }
+    ArenaBlock *block = arena->head;
+    while (block != NULL){
+        ArenaBlock *next = block->next;
+        free(block);
+        block = next;
+    }
+    free(arena);
+}
@@ -0,0 +1,32 @@
+#include <stddef.h>
+
+#ifndef MINISQL_ARENA_H
+#define MINISQL_ARENA_H
+
+// Size of the first block of an arena when no size hint is given
+#define ARENA_DEFAULT_SIZE 1024
+
+/*
+ * Block of an arena, the blocks are chained from the newest one
+ */
+struct ArenaBlock {
+    struct ArenaBlock *next;
+    size_t size;
+    size_t used;
+    char data[];
+} typedef ArenaBlock;
+
+/*
+ * Bump allocator holding the memory of a statement, every allocation is released at once
+ * by `arenaFree`. A full block is never moved, the next block is twice as large
+ */
+struct {
+    ArenaBlock *head;
+} typedef Arena;
+
+Arena *arenaCreate(size_t size);
+void *arenaAlloc(Arena *arena, size_t size);
+char *arenaCopy(Arena *arena, const char *data, size_t len);
+void arenaFree(Arena *arena);
+
+#endif //MINISQL_ARENA_H
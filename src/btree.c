@@ -0,0 +1,489 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "btree.h"
+
+#define BTREE_MAGIC 0x4d53514c42545245ULL
+
+/*
+ * Header stored in page 0 of the index file
+ */
+struct {
+    uint64_t magic;
+    uint64_t root;
+    uint64_t pageCount;
+} typedef BTreeHeader;
+
+
+/**
+ * Reads a node page from the index file
+ * @param tree B+tree
+ * @param pageNo Page number
+ * @param page Page to fill
+ * @return 1 if the page was read, 0 otherwise
+ */
+static int readPage(BTree *tree, uint64_t pageNo, BTreePage *page){
+    if(fseek(tree->file, (long)(pageNo * BTREE_PAGE_SIZE), SEEK_SET) != 0){
+        return 0;
+    }
+    return fread(page, sizeof(BTreePage), 1, tree->file) == 1;
+}
+
+/**
+ * Writes a node page in the index file
+ * @param tree B+tree
+ * @param pageNo Page number
+ * @param page Page to write
+ * @return 1 if the page was written, 0 otherwise
+ */
+static int writePage(BTree *tree, uint64_t pageNo, const BTreePage *page){
+    if(fseek(tree->file, (long)(pageNo * BTREE_PAGE_SIZE), SEEK_SET) != 0){
+        return 0;
+    }
+    return fwrite(page, sizeof(BTreePage), 1, tree->file) == 1;
+}
+
+/**
+ * Persists the root and page count of the tree in page 0
+ * @param tree B+tree
+ * @return 1 if the header was written, 0 otherwise
+ */
+static int writeHeader(BTree *tree){
+    BTreeHeader header = {BTREE_MAGIC, tree->root, tree->pageCount};
+    if(fseek(tree->file, 0, SEEK_SET) != 0){
+        return 0;
+    }
+    return fwrite(&header, sizeof(BTreeHeader), 1, tree->file) == 1;
+}
+
+/**
+ * Position of the first key that is greater or equal to `key`
+ */
+static uint32_t lowerBound(const BTreePage *page, uint64_t key){
+    uint32_t low = 0, high = page->count;
+    while(low < high){
+        uint32_t mid = (low + high) / 2;
+        if(page->keys[mid] < key){
+            low = mid + 1;
+        }
+        else{
+            high = mid;
+        }
+    }
+    return low;
+}
+
+/**
+ * Position of the first key that is greater than `key`, used to pick the child of an internal page
+ */
+static uint32_t upperBound(const BTreePage *page, uint64_t key){
+    uint32_t low = 0, high = page->count;
+    while(low < high){
+        uint32_t mid = (low + high) / 2;
+        if(page->keys[mid] <= key){
+            low = mid + 1;
+        }
+        else{
+            high = mid;
+        }
+    }
+    return low;
+}
+
+/**
+ * Walks from the root to the leaf that should contain `key`
+ * @param tree B+tree
+ * @param key Searched key
+ * @param page Leaf page found
+ * @return Page number of the leaf, 0 if the tree couldn't be read
+ */
+static uint64_t findLeaf(BTree *tree, uint64_t key, BTreePage *page){
+    uint64_t pageNo = tree->root;
+    while(1){
+        if(!readPage(tree, pageNo, page)){
+            return 0;
+        }
+        if(page->isLeaf){
+            return pageNo;
+        }
+        pageNo = page->values[upperBound(page, key)];
+    }
+}
+
+/**
+ * Opens a B+tree index file, creates an empty tree if the file doesn't exist
+ * @param fileName Index file name
+ * @return B+tree or NULL if the file is not a valid index
+ */
+BTree *btreeOpen(const char *fileName){
+    BTree *tree = malloc(sizeof(BTree));
+    if(tree == NULL){
+        return NULL;
+    }
+    tree->file = fopen(fileName, "r+b");
+    if(tree->file != NULL){
+        BTreeHeader header;
+        if(fread(&header, sizeof(BTreeHeader), 1, tree->file) != 1 || header.magic != BTREE_MAGIC){
+            fclose(tree->file);
+            free(tree);
+            return NULL;
+        }
+        tree->root = header.root;
+        tree->pageCount = header.pageCount;
+        return tree;
+    }
+    tree->file = fopen(fileName, "w+b");
+    if(tree->file == NULL){
+        free(tree);
+        return NULL;
+    }
+    BTreePage root;
+    memset(&root, 0, sizeof(BTreePage));
+    root.isLeaf = 1;
+    tree->root = 1;
+    tree->pageCount = 2;
+    if(!writeHeader(tree) || !writePage(tree, 1, &root)){
+        fclose(tree->file);
+        free(tree);
+        return NULL;
+    }
+    return tree;
+}
+
+/**
+ * Flushes and closes the index file
+ * @param tree B+tree
+ */
+void btreeClose(BTree *tree){
+    if(tree == NULL){
+        return;
+    }
+    fclose(tree->file);
+    free(tree);
+}
+
+/**
+ * Point lookup of a key
+ * @param tree B+tree
+ * @param key Searched key
+ * @param value Value of the key if found
+ * @return 1 if the key exists, 0 otherwise
+ */
+int btreeSearch(BTree *tree, uint64_t key, uint64_t *value){
+    BTreePage page;
+    if(findLeaf(tree, key, &page) == 0){
+        return 0;
+    }
+    uint32_t idx = lowerBound(&page, key);
+    if(idx < page.count && page.keys[idx] == key){
+        *value = page.values[idx];
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Inserts in the subtree rooted at `pageNo`, splitting the page when it is full
+ * @param tree B+tree
+ * @param pageNo Subtree root
+ * @param key Key to insert
+ * @param value Value of the key
+ * @param splitKey Separator key pushed to the parent on a split
+ * @param splitPage New right sibling created by a split
+ * @return 1 if the page was split, 0 if not, -1 on io error
+ */
+static int insertInPage(BTree *tree, uint64_t pageNo, uint64_t key, uint64_t value, uint64_t *splitKey, uint64_t *splitPage){
+    BTreePage page;
+    if(!readPage(tree, pageNo, &page)){
+        return -1;
+    }
+    uint64_t keys[BTREE_ORDER + 1];
+    uint64_t values[BTREE_ORDER + 2];
+    uint32_t count = page.count;
+
+    if(page.isLeaf){
+        uint32_t idx = lowerBound(&page, key);
+        if(idx < count && page.keys[idx] == key){
+            page.values[idx] = value;
+            return writePage(tree, pageNo, &page) ? 0 : -1;
+        }
+        memcpy(keys, page.keys, sizeof(uint64_t) * idx);
+        memcpy(values, page.values, sizeof(uint64_t) * idx);
+        keys[idx] = key;
+        values[idx] = value;
+        memcpy(keys + idx + 1, page.keys + idx, sizeof(uint64_t) * (count - idx));
+        memcpy(values + idx + 1, page.values + idx, sizeof(uint64_t) * (count - idx));
+        count++;
+        if(count <= BTREE_ORDER){
+            memcpy(page.keys, keys, sizeof(uint64_t) * count);
+            memcpy(page.values, values, sizeof(uint64_t) * count);
+            page.count = count;
+            return writePage(tree, pageNo, &page) ? 0 : -1;
+        }
+        BTreePage right;
+        memset(&right, 0, sizeof(BTreePage));
+        uint32_t half = count / 2;
+        right.isLeaf = 1;
+        right.count = count - half;
+        right.next = page.next;
+        memcpy(right.keys, keys + half, sizeof(uint64_t) * right.count);
+        memcpy(right.values, values + half, sizeof(uint64_t) * right.count);
+        page.count = half;
+        memcpy(page.keys, keys, sizeof(uint64_t) * half);
+        memcpy(page.values, values, sizeof(uint64_t) * half);
+        *splitPage = tree->pageCount++;
+        *splitKey = right.keys[0];
+        page.next = *splitPage;
+        if(!writePage(tree, *splitPage, &right) || !writePage(tree, pageNo, &page)){
+            return -1;
+        }
+        return 1;
+    }
+
+    uint32_t idx = upperBound(&page, key);
+    uint64_t childKey, childPage;
+    int split = insertInPage(tree, page.values[idx], key, value, &childKey, &childPage);
+    if(split != 1){
+        return split;
+    }
+    memcpy(keys, page.keys, sizeof(uint64_t) * idx);
+    memcpy(values, page.values, sizeof(uint64_t) * (idx + 1));
+    keys[idx] = childKey;
+    values[idx + 1] = childPage;
+    memcpy(keys + idx + 1, page.keys + idx, sizeof(uint64_t) * (count - idx));
+    memcpy(values + idx + 2, page.values + idx + 1, sizeof(uint64_t) * (count - idx));
+    count++;
+    if(count <= BTREE_ORDER){
+        memcpy(page.keys, keys, sizeof(uint64_t) * count);
+        memcpy(page.values, values, sizeof(uint64_t) * (count + 1));
+        page.count = count;
+        return writePage(tree, pageNo, &page) ? 0 : -1;
+    }
+    // Middle key moves up to the parent, it is not kept in either internal page
+    BTreePage right;
+    memset(&right, 0, sizeof(BTreePage));
+    uint32_t mid = count / 2;
+    right.count = count - mid - 1;
+    memcpy(right.keys, keys + mid + 1, sizeof(uint64_t) * right.count);
+    memcpy(right.values, values + mid + 1, sizeof(uint64_t) * (right.count + 1));
+    page.count = mid;
+    memcpy(page.keys, keys, sizeof(uint64_t) * mid);
+    memcpy(page.values, values, sizeof(uint64_t) * (mid + 1));
+    *splitPage = tree->pageCount++;
+    *splitKey = keys[mid];
+    if(!writePage(tree, *splitPage, &right) || !writePage(tree, pageNo, &page)){
+        return -1;
+    }
+    return 1;
+}
+
+/**
+ * Inserts a key or replaces the value of an existing key
+ * @param tree B+tree
+ * @param key Key to insert
+ * @param value Value of the key
+ * @return 1 if the key was stored, 0 on io error
+ */
+int btreeInsert(BTree *tree, uint64_t key, uint64_t value){
+    uint64_t splitKey, splitPage;
+    int split = insertInPage(tree, tree->root, key, value, &splitKey, &splitPage);
+    if(split == -1){
+        return 0;
+    }
+    if(split == 1){
+        BTreePage root;
+        memset(&root, 0, sizeof(BTreePage));
+        root.count = 1;
+        root.keys[0] = splitKey;
+        root.values[0] = tree->root;
+        root.values[1] = splitPage;
+        tree->root = tree->pageCount++;
+        if(!writePage(tree, tree->root, &root)){
+            return 0;
+        }
+    }
+    return writeHeader(tree);
+}
+
+/**
+ * Removes a key from its leaf
+ * Pages are not merged when they get sparse, the serial ids are append only so
+ * the space is given back by the next index rebuild
+ * @param tree B+tree
+ * @param key Key to delete
+ * @return 1 if the key was removed, 0 if it doesn't exist
+ */
+int btreeDelete(BTree *tree, uint64_t key){
+    BTreePage page;
+    uint64_t pageNo = findLeaf(tree, key, &page);
+    if(pageNo == 0){
+        return 0;
+    }
+    uint32_t idx = lowerBound(&page, key);
+    if(idx >= page.count || page.keys[idx] != key){
+        return 0;
+    }
+    memmove(page.keys + idx, page.keys + idx + 1, sizeof(uint64_t) * (page.count - idx - 1));
+    memmove(page.values + idx, page.values + idx + 1, sizeof(uint64_t) * (page.count - idx - 1));
+    page.count--;
+    return writePage(tree, pageNo, &page);
+}
+
+/**
+ * Positions a cursor on the first key greater or equal to `key`
+ * @param tree B+tree
+ * @param key Start of the range
+ * @return Cursor to iterate with `btreeNext`
+ */
+BTreeCursor btreeSeek(BTree *tree, uint64_t key){
+    BTreeCursor cursor;
+    cursor.tree = tree;
+    cursor.isValid = findLeaf(tree, key, &cursor.page) != 0;
+    cursor.idx = cursor.isValid ? lowerBound(&cursor.page, key) : 0;
+    return cursor;
+}
+
+/**
+ * Reads the entry under the cursor and advances it, following the leaf chain
+ * @param cursor Cursor created by `btreeSeek`
+ * @param key Key of the entry
+ * @param value Value of the entry
+ * @return 1 if an entry was read, 0 at the end of the tree
+ */
+int btreeNext(BTreeCursor *cursor, uint64_t *key, uint64_t *value){
+    while(cursor->isValid && cursor->idx >= cursor->page.count){
+        if(cursor->page.next == 0 || !readPage(cursor->tree, cursor->page.next, &cursor->page)){
+            cursor->isValid = 0;
+            break;
+        }
+        cursor->idx = 0;
+    }
+    if(!cursor->isValid){
+        return 0;
+    }
+    *key = cursor->page.keys[cursor->idx];
+    *value = cursor->page.values[cursor->idx];
+    cursor->idx++;
+    return 1;
+}
+
+/**
+ * Advances a cursor past entries without reading their values, the rest of a leaf is skipped
+ * at once by its key count and the following leaves are only read to follow the chain
+ * @param cursor Cursor created by `btreeSeek`
+ * @param count Number of entries to skip
+ * @return Number of entries skipped, less than `count` at the end of the tree
+ */
+uint64_t btreeSkip(BTreeCursor *cursor, uint64_t count){
+    uint64_t skipped = 0;
+    while(cursor->isValid && skipped < count){
+        uint64_t left = cursor->page.count > cursor->idx ? cursor->page.count - cursor->idx : 0;
+        if(count - skipped < left){
+            cursor->idx += (uint32_t)(count - skipped);
+            return count;
+        }
+        skipped += left;
+        if(cursor->page.next == 0 || !readPage(cursor->tree, cursor->page.next, &cursor->page)){
+            cursor->isValid = 0;
+            break;
+        }
+        cursor->idx = 0;
+    }
+    return skipped;
+}
+
+/**
+ * Counts the keys from a cursor up to a key, whole leaves are counted without looking at their keys
+ * @param cursor Cursor from a seek, moved past the counted keys
+ * @param high Last key counted
+ * @return Number of keys
+ */
+uint64_t btreeCountRange(BTreeCursor *cursor, uint64_t high){
+    uint64_t count = 0;
+    while(cursor->isValid){
+        if(cursor->idx < cursor->page.count && cursor->page.keys[cursor->page.count - 1] > high){
+            while (cursor->idx < cursor->page.count && cursor->page.keys[cursor->idx] <= high){
+                cursor->idx++;
+                count++;
+            }
+            return count;
+        }
+        count += cursor->page.count > cursor->idx ? cursor->page.count - cursor->idx : 0;
+        if(cursor->page.next == 0 || !readPage(cursor->tree, cursor->page.next, &cursor->page)){
+            cursor->isValid = 0;
+            break;
+        }
+        cursor->idx = 0;
+    }
+    return count;
+}
+
+/**
+ * Builds a new index file bottom up from sorted keys, one page write per node
+ * @param fileName Index file name, replaced if it exists
+ * @param keys Keys in ascending order
+ * @param values Value of each key
+ * @param size Number of keys
+ * @return 1 if the index was built, 0 on io error
+ */
+int btreeBulkLoad(const char *fileName, const uint64_t *keys, const uint64_t *values, size_t size){
+    BTree tree;
+    tree.file = fopen(fileName, "w+b");
+    if(tree.file == NULL){
+        return 0;
+    }
+    tree.pageCount = 1;
+    // An empty index is a single empty leaf, its root
+    size_t levelSize = size == 0 ? 1 : (size + BTREE_ORDER - 1) / BTREE_ORDER;
+    uint64_t *levelKeys = malloc(sizeof(uint64_t) * levelSize);
+    uint64_t *levelPages = malloc(sizeof(uint64_t) * levelSize);
+    if(levelKeys == NULL || levelPages == NULL){
+        free(levelKeys);
+        free(levelPages);
+        fclose(tree.file);
+        return 0;
+    }
+    int ok = 1;
+    BTreePage page;
+    for (size_t i = 0; i < levelSize && ok; ++i) {
+        size_t start = i * BTREE_ORDER;
+        size_t count = size - start < BTREE_ORDER ? size - start : BTREE_ORDER;
+        memset(&page, 0, sizeof(BTreePage));
+        page.isLeaf = 1;
+        page.count = (uint32_t)count;
+        page.next = i + 1 < levelSize ? tree.pageCount + 1 : 0;
+        memcpy(page.keys, keys + start, sizeof(uint64_t) * count);
+        memcpy(page.values, values + start, sizeof(uint64_t) * count);
+        levelKeys[i] = count > 0 ? keys[start] : 0;
+        levelPages[i] = tree.pageCount;
+        ok = writePage(&tree, tree.pageCount++, &page);
+    }
+    // Every internal page takes up to BTREE_ORDER + 1 children of the level below
+    while(levelSize > 1 && ok){
+        size_t parents = (levelSize + BTREE_ORDER) / (BTREE_ORDER + 1);
+        for (size_t i = 0; i < parents && ok; ++i) {
+            size_t start = i * (BTREE_ORDER + 1);
+            size_t children = levelSize - start < BTREE_ORDER + 1 ? levelSize - start : BTREE_ORDER + 1;
+            memset(&page, 0, sizeof(BTreePage));
+            page.count = (uint32_t)(children - 1);
+            for (size_t c = 0; c < children; ++c) {
+                page.values[c] = levelPages[start + c];
+                if(c > 0){
+                    page.keys[c - 1] = levelKeys[start + c];
+                }
+            }
+            levelKeys[i] = levelKeys[start];
+            levelPages[i] = tree.pageCount;
+            ok = writePage(&tree, tree.pageCount++, &page);
+        }
+        levelSize = parents;
+    }
+    // The root is the last page written, the only page of the top level
+    tree.root = tree.pageCount - 1;
+    ok = ok && writeHeader(&tree);
+    free(levelKeys);
+    free(levelPages);
+    fclose(tree.file);
+    return ok;
+}
@@ -0,0 +1,49 @@
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef MINISQL_BTREE_H
+#define MINISQL_BTREE_H
+
+#define BTREE_PAGE_SIZE 4096
+// Maximum keys a page can hold, sized so a page fits in BTREE_PAGE_SIZE
+#define BTREE_ORDER 254
+
+/*
+ * On disk B+tree page, page 0 of the file is the tree header and every other page is a node
+ * Leaf: keys[i] -> values[i], `next` links to the next leaf for range scans
+ * Internal: values[i] is the child page holding keys < keys[i], values[count] holds the rest
+ */
+struct {
+    uint32_t isLeaf;
+    uint32_t count;
+    uint64_t next;
+    uint64_t keys[BTREE_ORDER];
+    uint64_t values[BTREE_ORDER + 1];
+} typedef BTreePage;
+
+struct {
+    FILE *file;
+    uint64_t root;
+    uint64_t pageCount;
+} typedef BTree;
+
+struct {
+    BTree *tree;
+    BTreePage page;
+    uint32_t idx;
+    int isValid;
+} typedef BTreeCursor;
+
+BTree *btreeOpen(const char *fileName);
+void btreeClose(BTree *tree);
+int btreeSearch(BTree *tree, uint64_t key, uint64_t *value);
+int btreeInsert(BTree *tree, uint64_t key, uint64_t value);
+int btreeDelete(BTree *tree, uint64_t key);
+BTreeCursor btreeSeek(BTree *tree, uint64_t key);
+int btreeNext(BTreeCursor *cursor, uint64_t *key, uint64_t *value);
+uint64_t btreeSkip(BTreeCursor *cursor, uint64_t count);
+uint64_t btreeCountRange(BTreeCursor *cursor, uint64_t high);
+int btreeBulkLoad(const char *fileName, const uint64_t *keys, const uint64_t *values, size_t size);
+
+#endif //MINISQL_BTREE_H
@@ -0,0 +1,434 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "bufferpool.h"
+#include "filesystem.h"
+
+/*
+ * Table file known by the pool, the pool keeps its own handle so every page
+ * of a file is read and written through the same stream
+ */
+struct {
+    char *fileName;
+    FILE *file;
+    int openCount;
+} typedef BufferPoolFile;
+
+/*
+ * Single buffer pool shared by every table of the process, the scans of the worker pool
+ * pin pages concurrently so every call holds `lock`. A missing page is read without the lock,
+ * its frame is pinned and marked as loading until the read is done
+ */
+struct {
+    char *pages;
+    BufferFrame *frames;
+    int *buckets;
+    size_t frameCount;
+    size_t bucketMask;
+    size_t hand; // CLOCK hand
+    BufferPoolFile *files;
+    int fileCount;
+    BufferPoolStats stats;
+    pthread_mutex_t lock;
+    pthread_cond_t loaded; // A page was read into its frame
+} typedef BufferPool;
+
+static BufferPool pool = {.lock = PTHREAD_MUTEX_INITIALIZER, .loaded = PTHREAD_COND_INITIALIZER};
+
+
+static size_t bucketOf(int fileId, uint64_t pageNo){
+    uint64_t hash = ((uint64_t)fileId * 0x9E3779B97F4A7C15ULL) ^ (pageNo * 0xC2B2AE3D27D4EB4FULL);
+    return (size_t)(hash ^ (hash >> 29)) & pool.bucketMask;
+}
+
+static int findFrame(int fileId, uint64_t pageNo){
+    int idx = pool.buckets[bucketOf(fileId, pageNo)];
+    while(idx != -1){
+        if(pool.frames[idx].fileId == fileId && pool.frames[idx].pageNo == pageNo){
+            return idx;
+        }
+        idx = pool.frames[idx].next;
+    }
+    return -1;
+}
+
+static void unlinkFrame(int idx){
+    BufferFrame *frame = &pool.frames[idx];
+    int *link = &pool.buckets[bucketOf(frame->fileId, frame->pageNo)];
+    while(*link != -1 && *link != idx){
+        link = &pool.frames[*link].next;
+    }
+    if(*link == idx){
+        *link = frame->next;
+    }
+}
+
+static void removeFrame(int idx){
+    BufferFrame *frame = &pool.frames[idx];
+    unlinkFrame(idx);
+    frame->isValid = 0;
+    frame->isDirty = 0;
+    pool.stats.usedFrames--;
+}
+
+static int writeFrame(int idx){
+    BufferFrame *frame = &pool.frames[idx];
+    FILE *file = pool.files[frame->fileId].file;
+    if(file == NULL || fseek(file, (long)(frame->pageNo * BUFFER_POOL_PAGE_SIZE), SEEK_SET) != 0 ||
+       fwrite(pool.pages + (size_t)idx * BUFFER_POOL_PAGE_SIZE, BUFFER_POOL_PAGE_SIZE, 1, file) != 1 ||
+       fflush(file) != 0){
+        return 0;
+    }
+    frame->isDirty = 0;
+    pool.stats.writeBacks++;
+    return 1;
+}
+
+/**
+ * Finds a frame for a new page with the CLOCK algorithm, a referenced frame gets
+ * a second chance and a dirty victim is written back before it is reused
+ * @return Free frame or -1 if every frame is pinned
+ */
+static int evictFrame(){
+    for (size_t step = 0; step < pool.frameCount * 2; ++step) {
+        int idx = (int)pool.hand;
+        pool.hand = (pool.hand + 1) % pool.frameCount;
+        BufferFrame *frame = &pool.frames[idx];
+        if(!frame->isValid){
+            return idx;
+        }
+        if(frame->pinCount > 0){
+            continue;
+        }
+        if(frame->isReferenced){
+            frame->isReferenced = 0;
+            continue;
+        }
+        if(frame->isDirty && !writeFrame(idx)){
+            continue;
+        }
+        removeFrame(idx);
+        pool.stats.evictions++;
+        return idx;
+    }
+    return -1;
+}
+
+static int flushFile(int fileId){
+    if(fileId < 0 || fileId >= pool.fileCount || pool.files[fileId].file == NULL){
+        return 0;
+    }
+    int ok = 1;
+    for (size_t i = 0; i < pool.frameCount; ++i) {
+        BufferFrame *frame = &pool.frames[i];
+        if(frame->isValid && frame->isDirty && frame->fileId == fileId){
+            ok = writeFrame((int)i) && ok;
+        }
+    }
+    return fflush(pool.files[fileId].file) == 0 && ok;
+}
+
+static int initPool(size_t budget){
+    size_t frameCount = budget / BUFFER_POOL_PAGE_SIZE;
+    if(frameCount < 8){
+        frameCount = 8;
+    }
+    size_t bucketCount = 1;
+    while(bucketCount < frameCount){
+        bucketCount *= 2;
+    }
+    char *pages = malloc(frameCount * BUFFER_POOL_PAGE_SIZE);
+    BufferFrame *frames = calloc(frameCount, sizeof(BufferFrame));
+    int *buckets = malloc(sizeof(int) * bucketCount);
+    if(pages == NULL || frames == NULL || buckets == NULL){
+        free(pages);
+        free(frames);
+        free(buckets);
+        return 0;
+    }
+    for (int i = 0; i < pool.fileCount; ++i) {
+        flushFile(i);
+    }
+    free(pool.pages);
+    free(pool.frames);
+    free(pool.buckets);
+    memset(buckets, 0xFF, sizeof(int) * bucketCount);
+    pool.pages = pages;
+    pool.frames = frames;
+    pool.buckets = buckets;
+    pool.frameCount = frameCount;
+    pool.bucketMask = bucketCount - 1;
+    pool.hand = 0;
+    pool.stats.frameCount = frameCount;
+    pool.stats.usedFrames = 0;
+    return 1;
+}
+
+static int openFile(const char *fileName){
+    if(pool.frames == NULL && !initPool(BUFFER_POOL_DEFAULT_SIZE)){
+        return -1;
+    }
+    int fileId = 0;
+    while(fileId < pool.fileCount && strcmp(pool.files[fileId].fileName, fileName) != 0){
+        fileId++;
+    }
+    if(fileId == pool.fileCount){
+        BufferPoolFile *temp = realloc(pool.files, sizeof(BufferPoolFile) * (pool.fileCount + 1));
+        char *name = malloc(strlen(fileName) + 1);
+        if(temp == NULL || name == NULL){
+            pool.files = temp != NULL ? temp : pool.files;
+            free(name);
+            return -1;
+        }
+        strcpy(name, fileName);
+        pool.files = temp;
+        pool.files[fileId].fileName = name;
+        pool.files[fileId].file = NULL;
+        pool.files[fileId].openCount = 0;
+        pool.fileCount++;
+    }
+    BufferPoolFile *entry = &pool.files[fileId];
+    if(entry->file == NULL){
+        entry->file = fopen(fileName, "r+b");
+        if(entry->file == NULL){
+            return -1;
+        }
+    }
+    entry->openCount++;
+    return fileId;
+}
+
+/**
+ * Allocates the buffer pool, pages cached before are written back and dropped
+ * @param budget Memory of the pool in bytes, at least 8 pages are allocated
+ * @return 1 if the pool was allocated, 0 otherwise
+ */
+int bufferPoolInit(size_t budget){
+    pthread_mutex_lock(&pool.lock);
+    int ok = initPool(budget);
+    pthread_mutex_unlock(&pool.lock);
+    return ok;
+}
+
+/**
+ * Registers a table file in the pool and opens it if it isn't already
+ * @param fileName Table file name
+ * @return File id used to pin the pages of the file, -1 if the file can't be opened
+ */
+int bufferPoolOpen(const char *fileName){
+    pthread_mutex_lock(&pool.lock);
+    int fileId = openFile(fileName);
+    pthread_mutex_unlock(&pool.lock);
+    return fileId;
+}
+
+/**
+ * Writes back the dirty pages of a file, the file handle and its clean pages
+ * stay cached for the next statements
+ * @param fileId File id returned by `bufferPoolOpen`
+ */
+void bufferPoolClose(int fileId){
+    pthread_mutex_lock(&pool.lock);
+    if(fileId >= 0 && fileId < pool.fileCount){
+        flushFile(fileId);
+        if(pool.files[fileId].openCount > 0){
+            pool.files[fileId].openCount--;
+        }
+    }
+    pthread_mutex_unlock(&pool.lock);
+}
+
+static char *pinPage(int fileId, uint64_t pageNo, size_t *length){
+    if(fileId < 0 || fileId >= pool.fileCount || pool.files[fileId].file == NULL){
+        return NULL;
+    }
+    int idx;
+    // The frame of a page being read by another thread can be evicted once it is loaded, it is looked up again
+    while ((idx = findFrame(fileId, pageNo)) != -1 && pool.frames[idx].isLoading){
+        pthread_cond_wait(&pool.loaded, &pool.lock);
+    }
+    if(idx != -1){
+        pool.stats.hits++;
+        pool.frames[idx].pinCount++;
+    }
+    else{
+        pool.stats.misses++;
+        idx = evictFrame();
+        if(idx == -1){
+            return NULL;
+        }
+        BufferFrame *frame = &pool.frames[idx];
+        frame->fileId = fileId;
+        frame->pageNo = pageNo;
+        frame->pinCount = 1;
+        frame->isDirty = 0;
+        frame->isValid = 1;
+        frame->isLoading = 1;
+        frame->isDetached = 0;
+        size_t bucket = bucketOf(fileId, pageNo);
+        frame->next = pool.buckets[bucket];
+        pool.buckets[bucket] = idx;
+        pool.stats.usedFrames++;
+        char *page = pool.pages + (size_t)idx * BUFFER_POOL_PAGE_SIZE;
+        FILE *file = pool.files[fileId].file;
+        pthread_mutex_unlock(&pool.lock);
+        size_t read = readFileAt(file, page, BUFFER_POOL_PAGE_SIZE, pageNo * BUFFER_POOL_PAGE_SIZE);
+        memset(page + read, 0, BUFFER_POOL_PAGE_SIZE - read);
+        pthread_mutex_lock(&pool.lock);
+        frame->length = read;
+        frame->isLoading = 0;
+        pthread_cond_broadcast(&pool.loaded);
+    }
+    BufferFrame *frame = &pool.frames[idx];
+    frame->isReferenced = 1;
+    if(length != NULL){
+        *length = frame->length;
+    }
+    return pool.pages + (size_t)idx * BUFFER_POOL_PAGE_SIZE;
+}
+
+/**
+ * Pins a page in memory, the page is read from the file on a miss
+ * @param fileId File id returned by `bufferPoolOpen`
+ * @param pageNo Page number in the file
+ * @param length Number of bytes of the page stored in the file, 0 past the end of the file
+ * @return Page of BUFFER_POOL_PAGE_SIZE bytes or NULL if every frame is pinned
+ */
+char *bufferPoolPin(int fileId, uint64_t pageNo, size_t *length){
+    pthread_mutex_lock(&pool.lock);
+    char *page = pinPage(fileId, pageNo, length);
+    pthread_mutex_unlock(&pool.lock);
+    return page;
+}
+
+/**
+ * Releases a pinned page, a dirty page is written back on eviction or when its file is closed
+ * @param page Page returned by `bufferPoolPin`
+ * @param isDirty 1 if the page was changed
+ */
+void bufferPoolUnpin(const char *page, int isDirty){
+    if(page == NULL){
+        return;
+    }
+    pthread_mutex_lock(&pool.lock);
+    BufferFrame *frame = &pool.frames[(page - pool.pages) / BUFFER_POOL_PAGE_SIZE];
+    if(frame->pinCount > 0){
+        frame->pinCount--;
+    }
+    if(frame->isDetached){
+        // The page is no longer the one of the file, its changes are dropped with it
+        if(frame->pinCount == 0){
+            frame->isDetached = 0;
+            frame->isValid = 0;
+            frame->isDirty = 0;
+            pool.stats.usedFrames--;
+        }
+    }
+    else if(isDirty){
+        frame->isDirty = 1;
+        frame->length = BUFFER_POOL_PAGE_SIZE;
+    }
+    pthread_mutex_unlock(&pool.lock);
+}
+
+/**
+ * Writes back every dirty page of a file
+ * @param fileId File id returned by `bufferPoolOpen`
+ * @return 1 if the pages were written, 0 otherwise
+ */
+int bufferPoolFlush(int fileId){
+    pthread_mutex_lock(&pool.lock);
+    int ok = flushFile(fileId);
+    pthread_mutex_unlock(&pool.lock);
+    return ok;
+}
+
+/**
+ * Writes back the dirty pages of a file and syncs the file to the disk
+ * @param fileId File id returned by `bufferPoolOpen`
+ * @return 1 if the file is on the disk, 0 otherwise
+ */
+int bufferPoolSync(int fileId){
+    pthread_mutex_lock(&pool.lock);
+    int ok = flushFile(fileId) && syncFile(pool.files[fileId].file);
+    pthread_mutex_unlock(&pool.lock);
+    return ok;
+}
+
+/**
+ * Drops the cached pages of a file that was written or replaced outside the pool. A page pinned by
+ * another thread is detached, its holder keeps reading the old copy and the next pin reads the file
+ * @param fileName Table file name
+ * @param fromPageNo First page that changed, 0 when the whole file changed
+ */
+void bufferPoolInvalidate(const char *fileName, uint64_t fromPageNo){
+    pthread_mutex_lock(&pool.lock);
+    int fileId = 0;
+    while(fileId < pool.fileCount && strcmp(pool.files[fileId].fileName, fileName) != 0){
+        fileId++;
+    }
+    if(fileId == pool.fileCount){
+        pthread_mutex_unlock(&pool.lock);
+        return;
+    }
+    // Pages being read use the handle of the file without the lock, the reads are finished first
+    int isLoading = 1;
+    while(isLoading){
+        isLoading = 0;
+        for (size_t i = 0; !isLoading && i < pool.frameCount; ++i) {
+            isLoading = pool.frames[i].isValid && pool.frames[i].isLoading && pool.frames[i].fileId == fileId;
+        }
+        if(isLoading){
+            pthread_cond_wait(&pool.loaded, &pool.lock);
+        }
+    }
+    for (size_t i = 0; i < pool.frameCount; ++i) {
+        BufferFrame *frame = &pool.frames[i];
+        if(!frame->isValid || frame->isDetached || frame->fileId != fileId || frame->pageNo < fromPageNo){
+            continue;
+        }
+        if(frame->pinCount > 0){
+            unlinkFrame((int)i);
+            frame->isDetached = 1;
+            frame->isDirty = 0;
+        }
+        else{
+            removeFrame((int)i);
+        }
+    }
+    BufferPoolFile *entry = &pool.files[fileId];
+    if(entry->file != NULL && fromPageNo == 0 && entry->openCount == 0){
+        // The file may have been replaced, it is opened again on the next use
+        fclose(entry->file);
+        entry->file = NULL;
+    }
+    else if(entry->file != NULL){
+        fflush(entry->file);
+    }
+    pthread_mutex_unlock(&pool.lock);
+}
+
+/**
+ * Counters of the pool, used to size the pool for a working set
+ * @return Pool statistics
+ */
+BufferPoolStats bufferPoolGetStats(){
+    pthread_mutex_lock(&pool.lock);
+    BufferPoolStats stats = pool.stats;
+    pthread_mutex_unlock(&pool.lock);
+    return stats;
+}
+
+/**
+ * Prints the counters of the pool
+ */
+void printBufferPoolStats(){
+    BufferPoolStats stats = bufferPoolGetStats();
+    uint64_t total = stats.hits + stats.misses;
+    printf("Buffer pool: %zd pages of %d bytes, %zd in use\n", stats.frameCount, BUFFER_POOL_PAGE_SIZE, stats.usedFrames);
+    printf("Hits: %llu, Misses: %llu, Hit ratio: %.2f%%\n", (unsigned long long)stats.hits, (unsigned long long)stats.misses,
+           total > 0 ? 100.0 * (double)stats.hits / (double)total : 0.0);
+    printf("Evictions: %llu, Write backs: %llu\n", (unsigned long long)stats.evictions, (unsigned long long)stats.writeBacks);
+}
@@ -0,0 +1,48 @@
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef MINISQL_BUFFERPOOL_H
+#define MINISQL_BUFFERPOOL_H
+
+#define BUFFER_POOL_PAGE_SIZE 4096
+// Memory budget used when the pool is not initialized with `bufferPoolInit`
+#define BUFFER_POOL_DEFAULT_SIZE (8 * 1024 * 1024)
+
+/*
+ * Cached page of a table file, the pool evicts frames with the CLOCK algorithm
+ */
+struct {
+    int fileId;
+    uint64_t pageNo;
+    size_t length; // Bytes read from the file, the rest of the page is zeroed
+    int pinCount;
+    int isDirty;
+    int isReferenced; // CLOCK reference bit
+    int isValid;
+    int isLoading; // Pinned while its page is read without the lock of the pool
+    int isDetached; // Invalidated while pinned, out of the hash table and freed by its last unpin
+    int next; // Next frame in the same hash bucket
+} typedef BufferFrame;
+
+struct {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    uint64_t writeBacks;
+    size_t frameCount;
+    size_t usedFrames;
+} typedef BufferPoolStats;
+
+int bufferPoolInit(size_t budget);
+int bufferPoolOpen(const char *fileName);
+void bufferPoolClose(int fileId);
+char *bufferPoolPin(int fileId, uint64_t pageNo, size_t *length);
+void bufferPoolUnpin(const char *page, int isDirty);
+int bufferPoolFlush(int fileId);
+int bufferPoolSync(int fileId);
+void bufferPoolInvalidate(const char *fileName, uint64_t fromPageNo);
+BufferPoolStats bufferPoolGetStats();
+void printBufferPoolStats();
+
+#endif //MINISQL_BUFFERPOOL_H
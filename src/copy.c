@@ -0,0 +1,521 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "copy.h"
+#include "database.h"
+#include "hashindex.h"
+#include "page.h"
+#include "workerpool.h"
+
+
+/**
+ * Opens a csv file to load its rows in a table
+ * @param reader Reader to initialize
+ * @param fileName Csv file
+ * @param tableNode Table reference node
+ * @param columns Source of every column of the table
+ * @param fieldCount Fields of every line of the file
+ * @param isPaged Encodes the rows as records of a paged table as well
+ * @param isHeader The first line of the file is skipped
+ * @param sequence Sequence of the ids of the table, NULL for a table without an id column
+ * @return 1 if the file is open, 0 otherwise
+ */
+int copyReaderOpen(CopyReader *reader, const char *fileName, const Node *tableNode, const CopyColumn *columns,
+                   size_t fieldCount, int isPaged, int isHeader, Sequence *sequence){
+    memset(reader, 0, sizeof(CopyReader));
+    reader->fileName = fileName;
+    reader->tableNode = tableNode;
+    reader->columns = columns;
+    reader->fieldCount = fieldCount;
+    reader->isPaged = isPaged;
+    reader->isHeader = isHeader;
+    reader->nextLine = 1;
+    reader->sequence = sequence;
+    reader->error = createStringBuilder();
+    reader->file = fopen(fileName, "rb");
+    if(reader->file == NULL){
+        return 0;
+    }
+    reader->blockSize = COPY_BLOCK_SIZE;
+    reader->block = malloc(reader->blockSize);
+    reader->partCapacity = workerPoolSize() * COPY_PARTS_PER_WORKER;
+    reader->parts = calloc(reader->partCapacity, sizeof(CopyPart));
+    if(reader->block == NULL || reader->parts == NULL){
+        copyReaderClose(reader);
+        return 0;
+    }
+    for (size_t i = 0; i < reader->partCapacity; ++i) {
+        reader->parts[i].rows = createStringBuilder();
+        reader->parts[i].records = createStringBuilder();
+        reader->parts[i].error = createStringBuilder();
+    }
+    return 1;
+}
+
+/**
+ * Makes room for one more row in a part
+ * @param part Part of a block
+ * @return 1 if there is room, 0 if out of memory
+ */
+static int growPart(CopyPart *part){
+    if(part->count + 1 < part->capacity){
+        return 1;
+    }
+    size_t capacity = part->capacity == 0 ? 1024 : part->capacity * 2;
+    size_t *starts = realloc(part->starts, sizeof(size_t) * capacity);
+    if(starts == NULL){
+        return 0;
+    }
+    part->starts = starts;
+    size_t *recordStarts = realloc(part->recordStarts, sizeof(size_t) * capacity);
+    if(recordStarts == NULL){
+        return 0;
+    }
+    part->recordStarts = recordStarts;
+    part->capacity = capacity;
+    return 1;
+}
+
+/**
+ * Finds the line break that ends a csv record, a line break inside a quoted field belongs to the record
+ * @param data Start of the record
+ * @param end End of the data
+ * @param lineBreaks Line breaks inside the quoted fields of the record
+ * @return Line break ending the record or NULL if the record doesn't end before `end`
+ */
+static const char *findRecordEnd(const char *data, const char *end, size_t *lineBreaks){
+    const char *newLine = memchr(data, '\n', (size_t)(end - data));
+    *lineBreaks = 0;
+    // Most records have no double quote, their first line break ends them
+    if(memchr(data, '"', (size_t)((newLine != NULL ? newLine : end) - data)) == NULL){
+        return newLine;
+    }
+    int isFieldStart = 1;
+    for (const char *p = data; p < end; ++p) {
+        if(isFieldStart && *p == '"'){
+            // A quoted field ends on a double quote that isn't written twice
+            for (p++; p < end && !(*p == '"' && (p + 1 == end || p[1] != '"')); ++p) {
+                if(*p == '"'){
+                    p++;
+                }
+                else if(*p == '\n'){
+                    (*lineBreaks)++;
+                }
+            }
+            if(p == end){
+                return NULL;
+            }
+            isFieldStart = 0;
+            continue;
+        }
+        if(*p == '\n'){
+            return p;
+        }
+        isFieldStart = *p == ',';
+    }
+    return NULL;
+}
+
+/**
+ * Splits a csv line in its fields, a field between double quotes can hold commas and
+ * double quotes written twice
+ * @param line Line without its line break
+ * @param len Length of the line
+ * @param text Values of the fields one after the other
+ * @param starts Start of every field in `text`
+ * @param ends End of every field in `text`
+ * @param capacity Fields expected on the line
+ * @param error Reason the line can't be read
+ * @return Number of fields, 0 if the line can't be read
+ */
+static size_t splitCsvLine(const char *line, size_t len, StringBuilder *text, size_t *starts, size_t *ends,
+                           size_t capacity, const char **error){
+    const char *p = line, *end = line + len;
+    size_t count = 0;
+    resetStringBuilder(text);
+    while (1){
+        if(count == capacity){
+            *error = "has more fields than the columns copied";
+            return 0;
+        }
+        starts[count] = text->len;
+        if(p < end && *p == '"'){
+            p++;
+            while (1){
+                const char *quote = memchr(p, '"', (size_t)(end - p));
+                if(quote == NULL){
+                    *error = "has a quoted field without its closing quote";
+                    return 0;
+                }
+                if(memchr(p, '\n', (size_t)(quote - p)) != NULL){
+                    *error = "has a line break in a quoted field, a row can't hold one";
+                    return 0;
+                }
+                appendRawToBuilder(text, p, (size_t)(quote - p));
+                p = quote + 1;
+                if(p < end && *p == '"'){
+                    appendRawToBuilder(text, "\"", 1);
+                    p++;
+                    continue;
+                }
+                break;
+            }
+            if(p < end && *p != ','){
+                *error = "has text after a quoted field";
+                return 0;
+            }
+        }
+        else{
+            const char *comma = memchr(p, ',', (size_t)(end - p));
+            const char *fieldEnd = comma != NULL ? comma : end;
+            appendRawToBuilder(text, p, (size_t)(fieldEnd - p));
+            p = fieldEnd;
+        }
+        ends[count++] = text->len;
+        if(p < end){
+            // The comma after the field, a line ending with a comma has an empty last field
+            p++;
+            continue;
+        }
+        break;
+    }
+    if(count != capacity){
+        *error = "has fewer fields than the columns copied";
+        return 0;
+    }
+    return count;
+}
+
+/**
+ * Parses the lines of a part of a block into rows, run by the worker pool. Every row takes the
+ * next id and is encoded as a record for a paged table
+ * @param arg Reader
+ * @param worker Thread
+ * @param index Part of the block
+ */
+static void parsePartTask(void *arg, size_t worker, size_t index){
+    CopyReader *reader = arg;
+    CopyPart *part = &reader->parts[index];
+    const Node *tableNode = reader->tableNode;
+    StringBuilder text = createStringBuilder();
+    size_t starts[reader->fieldCount + 1];
+    size_t ends[reader->fieldCount + 1];
+    char record[PAGE_SIZE];
+    const char *error = NULL;
+    const char *line = part->data, *end = part->data + part->len;
+    size_t lineNo = part->firstLine, lineBreaks = 0;
+    (void)worker;
+    resetStringBuilder(&part->rows);
+    resetStringBuilder(&part->records);
+    resetStringBuilder(&part->error);
+    part->count = 0;
+    for (; line < end && error == NULL; lineNo += 1 + lineBreaks) {
+        const char *newLine = findRecordEnd(line, end, &lineBreaks);
+        const char *lineEnd = newLine != NULL ? newLine : end;
+        const char *next = newLine != NULL ? newLine + 1 : end;
+        if(lineEnd > line && lineEnd[-1] == '\r'){
+            lineEnd--;
+        }
+        if(lineEnd == line){
+            line = next;
+            continue;
+        }
+        if(!growPart(part) ||
+           splitCsvLine(line, (size_t)(lineEnd - line), &text, starts, ends, reader->fieldCount, &error) == 0){
+            error = error != NULL ? error : "can't be read, out of memory";
+            break;
+        }
+        part->starts[part->count] = part->rows.len;
+        appendRawToBuilder(&part->rows, "1,", 2);
+        for (int i = 0; i < tableNode->colsLen; ++i) {
+            const CopyColumn *column = &reader->columns[i];
+            if(column->isId){
+                appendToBuilder(&part->rows, "%llu", (unsigned long long)(part->firstId + part->count));
+            }
+            else if(column->field >= 0){
+                // Commas of a value are escaped the way they are stored
+                const char *value = text.data + starts[column->field];
+                const char *valueEnd = text.data + ends[column->field];
+                const char *comma;
+                while ((comma = memchr(value, ',', (size_t)(valueEnd - value))) != NULL){
+                    appendRawToBuilder(&part->rows, value, (size_t)(comma - value));
+                    appendRawToBuilder(&part->rows, "\\,", 2);
+                    value = comma + 1;
+                }
+                appendRawToBuilder(&part->rows, value, (size_t)(valueEnd - value));
+            }
+            else{
+                appendRawToBuilder(&part->rows, column->value, strlen(column->value));
+            }
+            if(i != tableNode->colsLen - 1){
+                appendRawToBuilder(&part->rows, ",", 1);
+            }
+        }
+        appendRawToBuilder(&part->rows, "\n", 1);
+        if(reader->isPaged){
+            // The row is the end of the text, it is encoded before the next row is added
+            size_t recordLen = encodeRowLine(tableNode, part->rows.data + part->starts[part->count], record, sizeof(record));
+            if(recordLen == 0){
+                error = "doesn't fit in a page";
+                break;
+            }
+            part->recordStarts[part->count] = part->records.len;
+            appendRawToBuilder(&part->records, record, recordLen);
+        }
+        part->count++;
+        line = next;
+    }
+    if(error != NULL){
+        appendToBuilder(&part->error, "Line %zu of `%s` %s", lineNo, reader->fileName, error);
+    }
+    if(part->recordStarts != NULL){
+        part->recordStarts[part->count] = part->records.len;
+    }
+    clearStringBuilder(&text);
+}
+
+/**
+ * Adds a part to the block being split
+ * @param reader Reader
+ * @param start First record of the part
+ * @param end End of the last record of the part
+ * @param firstLine Line of the file of the first record
+ * @param firstRow Rows of the block before the part
+ */
+static void addPart(CopyReader *reader, const char *start, const char *end, size_t firstLine, uint64_t firstRow){
+    CopyPart *part = &reader->parts[reader->partCount++];
+    part->data = start;
+    part->len = (size_t)(end - start);
+    part->firstLine = firstLine;
+    part->firstId = firstRow;
+}
+
+/**
+ * Splits the records read in the block in parts of about the same size, a part and the block
+ * end on the end of a record so a quoted field with a line break stays in one part
+ * @param reader Reader
+ * @param len Bytes read in the block
+ * @param isHeader The first record of the block is the header of the file
+ * @param rowCount Rows of the block
+ * @return 1 if the block was split, 0 if it must grow to hold its first record
+ */
+static int splitBlock(CopyReader *reader, size_t len, int isHeader, uint64_t *rowCount){
+    const char *data = reader->block, *end = reader->block + len;
+    const char *record = data, *partStart = data;
+    size_t partSize = len / reader->partCapacity;
+    size_t line = reader->nextLine, partLine = line, lineBreaks;
+    uint64_t rows = 0, partRows = 0;
+    partSize = partSize > COPY_MIN_PART_SIZE ? partSize : COPY_MIN_PART_SIZE;
+    reader->partCount = 0;
+    while (record < end){
+        const char *recordEnd = findRecordEnd(record, end, &lineBreaks);
+        if(recordEnd == NULL && !reader->isEnd){
+            break;
+        }
+        const char *next = recordEnd != NULL ? recordEnd + 1 : end;
+        const char *last = recordEnd != NULL ? recordEnd : end;
+        line += 1 + lineBreaks;
+        if(isHeader){
+            isHeader = 0;
+            partStart = next;
+            partLine = line;
+        }
+        else{
+            rows += last > record && !(last - record == 1 && *record == '\r');
+        }
+        record = next;
+        // The rows are counted while the block is split so every part knows the ids of its rows,
+        // the last part takes the rest of the block
+        if((size_t)(record - partStart) >= partSize && reader->partCount < reader->partCapacity - 1){
+            addPart(reader, partStart, record, partLine, partRows);
+            partStart = record;
+            partLine = line;
+            partRows = rows;
+        }
+    }
+    if(record == data && !reader->isEnd){
+        reader->partCount = 0;
+        return 0;
+    }
+    if(record > partStart){
+        addPart(reader, partStart, record, partLine, partRows);
+    }
+    reader->blockLen = (size_t)(record - data);
+    reader->carry = len - reader->blockLen;
+    reader->nextLine = line;
+    *rowCount = rows;
+    return 1;
+}
+
+/**
+ * Reads the next block of the file and parses its records, the parts of the block are split
+ * on the ends of the records and parsed by the worker pool
+ * @param reader Opened reader
+ * @return 1 if the parts hold the rows of the next block, 0 at the end of the file or on error,
+ * `error` holds the reason of an error
+ */
+int copyReaderNext(CopyReader *reader){
+    reader->partCount = 0;
+    if(reader->error.len > 0 || (reader->isEnd && reader->carry == 0)){
+        return 0;
+    }
+    memmove(reader->block, reader->block + reader->blockLen, reader->carry);
+    size_t len = reader->carry;
+    int isHeader = reader->isHeader && reader->nextLine == 1;
+    uint64_t blockRows = 0;
+    while (1){
+        while (len < reader->blockSize && !reader->isEnd){
+            size_t read = fread(reader->block + len, 1, reader->blockSize - len, reader->file);
+            len += read;
+            if(read == 0){
+                if(ferror(reader->file)){
+                    appendToBuilder(&reader->error, "Unable to read `%s`", reader->fileName);
+                    return 0;
+                }
+                reader->isEnd = 1;
+            }
+        }
+        if(splitBlock(reader, len, isHeader, &blockRows)){
+            break;
+        }
+        // A record longer than the block, the block grows until it holds the record
+        char *block = realloc(reader->block, reader->blockSize * 2);
+        if(block == NULL){
+            appendToBuilder(&reader->error, "Line %zu of `%s` is too long", reader->nextLine, reader->fileName);
+            return 0;
+        }
+        reader->block = block;
+        reader->blockSize *= 2;
+    }
+    // The ids of the whole block are taken at once before its rows are parsed
+    uint64_t firstId = 0;
+    if(reader->sequence != NULL && blockRows > 0 && !sequenceNext(reader->sequence, blockRows, &firstId)){
+        appendToBuilder(&reader->error, "Unable to take the ids of table `%s`", reader->tableNode->table.value);
+        return 0;
+    }
+    for (size_t i = 0; i < reader->partCount; ++i) {
+        reader->parts[i].firstId += firstId;
+    }
+    workerPoolRun(parsePartTask, reader, reader->partCount);
+    for (size_t i = 0; i < reader->partCount; ++i) {
+        if(reader->parts[i].error.len > 0){
+            appendRawToBuilder(&reader->error, reader->parts[i].error.data, reader->parts[i].error.len);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * Closes the file of a reader and frees its blocks
+ * @param reader Reader
+ */
+void copyReaderClose(CopyReader *reader){
+    if(reader->file != NULL){
+        fclose(reader->file);
+        reader->file = NULL;
+    }
+    for (size_t i = 0; reader->parts != NULL && i < reader->partCapacity; ++i) {
+        clearStringBuilder(&reader->parts[i].rows);
+        clearStringBuilder(&reader->parts[i].records);
+        clearStringBuilder(&reader->parts[i].error);
+        free(reader->parts[i].starts);
+        free(reader->parts[i].recordStarts);
+    }
+    free(reader->parts);
+    reader->parts = NULL;
+    free(reader->block);
+    reader->block = NULL;
+    clearStringBuilder(&reader->error);
+}
+
+/**
+ * Appends a stored value as a csv field, a value holding a comma, a double quote or a carriage return is quoted
+ * so it reads back unchanged
+ * @param out Csv line
+ * @param data Stored value, its commas are escaped as `\,`
+ * @param len Length of the value
+ */
+void copyAppendField(StringBuilder *out, const char *data, size_t len){
+    if(memchr(data, ',', len) == NULL && memchr(data, '"', len) == NULL && memchr(data, '\r', len) == NULL &&
+       memchr(data, '\n', len) == NULL){
+        appendRawToBuilder(out, data, len);
+        return;
+    }
+    appendRawToBuilder(out, "\"", 1);
+    for (size_t i = 0; i < len; ++i) {
+        if(data[i] == '\\' && i + 1 < len && data[i+1] == ','){
+            continue;
+        }
+        if(data[i] == '"'){
+            appendRawToBuilder(out, "\"", 1);
+        }
+        appendRawToBuilder(out, data + i, 1);
+    }
+    appendRawToBuilder(out, "\"", 1);
+}
+
+/**
+ * Initializes an empty value set
+ * @param set Value set
+ * @return 1 if the set is ready, 0 if out of memory
+ */
+int copyValueSetInit(CopyValueSet *set){
+    set->size = 0;
+    set->slotCount = 1024;
+    set->arena = arenaCreate(0);
+    set->values = calloc(set->slotCount, sizeof(char *));
+    return set->arena != NULL && set->values != NULL;
+}
+
+/**
+ * Adds a value to a set, the table doubles once it is half full
+ * @param set Value set
+ * @param value Value
+ * @return 1 if the value was added, 0 if the set holds it, -1 if out of memory
+ */
+int copyValueSetAdd(CopyValueSet *set, const char *value){
+    if((set->size + 1) * 2 > set->slotCount){
+        size_t slotCount = set->slotCount * 2;
+        char **values = calloc(slotCount, sizeof(char *));
+        if(values == NULL){
+            return -1;
+        }
+        for (size_t i = 0; i < set->slotCount; ++i) {
+            if(set->values[i] != NULL){
+                size_t slot = hashKey(set->values[i]) & (slotCount - 1);
+                while (values[slot] != NULL){
+                    slot = (slot + 1) & (slotCount - 1);
+                }
+                values[slot] = set->values[i];
+            }
+        }
+        free(set->values);
+        set->values = values;
+        set->slotCount = slotCount;
+    }
+    size_t slot = hashKey(value) & (set->slotCount - 1);
+    while (set->values[slot] != NULL){
+        if(strcmp(set->values[slot], value) == 0){
+            return 0;
+        }
+        slot = (slot + 1) & (set->slotCount - 1);
+    }
+    set->values[slot] = arenaCopy(set->arena, value, strlen(value));
+    if(set->values[slot] == NULL){
+        return -1;
+    }
+    set->size++;
+    return 1;
+}
+
+/**
+ * Frees the values of a set
+ * @param set Value set
+ */
+void copyValueSetFree(CopyValueSet *set){
+    arenaFree(set->arena);
+    free(set->values);
+    set->arena = NULL;
+    set->values = NULL;
+}
@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "lexer.h"
+#include "arena.h"
+#include "utils.h"
+#include "sequence.h"
+
+#ifndef MINISQL_COPY_H
+#define MINISQL_COPY_H
+
+// Bytes of a csv file read at once, a block ends on the end of its last record and grows for a longer record
+#define COPY_BLOCK_SIZE (4 * 1024 * 1024)
+// Parts of a block per thread of the worker pool, every part is parsed by one task
+#define COPY_PARTS_PER_WORKER 4
+// Smallest part of a block, a small block is parsed by fewer tasks
+#define COPY_MIN_PART_SIZE (64 * 1024)
+
+/*
+ * Source of a column of the loaded rows, a field of the csv lines, the next id or a fixed value
+ */
+struct {
+    int field; // Field of a csv line, -1 for a column missing from the file
+    int isId; // Takes the next id, the field of the file is ignored
+    const char *value; // Value of a missing column, the result of its default function or empty
+} typedef CopyColumn;
+
+/*
+ * Lines of a block parsed by one task, as text rows and for a paged table as encoded records
+ */
+struct {
+    const char *data;
+    size_t len;
+    size_t firstLine; // Line of the file of the first line of the part
+    uint64_t firstId; // Id of the first row of the part, the first id of its block is added once it is taken
+    StringBuilder rows;
+    size_t *starts; // Offset of every row in `rows`
+    StringBuilder records;
+    size_t *recordStarts; // Offset of every record in `records`, the last entry is the end of the records
+    size_t count;
+    size_t capacity;
+    StringBuilder error;
+} typedef CopyPart;
+
+/*
+ * Reader of a csv file that parses it block by block, the lines of a block are split in parts
+ * parsed by the worker pool and the rows of the parts follow the order of the file
+ */
+struct {
+    FILE *file;
+    const char *fileName;
+    const Node *tableNode;
+    const CopyColumn *columns; // Source of every column of the table
+    size_t fieldCount; // Fields of every csv line
+    int isPaged; // The rows are encoded as records of a paged table too
+    char *block;
+    size_t blockLen;
+    size_t blockSize;
+    size_t carry; // Bytes after the last record of the block, moved to the start of the next block
+    int isEnd;
+    int isHeader; // The first line of the file holds the names of the columns
+    size_t nextLine;
+    Sequence *sequence; // Ids of the rows, NULL for a table without an id column
+    CopyPart *parts;
+    size_t partCount;
+    size_t partCapacity;
+    StringBuilder error;
+} typedef CopyReader;
+
+/*
+ * Values of a unique column loaded by a copy, kept in an open addressing table to find
+ * a value that is twice in the file
+ */
+struct {
+    Arena *arena;
+    char **values; // NULL for an empty slot
+    size_t size;
+    size_t slotCount;
+} typedef CopyValueSet;
+
+int copyReaderOpen(CopyReader *reader, const char *fileName, const Node *tableNode, const CopyColumn *columns,
+                   size_t fieldCount, int isPaged, int isHeader, Sequence *sequence);
+int copyReaderNext(CopyReader *reader);
+void copyReaderClose(CopyReader *reader);
+void copyAppendField(StringBuilder *out, const char *data, size_t len);
+int copyValueSetInit(CopyValueSet *set);
+int copyValueSetAdd(CopyValueSet *set, const char *value);
+void copyValueSetFree(CopyValueSet *set);
+
+#endif //MINISQL_COPY_H
@@ -3,12 +3,34 @@
 #include "const.h"
 #include "filesystem.h"
 #include "database.h"
+#include "btree.h"
+#include "hashindex.h"
+#include "page.h"
+#include "bufferpool.h"
+#include "wal.h"
+#include "predicate.h"
+#include "sort.h"
+#include "aggregate.h"
+#include "join.h"
+#include "workerpool.h"
+#include "statement.h"
+#include "copy.h"
+#include "sequence.h"
 #include <time.h>
+#include <ctype.h>
+#include <pthread.h>
+#include <errno.h>
+#include <stdint.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 
+// Size of the table file from which a filtered select is read by the worker pool
+static size_t parallelThreshold = PARALLEL_SCAN_DEFAULT_THRESHOLD;
+// Number of times the tables were loaded, the table nodes of a previous load are outdated
+static uint64_t catalogVersion = 0;
+
 /**
  * Identify the maximum space a column is taking while printing the table
  * @param a
@@ -38,9 +60,9 @@ size_t getMaxColSize(size_t a, size_t b){
  * @param node SQL AST Node
  * @return name of the data file
  */
-char* getTableDataFileName(Node node){
+char* getTableDataFileName(const Node *node){
     char* buffer = createBuffer();
-    insertInBuffer(&buffer, "%s/table_%s", DATA_DIR, node.table.value);
+    insertInBuffer(&buffer, "%s/table_%s", DATA_DIR, node->table.value);
     return buffer;
 }
 
@@ -51,9 +73,9 @@ char* getTableDataFileName(Node node){
  * @param node SQL AST Node
  * @return name of the data sql file
  */
-char* getTableSQLName(Node node){
+char* getTableSQLName(const Node *node){
     char* buffer = createBuffer();
-    insertInBuffer(&buffer, "%s/table_%s_sql", DATA_DIR, node.table.value);
+    insertInBuffer(&buffer, "%s/table_%s_sql", DATA_DIR, node->table.value);
     return buffer;
 }
 
@@ -64,9 +86,134 @@ char* getTableSQLName(Node node){
  * @param node SQL AST Node
  * @return name of the data file
  */
-char* getTablePkName(Node node){
+char* getTablePkName(const Node *node){
+    char* buffer = createBuffer();
+    insertInBuffer(&buffer, "%s/table_%s_pk", DATA_DIR, node->table.value);
+    return buffer;
+}
+
+/**
+ * Id sequence of a table, the ids of its rows are taken from it
+ * @param tableNode Table reference node
+ * @return Sequence or NULL if the table has no `id` column or its pk file can't be read
+ */
+static Sequence *getTableSequence(const Node *tableNode){
+    if(getColumnIndex(tableNode, "id") == -1){
+        return NULL;
+    }
+    char *pkFileName = getTablePkName(tableNode);
+    Sequence *sequence = sequenceGet(pkFileName);
+    free(pkFileName);
+    return sequence;
+}
+
+/**
+ * The number of live rows is stored to count the rows of the table without reading it,
+ * Data file's name format "DATA_DIRECTORY/table_(table_name)_count"
+ * @param node SQL AST Node
+ * @return name of the count file
+ */
+char* getTableCountName(const Node *node){
+    char* buffer = createBuffer();
+    insertInBuffer(&buffer, "%s/table_%s_count", DATA_DIR, node->table.value);
+    return buffer;
+}
+
+/**
+ * Stores the number of live rows of a table
+ * @param tableNode Table reference node
+ * @param count Number of rows
+ * @return 1 if the count is stored, 0 otherwise
+ */
+static int writeRowCount(const Node *tableNode, uint64_t count){
+    char *countName = getTableCountName(tableNode);
+    FILE *file = fopen(countName, "w");
+    free(countName);
+    if(file == NULL){
+        return 0;
+    }
+    int ok = fprintf(file, "%llu", (unsigned long long)count) > 0;
+    return fclose(file) == 0 && ok;
+}
+
+/**
+ * Reads the stored number of live rows of a table
+ * @param tableNode Table reference node
+ * @param count Number of rows
+ * @return 1 if the count is stored, 0 if the table has no count file
+ */
+static int readRowCount(const Node *tableNode, uint64_t *count){
+    char *countName = getTableCountName(tableNode);
+    FILE *file = fopen(countName, "r");
+    free(countName);
+    if(file == NULL){
+        return 0;
+    }
+    unsigned long long value;
+    int ok = fscanf(file, "%llu", &value) == 1;
+    fclose(file);
+    *count = ok ? (uint64_t)value : 0;
+    return ok;
+}
+
+/**
+ * Moves the stored row count of a table by the rows a statement committed. A table without
+ * a count file keeps none, its rows are counted the next time the count is read
+ * @param tableNode Table reference node
+ * @param delta Inserted rows, or minus the deleted rows
+ */
+static void addRowCount(const Node *tableNode, long long delta){
+    uint64_t count;
+    if(readRowCount(tableNode, &count)){
+        writeRowCount(tableNode, delta < 0 && (uint64_t)-delta > count ? 0 : count + (uint64_t)delta);
+    }
+}
+
+/**
+ * Number of live rows of a table, tables created before the count existed are counted once here
+ * @param tableNode Table reference node
+ * @param count Number of rows
+ * @return 1 if the rows are counted, 0 if the table can't be read
+ */
+int getRowCount(const Node *tableNode, uint64_t *count){
+    if(readRowCount(tableNode, count)){
+        return 1;
+    }
+    TableScan scan;
+    if(!scanOpen(&scan, tableNode, tableNode)){
+        return 0;
+    }
+    *count = 0;
+    while (scanNext(&scan)){
+        (*count)++;
+    }
+    scanClose(&scan);
+    writeRowCount(tableNode, *count);
+    return 1;
+}
+
+/**
+ * The primary key index maps the id of a row to the offset of the row in the data file,
+ * Index file's name format "DATA_DIRECTORY/table_(table_name)_idx"
+ * @param node SQL AST Node
+ * @return name of the index file
+ */
+char* getTablePkIndexName(const Node *node){
+    char* buffer = createBuffer();
+    insertInBuffer(&buffer, "%s/table_%s_idx", DATA_DIR, node->table.value);
+    return buffer;
+}
+
+/**
+ * Every unique column has a hash index from its values to the offset of their rows,
+ * Index file's name format "DATA_DIRECTORY/table_(table_name)_(column)_hash"
+ * @param node SQL AST Node
+ * @param column Name of the unique column
+ * @return name of the index file
+ */
+char* getTableUniqueIndexName(const Node *node, const char *column){
     char* buffer = createBuffer();
-    insertInBuffer(&buffer, "%s/table_%s_pk", DATA_DIR, node.table.value);
+    insertInBuffer(&buffer, "%s/table_%s_%s_hash", DATA_DIR, node->table.value, column);
     return buffer;
 }
 
@@ -88,15 +235,16 @@ char* getTableConfFileName(){
 DBOp createDBOp(){
     DBOp dbOperation;
     dbOperation.code = SUCCESS;
-    dbOperation.successMsg = createBuffer();
-    dbOperation.error = createBuffer();
-    dbOperation.result = createBuffer();
+    dbOperation.successMsg = createStringBuilder();
+    dbOperation.error = createStringBuilder();
+    dbOperation.result = createStringBuilder();
     dbOperation.action = createBuffer();
-    dbOperation.rows = malloc(sizeof(char ) * 1);
+    dbOperation.rows = malloc(sizeof(char *) * 1);
     dbOperation.rowCount = 0;
     dbOperation.maxColSpace = 5;
     dbOperation.lineCount = 0;
     dbOperation.colCount = 0;
+    dbOperation.cursor = NULL;
     return dbOperation;
 }
 
@@ -105,14 +253,12 @@ DBOp createDBOp(){
  * @param dbOp db operation object
  */
 void clearDBOp(DBOp *dbOp){
-    if(dbOp->error != NULL){
-        free(dbOp->error);
-    }
-    if(dbOp->result != NULL){
-        free(dbOp->result);
-    }
-    if(dbOp->successMsg != NULL){
-        free(dbOp->successMsg);
+    clearStringBuilder(&dbOp->error);
+    clearStringBuilder(&dbOp->result);
+    clearStringBuilder(&dbOp->successMsg);
+    if(dbOp->cursor != NULL){
+        cursorClose(dbOp->cursor);
+        dbOp->cursor = NULL;
     }
     if(dbOp->action != NULL){
         free(dbOp->action);
@@ -122,12 +268,12 @@ void clearDBOp(DBOp *dbOp){
 
 /**
  * Creates default value by a default function
- * @return Default value
+ * @return Default value, freed by the caller
  */
 char* defaultValue(Token token){
     // Default function = NOW
     // Generates current time while creation of the data
-    if(caseInsensitiveCompare(token.value, "NOW") == 0){
+    if(token.keyword == KW_NOW){
         // Allocate memory for current timestamp
         time_t now;
         struct tm *utc;
@@ -135,7 +281,7 @@ char* defaultValue(Token token){
         dateTimeStr = createBufferWithSize(sizeof(char) * 100);
         if (dateTimeStr == NULL) {
             printError("Memory allocation failed while creating timestamp.\n");
-            return "";
+            return createBuffer();
         }
         time(&now);
         // Get utc time from now time
@@ -144,18 +290,44 @@ char* defaultValue(Token token){
         if (strftime(dateTimeStr, 100, "%Y-%m-%d %H:%M:%S GMT+0", utc) == 0) {
             printError("Failed to format date-time string.\n");
             free(dateTimeStr);
-            return "";
+            return createBuffer();
         }
         return dateTimeStr;
     }
-    return "1";
+    char *value = createBuffer();
+    insertInBuffer(&value, "1");
+    return value;
+}
+
+/**
+ * Table definition as it is stored in the sql file of a table, on a single line with the runs of
+ * blanks and line breaks outside of quoted values replaced by a space
+ * @param sql Create table statement
+ * @return Definition, freed by the caller
+ */
+static char *normalizeDefinition(const char *sql){
+    StringBuilder definition = createStringBuilder();
+    int isQuoted = 0, isBlank = 0;
+    for (const char *c = sql; *c != '\0'; ++c) {
+        if(!isQuoted && isspace((unsigned char)*c)){
+            isBlank = 1;
+            continue;
+        }
+        if(isBlank && definition.len > 0){
+            appendRawToBuilder(&definition, " ", 1);
+        }
+        isBlank = 0;
+        isQuoted = *c == '\'' ? !isQuoted : isQuoted;
+        appendRawToBuilder(&definition, c, 1);
+    }
+    return detachStringBuilder(&definition);
 }
 
 /**
  * Creates a table
  * @return DBOp
  */
-DBOp dbCreateTable(Node sqlNode){
+DBOp dbCreateTable(const Node *sqlNode){
 
     DBOp dbOperation = createDBOp();
     FILE *tableFile = NULL, *tableSqlFile = NULL, *tableConfig = NULL;
@@ -165,13 +337,13 @@ DBOp dbCreateTable(Node sqlNode){
     tableConfig = fopen(tableConfStr, "a");
     char *pKeyFile;
     if(fileExists(tableFullName) || fileExists(tableSql)){
-        insertInBuffer(&dbOperation.error, "Table `%s` already exists", sqlNode.table.value);
+        appendToBuilder(&dbOperation.error, "Table `%s` already exists", sqlNode->table.value);
         dbOperation.code = FAIL;
         return dbOperation;
     }
     if(dbOperation.code == SUCCESS){
         if(tableConfig == NULL){
-            insertInBuffer(&dbOperation.error, "Database Corrupted", sqlNode.table.value);
+            appendToBuilder(&dbOperation.error, "Database Corrupted", sqlNode->table.value);
             dbOperation.code = INTERNAL_ERROR;
             return dbOperation;
         }
@@ -185,8 +357,8 @@ DBOp dbCreateTable(Node sqlNode){
         tableFile = fopen(tableFullName, "a");
         tableSqlFile = fopen(tableSql, "a+");
         if(tableFile != NULL && tableSqlFile != NULL){
-            for (int i = 0; i < sqlNode.colsLen; ++i) {
-                if(caseInsensitiveCompare(sqlNode.columns[i].columnToken.value, "id") == 0){
+            for (int i = 0; i < sqlNode->colsLen; ++i) {
+                if(caseInsensitiveCompare(sqlNode->columns[i].columnToken.value, "id") == 0){
                     pKeyFile = getTablePkName(sqlNode);
                     FILE *file = fopen(pKeyFile, "w");
                     fprintf(file, "1");
@@ -194,13 +366,19 @@ DBOp dbCreateTable(Node sqlNode){
                     free(pKeyFile);
                 }
             }
-            fprintf(tableSqlFile, "%s", sqlNode.sql);
+            char *definition = normalizeDefinition(sqlNode->sql);
+            fprintf(tableSqlFile, "%s", definition != NULL ? definition : sqlNode->sql);
+            free(definition);
             fclose(tableSqlFile);
             fclose(tableFile);
-            insertInBuffer(&dbOperation.successMsg, "Created table `%s`", sqlNode.table.value);
+            if(sqlNode->storage == STORAGE_PAGE){
+                pageFileClose(pageFileCreate(tableFullName));
+            }
+            rebuildIndexes(sqlNode);
+            appendToBuilder(&dbOperation.successMsg, "Created table `%s`", sqlNode->table.value);
         }
         else{
-            insertInBuffer(&dbOperation.error, "Error creating table, table data is corrupted\n");
+            appendToBuilder(&dbOperation.error, "Error creating table, table data is corrupted\n");
             dbOperation.code = INTERNAL_ERROR;
         }
     }
@@ -211,7 +389,7 @@ DBOp dbCreateTable(Node sqlNode){
 }
 
 
-int getColumnIndex(Node* node, char* column){
+int getColumnIndex(const Node *node, const char *column){
     for (int i = 0; i < node->colsLen ; i++) {
         if(caseInsensitiveCompare(node->columns[i].columnToken.value, column) == 0){
             return i;
@@ -220,7 +398,7 @@ int getColumnIndex(Node* node, char* column){
     return -1;
 }
 
-int getFilterIndex(Node* node, char* column){
+int getFilterIndex(const Node *node, const char *column){
     for (int i = 0; i < node->filtersLen ; i++) {
         if(caseInsensitiveCompare(node->filters[i].columnToken.value, column) == 0){
             return i;
@@ -230,734 +408,3678 @@ int getFilterIndex(Node* node, char* column){
 }
 
 
-int matchColumnValue(char* table, size_t colIdx, char* str){
-    FILE *file;
-    file = fopen(table, "r");
-    char *line = NULL;
-    size_t len = 0;
-    if (file == NULL) {
-        printError("Database Table `%s` corrupted", table);
-        return -1;
-    }
-    int lineCount = 0;
-    while (getLine(&line, &len, file) != -1) {
-        int start = 0;
-        int i = 0;
-        size_t commas = 0;
-        while (1){
-            if(line[i] == ','){
-                commas++;
-                if(commas == colIdx + 2){
-                    char value[i - start + 1];
-                    strncpy(value, line + start, i - start);
-                    value[i - start] = '\0';
-                    if(strcmp(value, str) == 0){
-                        return 1;
-                    }
-                    else{
-                        break;
-                    }
-                }
-                else{
-                    start = i + 1;
-                }
-            }
-            i++;
-        }
-        lineCount++;
-    }
-    free(line);
-    fclose(file);
-    return 0;
+/**
+ * Splits a stored row into its column values in a single pass, rows are stored as `1,col_0,col_1,...`
+ * and a comma inside a value is escaped as `\,`, the delimiters are found by the SIMD scanner
+ * @param line Stored row
+ * @param fields Column values, they point into the row
+ * @param capacity Number of columns to split, the rest of the row is not read
+ * @return Number of columns found
+ */
+size_t splitRow(const char *line, FieldSlice *fields, size_t capacity){
+    return simdSplitRow(line, strlen(line), fields, capacity);
 }
 
 
-NodeList loadTables(){
-    FILE *file;
-    NodeList nodeList = emptyNodeList();
-    const char* tableConf[] = {DATA_DIR, "/", ".table"};
-    char* tableConfStr = concatStrings(tableConf, 3);
-    file = fopen(tableConfStr, "r");
-    char *line = NULL;
-    size_t len = 0;
-    if (file == NULL) {
-        printError("Database corrupted");
-        return nodeList;
+/**
+ * Orders (id, offset) pairs by id
+ */
+static int comparePkEntries(const void *a, const void *b){
+    uint64_t x = ((const uint64_t *)a)[0];
+    uint64_t y = ((const uint64_t *)b)[0];
+    return x < y ? -1 : x > y;
+}
+
+/**
+ * Rebuilds every index of a table, the primary key B+tree and the hash index
+ * of each unique column, with a single pass over the data file
+ * @param tableNode Table reference node
+ * @return 1 if the indexes were built, 0 otherwise
+ */
+int rebuildIndexes(const Node *tableNode){
+    int pkIdx = getColumnIndex(tableNode, "id");
+    int uniqueCount = 0;
+    int uniqueCols[tableNode->colsLen + 1];
+    for (int i = 0; i < tableNode->colsLen; ++i) {
+        if(tableNode->columns[i].isUnique == 1){
+            uniqueCols[uniqueCount++] = i;
+        }
     }
-    size_t size = 0;
-    while ((getLine(&line, &len, file)) != -1) {
-        size_t s_len = strlen(line);
-        line[s_len-1] = '\0';
-        FILE *sqlFile = fopen(line, "r");
-        size_t internalLen = 0;
-        if(sqlFile != NULL){
+    if(pkIdx == -1 && uniqueCount == 0){
+        // The rows are counted again when the count is read
+        char *countName = getTableCountName(tableNode);
+        remove(countName);
+        free(countName);
+        return 0;
+    }
+    TableScan scan;
+    int isOpen = scanOpen(&scan, tableNode, tableNode);
+    size_t size = 0, pkSize = 0, capacity = 64;
+    uint64_t *pkEntries = malloc(sizeof(uint64_t) * 2 * capacity);
+    uint64_t *offsets = malloc(sizeof(uint64_t) * capacity);
+    uint64_t *hashes[uniqueCount + 1];
+    int ok = pkEntries != NULL && offsets != NULL;
+    for (int u = 0; u < uniqueCount; ++u) {
+        hashes[u] = malloc(sizeof(uint64_t) * capacity);
+        ok = ok && hashes[u] != NULL;
+    }
+    int isSorted = 1;
+    if(isOpen && ok){
+        while (ok && scanNext(&scan)){
+            if(size == capacity){
+                capacity *= 2;
+                uint64_t *temp = realloc(pkEntries, sizeof(uint64_t) * 2 * capacity);
+                ok = temp != NULL;
+                pkEntries = ok ? temp : pkEntries;
+                temp = ok ? realloc(offsets, sizeof(uint64_t) * capacity) : NULL;
+                ok = temp != NULL;
+                offsets = ok ? temp : offsets;
+                for (int u = 0; ok && u < uniqueCount; ++u) {
+                    temp = realloc(hashes[u], sizeof(uint64_t) * capacity);
+                    ok = temp != NULL;
+                    hashes[u] = ok ? temp : hashes[u];
+                }
+                if(!ok){
+                    break;
+                }
+            }
+            char *value = pkIdx != -1 ? scanValue(&scan, pkIdx) : NULL;
+            if(value != NULL){
+                pkEntries[pkSize * 2] = strtoull(value, NULL, 10);
+                pkEntries[pkSize * 2 + 1] = scan.location;
+                if(pkSize > 0 && pkEntries[pkSize * 2] < pkEntries[pkSize * 2 - 2]){
+                    isSorted = 0;
+                }
+                pkSize++;
+            }
+            free(value);
+            for (int u = 0; u < uniqueCount; ++u) {
+                value = scanValue(&scan, uniqueCols[u]);
+                hashes[u][size] = hashKey(value != NULL ? value : "");
+                free(value);
+            }
+            offsets[size] = scan.location;
             size++;
-            char *sql = NULL;
-            getLine(&sql, &internalLen, sqlFile);
-            TokenRet tokenRet = lexAnalyze(sql);
-            Node node = createASTNode(tokenRet);
-            Node *newNode = malloc(sizeof(node) * 1);
-            *newNode = node;
-            insertInNodeList(&nodeList, newNode);
-            free(sql);
         }
     }
-    nodeList.size = size;
-    free(line);
-    fclose(file);
-    return nodeList;
-}
-
-DBOp createDbOpWithHeader(Node sqlNode, Node tableNode){
-    DBOp header = createDBOp();
-    Node sNode = sqlNode;
-    if(sqlNode.isAllCol || isInsertKeyword(sqlNode.action.value)){
-        sNode = tableNode;
+    if(isOpen){
+        scanClose(&scan);
     }
-
-    int i = 0;
-    for (; i < sNode.colsLen; ++i) {
-        int col_idx = getColumnIndex(&tableNode, sNode.columns[i].columnToken.value);
-        if(col_idx == -1){
-            printError(
-                    "Invalid column `%s`, column `%s` doesn't exist in table",
-                    sNode.columns[i].columnToken.value,
-                    sNode.columns[i].columnToken.value,
-                    sNode.table.value
-            );
-            clearBuffer(&header.error);
-            header.code = FAIL;
-            return header;
+    // The count follows the rows of the table file, a count lost in a crash is restored by the checkpoint of recovery
+    if(isOpen && ok){
+        ok = writeRowCount(tableNode, size);
+    }
+    if(ok && pkIdx != -1){
+        if(!isSorted){
+            qsort(pkEntries, pkSize, sizeof(uint64_t) * 2, comparePkEntries);
         }
-        else if(col_idx < COL_MAX_SIZE){
-            header.maxColSpace = getMaxColSize(header.maxColSpace, strlen(tableNode.columns[col_idx].columnToken.value));
-            insertInBuffer(&header.result, "%s", tableNode.columns[col_idx].columnToken.value);
+        uint64_t *keys = malloc(sizeof(uint64_t) * (pkSize + 1));
+        uint64_t *values = malloc(sizeof(uint64_t) * (pkSize + 1));
+        ok = keys != NULL && values != NULL;
+        for (size_t i = 0; ok && i < pkSize; ++i) {
+            keys[i] = pkEntries[i * 2];
+            values[i] = pkEntries[i * 2 + 1];
         }
-        if(i != sNode.colsLen - 1){
-            insertInBuffer(&header.result, ",");
+        if(ok){
+            char *indexName = getTablePkIndexName(tableNode);
+            ok = btreeBulkLoad(indexName, keys, values, pkSize);
+            free(indexName);
         }
-        else{
-            insertInBuffer(&header.result, "\n");
+        free(keys);
+        free(values);
+    }
+    for (int u = 0; u < uniqueCount; ++u) {
+        if(ok){
+            char *indexName = getTableUniqueIndexName(tableNode, tableNode->columns[uniqueCols[u]].columnToken.value);
+            ok = hashIndexBuild(indexName, hashes[u], offsets, size);
+            free(indexName);
         }
+        free(hashes[u]);
     }
-    header.lineCount = 1;
-    header.colCount = i;
-    header.action = createBufferWithSize(strlen(sNode.action.value));
-    insertInBuffer(&header.action, "%s", sqlNode.action.value);
-    return header;
+    free(pkEntries);
+    free(offsets);
+    return ok;
 }
 
-
-
-
-size_t getPkFromPkFile(FILE *pkFile){
-    if(pkFile != NULL){
-        size_t _id;
-        char buffer[64];
-        if (fgets(buffer, sizeof(buffer), pkFile) != NULL) {
-            char *endPointer;
-            long int temp_id = strtol(buffer, &endPointer, 10);
-            if (*endPointer == '\0' || *endPointer == '\n') {
-                _id = (size_t)temp_id;
-                return _id;
-            } else {
-                printError("Invalid pk file, pk file is corrupted\n");
-                fprintf(stderr, "Conversion error occurred\n");
-            }
-        } else {
-            printError("Invalid pk file, pk file is corrupted\n");
-            fprintf(stderr, "Read error occurred\n");
-        }
+/**
+ * Opens the primary key index of a table, tables created before the index existed get it built here
+ * @param tableNode Table reference node
+ * @return B+tree of the index or NULL if the table has no `id` column
+ */
+BTree *openPkIndex(const Node *tableNode){
+    if(getColumnIndex(tableNode, "id") == -1){
+        return NULL;
     }
-    return -1;
+    char *indexName = getTablePkIndexName(tableNode);
+    if(!fileExists(indexName)){
+        rebuildIndexes(tableNode);
+    }
+    BTree *tree = btreeOpen(indexName);
+    free(indexName);
+    return tree;
 }
 
-
-int deleteLine(const char *filename, const size_t *lines, size_t size) {
-    FILE *file;
-    char *buffer, *newBuffer;
-    long length;
-    size_t line_count = 1;
-    size_t current_line = 0;
-    char *cursor, *next_line;
-    file = fopen(filename, "r");
-    if (file == NULL) {
-        printError("Unable to open file for deletion");
-        return -1;
+/**
+ * Opens the hash index of a unique column, built from the data file if it doesn't exist yet
+ * @param tableNode Table reference node
+ * @param colIdx Index of the column in the table
+ * @return Hash index or NULL if the column is not unique
+ */
+HashIndex *openUniqueIndex(const Node *tableNode, int colIdx){
+    if(colIdx < 0 || colIdx >= tableNode->colsLen || tableNode->columns[colIdx].isUnique != 1){
+        return NULL;
     }
-
-    fseek(file, 0, SEEK_END);
-    length = ftell(file);
-    rewind(file);
-
-    buffer = (char *)malloc(length + 1);
-    if (buffer == NULL) {
-        printError("Error allocating memory");
-        fclose(file);
-        return -1;
+    char *indexName = getTableUniqueIndexName(tableNode, tableNode->columns[colIdx].columnToken.value);
+    if(!fileExists(indexName)){
+        rebuildIndexes(tableNode);
     }
+    HashIndex *index = hashIndexOpen(indexName);
+    free(indexName);
+    return index;
+}
 
-    fread(buffer, length, 1, file);
-    fclose(file);
-    buffer[length] = '\0';
-
-    newBuffer = (char *)malloc(length + 1);
-    if (newBuffer == NULL) {
-        printError("Error allocating memory for new buffer");
-        free(buffer);
-        return -1;
-    }
+/**
+ * Reports a value already stored in a unique column, inserts, updates and copies give the same error
+ * @param error Error of the operation
+ * @param tableNode Table reference node
+ * @param colIdx Index of the unique column in the table
+ * @param value Duplicate value
+ */
+static void appendUniqueError(StringBuilder *error, const Node *tableNode, int colIdx, const char *value){
+    appendToBuilder(error, "Duplicate value `%s` violates unique constraint on column `%s` for table `%s`",
+                    value, tableNode->columns[colIdx].columnToken.value, tableNode->table.value);
+}
 
-    cursor = buffer;
-    next_line = NULL;
-    size_t newBufferIdx = 0;
-    while (line_count <= lines[size - 1] && *cursor != '\0') {
-        if (current_line < size && line_count == lines[current_line]) {
-            next_line = strchr(cursor, '\n');
-            if (next_line != NULL) {
-                cursor = next_line + 1;
-            } else {
-                cursor = cursor + strlen(cursor);
-            }
-            current_line++;
-        } else {
-            next_line = strchr(cursor, '\n');
-            size_t line_length = (next_line != NULL) ? (size_t)(next_line - cursor) + 1 : strlen(cursor);
-            memcpy(newBuffer + newBufferIdx, cursor, line_length);
-            newBufferIdx += line_length;
-            cursor += line_length;
+/**
+ * Checks if a value is stored in a column, looked up in the column's hash index when it has one
+ * @param scan Opened scan of the table, read on from its current row when the column has no index
+ * @param index Hash index of the column, NULL to read every row
+ * @param colIdx Index of the column in the table
+ * @param str Value to look for
+ * @return 1 if the value exists, 0 if it doesn't
+ */
+static int findColumnValue(TableScan *scan, HashIndex *index, int colIdx, const char *str){
+    int match = 0;
+    const char *value;
+    size_t valueLen, strLen = strlen(str);
+    if(index != NULL){
+        HashCursor cursor = hashIndexFind(index, str);
+        uint64_t location;
+        while (match == 0 && hashIndexNext(&cursor, &location)) {
+            match = scanFetch(scan, location) && scanField(scan, colIdx, &value, &valueLen) &&
+                    valueLen == strLen && memcmp(value, str, strLen) == 0;
         }
-        line_count++;
     }
-    if (*cursor != '\0') {
-        strcpy(newBuffer + newBufferIdx, cursor);
+    else{
+        while (match == 0 && scanNext(scan)) {
+            match = scanField(scan, colIdx, &value, &valueLen) && valueLen == strLen && memcmp(value, str, strLen) == 0;
+        }
     }
-    file = fopen(filename, "w");
-    if (file == NULL) {
-        perror("Error opening file");
-        free(buffer);
-        free(newBuffer);
+    return match;
+}
+
+/**
+ * Checks if a value is already stored in a unique column, looked up in the column's hash index
+ * @param tableNode Table reference node
+ * @param colIdx Index of the column in the table
+ * @param str Value to look for
+ * @return 1 if the value exists, 0 if it doesn't, -1 if the table can't be read
+ */
+int matchColumnValue(const Node *tableNode, int colIdx, const char *str){
+    TableScan scan;
+    if(!scanOpen(&scan, tableNode, tableNode)){
+        char *tableName = getTableDataFileName(tableNode);
+        printError("Database Table `%s` corrupted", tableName);
+        free(tableName);
         return -1;
     }
-    fwrite(newBuffer, strlen(newBuffer), 1, file);
-    fclose(file);
-    free(buffer);
-    free(newBuffer);
-    return 0;
+    HashIndex *index = openUniqueIndex(tableNode, colIdx);
+    int match = findColumnValue(&scan, index, colIdx, str);
+    hashIndexClose(index);
+    scanClose(&scan);
+    return match;
 }
 
+/**
+ * Finds an equality filter on a unique column that can be answered by the column's hash index
+ * @param sqlNode SQL AST Node
+ * @param tableNode Table reference node
+ * @param colIdx Index of the column in the table
+ * @return Index of the filter or -1 if there is none
+ */
+int getUniqueFilter(const Node *sqlNode, const Node *tableNode, int *colIdx){
+    int found = -1;
+    for (int fil = 0; fil < sqlNode->filtersLen; ++fil) {
+        const Column *filter = &sqlNode->filters[fil];
+        if(fil < sqlNode->filtersLen - 1 && filter->nextLogicalOp.keyword != KW_AND){
+            return -1;
+        }
+        int idx = getColumnIndex(tableNode, filter->columnToken.value);
+        if(found == -1 && idx != -1 && tableNode->columns[idx].isUnique == 1 && strcmp(filter->symbol.value, "=") == 0 &&
+           (filter->valueToken.type == TOKEN_STRING || filter->valueToken.type == TOKEN_NUMBER)){
+            found = fil;
+            *colIdx = idx;
+        }
+    }
+    return found;
+}
 
-int filterValue(Column filter, const char* value){
-    int shouldInsertInRow = 1;
-    removeSingleQuotes(filter.valueToken.value);
-    if(filter.valueToken.type == TOKEN_NUMBER && isNumber(value)){
-        size_t val = strToLongInt(value);
-        size_t cmpVal = strToLongInt(filter.valueToken.value);
-        if(strcmp(filter.symbol.value, "<") == 0){
-            if(val < cmpVal){
-                shouldInsertInRow = 1;
-            }
-            else{
-                shouldInsertInRow = 0;
-            }
+/**
+ * Resolves the range of ids a where clause is limited to, the index can only drive the scan
+ * when every filter is joined with AND, the other filters are checked on the fetched rows
+ * @param sqlNode SQL AST Node
+ * @param tableNode Table reference node
+ * @param low First id of the range
+ * @param high Last id of the range
+ * @return 1 if the filters restrict the id, 0 if the table needs a full scan
+ */
+int getPkRange(const Node *sqlNode, const Node *tableNode, uint64_t *low, uint64_t *high){
+    if(sqlNode->filtersLen == 0 || getColumnIndex(tableNode, "id") == -1){
+        return 0;
+    }
+    int found = 0;
+    *low = 0;
+    *high = UINT64_MAX;
+    for (int fil = 0; fil < sqlNode->filtersLen; ++fil) {
+        const Column *filter = &sqlNode->filters[fil];
+        if(fil < sqlNode->filtersLen - 1 && filter->nextLogicalOp.keyword != KW_AND){
+            return 0;
         }
-        else if(strcmp(filter.symbol.value, ">") == 0){
-            if(val > cmpVal){
-                shouldInsertInRow = 1;
-            }
-            else{
-                shouldInsertInRow = 0;
-            }
+        if(caseInsensitiveCompare(filter->columnToken.value, "id") != 0 || filter->valueToken.type != TOKEN_NUMBER){
+            continue;
         }
-        else if(strcmp(filter.symbol.value, ">=") == 0){
-            if(val >= cmpVal){
-                shouldInsertInRow = 1;
+        long long value = strtoll(filter->valueToken.value, NULL, 10);
+        uint64_t val = value < 0 ? 0 : (uint64_t)value;
+        const char *op = filter->symbol.value;
+        if(strcmp(op, "=") == 0){
+            if(value < 0){
+                *low = 1;
+                *high = 0;
             }
             else{
-                shouldInsertInRow = 0;
+                *low = max(*low, val);
+                *high = *high < val ? *high : val;
             }
         }
-        else if(strcmp(filter.symbol.value, "<=") == 0){
-            if(val <= cmpVal){
-                shouldInsertInRow = 1;
-            }
-            else{
-                shouldInsertInRow = 0;
-            }
+        else if(strcmp(op, ">") == 0){
+            *low = value < 0 ? *low : max(*low, val + 1);
         }
-        else if(strcmp(filter.symbol.value, "!=") == 0){
-            if(val != cmpVal){
-                shouldInsertInRow = 1;
+        else if(strcmp(op, ">=") == 0){
+            *low = max(*low, val);
+        }
+        else if(strcmp(op, "<") == 0){
+            if(value <= 0){
+                *low = 1;
+                *high = 0;
             }
-            else{
-                shouldInsertInRow = 0;
+            else if(val - 1 < *high){
+                *high = val - 1;
             }
         }
-        else if(strcmp(filter.symbol.value, "=") == 0){
-            if(val == cmpVal){
-                shouldInsertInRow = 1;
+        else if(strcmp(op, "<=") == 0){
+            if(value < 0){
+                *low = 1;
+                *high = 0;
             }
-            else{
-                shouldInsertInRow = 0;
+            else if(val < *high){
+                *high = val;
             }
         }
         else{
-            shouldInsertInRow = 0;
+            continue;
         }
+        found = 1;
     }
-    else if(strcmp(filter.valueToken.value, value) != 0){
-        shouldInsertInRow = 0;
-    }
-    return shouldInsertInRow;
+    return found;
 }
 
-DBOp dbUpdate(Node sqlNode, Node tableNode){
-    Node sNode = sqlNode;
-    if(sqlNode.isAllCol){
-        sNode = tableNode;
+/**
+ * If the id range of the primary key index is all the where clause checks, every row the index
+ * points to in the range matches and rows can be skipped in the index without reading them
+ * @param sqlNode SQL AST Node
+ * @return 1 if every filter compares `id` to a number and they are joined with AND, 0 otherwise
+ */
+static int isPkRangeExact(const Node *sqlNode){
+    for (int fil = 0; fil < sqlNode->filtersLen; ++fil) {
+        const Column *filter = &sqlNode->filters[fil];
+        const char *op = filter->symbol.value;
+        if((fil < sqlNode->filtersLen - 1 && filter->nextLogicalOp.keyword != KW_AND) ||
+           caseInsensitiveCompare(filter->columnToken.value, "id") != 0 || filter->valueToken.type != TOKEN_NUMBER ||
+           op == NULL || strchr(filter->valueToken.value, '.') != NULL ||
+           (strcmp(op, "=") != 0 && strcmp(op, "<") != 0 && strcmp(op, "<=") != 0 && strcmp(op, ">") != 0 && strcmp(op, ">=") != 0)){
+            return 0;
+        }
     }
-    DBOp dbOp = createDbOpWithHeader(sqlNode, tableNode);
+    return 1;
+}
 
-    size_t upCount = 0;
-    char *tableName = getTableDataFileName(sqlNode);
-    char* tBuffer = createBuffer();
-    FILE *tableFile = fopen(tableName, "r+");
-    char **rows = malloc(sizeof(char ) * 1);
-    size_t rowCount = 0;
-    if(tableFile != NULL){
-        char *line = NULL;
-        char *write = NULL;
-        int toWrite = 0;
-        size_t len = 0;
-        int lineCount = 0;
-        while (getLine(&line, &len, tableFile) != -1){
-            lineCount++;
-            int shouldInsertInRow = 1;
-            for (int fil = 0; fil < sNode.filtersLen; ++fil) {
-                Column filter = sNode.filters[fil];
-                int colIdx = getColumnIndex(&tableNode, sNode.filters[fil].columnToken.value);
-                size_t start = 0;
-                size_t i = 0;
-                size_t commas = 0;
-                while (1){
-                    if((i>0 && line[i] == ',' && line[i-1] != '\\') || line[i] == '\n'){
-                        commas++;
-                        if(colIdx == commas - 2){
-                            char *value = createBufferWithSize(i - start);
-                            strncpy(value, line + start, i - start);
-                            value[i - start] = '\0';
-                            removeSingleQuotes(filter.valueToken.value);
-                            shouldInsertInRow = filterValue(filter, value);
-                            clearBuffer(&value);
-                            break;
-                        }
-                        else{
-                            start = i + 1;
-                        }
-                    }
-                    i++;
-                }
-                if(shouldInsertInRow == 0){
-                    break;
-                }
-            }
-            if(shouldInsertInRow == 1){
-                upCount++;
-                for (int col = 0; col < sNode.colsLen; ++col) {
-                    Column column = sNode.columns[col];
-                    int colIdx = getColumnIndex(&tableNode, column.columnToken.value);
-                    size_t iStart = 0;
-                    size_t j = 0;
-                    size_t commas = 0;
-                    while (1){
-                        if((j>0 && line[j] == ',' && line[j-1] != '\\') || line[j] == '\n'){
-                            commas++;
-                            if(colIdx == commas - 2){
-                                int match = 0;
-                                if(tableNode.columns[colIdx].isUnique == 1){
-                                    match = matchColumnValue(tableName, colIdx, column.valueToken.value);
-                                }
-                                if(match == 0 && upCount < 2){
-                                    removeSingleQuotes(column.valueToken.value);
-                                    write = replaceString(line, iStart, j-1, column.valueToken.value);
-                                    toWrite = 1;
-                                    break;
-                                }
-                                else{
-                                    dbOp.code = FAIL;
-                                    insertInBuffer(&dbOp.error, "Duplicate value `%s` for column `%s` violates unique constraint", column.valueToken.value, column.columnToken.value);
-                                    free(tableName);
-                                    free(tBuffer);
-                                    free(line);
-                                    return dbOp;
-                                }
-                            }
-
-                            else{
-                                iStart = j + 1;
-                            }
-                        }
-                        j++;
-                    }
-                }
-                rows[rowCount] = createBuffer();
-                if(toWrite == 1){
-                    insertInBuffer(&rows[rowCount], write);
-                }
-                else{
-                    insertInBuffer(&rows[rowCount], line);
-                }
-                rowCount++;
-                char **tempRow = realloc(rows, sizeof(char) * rowCount);
-                if(tempRow != NULL){
-                    rows = tempRow;
-                }
-                else{
-                    dbOp.code = FAIL;
-                    insertInBuffer(&dbOp.error, "MEM Failed");
-                    free(tableName);
-                    free(tBuffer);
-                    free(line);
-                    return dbOp;
-                }
+/**
+ * Opens the table file of a scan of every row
+ * @param scan Scan to initialize
+ * @param tableNode Table reference node
+ * @return 1 if the table file was opened, 0 otherwise
+ */
+static int scanOpenFile(TableScan *scan, const Node *tableNode){
+    char *tableName = getTableDataFileName(tableNode);
+    memset(scan, 0, sizeof(TableScan));
+    scan->pageFile = pageFileOpen(tableName);
+    scan->fileId = scan->pageFile != NULL ? scan->pageFile->fileId : bufferPoolOpen(tableName);
+    free(tableName);
+    if(scan->fileId == -1){
+        return 0;
+    }
+    scan->walTable = walGetTable(tableNode->table.value);
+    scan->fieldCapacity = tableNode->colsLen > 0 ? (size_t)tableNode->colsLen : 1;
+    scan->fields = malloc(sizeof(FieldSlice) * scan->fieldCapacity);
+    scan->numbers = scan->pageFile != NULL ? malloc(SCAN_NUMBER_SIZE * scan->fieldCapacity) : NULL;
+    if(scan->fields == NULL || (scan->pageFile != NULL && scan->numbers == NULL)){
+        scanClose(scan);
+        return 0;
+    }
+    // Page 0 is the file header
+    scan->rangeStart = 1;
+    scan->rangeEnd = UINT64_MAX;
+    return 1;
+}
 
+/**
+ * Opens the row source of a statement, filters on `id` are served by the primary key index
+ * and equality filters on a unique column by the column's hash index
+ * @param scan Scan to initialize
+ * @param sqlNode SQL AST Node
+ * @param tableNode Table reference node
+ * @return 1 if the table file was opened, 0 otherwise
+ */
+int scanOpen(TableScan *scan, const Node *sqlNode, const Node *tableNode){
+    uint64_t low, high;
+    int colIdx;
+    if(!scanOpenFile(scan, tableNode)){
+        return 0;
+    }
+    int isPkRange = getPkRange(sqlNode, tableNode, &low, &high);
+    // Rows before the OFFSET of a select without filters are skipped in the primary key index
+    if(!isPkRange && sqlNode->offset > 0 && sqlNode->filtersLen == 0 && sqlNode->orderLen == 0 &&
+       !sqlNode->isAggregate && sqlNode->groupLen == 0 && getColumnIndex(tableNode, "id") != -1){
+        low = 0;
+        high = UINT64_MAX;
+        isPkRange = 1;
+    }
+    if(isPkRange){
+        scan->index = openPkIndex(tableNode);
+        if(scan->index != NULL){
+            scan->cursor = btreeSeek(scan->index, low);
+            scan->high = high;
+            if(low > high){
+                scan->cursor.isValid = 0;
             }
-            if(toWrite == 1){
-                insertInBuffer(&tBuffer, "%s", write);
-                clearBuffer(&write);
-                toWrite = 0;
-            }
-            else{
-                insertInBuffer(&tBuffer, "%s", line);
-            }
-
+            return 1;
         }
-        fclose(tableFile);
-        dbOp.lineCount += lineCount;
     }
-    dbOp.rows = rows;
-    dbOp.rowCount = rowCount;
-    FILE *writeFile = fopen(tableName, "w");
-    if(writeFile != NULL){
-        fprintf(writeFile, "%s", tBuffer);
+    int fil = getUniqueFilter(sqlNode, tableNode, &colIdx);
+    if(fil != -1){
+        scan->hashIndex = openUniqueIndex(tableNode, colIdx);
+        if(scan->hashIndex != NULL){
+            char *value = createBuffer();
+            insertInBuffer(&value, "%s", sqlNode->filters[fil].valueToken.value);
+            removeSingleQuotes(value);
+            scan->hashCursor = hashIndexFind(scan->hashIndex, value);
+            free(value);
+        }
     }
-    fclose(writeFile);
-    clearBuffer(&tBuffer);
-    insertInBuffer(&dbOp.successMsg, "Updated `%zd` rows in table %s", upCount, sNode.table.value);
-    free(tableName);
-    return dbOp;
+    return 1;
 }
 
-
-DBOp dbSelect(Node sqlNode, Node tableNode){
-    Node sNode = sqlNode;
-    if(sqlNode.isAllCol){
+/**
+ * Keeps a single page of the table pinned in the buffer pool for the scan
+ * @param scan Opened scan
+ * @param pageNo Page number
+ * @return 1 if the page is pinned, 0 otherwise
+ */
+static int scanPinPage(TableScan *scan, uint64_t pageNo){
+    if(scan->page != NULL && scan->pageNo == pageNo){
+        return 1;
+    }
+    bufferPoolUnpin(scan->page, 0);
+    if(scan->pageFile != NULL){
+        scan->page = pagePin(scan->pageFile, pageNo);
+        scan->pageLength = PAGE_SIZE;
+    }
+    else{
+        scan->page = bufferPoolPin(scan->fileId, pageNo, &scan->pageLength);
+    }
+    scan->pageNo = pageNo;
+    return scan->page != NULL;
+}
+
+/**
+ * Copies the text row starting at an offset from the pages of the table
+ * @param scan Scan of a text table
+ * @param offset Byte offset of the row
+ * @return 1 if a row was read, 0 at the end of the file
+ */
+static int scanReadLine(TableScan *scan, uint64_t offset){
+    size_t len = 0;
+    scan->location = offset;
+    while(scanPinPage(scan, offset / PAGE_SIZE)){
+        size_t start = offset % PAGE_SIZE;
+        if(start >= scan->pageLength){
+            break;
+        }
+        const char *data = scan->page + start;
+        const char *newLine = simdFindNewLine(data, scan->pageLength - start);
+        size_t chunk = newLine != NULL ? (size_t)(newLine - data) + 1 : scan->pageLength - start;
+        if(len + chunk + 1 > scan->lineSize){
+            size_t size = scan->lineSize == 0 ? 128 : scan->lineSize;
+            while(size < len + chunk + 1){
+                size *= 2;
+            }
+            char *temp = realloc(scan->line, size);
+            if(temp == NULL){
+                return 0;
+            }
+            scan->line = temp;
+            scan->lineSize = size;
+        }
+        memcpy(scan->line + len, data, chunk);
+        len += chunk;
+        offset += chunk;
+        if(newLine != NULL || scan->pageLength < PAGE_SIZE){
+            break;
+        }
+    }
+    if(len == 0){
+        return 0;
+    }
+    scan->line[len] = '\0';
+    scan->lineLength = len;
+    scan->offset = offset;
+    return 1;
+}
+
+/**
+ * Opens a scan of the rows of a range of a table, used by the tasks of a parallel scan.
+ * A text row belongs to the range its first byte is in
+ * @param scan Scan to initialize
+ * @param tableNode Table reference node
+ * @param start First byte offset of a text table or first page of a paged table
+ * @param end End of the range, excluded
+ * @return 1 if the table file was opened, 0 otherwise
+ */
+int scanOpenRange(TableScan *scan, const Node *tableNode, uint64_t start, uint64_t end){
+    if(!scanOpenFile(scan, tableNode)){
+        return 0;
+    }
+    scan->rangeEnd = end;
+    if(scan->pageFile != NULL){
+        scan->rangeStart = start > 1 ? start : 1;
+    }
+    // The row ending in the range started in the previous range, the scan starts after it
+    else if(start > 0 && !scanReadLine(scan, start - 1)){
+        scan->offset = end;
+    }
+    return 1;
+}
+
+/**
+ * Applies the logged change of the current row of a scan, rows marked as deleted are skipped
+ * @param scan Scan positioned on a row
+ * @return 0 if the row was deleted, 1 otherwise
+ */
+static int scanApplyLog(TableScan *scan){
+    scan->overlay = NULL;
+    scan->isSplit = 0;
+    if(scan->pageFile == NULL && scan->line[0] == '0'){
+        // Deleted text row, its space is reclaimed by VACUUM
+        scan->deadRows++;
+        return 0;
+    }
+    const WalChange *change = scan->isRaw ? NULL : walFind(scan->walTable, scan->location);
+    if(change == NULL){
+        return 1;
+    }
+    scan->overlay = change->newRow;
+    return change->newRow != NULL;
+}
+
+/**
+ * Makes the row at a location the current row of a scan
+ * @param scan Opened scan
+ * @param location Byte offset of a text row or page location of a record
+ * @return 1 if there is a row at the location, 0 otherwise
+ */
+int scanFetch(TableScan *scan, uint64_t location){
+    if(scan->pageFile == NULL){
+        return scanReadLine(scan, location) && scanApplyLog(scan);
+    }
+    scan->location = location;
+    if(!scanPinPage(scan, PAGE_LOCATION_PAGE(location))){
+        return 0;
+    }
+    uint16_t len;
+    scan->record = pageGetRecord(scan->page, PAGE_LOCATION_SLOT(location), &len);
+    return scan->record != NULL && scanApplyLog(scan);
+}
+
+/**
+ * Moves a scan to its next candidate row
+ * @param scan Opened scan
+ * @return 1 if the scan is on a row, 0 at the end of the scan
+ */
+int scanNext(TableScan *scan){
+    uint64_t key, value;
+    if(scan->hashIndex != NULL){
+        while(hashIndexNext(&scan->hashCursor, &value)){
+            if(scanFetch(scan, value)){
+                return 1;
+            }
+        }
+        return 0;
+    }
+    if(scan->index != NULL){
+        while(btreeNext(&scan->cursor, &key, &value)){
+            if(key > scan->high){
+                break;
+            }
+            if(scanFetch(scan, value)){
+                return 1;
+            }
+        }
+        scan->cursor.isValid = 0;
+        return 0;
+    }
+    if(scan->pageFile == NULL){
+        while(scan->offset < scan->rangeEnd && scanReadLine(scan, scan->offset)){
+            if(scanApplyLog(scan)){
+                return 1;
+            }
+        }
+        return 0;
+    }
+    uint32_t slot = scan->pageNo == 0 ? 0 : scan->slot + 1;
+    uint64_t pageNo = scan->pageNo == 0 ? scan->rangeStart : scan->pageNo;
+    while(pageNo < scan->pageFile->pageCount && pageNo < scan->rangeEnd){
+        if(!scanPinPage(scan, pageNo)){
+            return 0;
+        }
+        for (; slot < pageSlotCount(scan->page); ++slot) {
+            uint16_t len;
+            scan->record = pageGetRecord(scan->page, slot, &len);
+            if(scan->record != NULL){
+                scan->slot = slot;
+                scan->location = PAGE_LOCATION(pageNo, slot);
+                if(scanApplyLog(scan)){
+                    return 1;
+                }
+            }
+        }
+        pageNo++;
+        slot = 0;
+    }
+    return 0;
+}
+
+/**
+ * Column value of the current row of a scan without copying it, a text row is split once
+ * and its columns are then read with one lookup
+ * @param scan Scan positioned on a row
+ * @param colIdx Index of the column in the table
+ * @param data Start of the value, valid until the scan moves to another row
+ * @param len Length of the value
+ * @return 1 if the row has the column, 0 otherwise
+ */
+int scanField(TableScan *scan, int colIdx, const char **data, size_t *len){
+    if(colIdx < 0){
+        return 0;
+    }
+    if(scan->pageFile == NULL || scan->overlay != NULL){
+        if(!scan->isSplit){
+            const char *line = scan->overlay != NULL ? scan->overlay : scan->line;
+            size_t length = scan->overlay != NULL ? strlen(scan->overlay) : scan->lineLength;
+            scan->fieldCount = simdSplitRow(line, length, scan->fields, scan->fieldCapacity);
+            scan->isSplit = 1;
+        }
+        if((size_t)colIdx >= scan->fieldCount){
+            return 0;
+        }
+        *data = scan->fields[colIdx].data;
+        *len = scan->fields[colIdx].len;
+        return 1;
+    }
+    if(colIdx >= recordFieldCount(scan->record) || (size_t)colIdx >= scan->fieldCapacity){
+        return 0;
+    }
+    if(recordField(scan->record, colIdx, data, len) == FIELD_INT){
+        char *number = scan->numbers + (size_t)colIdx * SCAN_NUMBER_SIZE;
+        *len = (size_t)snprintf(number, SCAN_NUMBER_SIZE, "%lld", (long long)recordInt(*data));
+        *data = number;
+    }
+    return 1;
+}
+
+/**
+ * Copies a column value of the current row of a scan
+ * @param scan Scan positioned on a row
+ * @param colIdx Index of the column in the table
+ * @return Column value, NULL if the row doesn't have the column
+ */
+char *scanValue(TableScan *scan, int colIdx){
+    const char *data;
+    size_t len;
+    if(!scanField(scan, colIdx, &data, &len)){
+        return NULL;
+    }
+    char *value = createBufferWithSize(len);
+    memcpy(value, data, len);
+    value[len] = '\0';
+    return value;
+}
+
+/**
+ * Current row of a scan in the text row format `1,col_0,col_1,...\n`
+ * @param scan Scan positioned on a row
+ * @return Row text
+ */
+char *scanRowText(TableScan *scan){
+    if(scan->pageFile == NULL || scan->overlay != NULL){
+        char *row = strdup(scan->overlay != NULL ? scan->overlay : scan->line);
+        if(row == NULL){
+            perror("Memory allocation failed for row");
+            exit(EXIT_FAILURE);
+        }
+        return row;
+    }
+    StringBuilder row = createStringBuilder();
+    appendRawToBuilder(&row, "1", 1);
+    int count = recordFieldCount(scan->record);
+    for (int i = 0; i < count; ++i) {
+        const char *data;
+        size_t len;
+        scanField(scan, i, &data, &len);
+        appendRawToBuilder(&row, ",", 1);
+        appendRawToBuilder(&row, data, len);
+    }
+    appendRawToBuilder(&row, "\n", 1);
+    return detachStringBuilder(&row);
+}
+
+/**
+ * Closes the table file and the index of a scan
+ * @param scan Opened scan
+ */
+void scanClose(TableScan *scan){
+    bufferPoolUnpin(scan->page, 0);
+    scan->page = NULL;
+    if(scan->pageFile != NULL){
+        pageFileClose(scan->pageFile);
+        scan->pageFile = NULL;
+    }
+    else if(scan->fileId != -1){
+        bufferPoolClose(scan->fileId);
+    }
+    scan->fileId = -1;
+    free(scan->line);
+    scan->line = NULL;
+    free(scan->fields);
+    free(scan->numbers);
+    scan->fields = NULL;
+    if(scan->index != NULL){
+        btreeClose(scan->index);
+        scan->index = NULL;
+    }
+    if(scan->hashIndex != NULL){
+        hashIndexClose(scan->hashIndex);
+        scan->hashIndex = NULL;
+    }
+}
+
+/*
+ * Morsel of a parallel scan, a fixed size piece of the table file read by one task. Its rows
+ * are scanned, filtered and passed to the operator of the scan on the same thread
+ */
+struct {
+    uint64_t start;
+    uint64_t end;
+    uint64_t *matches; // Locations of the matching rows in table order
+    size_t size;
+    size_t capacity;
+    size_t rowCount; // Rows read
+    int isFailed;
+} typedef Morsel;
+
+/*
+ * Aggregation of the morsels read by a thread of a parallel scan
+ */
+struct {
+    Aggregator aggregator;
+    FieldSlice *fields; // Group columns then arguments of the aggregates of the current row
+    int isFailed;
+} typedef PartialAggregate;
+
+/*
+ * Scan of every row of a table in morsels run by the worker pool, the threads take their morsels
+ * in table order and steal the morsels of the others once they run out. The matching rows of a
+ * batch of morsels are read back in table order before the next batch is run, an aggregation
+ * reads the whole table in one run with an aggregator per thread
+ */
+struct {
+    const Node *tableNode;
+    const Predicate *predicate;
+    TableScan *scan; // Scan the matching rows are read back with
+    uint64_t first; // First byte of a text table or first page of a paged table
+    uint64_t size; // Bytes of a text table or pages of a paged table
+    uint64_t morselSize;
+    uint64_t nextStart; // Start of the next batch
+    Morsel *morsels;
+    size_t morselCapacity; // Morsels of a batch
+    size_t morselCount;
+    size_t current; // Morsel being read back
+    size_t next; // Next match of the current morsel
+    size_t rowCount; // Rows of the morsels read back
+    PartialAggregate *partials; // Aggregation of every thread
+    const int *groupCols;
+    const int *argCols;
+    int isFailed;
+} typedef ParallelScan;
+
+/**
+ * Sets the size of the table file from which a filtered select is read by the worker pool
+ * @param size Bytes, 0 to read every filtered table in parallel
+ */
+void scanSetParallelThreshold(size_t size){
+    parallelThreshold = size;
+}
+
+/**
+ * Prepares the parallel scan of a filtered scan of every row when the table is large enough,
+ * the worker pool has more than one thread and the buffer pool can pin a page for every thread
+ * @param parallel Parallel scan to initialize
+ * @param scan Opened scan, reads back the matching rows
+ * @param predicate Compiled where clause
+ * @param tableNode Table reference node
+ * @return 1 if the table is read in parallel, 0 otherwise
+ */
+static int parallelScanOpen(ParallelScan *parallel, TableScan *scan, const Predicate *predicate, const Node *tableNode){
+    memset(parallel, 0, sizeof(ParallelScan));
+    size_t workerCount = workerPoolSize();
+    if(workerCount < 2 || predicate->size == 0 || scan->index != NULL || scan->hashIndex != NULL ||
+       bufferPoolGetStats().frameCount < workerCount * 4){
+        return 0;
+    }
+    uint64_t unit = 1;
+    if(scan->pageFile != NULL){
+        parallel->first = 1;
+        parallel->size = scan->pageFile->pageCount;
+        unit = PAGE_SIZE;
+    }
+    else{
+        char *tableName = getTableDataFileName(tableNode);
+        long fileSize = getFileSize(tableName);
+        free(tableName);
+        parallel->size = fileSize > 0 ? (uint64_t)fileSize : 0;
+    }
+    if(parallel->size <= parallel->first || parallel->size * unit < parallelThreshold){
+        return 0;
+    }
+    parallel->morselCapacity = workerCount * PARALLEL_SCAN_BATCH_MORSELS;
+    parallel->morsels = calloc(parallel->morselCapacity, sizeof(Morsel));
+    if(parallel->morsels == NULL){
+        return 0;
+    }
+    parallel->tableNode = tableNode;
+    parallel->predicate = predicate;
+    parallel->scan = scan;
+    parallel->morselSize = PARALLEL_SCAN_MORSEL_SIZE / unit;
+    parallel->nextStart = parallel->first;
+    return 1;
+}
+
+/**
+ * Finds the rows of a morsel matching the where clause, run by the worker pool
+ * @param arg Parallel scan
+ * @param worker Thread
+ * @param index Morsel of the current batch
+ */
+static void matchMorselTask(void *arg, size_t worker, size_t index){
+    ParallelScan *parallel = arg;
+    Morsel *morsel = &parallel->morsels[index];
+    TableScan scan;
+    (void)worker;
+    morsel->size = 0;
+    morsel->rowCount = 0;
+    morsel->isFailed = !scanOpenRange(&scan, parallel->tableNode, morsel->start, morsel->end);
+    if(morsel->isFailed){
+        return;
+    }
+    while (scanNext(&scan)){
+        morsel->rowCount++;
+        if(!predicateMatch(parallel->predicate, &scan)){
+            continue;
+        }
+        if(morsel->size == morsel->capacity){
+            size_t capacity = morsel->capacity == 0 ? 256 : morsel->capacity * 2;
+            uint64_t *temp = realloc(morsel->matches, sizeof(uint64_t) * capacity);
+            if(temp == NULL){
+                morsel->isFailed = 1;
+                break;
+            }
+            morsel->matches = temp;
+            morsel->capacity = capacity;
+        }
+        morsel->matches[morsel->size++] = scan.location;
+    }
+    scanClose(&scan);
+}
+
+/**
+ * Moves the scan of a parallel scan to its next matching row, the next batch of morsels
+ * is run by the worker pool once every match of the current batch is read back
+ * @param parallel Parallel scan
+ * @return 1 if the scan is on a row, 0 once every row is read or if a morsel couldn't be read
+ */
+static int parallelScanNext(ParallelScan *parallel){
+    while (!parallel->isFailed){
+        for (; parallel->current < parallel->morselCount; ++parallel->current, parallel->next = 0) {
+            Morsel *morsel = &parallel->morsels[parallel->current];
+            if(morsel->isFailed){
+                printError("Unable to read the rows of table `%s`", parallel->tableNode->table.value);
+                parallel->isFailed = 1;
+                return 0;
+            }
+            if(parallel->next == 0){
+                parallel->rowCount += morsel->rowCount;
+            }
+            while (parallel->next < morsel->size){
+                if(scanFetch(parallel->scan, morsel->matches[parallel->next++])){
+                    return 1;
+                }
+            }
+        }
+        if(parallel->nextStart >= parallel->size){
+            return 0;
+        }
+        parallel->morselCount = 0;
+        while (parallel->morselCount < parallel->morselCapacity && parallel->nextStart < parallel->size){
+            Morsel *morsel = &parallel->morsels[parallel->morselCount++];
+            morsel->start = parallel->nextStart;
+            morsel->end = parallel->size - morsel->start > parallel->morselSize ? morsel->start + parallel->morselSize : parallel->size;
+            parallel->nextStart = morsel->end;
+        }
+        parallel->current = 0;
+        parallel->next = 0;
+        workerPoolRun(matchMorselTask, parallel, parallel->morselCount);
+    }
+    return 0;
+}
+
+/**
+ * Aggregates the matching rows of a morsel in the aggregator of the thread, run by the worker pool
+ * @param arg Parallel scan
+ * @param worker Thread
+ * @param index Morsel of the table
+ */
+static void aggregateMorselTask(void *arg, size_t worker, size_t index){
+    ParallelScan *parallel = arg;
+    PartialAggregate *partial = &parallel->partials[worker];
+    Aggregator *aggregator = &partial->aggregator;
+    uint64_t start = parallel->first + index * parallel->morselSize;
+    uint64_t end = parallel->size - start > parallel->morselSize ? start + parallel->morselSize : parallel->size;
+    TableScan scan;
+    if(partial->isFailed || !scanOpenRange(&scan, parallel->tableNode, start, end)){
+        partial->isFailed = 1;
+        return;
+    }
+    size_t fieldCount = aggregator->groupCount + aggregator->specCount;
+    while (scanNext(&scan)){
+        if(!predicateMatch(parallel->predicate, &scan)){
+            continue;
+        }
+        for (size_t f = 0; f < fieldCount; ++f) {
+            int colIdx = f < aggregator->groupCount ? parallel->groupCols[f] : parallel->argCols[f - aggregator->groupCount];
+            if(colIdx == -1 || !scanField(&scan, colIdx, &partial->fields[f].data, &partial->fields[f].len)){
+                partial->fields[f].data = "";
+                partial->fields[f].len = 0;
+            }
+        }
+        if(!aggregatorAdd(aggregator, partial->fields)){
+            partial->isFailed = 1;
+            break;
+        }
+    }
+    scanClose(&scan);
+}
+
+/**
+ * Aggregates the matching rows of a table in one run of the worker pool, every thread aggregates
+ * its morsels in its own aggregator with a share of the memory budget and the groups of the threads
+ * are merged once the table is read
+ * @param parallel Parallel scan
+ * @param aggregator Initialized aggregator, the groups of the threads are merged in it
+ * @param groupCols Table column of every group column
+ * @param argCols Table column of the argument of every aggregate, -1 for COUNT(*)
+ * @return 1 if the rows are aggregated, 0 on memory or io error
+ */
+static int parallelAggregate(ParallelScan *parallel, Aggregator *aggregator, const int *groupCols, const int *argCols){
+    size_t workerCount = workerPoolSize();
+    size_t fieldCount = aggregator->groupCount + aggregator->specCount;
+    parallel->partials = calloc(workerCount, sizeof(PartialAggregate));
+    if(parallel->partials == NULL){
+        return 0;
+    }
+    for (size_t w = 0; w < workerCount; ++w) {
+        PartialAggregate *partial = &parallel->partials[w];
+        aggregatorInit(&partial->aggregator, aggregator->groupCount, aggregator->specs, aggregator->specCount);
+        partial->aggregator.budget /= workerCount;
+        partial->fields = malloc(sizeof(FieldSlice) * (fieldCount + 1));
+        partial->isFailed = partial->fields == NULL;
+    }
+    parallel->groupCols = groupCols;
+    parallel->argCols = argCols;
+    workerPoolRun(aggregateMorselTask, parallel, (parallel->size - parallel->first + parallel->morselSize - 1) / parallel->morselSize);
+    int ok = 1;
+    for (size_t w = 0; w < workerCount; ++w) {
+        PartialAggregate *partial = &parallel->partials[w];
+        ok = ok && !partial->isFailed && aggregatorFinish(&partial->aggregator);
+        const AggregateGroup *group;
+        while (ok && (group = aggregatorNext(&partial->aggregator)) != NULL){
+            ok = aggregatorMerge(aggregator, group, partial->aggregator.groupValues);
+        }
+        aggregatorFree(&partial->aggregator);
+        free(partial->fields);
+    }
+    free(parallel->partials);
+    parallel->partials = NULL;
+    return ok;
+}
+
+/**
+ * Frees the morsels of a parallel scan
+ * @param parallel Parallel scan
+ */
+static void parallelScanFree(ParallelScan *parallel){
+    for (size_t i = 0; i < parallel->morselCapacity; ++i) {
+        free(parallel->morsels[i].matches);
+    }
+    free(parallel->morsels);
+    parallel->morsels = NULL;
+    parallel->morselCapacity = 0;
+}
+
+/**
+ * Moves a scan to its next row matching a where clause, the rows are found by the worker pool
+ * when the table is read by a parallel scan
+ * @param scan Opened scan
+ * @param predicate Compiled where clause
+ * @param parallel Parallel scan of the table, NULL to read the rows on this thread
+ * @param rowCount Rows read so far, can be NULL
+ * @return 1 if the scan is on a matching row, 0 once every row is read
+ */
+static int scanNextMatch(TableScan *scan, const Predicate *predicate, ParallelScan *parallel, size_t *rowCount){
+    if(parallel != NULL){
+        int isRow = parallelScanNext(parallel);
+        if(rowCount != NULL){
+            *rowCount = parallel->rowCount;
+        }
+        return isRow;
+    }
+    while (scanNext(scan)){
+        if(rowCount != NULL){
+            (*rowCount)++;
+        }
+        if(predicateMatch(predicate, scan)){
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Encodes a text row as a paged table record, integer columns are stored as 8 byte integers
+ * @param tableNode Table reference node
+ * @param line Row in the text row format
+ * @param out Output buffer
+ * @param size Size of the output buffer
+ * @return Length of the record or 0 if it doesn't fit
+ */
+size_t encodeRowLine(const Node *tableNode, const char *line, char *out, size_t size){
+    int count = tableNode->colsLen;
+    FieldType types[count + 1];
+    const char *values[count + 1];
+    size_t lens[count + 1];
+    int64_t integers[count + 1];
+    FieldSlice fields[count + 1];
+    size_t fieldCount = splitRow(line, fields, (size_t)count);
+    for (int i = 0; i < count; ++i) {
+        size_t len = (size_t)i < fieldCount ? fields[i].len : 0;
+        if(len == 0){
+            types[i] = FIELD_NULL;
+            values[i] = line;
+            lens[i] = 0;
+            continue;
+        }
+        types[i] = FIELD_TEXT;
+        values[i] = fields[i].data;
+        lens[i] = len;
+        KeywordId dataType = tableNode->columns[i].dataTypeToken.keyword;
+        if(dataType == KW_INTEGER || dataType == KW_INT || dataType == KW_SERIAL){
+            char number[len + 1];
+            char *end;
+            memcpy(number, fields[i].data, len);
+            number[len] = '\0';
+            errno = 0;
+            long long integer = strtoll(number, &end, 10);
+            if(*end == '\0' && errno == 0){
+                integers[i] = integer;
+                types[i] = FIELD_INT;
+                values[i] = (const char *)&integers[i];
+                lens[i] = sizeof(int64_t);
+            }
+        }
+    }
+    return recordEncode(out, size, types, values, lens, count);
+}
+
+/**
+ * Stores new rows at the end of a table, the rows of a text table are written with a single write
+ * and the records of a paged table are appended to its last pages. When a row can't be stored the
+ * rows already appended are removed, the table is left as it was
+ * @param tableNode Table reference node
+ * @param rows Rows in the text row format, one after the other
+ * @param len Length of the rows
+ * @param starts Offset of every row in `rows`
+ * @param count Number of rows
+ * @param locations Location of every stored row
+ * @return 1 if every row is stored, 0 otherwise
+ */
+int appendRows(const Node *tableNode, const char *rows, size_t len, const size_t *starts, size_t count, uint64_t *locations){
+    char *tableName = getTableDataFileName(tableNode);
+    int ok = 0;
+    PageFile *pageFile = pageFileOpen(tableName);
+    if(pageFile != NULL){
+        char record[PAGE_SIZE];
+        ok = 1;
+        // A row too large for a page fails the batch before any row is appended
+        for (size_t i = 0; ok && count > 1 && i < count; ++i) {
+            ok = encodeRowLine(tableNode, rows + starts[i], record, sizeof(record)) > 0;
+        }
+        size_t appended = 0;
+        for (; ok && appended < count; ++appended) {
+            size_t recordLen = encodeRowLine(tableNode, rows + starts[appended], record, sizeof(record));
+            locations[appended] = recordLen > 0 ? pageFileAppend(pageFile, record, (uint16_t)recordLen) : PAGE_NO_LOCATION;
+            ok = locations[appended] != PAGE_NO_LOCATION;
+        }
+        for (size_t i = 0; !ok && i + 1 < appended; ++i) {
+            pageFileRemove(pageFile, locations[i]);
+        }
+        pageFileClose(pageFile);
+    }
+    else{
+        FILE *file = fopen(tableName, "ab");
+        uint64_t start = 0;
+        if(file != NULL){
+            fseek(file, 0, SEEK_END);
+            start = (uint64_t)ftell(file);
+            ok = fwrite(rows, 1, len, file) == len && fflush(file) == 0;
+            if(!ok){
+                truncateFile(file, (long)start);
+            }
+            ok = fclose(file) == 0 && ok;
+            // Only the last page of the file and the pages after it changed
+            bufferPoolInvalidate(tableName, start / PAGE_SIZE);
+        }
+        for (size_t i = 0; ok && i < count; ++i) {
+            locations[i] = start + starts[i];
+        }
+    }
+    free(tableName);
+    return ok;
+}
+
+/**
+ * Finds the locations `appendRows` gives new rows without storing them, so the rows can be
+ * logged before they are written
+ * @param tableNode Table reference node
+ * @param rows Rows in the text row format, one after the other
+ * @param starts Offset of every row in `rows`
+ * @param count Number of rows
+ * @param locations Location of every row
+ * @return 1 if every row has a location, 0 otherwise
+ */
+int planRows(const Node *tableNode, const char *rows, const size_t *starts, size_t count, uint64_t *locations){
+    char *tableName = getTableDataFileName(tableNode);
+    int ok = 1;
+    PageFile *pageFile = pageFileOpen(tableName);
+    if(pageFile != NULL){
+        PageAppendPlan *plan = malloc(sizeof(PageAppendPlan));
+        char record[PAGE_SIZE];
+        ok = plan != NULL;
+        if(ok){
+            pageFilePlanStart(pageFile, plan);
+        }
+        for (size_t i = 0; ok && i < count; ++i) {
+            size_t recordLen = encodeRowLine(tableNode, rows + starts[i], record, sizeof(record));
+            locations[i] = recordLen > 0 ? pageFilePlanAppend(pageFile, plan, record, (uint16_t)recordLen) : PAGE_NO_LOCATION;
+            ok = locations[i] != PAGE_NO_LOCATION;
+        }
+        free(plan);
+        pageFileClose(pageFile);
+    }
+    else{
+        // A missing file is created by the append
+        long size = getFileSize(tableName);
+        uint64_t start = size > 0 ? (uint64_t)size : 0;
+        for (size_t i = 0; i < count; ++i) {
+            locations[i] = start + starts[i];
+        }
+    }
+    free(tableName);
+    return ok;
+}
+
+/**
+ * Stores a new row at the end of a table
+ * @param tableNode Table reference node
+ * @param line Row in the text row format
+ * @return Location of the row or PAGE_NO_LOCATION if it couldn't be stored
+ */
+uint64_t appendRow(const Node *tableNode, const char *line){
+    size_t start = 0;
+    uint64_t location;
+    return appendRows(tableNode, line, strlen(line), &start, 1, &location) ? location : PAGE_NO_LOCATION;
+}
+
+/**
+ * Replaces or removes rows of a table, text tables are rewritten when a row changes and
+ * paged tables are changed in place, removed rows of both are only marked in place
+ * @param tableNode Table reference node
+ * @param locations Location of every row
+ * @param lines New content of every row, a NULL row or a NULL array removes the rows
+ * @param size Number of rows
+ * @return 0 if the rows were changed, -1 otherwise
+ */
+int replaceRows(const Node *tableNode, const uint64_t *locations, char **lines, size_t size){
+    char *tableName = getTableDataFileName(tableNode);
+    PageFile *pageFile = pageFileOpen(tableName);
+    int result = 0;
+    if(pageFile != NULL){
+        char record[PAGE_SIZE];
+        for (size_t i = 0; i < size && result == 0; ++i) {
+            if(lines == NULL || lines[i] == NULL){
+                result = pageFileRemove(pageFile, locations[i]) ? 0 : -1;
+                continue;
+            }
+            size_t len = encodeRowLine(tableNode, lines[i], record, sizeof(record));
+            if(len == 0 || pageFileReplace(pageFile, locations[i], record, (uint16_t)len) == PAGE_NO_LOCATION){
+                result = -1;
+            }
+        }
+        pageFileClose(pageFile);
+    }
+    else{
+        // Removed rows are marked in place, only changed rows need the file to be rewritten
+        long *deleted = malloc(sizeof(long) * (size + 1));
+        long *offsets = malloc(sizeof(long) * (size + 1));
+        char **changed = malloc(sizeof(char *) * (size + 1));
+        size_t deleteCount = 0, changeCount = 0;
+        if(deleted != NULL && offsets != NULL && changed != NULL){
+            uint64_t firstPage = UINT64_MAX;
+            for (size_t i = 0; i < size; ++i) {
+                if(lines == NULL || lines[i] == NULL){
+                    deleted[deleteCount++] = (long)locations[i];
+                    firstPage = locations[i] / PAGE_SIZE < firstPage ? locations[i] / PAGE_SIZE : firstPage;
+                }
+                else{
+                    offsets[changeCount] = (long)locations[i];
+                    changed[changeCount++] = lines[i];
+                }
+            }
+            result = deleteCount > 0 ? deleteLine(tableName, deleted, deleteCount) : 0;
+            if(result == 0 && changeCount > 0){
+                result = replaceLines(tableName, offsets, changed, changeCount);
+                firstPage = 0;
+            }
+            bufferPoolInvalidate(tableName, firstPage);
+        }
+        else{
+            result = -1;
+        }
+        free(deleted);
+        free(offsets);
+        free(changed);
+    }
+    free(tableName);
+    return result;
+}
+
+/**
+ * Version of the catalog, it changes every time the tables are loaded again
+ * @return Version of the table nodes returned by the last `loadTables`
+ */
+uint64_t dbCatalogVersion(){
+    return catalogVersion;
+}
+
+NodeList loadTables(){
+    FILE *file;
+    NodeList nodeList = emptyNodeList();
+    const char* tableConf[] = {DATA_DIR, "/", ".table"};
+    char* tableConfStr = concatStrings(tableConf, 3);
+    file = fopen(tableConfStr, "r");
+    char *line = NULL;
+    size_t len = 0;
+    if (file == NULL) {
+        printError("Database corrupted");
+        return nodeList;
+    }
+    size_t size = 0;
+    while ((getLine(&line, &len, file)) != -1) {
+        size_t s_len = strlen(line);
+        line[s_len-1] = '\0';
+        FILE *sqlFile = fopen(line, "r");
+        if(sqlFile == NULL){
+            printError("Table definition `%s` couldn't be opened", line);
+            continue;
+        }
+        // Older definitions were stored as typed and can span several lines
+        StringBuilder sql = createStringBuilder();
+        char *sqlLine = NULL;
+        size_t sqlLen = 0, read;
+        while((read = getLine(&sqlLine, &sqlLen, sqlFile)) != (size_t)-1){
+            appendRawToBuilder(&sql, sqlLine, read);
+        }
+        free(sqlLine);
+        fclose(sqlFile);
+        TokenRet tokenRet = lexAnalyze(sql.data);
+        // The node and its tokens stay in the arena of the statement while the table is loaded
+        Node *node = createASTNode(&tokenRet);
+        if(node->isInvalid == 0){
+            insertInNodeList(&nodeList, node);
+            size++;
+        }
+        else{
+            printError("Table definition `%s` couldn't be parsed", line);
+            freeTokenRet(&tokenRet);
+        }
+        clearStringBuilder(&sql);
+    }
+    nodeList.size = size;
+    free(line);
+    fclose(file);
+    catalogVersion++;
+    return nodeList;
+}
+
+DBOp createDbOpWithHeader(const Node *sqlNode, const Node *tableNode){
+    DBOp header = createDBOp();
+    const Node *sNode = sqlNode;
+    if(sqlNode->isAllCol || sqlNode->action.keyword == KW_INSERT){
+        sNode = tableNode;
+    }
+
+    int i = 0;
+    for (; i < sNode->colsLen; ++i) {
+        // Aggregates are named after their function and argument, `count(*)`
+        if(sNode->columns[i].aggregate != AGG_NONE){
+            const char *name = aggregateName(sNode->columns[i].aggregate);
+            const char *arg = sNode->columns[i].columnToken.value;
+            header.maxColSpace = getMaxColSize(header.maxColSpace, strlen(name) + strlen(arg) + 2);
+            appendToBuilder(&header.result, "%s(%s)", name, arg);
+            appendToBuilder(&header.result, i != sNode->colsLen - 1 ? "," : "\n");
+            continue;
+        }
+        int col_idx = getColumnIndex(tableNode, sNode->columns[i].columnToken.value);
+        if(col_idx == -1){
+            printError(
+                    "Invalid column `%s`, column `%s` doesn't exist in table",
+                    sNode->columns[i].columnToken.value,
+                    sNode->columns[i].columnToken.value,
+                    sNode->table.value
+            );
+            resetStringBuilder(&header.error);
+            header.code = FAIL;
+            return header;
+        }
+        else{
+            header.maxColSpace = getMaxColSize(header.maxColSpace, strlen(tableNode->columns[col_idx].columnToken.value));
+            appendToBuilder(&header.result, "%s", tableNode->columns[col_idx].columnToken.value);
+        }
+        if(i != sNode->colsLen - 1){
+            appendToBuilder(&header.result, ",");
+        }
+        else{
+            appendToBuilder(&header.result, "\n");
+        }
+    }
+    header.lineCount = 1;
+    header.colCount = i;
+    header.action = createBufferWithSize(strlen(sNode->action.value));
+    insertInBuffer(&header.action, "%s", sqlNode->action.value);
+    return header;
+}
+
+
+/*
+ * Row of a table file being replaced by `replaceLines`
+ */
+struct {
+    long offset;
+    char *line;
+} typedef LineEdit;
+
+static int compareLineEdits(const void *a, const void *b){
+    long x = ((const LineEdit *)a)->offset;
+    long y = ((const LineEdit *)b)->offset;
+    return x < y ? -1 : x > y;
+}
+
+/**
+ * Rewrites a table file, replacing the rows that start at the given offsets
+ * @param filename Table file name
+ * @param offsets Offset of each replaced row
+ * @param lines New content of each row, NULL removes the row
+ * @param size Number of rows
+ * @return 0 if the file was rewritten, -1 otherwise
+ */
+int replaceLines(const char *filename, const long *offsets, char **lines, size_t size) {
+    FILE *file;
+    char *buffer;
+    long length;
+    file = fopen(filename, "r");
+    if (file == NULL) {
+        printError("Unable to open file for rewrite");
+        return -1;
+    }
+
+    fseek(file, 0, SEEK_END);
+    length = ftell(file);
+    rewind(file);
+
+    buffer = (char *)malloc(length + 1);
+    LineEdit *edits = malloc(sizeof(LineEdit) * (size + 1));
+    if (buffer == NULL || edits == NULL) {
+        printError("Error allocating memory");
+        free(buffer);
+        free(edits);
+        fclose(file);
+        return -1;
+    }
+
+    length = (long)fread(buffer, 1, length, file);
+    fclose(file);
+    buffer[length] = '\0';
+    for (size_t i = 0; i < size; ++i) {
+        edits[i].offset = offsets[i];
+        edits[i].line = lines != NULL ? lines[i] : NULL;
+    }
+    qsort(edits, size, sizeof(LineEdit), compareLineEdits);
+
+    // The new file replaces the table file once complete, a crash leaves one of them intact
+    char *tempName = createBuffer();
+    insertInBuffer(&tempName, "%s.tmp", filename);
+    file = fopen(tempName, "w");
+    if (file == NULL) {
+        perror("Error opening file");
+        free(tempName);
+        free(buffer);
+        free(edits);
+        return -1;
+    }
+    long cursor = 0;
+    for (size_t i = 0; i < size; ++i) {
+        if (edits[i].offset < cursor || edits[i].offset >= length) {
+            continue;
+        }
+        fwrite(buffer + cursor, 1, edits[i].offset - cursor, file);
+        char *next_line = strchr(buffer + edits[i].offset, '\n');
+        cursor = next_line != NULL ? (long)(next_line - buffer) + 1 : length;
+        if (edits[i].line != NULL) {
+            fputs(edits[i].line, file);
+        }
+    }
+    fwrite(buffer + cursor, 1, length - cursor, file);
+    int isSynced = syncFile(file);
+    fclose(file);
+    free(buffer);
+    free(edits);
+    if (!isSynced || replaceFile(tempName, filename) != 0) {
+        remove(tempName);
+        free(tempName);
+        return -1;
+    }
+    free(tempName);
+    return 0;
+}
+
+/**
+ * Adds the new values of updated rows to the indexes, the rows keep their locations until the next
+ * checkpoint so the old entries of unique columns are left in place and filtered out on lookup
+ * @param tableNode Table reference node
+ * @param sNode SQL AST Node with the updated columns
+ * @param locations Locations of the rows
+ * @param oldRows Rows before the update
+ * @param rows Rows after the update
+ * @param size Number of rows
+ */
+static void updateIndexes(const Node *tableNode, const Node *sNode, const uint64_t *locations, char **oldRows, char **rows, size_t size){
+    for (int col = 0; col < sNode->colsLen; ++col) {
+        int colIdx = getColumnIndex(tableNode, sNode->columns[col].columnToken.value);
+        if(colIdx == -1){
+            continue;
+        }
+        int isPk = strcmp(tableNode->columns[colIdx].columnToken.value, "id") == 0;
+        BTree *tree = isPk ? openPkIndex(tableNode) : NULL;
+        HashIndex *index = openUniqueIndex(tableNode, colIdx);
+        for (size_t r = 0; r < size && (tree != NULL || index != NULL); ++r) {
+            char *oldValue = getRowValue(oldRows, r, colIdx, size);
+            char *value = getRowValue(rows, r, colIdx, size);
+            if(oldValue != NULL && value != NULL && strcmp(oldValue, value) != 0){
+                if(tree != NULL){
+                    btreeDelete(tree, strtoull(oldValue, NULL, 10));
+                    btreeInsert(tree, strtoull(value, NULL, 10), locations[r]);
+                }
+                if(index != NULL){
+                    hashIndexInsert(index, value, locations[r]);
+                }
+            }
+            free(oldValue);
+            free(value);
+        }
+        if(tree != NULL){
+            btreeClose(tree);
+        }
+        if(index != NULL){
+            hashIndexClose(index);
+        }
+    }
+}
+
+/**
+ * Marks rows of a table file as deleted in place, the leading `1,` of a row becomes `0,`
+ * and the space of the row is reclaimed by VACUUM
+ * @param filename Table file name
+ * @param offsets Offset of each removed row
+ * @param size Number of rows
+ * @return 0 if the rows were removed, -1 otherwise
+ */
+int deleteLine(const char *filename, const long *offsets, size_t size) {
+    FILE *file = fopen(filename, "r+b");
+    if (file == NULL) {
+        printError("Unable to open file for delete");
+        return -1;
+    }
+    int result = 0;
+    for (size_t i = 0; i < size && result == 0; ++i) {
+        if (fseek(file, offsets[i], SEEK_SET) != 0) {
+            result = -1;
+        }
+        // A row already marked is left as is, the delete can be applied again after a crash
+        else if (fgetc(file) == '1' && (fseek(file, offsets[i], SEEK_SET) != 0 || fputc('0', file) == EOF)) {
+            result = -1;
+        }
+    }
+    if (fclose(file) != 0) {
+        result = -1;
+    }
+    return result;
+}
+
+
+DBOp dbUpdate(const Node *sqlNode, const Node *tableNode){
+    const Node *sNode = sqlNode;
+    if(sqlNode->isAllCol){
+        sNode = tableNode;
+    }
+    DBOp dbOp = createDbOpWithHeader(sqlNode, tableNode);
+
+    size_t upCount = 0;
+    TableScan scan;
+    char **rows = malloc(sizeof(char *) * 1);
+    char **oldRows = malloc(sizeof(char *) * 1);
+    uint64_t *locations = malloc(sizeof(uint64_t) * 1);
+    size_t rowCount = 0;
+    Predicate predicate;
+    // Assigned column of every table column, -1 for the columns kept as they are
+    int *setCols = malloc(sizeof(int) * (tableNode->colsLen > 0 ? tableNode->colsLen : 1));
+    if(setCols == NULL || !predicateCompile(&predicate, sqlNode, tableNode)){
+        dbOp.code = FAIL;
+        appendToBuilder(&dbOp.error, "MEM Failed");
+        free(setCols);
+        free(rows);
+        free(oldRows);
+        free(locations);
+        return dbOp;
+    }
+    for (int i = 0; i < tableNode->colsLen; ++i) {
+        setCols[i] = getColumnIndex(sNode, tableNode->columns[i].columnToken.value);
+    }
+    for (int col = 0; col < sNode->colsLen; ++col) {
+        removeSingleQuotes(sNode->columns[col].valueToken.value);
+    }
+    if(scanOpen(&scan, sqlNode, tableNode)){
+        size_t lineCount = 0;
+        ParallelScan parallel;
+        int isParallel = parallelScanOpen(&parallel, &scan, &predicate, tableNode);
+        while (scanNextMatch(&scan, &predicate, isParallel ? &parallel : NULL, &lineCount)){
+            upCount++;
+            const char *data;
+            size_t len;
+            for (int colIdx = 0; colIdx < tableNode->colsLen; ++colIdx) {
+                if(setCols[colIdx] == -1 || !scanField(&scan, colIdx, &data, &len)){
+                    continue;
+                }
+                Column column = sNode->columns[setCols[colIdx]];
+                if(tableNode->columns[colIdx].isUnique == 1 &&
+                   (upCount > 1 || matchColumnValue(tableNode, colIdx, column.valueToken.value) == 1)){
+                    dbOp.code = FAIL;
+                    appendUniqueError(&dbOp.error, tableNode, colIdx, column.valueToken.value);
+                    for (size_t r = 0; r < rowCount; ++r) {
+                        free(rows[r]);
+                        free(oldRows[r]);
+                    }
+                    free(rows);
+                    free(oldRows);
+                    free(locations);
+                    free(setCols);
+                    predicateFree(&predicate);
+                    if(isParallel){
+                        parallelScanFree(&parallel);
+                    }
+                    scanClose(&scan);
+                    return dbOp;
+                }
+            }
+            // The new row is built from the split columns of the current row
+            StringBuilder write = createStringBuilder();
+            appendRawToBuilder(&write, "1", 1);
+            for (int i = 0; i < tableNode->colsLen && scanField(&scan, i, &data, &len); ++i) {
+                int col = setCols[i];
+                appendRawToBuilder(&write, ",", 1);
+                if(col != -1){
+                    appendToBuilder(&write, "%s", sNode->columns[col].valueToken.value);
+                }
+                else{
+                    appendRawToBuilder(&write, data, len);
+                }
+            }
+            appendRawToBuilder(&write, "\n", 1);
+            rows[rowCount] = detachStringBuilder(&write);
+            oldRows[rowCount] = scanRowText(&scan);
+            locations[rowCount] = scan.location;
+            rowCount++;
+            char **tempRow = realloc(rows, sizeof(char *) * (rowCount + 1));
+            char **tempOldRow = realloc(oldRows, sizeof(char *) * (rowCount + 1));
+            uint64_t *tempLocations = realloc(locations, sizeof(uint64_t) * (rowCount + 1));
+            if(tempRow != NULL){
+                rows = tempRow;
+            }
+            if(tempOldRow != NULL){
+                oldRows = tempOldRow;
+            }
+            if(tempLocations != NULL){
+                locations = tempLocations;
+            }
+            if(tempRow == NULL || tempOldRow == NULL || tempLocations == NULL){
+                dbOp.code = FAIL;
+                appendToBuilder(&dbOp.error, "MEM Failed");
+                free(setCols);
+                predicateFree(&predicate);
+                if(isParallel){
+                    parallelScanFree(&parallel);
+                }
+                scanClose(&scan);
+                return dbOp;
+            }
+        }
+        if(isParallel && parallel.isFailed){
+            // Rows of a morsel that couldn't be read are not updated, the statement is not applied
+            dbOp.code = FAIL;
+            appendToBuilder(&dbOp.error, "Unable to read the rows of table `%s`", tableNode->table.value);
+            for (size_t r = 0; r < rowCount; ++r) {
+                free(rows[r]);
+                free(oldRows[r]);
+            }
+            rowCount = 0;
+        }
+        if(isParallel){
+            parallelScanFree(&parallel);
+        }
+        scanClose(&scan);
+        dbOp.lineCount += lineCount;
+    }
+    free(setCols);
+    predicateFree(&predicate);
+    // The rows are logged and applied to the table file by the next checkpoint
+    int isLogged = 1;
+    for (size_t r = 0; isLogged && r < rowCount; ++r) {
+        isLogged = walLogUpdate(tableNode->table.value, locations[r], oldRows[r], rows[r]);
+    }
+    if(!isLogged){
+        walAbort();
+    }
+    if(rowCount > 0 && (!isLogged || !walCommit())){
+        dbOp.code = FAIL;
+        appendToBuilder(&dbOp.error, "Failed to write the log of table `%s`", sNode->table.value);
+    }
+    else if(rowCount > 0){
+        updateIndexes(tableNode, sNode, locations, oldRows, rows, rowCount);
+    }
+    for (size_t r = 0; r < rowCount; ++r) {
+        free(oldRows[r]);
+    }
+    dbOp.rows = rows;
+    dbOp.rowCount = rowCount;
+    free(oldRows);
+    free(locations);
+    appendToBuilder(&dbOp.successMsg, "Updated `%zd` rows in table %s", upCount, sNode->table.value);
+    return dbOp;
+}
+
+
+/*
+ * Rows of a select are produced one at a time from an open scan, a consumer pulls them
+ * as it needs them and only the current row is held in memory
+ */
+struct Cursor {
+    TableScan scan;
+    Predicate predicate;
+    int *selectCols; // Table column of every selected column, -1 if the table has no such column
+    int colsLen;
+    long long limit; // Rows left to return, -1 without a limit
+    long long offset; // Matching rows left to skip
+    int isScanOpen;
+    int isDone;
+    RowSorter sorter; // ORDER BY, the rows are sorted when the cursor is opened
+    SortKey *sortKeys;
+    int isSorted;
+    const FieldSlice *sortedRow; // Current row of the sorter, its keys then its selected columns
+    Aggregator aggregator; // GROUP BY and aggregates, the groups are built when the cursor is opened
+    AggregateSpec *aggregateSpecs;
+    int *selectSpecs; // Aggregate of every selected column, -1 for a group column whose position is in `selectCols`
+    int isAggregated;
+    StringBuilder groupRow; // Values of the aggregates of the current group
+    FieldSlice *groupFields; // Selected columns of the current group
+    HashJoin join; // JOIN, the smaller table is built when the cursor is opened and the scan probes it
+    int isJoined;
+    int isBuildLeft; // The table of FROM is the build side
+    int leftColsLen; // A joined row holds the columns of the table of FROM then the columns of the joined table
+    int probeKey; // Column of the scanned table compared to the keys of the build rows
+    FieldSlice *probeRow; // Columns of the current row of the scan
+    FieldSlice *joinedRow; // Columns of both tables of the current match
+    ParallelScan parallel; // Large filtered scan read by the worker pool, the scan of the cursor reads back the matching rows
+    int isParallel;
+    TokenRet tokens; // Statement the cursor reads, owned by the cursor when it is opened by `execSQL`
+};
+
+/**
+ * How the values of a column are ordered
+ * @param column Column of the table
+ * @return Integer and float columns are ordered by value, the others by their text
+ */
+static SortType getSortType(const Column *column){
+    switch (column->dataTypeToken.keyword) {
+        case KW_INTEGER:
+        case KW_INT:
+        case KW_SERIAL:
+            return SORT_INTEGER;
+        case KW_FLOAT:
+            return SORT_FLOAT;
+        default:
+            return SORT_TEXT;
+    }
+}
+
+/**
+ * Moves a cursor to the next group of its aggregation and formats the selected columns of the group
+ * @param cursor Cursor with finished aggregation
+ * @return 1 if the cursor is on a group, 0 once every group is read
+ */
+static int cursorNextGroup(Cursor *cursor){
+    const AggregateGroup *group = aggregatorNext(&cursor->aggregator);
+    if(group == NULL){
+        return 0;
+    }
+    size_t starts[cursor->colsLen > 0 ? cursor->colsLen : 1];
+    resetStringBuilder(&cursor->groupRow);
+    for (int col = 0; col < cursor->colsLen; ++col) {
+        starts[col] = cursor->groupRow.len;
+        int spec = cursor->selectSpecs[col];
+        if(spec != -1){
+            aggregateFormat(&cursor->aggregateSpecs[spec], &group->accumulators[spec], &cursor->groupRow);
+        }
+    }
+    // The values point into the row once it is complete, appending can move it
+    for (int col = 0; col < cursor->colsLen; ++col) {
+        if(cursor->selectSpecs[col] == -1){
+            cursor->groupFields[col] = cursor->aggregator.groupValues[cursor->selectCols[col]];
+        }
+        else{
+            size_t end = col + 1 < cursor->colsLen ? starts[col + 1] : cursor->groupRow.len;
+            cursor->groupFields[col].data = cursor->groupRow.data != NULL ? cursor->groupRow.data + starts[col] : "";
+            cursor->groupFields[col].len = end - starts[col];
+        }
+    }
+    return 1;
+}
+
+/**
+ * Moves the scan of a cursor to its next row matching the where clause
+ * @param cursor Cursor with an open scan
+ * @return 1 if the scan is on a row, 0 once every row is read
+ */
+static int cursorScanNext(Cursor *cursor){
+    return scanNextMatch(&cursor->scan, &cursor->predicate, cursor->isParallel ? &cursor->parallel : NULL, NULL);
+}
+
+/**
+ * Moves a cursor to the next match of its join, the scanned rows probe the build rows until one matches
+ * @param cursor Cursor with a built join
+ * @return 1 if the cursor is on a joined row, 0 once every row is joined
+ */
+static int cursorNextMatch(Cursor *cursor){
+    HashJoin *join = &cursor->join;
+    while (!hashJoinNext(join)){
+        if(join->isProbeFinished){
+            return 0;
+        }
+        int ok;
+        if(cursor->isScanOpen && cursorScanNext(cursor)){
+            for (size_t col = 0; col < join->probeFieldCount; ++col) {
+                if(!scanField(&cursor->scan, (int)col, &cursor->probeRow[col].data, &cursor->probeRow[col].len)){
+                    cursor->probeRow[col].data = "";
+                    cursor->probeRow[col].len = 0;
+                }
+            }
+            ok = hashJoinProbe(join, &cursor->probeRow[cursor->probeKey], cursor->probeRow);
+        }
+        else{
+            if(cursor->isScanOpen){
+                scanClose(&cursor->scan);
+                cursor->isScanOpen = 0;
+            }
+            ok = hashJoinFinishProbe(join);
+        }
+        if(!ok){
+            printError("Unable to join the rows of the tables");
+            return 0;
+        }
+    }
+    const FieldSlice *left = cursor->isBuildLeft ? join->buildFields : join->probeFields;
+    const FieldSlice *right = cursor->isBuildLeft ? join->probeFields : join->buildFields;
+    size_t rightColsLen = cursor->isBuildLeft ? join->probeFieldCount : join->buildFieldCount;
+    memcpy(cursor->joinedRow, left, sizeof(FieldSlice) * (size_t)cursor->leftColsLen);
+    memcpy(cursor->joinedRow + cursor->leftColsLen, right, sizeof(FieldSlice) * rightColsLen);
+    return 1;
+}
+
+/**
+ * Moves a cursor to the next row of its source, a group of its aggregation, a match of its join
+ * or a matching row of its scan
+ * @param cursor Cursor
+ * @return 1 if the cursor is on a row, 0 once every row is read
+ */
+static int cursorSourceNext(Cursor *cursor){
+    if(cursor->isAggregated){
+        return cursorNextGroup(cursor);
+    }
+    if(cursor->isJoined){
+        return cursorNextMatch(cursor);
+    }
+    return cursorScanNext(cursor);
+}
+
+/**
+ * Value of a selected column in the current row of the source of a cursor
+ * @param cursor Cursor on a row of its source
+ * @param col Selected column
+ * @param data Value
+ * @param len Length of the value
+ * @return 1 if the column has a value, 0 otherwise
+ */
+static int cursorSourceField(Cursor *cursor, int col, const char **data, size_t *len){
+    if(cursor->isAggregated){
+        *data = cursor->groupFields[col].data;
+        *len = cursor->groupFields[col].len;
+        return 1;
+    }
+    if(cursor->isJoined){
+        *data = cursor->joinedRow[cursor->selectCols[col]].data;
+        *len = cursor->joinedRow[cursor->selectCols[col]].len;
+        return 1;
+    }
+    return cursor->selectCols[col] != -1 && scanField(&cursor->scan, cursor->selectCols[col], data, len);
+}
+
+/**
+ * Aggregates the matching rows of a cursor, each row is added as its group columns
+ * followed by the arguments of the aggregates
+ * @param cursor Cursor with an open scan
+ * @param sqlNode SQL AST Node
+ * @param groupCols Table column of every group column
+ * @param argCols Table column of the argument of every aggregate, -1 for COUNT(*)
+ * @param specCount Number of aggregates
+ * @return 1 if the rows are aggregated, 0 on memory or io error
+ */
+static int cursorAggregate(Cursor *cursor, const Node *sqlNode, const int *groupCols, const int *argCols, size_t specCount){
+    size_t groupCount = (size_t)sqlNode->groupLen;
+    aggregatorInit(&cursor->aggregator, groupCount, cursor->aggregateSpecs, specCount);
+    cursor->isAggregated = 1;
+    if(cursor->isParallel){
+        int ok = parallelAggregate(&cursor->parallel, &cursor->aggregator, groupCols, argCols);
+        scanClose(&cursor->scan);
+        cursor->isScanOpen = 0;
+        return ok && aggregatorFinish(&cursor->aggregator);
+    }
+    FieldSlice *fields = malloc(sizeof(FieldSlice) * (groupCount + specCount + 1));
+    int ok = fields != NULL;
+    while (ok && cursorScanNext(cursor)){
+        for (size_t f = 0; f < groupCount + specCount; ++f) {
+            int colIdx = f < groupCount ? groupCols[f] : argCols[f - groupCount];
+            if(colIdx == -1 || !scanField(&cursor->scan, colIdx, &fields[f].data, &fields[f].len)){
+                fields[f].data = "";
+                fields[f].len = 0;
+            }
+        }
+        ok = aggregatorAdd(&cursor->aggregator, fields);
+    }
+    free(fields);
+    scanClose(&cursor->scan);
+    cursor->isScanOpen = 0;
+    return ok && aggregatorFinish(&cursor->aggregator);
+}
+
+/**
+ * Reads the rows of the source of a cursor into its sorter, each row is added as its sort keys
+ * followed by its selected columns. With a LIMIT only the rows up to the limit and offset are kept
+ * @param cursor Cursor with an open scan, a finished aggregation or a built join
+ * @param sqlNode SQL AST Node
+ * @param orderCols Table column of every sort key, group column of an aggregation, joined column of a join
+ * @return 1 if the rows are sorted, 0 on memory or io error
+ */
+static int cursorSort(Cursor *cursor, const Node *sqlNode, const int *orderCols){
+    size_t keyCount = (size_t)sqlNode->orderLen;
+    size_t limit = sqlNode->limit >= 0 ? (size_t)sqlNode->limit + (size_t)sqlNode->offset : 0;
+    sorterInit(&cursor->sorter, cursor->sortKeys, keyCount, keyCount + (size_t)cursor->colsLen, limit);
+    StringBuilder line = createStringBuilder();
+    int ok = 1;
+    while (ok && sqlNode->limit != 0 && cursorSourceNext(cursor)){
+        const char *data;
+        size_t len;
+        resetStringBuilder(&line);
+        appendRawToBuilder(&line, "1", 1);
+        for (size_t k = 0; k < keyCount; ++k) {
+            appendRawToBuilder(&line, ",", 1);
+            if(cursor->isAggregated){
+                appendRawToBuilder(&line, cursor->aggregator.groupValues[orderCols[k]].data, cursor->aggregator.groupValues[orderCols[k]].len);
+            }
+            else if(cursor->isJoined){
+                appendRawToBuilder(&line, cursor->joinedRow[orderCols[k]].data, cursor->joinedRow[orderCols[k]].len);
+            }
+            else if(scanField(&cursor->scan, orderCols[k], &data, &len)){
+                appendRawToBuilder(&line, data, len);
+            }
+        }
+        for (int col = 0; col < cursor->colsLen; ++col) {
+            appendRawToBuilder(&line, ",", 1);
+            if(cursorSourceField(cursor, col, &data, &len)){
+                appendRawToBuilder(&line, data, len);
+            }
+        }
+        appendRawToBuilder(&line, "\n", 1);
+        ok = sorterAdd(&cursor->sorter, line.data, line.len);
+    }
+    clearStringBuilder(&line);
+    if(cursor->isScanOpen){
+        scanClose(&cursor->scan);
+        cursor->isScanOpen = 0;
+    }
+    cursor->isSorted = 1;
+    return ok && sorterFinish(&cursor->sorter);
+}
+
+/**
+ * Prepares the aggregation of a select, every selected column is a GROUP BY column or an aggregate
+ * @param cursor Cursor of the select
+ * @param sqlNode SQL AST Node
+ * @param tableNode Table reference node
+ * @param groupCols Table column of every group column
+ * @param argCols Table column of the argument of every aggregate, -1 for COUNT(*)
+ * @param error Error of an invalid column
+ * @return Number of aggregates, -1 on error
+ */
+static int prepareAggregation(Cursor *cursor, const Node *sqlNode, const Node *tableNode, int *groupCols, int *argCols, StringBuilder *error){
+    if(sqlNode->isAllCol){
+        appendToBuilder(error, "SELECT * can't be used with GROUP BY or aggregates, select the group columns");
+        return -1;
+    }
+    for (int g = 0; g < sqlNode->groupLen; ++g) {
+        groupCols[g] = getColumnIndex(tableNode, sqlNode->groupBy[g].value);
+        if(groupCols[g] == -1){
+            appendToBuilder(error, "Invalid column `%s` in GROUP BY, column doesn't exist in table `%s`",
+                            sqlNode->groupBy[g].value, tableNode->table.value);
+            return -1;
+        }
+    }
+    int specCount = 0;
+    for (int col = 0; col < sqlNode->colsLen; ++col) {
+        const Column *column = &sqlNode->columns[col];
+        cursor->selectSpecs[col] = -1;
+        cursor->selectCols[col] = 0;
+        if(column->aggregate == AGG_NONE){
+            int g = 0;
+            while (g < sqlNode->groupLen && caseInsensitiveCompare(sqlNode->groupBy[g].value, column->columnToken.value) != 0){
+                g++;
+            }
+            if(g == sqlNode->groupLen){
+                appendToBuilder(error, "Column `%s` must be in GROUP BY or used in an aggregate", column->columnToken.value);
+                return -1;
+            }
+            cursor->selectCols[col] = g;
+            continue;
+        }
+        AggregateSpec *spec = &cursor->aggregateSpecs[specCount];
+        spec->func = column->aggregate;
+        spec->isAllRows = column->columnToken.type == TOKEN_SYMBOL;
+        spec->type = SORT_TEXT;
+        argCols[specCount] = -1;
+        if(!spec->isAllRows){
+            argCols[specCount] = getColumnIndex(tableNode, column->columnToken.value);
+            if(argCols[specCount] == -1){
+                appendToBuilder(error, "Invalid column `%s` in %s, column doesn't exist in table `%s`",
+                                column->columnToken.value, aggregateName(column->aggregate), tableNode->table.value);
+                return -1;
+            }
+            spec->type = getSortType(&tableNode->columns[argCols[specCount]]);
+        }
+        cursor->selectSpecs[col] = specCount++;
+    }
+    return specCount;
+}
+
+/**
+ * Counts the rows of a `SELECT COUNT(*)` without reading the table, from the stored row count
+ * without a where clause or from the primary key index when the where clause is an `id` range
+ * @param sqlNode SQL AST Node
+ * @param tableNode Table reference node
+ * @param count Number of matching rows
+ * @return 1 if the rows are counted, 0 if the select needs to read the table
+ */
+static int countRowsWithoutScan(const Node *sqlNode, const Node *tableNode, uint64_t *count){
+    if(!sqlNode->isAggregate || sqlNode->groupLen > 0 || sqlNode->colsLen == 0){
+        return 0;
+    }
+    for (int col = 0; col < sqlNode->colsLen; ++col) {
+        if(sqlNode->columns[col].aggregate != AGG_COUNT || sqlNode->columns[col].columnToken.type != TOKEN_SYMBOL){
+            return 0;
+        }
+    }
+    if(sqlNode->filtersLen == 0){
+        return getRowCount(tableNode, count);
+    }
+    uint64_t low, high;
+    if(!isPkRangeExact(sqlNode) || !getPkRange(sqlNode, tableNode, &low, &high)){
+        return 0;
+    }
+    BTree *index = openPkIndex(tableNode);
+    if(index == NULL){
+        return 0;
+    }
+    BTreeCursor cursor = btreeSeek(index, low);
+    *count = low <= high ? btreeCountRange(&cursor, high) : 0;
+    btreeClose(index);
+    return 1;
+}
+
+/**
+ * Opens a cursor on the rows of a select, with GROUP BY or aggregates the cursor reads the groups
+ * @param sqlNode SQL AST Node
+ * @param tableNode Table reference node
+ * @return Response of select, its header and its cursor
+ */
+DBOp dbSelect(const Node *sqlNode, const Node *tableNode){
+    const Node *sNode = sqlNode;
+    if(sqlNode->isAllCol){
+        sNode = tableNode;
+    }
+    DBOp dbOp = createDbOpWithHeader(sqlNode, tableNode);
+    if(dbOp.code != SUCCESS){
+        return dbOp;
+    }
+    Cursor *cursor = calloc(1, sizeof(Cursor));
+    if(cursor == NULL){
+        dbOp.code = FAIL;
+        appendToBuilder(&dbOp.error, "MEM Failed");
+        return dbOp;
+    }
+    cursor->colsLen = sNode->colsLen;
+    cursor->selectCols = malloc(sizeof(int) * (sNode->colsLen > 0 ? sNode->colsLen : 1));
+    if(cursor->selectCols == NULL || !predicateCompile(&cursor->predicate, sqlNode, tableNode)){
+        dbOp.code = FAIL;
+        appendToBuilder(&dbOp.error, "MEM Failed");
+        free(cursor->selectCols);
+        free(cursor);
+        return dbOp;
+    }
+    for (int col = 0; col < sNode->colsLen; ++col) {
+        cursor->selectCols[col] = getColumnIndex(tableNode, sNode->columns[col].columnToken.value);
+    }
+    cursor->limit = sqlNode->limit;
+    cursor->offset = sqlNode->offset;
+    cursor->groupRow = createStringBuilder();
+    dbOp.cursor = cursor;
+    int isAggregate = sqlNode->isAggregate || sqlNode->groupLen > 0;
+    int specCount = 0;
+    int *groupCols = NULL, *argCols = NULL;
+    if(isAggregate){
+        size_t colsSize = sizeof(int) * (sNode->colsLen > 0 ? sNode->colsLen : 1);
+        groupCols = malloc(sizeof(int) * (sqlNode->groupLen > 0 ? sqlNode->groupLen : 1));
+        argCols = malloc(colsSize);
+        cursor->selectSpecs = malloc(colsSize);
+        cursor->aggregateSpecs = malloc(sizeof(AggregateSpec) * (sNode->colsLen > 0 ? sNode->colsLen : 1));
+        cursor->groupFields = malloc(sizeof(FieldSlice) * (sNode->colsLen > 0 ? sNode->colsLen : 1));
+        if(groupCols == NULL || argCols == NULL || cursor->selectSpecs == NULL || cursor->aggregateSpecs == NULL || cursor->groupFields == NULL){
+            dbOp.code = FAIL;
+            appendToBuilder(&dbOp.error, "MEM Failed");
+            free(groupCols);
+            free(argCols);
+            return dbOp;
+        }
+        specCount = prepareAggregation(cursor, sqlNode, tableNode, groupCols, argCols, &dbOp.error);
+        if(specCount == -1){
+            dbOp.code = FAIL;
+            free(groupCols);
+            free(argCols);
+            return dbOp;
+        }
+    }
+    int *orderCols = NULL;
+    if(sqlNode->orderLen > 0){
+        orderCols = malloc(sizeof(int) * sqlNode->orderLen);
+        cursor->sortKeys = malloc(sizeof(SortKey) * sqlNode->orderLen);
+        if(orderCols == NULL || cursor->sortKeys == NULL){
+            dbOp.code = FAIL;
+            appendToBuilder(&dbOp.error, "MEM Failed");
+            free(orderCols);
+            free(groupCols);
+            free(argCols);
+            return dbOp;
+        }
+        for (int k = 0; k < sqlNode->orderLen; ++k) {
+            const char *column = sqlNode->orderBy[k].columnToken.value;
+            int colIdx = getColumnIndex(tableNode, column);
+            orderCols[k] = colIdx;
+            // The groups are ordered by their group columns
+            if(isAggregate){
+                orderCols[k] = 0;
+                while (orderCols[k] < sqlNode->groupLen && caseInsensitiveCompare(sqlNode->groupBy[orderCols[k]].value, column) != 0){
+                    orderCols[k]++;
+                }
+                if(orderCols[k] == sqlNode->groupLen){
+                    dbOp.code = FAIL;
+                    appendToBuilder(&dbOp.error, "Invalid column `%s` in ORDER BY, column must be in GROUP BY", column);
+                    free(orderCols);
+                    free(groupCols);
+                    free(argCols);
+                    return dbOp;
+                }
+            }
+            if(colIdx == -1){
+                dbOp.code = FAIL;
+                appendToBuilder(&dbOp.error, "Invalid column `%s` in ORDER BY, column doesn't exist in table `%s`",
+                                column, tableNode->table.value);
+                free(orderCols);
+                free(groupCols);
+                free(argCols);
+                return dbOp;
+            }
+            cursor->sortKeys[k].type = getSortType(&tableNode->columns[colIdx]);
+            cursor->sortKeys[k].isDesc = sqlNode->orderBy[k].isDesc;
+        }
+    }
+    uint64_t rowCount;
+    if(isAggregate && countRowsWithoutScan(sqlNode, tableNode, &rowCount)){
+        // The only group holds the count of every COUNT(*)
+        aggregatorInit(&cursor->aggregator, 0, cursor->aggregateSpecs, (size_t)specCount);
+        cursor->isAggregated = 1;
+        if(!aggregatorFinish(&cursor->aggregator)){
+            dbOp.code = INTERNAL_ERROR;
+            appendToBuilder(&dbOp.error, "MEM Failed");
+        }
+        else{
+            for (int spec = 0; spec < specCount; ++spec) {
+                cursor->aggregator.groups[0].accumulators[spec].count = (long long)rowCount;
+            }
+        }
+        free(orderCols);
+        free(groupCols);
+        free(argCols);
+        return dbOp;
+    }
+    // A table that can't be read has no rows
+    cursor->isScanOpen = scanOpen(&cursor->scan, sqlNode, tableNode);
+    cursor->isDone = !cursor->isScanOpen;
+    if(!cursor->isDone){
+        cursor->isParallel = parallelScanOpen(&cursor->parallel, &cursor->scan, &cursor->predicate, tableNode);
+    }
+    if(!cursor->isDone && isAggregate && !cursorAggregate(cursor, sqlNode, groupCols, argCols, (size_t)specCount)){
+        dbOp.code = INTERNAL_ERROR;
+        appendToBuilder(&dbOp.error, "Unable to aggregate the rows of table `%s`", tableNode->table.value);
+    }
+    else if(!cursor->isDone && orderCols != NULL && !cursorSort(cursor, sqlNode, orderCols)){
+        dbOp.code = INTERNAL_ERROR;
+        appendToBuilder(&dbOp.error, "Unable to sort the rows of table `%s`", tableNode->table.value);
+    }
+    // Every row of an index range matches, the offset moves the index cursor instead of reading rows
+    else if(!cursor->isDone && !isAggregate && orderCols == NULL && cursor->offset > 0 && cursor->scan.index != NULL &&
+            isPkRangeExact(sqlNode)){
+        btreeSkip(&cursor->scan.cursor, (uint64_t)cursor->offset);
+        cursor->offset = 0;
+    }
+    free(orderCols);
+    free(groupCols);
+    free(argCols);
+    return dbOp;
+}
+
+/**
+ * Resolves a column of a join, a column without its table must be in only one of the tables
+ * @param leftNode Table of FROM
+ * @param rightNode Joined table
+ * @param tableToken Table of the column, TOKEN_EMPTY if it is not qualified
+ * @param columnToken Column
+ * @param error Error of an unknown or ambiguous column
+ * @return Joined column, the columns of the table of FROM then the columns of the joined table, -1 on error
+ */
+static int getJoinColumnIndex(const Node *leftNode, const Node *rightNode, const Token *tableToken, const Token *columnToken,
+                              StringBuilder *error){
+    int leftIdx = -1, rightIdx = -1;
+    if(tableToken->type == TOKEN_EMPTY || caseInsensitiveCompare(tableToken->value, leftNode->table.value) == 0){
+        leftIdx = getColumnIndex(leftNode, columnToken->value);
+    }
+    if(tableToken->type == TOKEN_EMPTY || caseInsensitiveCompare(tableToken->value, rightNode->table.value) == 0){
+        rightIdx = getColumnIndex(rightNode, columnToken->value);
+    }
+    if(leftIdx != -1 && rightIdx != -1){
+        appendToBuilder(error, "Column `%s` is in both tables, use `%s.%s` or `%s.%s`", columnToken->value,
+                        leftNode->table.value, columnToken->value, rightNode->table.value, columnToken->value);
+        return -1;
+    }
+    if(leftIdx == -1 && rightIdx == -1){
+        if(tableToken->type == TOKEN_EMPTY){
+            appendToBuilder(error, "Invalid column `%s`, column doesn't exist in table `%s` or `%s`", columnToken->value,
+                            leftNode->table.value, rightNode->table.value);
+        }
+        else{
+            appendToBuilder(error, "Invalid column `%s.%s`, column doesn't exist in the joined tables", tableToken->value, columnToken->value);
+        }
+        return -1;
+    }
+    return leftIdx != -1 ? leftIdx : leftNode->colsLen + rightIdx;
+}
+
+/**
+ * Splits the where clause of a join into the filters of each table, the filters of a table are
+ * checked while it is read. Filters joined with OR can only check the columns of one table
+ * @param sqlNode SQL AST Node
+ * @param leftNode Table of FROM
+ * @param rightNode Joined table
+ * @param leftQuery Select of the table of FROM with its filters
+ * @param rightQuery Select of the joined table with its filters
+ * @param error Error of an invalid filter
+ * @return 1 if the filters are split, 0 on error
+ */
+static int splitJoinFilters(const Node *sqlNode, const Node *leftNode, const Node *rightNode, Node *leftQuery, Node *rightQuery,
+                            StringBuilder *error){
+    int hasOr = 0, hasLeft = 0, hasRight = 0;
+    for (int fil = 0; fil < sqlNode->filtersLen; ++fil) {
+        const Column *filter = &sqlNode->filters[fil];
+        int colIdx = getJoinColumnIndex(leftNode, rightNode, &filter->tableToken, &filter->columnToken, error);
+        if(colIdx == -1){
+            return 0;
+        }
+        Node *query = colIdx < leftNode->colsLen ? leftQuery : rightQuery;
+        query->filters[query->filtersLen++] = *filter;
+        hasLeft |= colIdx < leftNode->colsLen;
+        hasRight |= colIdx >= leftNode->colsLen;
+        hasOr |= fil < sqlNode->filtersLen - 1 && filter->nextLogicalOp.keyword == KW_OR;
+    }
+    if(hasOr && hasLeft && hasRight){
+        appendToBuilder(error, "OR can only combine the filters of one table of a join");
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * Opens a cursor on the rows of a join. The table with fewer rows is read into a hash table
+ * and the other table is scanned and matched against it, the filters of each table are checked while it is read
+ * @param sqlNode SQL AST Node
+ * @param leftNode Table of FROM
+ * @param rightNode Joined table
+ * @return Response of select, its header and its cursor
+ */
+DBOp dbSelectJoin(const Node *sqlNode, const Node *leftNode, const Node *rightNode){
+    DBOp dbOp = createDBOp();
+    dbOp.action = createBufferWithSize(strlen(sqlNode->action.value));
+    insertInBuffer(&dbOp.action, "%s", sqlNode->action.value);
+    if(sqlNode->isAggregate || sqlNode->groupLen > 0){
+        dbOp.code = FAIL;
+        appendToBuilder(&dbOp.error, "GROUP BY and aggregates can't be used with JOIN");
+        return dbOp;
+    }
+    Cursor *cursor = calloc(1, sizeof(Cursor));
+    int joinedColsLen = leftNode->colsLen + rightNode->colsLen;
+    int colsLen = sqlNode->isAllCol ? joinedColsLen : sqlNode->colsLen;
+    size_t filtersSize = sizeof(Column) * (sqlNode->filtersLen > 0 ? sqlNode->filtersLen : 1);
+    Node leftQuery = *sqlNode, rightQuery = *sqlNode;
+    leftQuery.filters = malloc(filtersSize);
+    rightQuery.filters = malloc(filtersSize);
+    if(cursor == NULL || leftQuery.filters == NULL || rightQuery.filters == NULL){
+        dbOp.code = FAIL;
+        appendToBuilder(&dbOp.error, "MEM Failed");
+        free(cursor);
+        free(leftQuery.filters);
+        free(rightQuery.filters);
+        return dbOp;
+    }
+    dbOp.cursor = cursor;
+    cursor->colsLen = colsLen;
+    cursor->leftColsLen = leftNode->colsLen;
+    cursor->limit = sqlNode->limit;
+    cursor->offset = sqlNode->offset;
+    cursor->groupRow = createStringBuilder();
+    cursor->selectCols = malloc(sizeof(int) * (colsLen > 0 ? colsLen : 1));
+    cursor->joinedRow = malloc(sizeof(FieldSlice) * (joinedColsLen > 0 ? joinedColsLen : 1));
+    int *orderCols = malloc(sizeof(int) * (sqlNode->orderLen > 0 ? sqlNode->orderLen : 1));
+    cursor->sortKeys = malloc(sizeof(SortKey) * (sqlNode->orderLen > 0 ? sqlNode->orderLen : 1));
+    // The filters of each table are checked by its own scan, the rows of the statement are not limited by them
+    leftQuery.filtersLen = 0;
+    rightQuery.filtersLen = 0;
+    leftQuery.offset = rightQuery.offset = 0;
+    leftQuery.limit = rightQuery.limit = -1;
+    leftQuery.orderLen = rightQuery.orderLen = 0;
+    int ok = cursor->selectCols != NULL && cursor->joinedRow != NULL && orderCols != NULL && cursor->sortKeys != NULL;
+    if(!ok){
+        appendToBuilder(&dbOp.error, "MEM Failed");
+    }
+    // Header, the columns of `*` are named after their table
+    for (int col = 0; ok && col < colsLen; ++col) {
+        const Node *tableNode = col < leftNode->colsLen ? leftNode : rightNode;
+        if(sqlNode->isAllCol){
+            const char *column = tableNode->columns[col < leftNode->colsLen ? col : col - leftNode->colsLen].columnToken.value;
+            cursor->selectCols[col] = col;
+            dbOp.maxColSpace = getMaxColSize(dbOp.maxColSpace, strlen(tableNode->table.value) + strlen(column) + 1);
+            appendToBuilder(&dbOp.result, "%s.%s", tableNode->table.value, column);
+        }
+        else{
+            const Column *column = &sqlNode->columns[col];
+            cursor->selectCols[col] = getJoinColumnIndex(leftNode, rightNode, &column->tableToken, &column->columnToken, &dbOp.error);
+            ok = cursor->selectCols[col] != -1;
+            if(column->tableToken.type != TOKEN_EMPTY){
+                appendToBuilder(&dbOp.result, "%s.", column->tableToken.value);
+            }
+            appendToBuilder(&dbOp.result, "%s", column->columnToken.value);
+            dbOp.maxColSpace = getMaxColSize(dbOp.maxColSpace, strlen(column->columnToken.value) +
+                                             (column->tableToken.type != TOKEN_EMPTY ? strlen(column->tableToken.value) + 1 : 0));
+        }
+        appendToBuilder(&dbOp.result, col != colsLen - 1 ? "," : "\n");
+    }
+    dbOp.lineCount = 1;
+    dbOp.colCount = colsLen;
+    for (int k = 0; ok && k < sqlNode->orderLen; ++k) {
+        const OrderColumn *order = &sqlNode->orderBy[k];
+        orderCols[k] = getJoinColumnIndex(leftNode, rightNode, &order->tableToken, &order->columnToken, &dbOp.error);
+        ok = orderCols[k] != -1;
+        if(ok){
+            const Node *tableNode = orderCols[k] < leftNode->colsLen ? leftNode : rightNode;
+            int colIdx = orderCols[k] < leftNode->colsLen ? orderCols[k] : orderCols[k] - leftNode->colsLen;
+            cursor->sortKeys[k].type = getSortType(&tableNode->columns[colIdx]);
+            cursor->sortKeys[k].isDesc = order->isDesc;
+        }
+    }
+    int leftKey = -1, rightKey = -1;
+    if(ok){
+        int first = getJoinColumnIndex(leftNode, rightNode, &sqlNode->joinLeft.tableToken, &sqlNode->joinLeft.columnToken, &dbOp.error);
+        int second = first == -1 ? -1 :
+                getJoinColumnIndex(leftNode, rightNode, &sqlNode->joinRight.tableToken, &sqlNode->joinRight.columnToken, &dbOp.error);
+        ok = second != -1;
+        if(ok && (first < leftNode->colsLen) == (second < leftNode->colsLen)){
+            appendToBuilder(&dbOp.error, "The columns of ON must be one of each table");
+            ok = 0;
+        }
+        leftKey = first < second ? first : second;
+        rightKey = (first < second ? second : first) - leftNode->colsLen;
+    }
+    ok = ok && splitJoinFilters(sqlNode, leftNode, rightNode, &leftQuery, &rightQuery, &dbOp.error);
+    if(ok){
+        // The table with fewer rows is held in memory, the row counts are read without reading the tables
+        uint64_t leftCount = 0, rightCount = 0;
+        getRowCount(leftNode, &leftCount);
+        getRowCount(rightNode, &rightCount);
+        cursor->isBuildLeft = leftCount <= rightCount;
+        const Node *buildNode = cursor->isBuildLeft ? leftNode : rightNode;
+        const Node *probeNode = cursor->isBuildLeft ? rightNode : leftNode;
+        const Node *buildQuery = cursor->isBuildLeft ? &leftQuery : &rightQuery;
+        const Node *probeQuery = cursor->isBuildLeft ? &rightQuery : &leftQuery;
+        int buildKey = cursor->isBuildLeft ? leftKey : rightKey;
+        cursor->probeKey = cursor->isBuildLeft ? rightKey : leftKey;
+        hashJoinInit(&cursor->join, (size_t)buildNode->colsLen, (size_t)probeNode->colsLen);
+        cursor->isJoined = 1;
+        cursor->probeRow = malloc(sizeof(FieldSlice) * (probeNode->colsLen > 0 ? probeNode->colsLen : 1));
+        FieldSlice *buildRow = malloc(sizeof(FieldSlice) * (buildNode->colsLen > 0 ? buildNode->colsLen : 1));
+        ok = cursor->probeRow != NULL && buildRow != NULL && predicateCompile(&cursor->predicate, buildQuery, buildNode);
+        // The build table is read with the predicate of the cursor, which then checks the rows of the probe table
+        if(ok && scanOpen(&cursor->scan, buildQuery, buildNode)){
+            while (ok && cursorScanNext(cursor)){
+                for (int col = 0; col < buildNode->colsLen; ++col) {
+                    if(!scanField(&cursor->scan, col, &buildRow[col].data, &buildRow[col].len)){
+                        buildRow[col].data = "";
+                        buildRow[col].len = 0;
+                    }
+                }
+                ok = hashJoinBuild(&cursor->join, &buildRow[buildKey], buildRow);
+            }
+            scanClose(&cursor->scan);
+        }
+        free(buildRow);
+        predicateFree(&cursor->predicate);
+        ok = ok && hashJoinFinishBuild(&cursor->join) && predicateCompile(&cursor->predicate, probeQuery, probeNode);
+        if(!ok){
+            dbOp.code = INTERNAL_ERROR;
+            appendToBuilder(&dbOp.error, "Unable to join the rows of tables `%s` and `%s`", leftNode->table.value, rightNode->table.value);
+        }
+        else{
+            // A table that can't be read has no rows
+            cursor->isScanOpen = scanOpen(&cursor->scan, probeQuery, probeNode);
+            if(!cursor->isScanOpen){
+                hashJoinFinishProbe(&cursor->join);
+            }
+            if(sqlNode->orderLen > 0 && !cursorSort(cursor, sqlNode, orderCols)){
+                dbOp.code = INTERNAL_ERROR;
+                appendToBuilder(&dbOp.error, "Unable to sort the rows of the join");
+            }
+        }
+    }
+    else{
+        dbOp.code = FAIL;
+    }
+    free(orderCols);
+    free(leftQuery.filters);
+    free(rightQuery.filters);
+    return dbOp;
+}
+
+/**
+ * Reads the next row of a cursor, from its sorter or from its source
+ * @param cursor Cursor
+ * @return 1 if the cursor is on a row, 0 once every row is read
+ */
+static int cursorRead(Cursor *cursor){
+    if(cursor->isSorted){
+        cursor->sortedRow = sorterNext(&cursor->sorter);
+        return cursor->sortedRow != NULL;
+    }
+    return cursorSourceNext(cursor);
+}
+
+/**
+ * Moves a cursor to its next row matching the where clause, within its OFFSET and LIMIT
+ * @param cursor Cursor
+ * @return 1 if the cursor is on a row, 0 once every row is read
+ */
+int cursorNext(Cursor *cursor){
+    if(cursor->isDone){
+        return 0;
+    }
+    // The table is not read past the last row of the limit
+    while (cursor->limit != 0 && cursorRead(cursor)){
+        if(cursor->offset > 0){
+            cursor->offset--;
+            continue;
+        }
+        if(cursor->limit > 0){
+            cursor->limit--;
+        }
+        return 1;
+    }
+    // The table is closed as soon as it is read, the cursor only keeps the statement
+    if(cursor->isScanOpen){
+        scanClose(&cursor->scan);
+        cursor->isScanOpen = 0;
+    }
+    cursor->isDone = 1;
+    return 0;
+}
+
+/**
+ * Value of a selected column in the current row of a cursor
+ * @param cursor Cursor on a row
+ * @param col Selected column
+ * @param data Value, points into the row and is valid until the cursor moves
+ * @param len Length of the value
+ * @return 1 if the column has a value, 0 otherwise
+ */
+int cursorField(Cursor *cursor, int col, const char **data, size_t *len){
+    if(cursor->isDone || col < 0 || col >= cursor->colsLen || cursor->selectCols[col] == -1){
+        return 0;
+    }
+    if(cursor->isSorted){
+        *data = cursor->sortedRow[cursor->sorter.keyCount + (size_t)col].data;
+        *len = cursor->sortedRow[cursor->sorter.keyCount + (size_t)col].len;
+        return 1;
+    }
+    return cursorSourceField(cursor, col, data, len);
+}
+
+/**
+ * Formats the next rows of a cursor in the result format `col_0,col_1,...\n`
+ * @param cursor Cursor
+ * @param batch Rows of the batch, the previous batch is replaced
+ * @param maxRows Maximum number of rows
+ * @param maxColSpace Widest value, updated with the values of the batch, can be NULL
+ * @return Number of rows, 0 once every row is read
+ */
+size_t cursorFetch(Cursor *cursor, StringBuilder *batch, size_t maxRows, size_t *maxColSpace){
+    size_t rowCount = 0;
+    resetStringBuilder(batch);
+    while (rowCount < maxRows && cursorNext(cursor)){
+        for (int col = 0; col < cursor->colsLen; ++col) {
+            const char *value;
+            size_t valueLen;
+            if(cursorField(cursor, col, &value, &valueLen)){
+                appendRawToBuilder(batch, value, valueLen);
+                if(maxColSpace != NULL){
+                    *maxColSpace = getMaxColSize(*maxColSpace, valueLen);
+                }
+            }
+            if(col != cursor->colsLen - 1){
+                appendRawToBuilder(batch, ",", 1);
+            }
+        }
+        appendRawToBuilder(batch, "\n", 1);
+        rowCount++;
+    }
+    return rowCount;
+}
+
+/**
+ * Closes a cursor and frees it
+ * @param cursor Cursor
+ */
+void cursorClose(Cursor *cursor){
+    if(cursor->isScanOpen){
+        scanClose(&cursor->scan);
+    }
+    if(cursor->isSorted){
+        sorterFree(&cursor->sorter);
+    }
+    if(cursor->isAggregated){
+        aggregatorFree(&cursor->aggregator);
+    }
+    if(cursor->isJoined){
+        hashJoinFree(&cursor->join);
+    }
+    if(cursor->isParallel){
+        parallelScanFree(&cursor->parallel);
+    }
+    free(cursor->probeRow);
+    free(cursor->joinedRow);
+    free(cursor->aggregateSpecs);
+    free(cursor->selectSpecs);
+    free(cursor->groupFields);
+    clearStringBuilder(&cursor->groupRow);
+    free(cursor->sortKeys);
+    predicateFree(&cursor->predicate);
+    free(cursor->selectCols);
+    freeTokenRet(&cursor->tokens);
+    free(cursor);
+}
+
+DBOp dbDelete(const Node *sqlNode, const Node *tableNode){
+    const Node *sNode = sqlNode;
+    if(sqlNode->isAllCol){
         sNode = tableNode;
     }
     DBOp dbOp = createDbOpWithHeader(sqlNode, tableNode);
-    char *tableName = getTableDataFileName(sqlNode);
-    FILE *tableFile = fopen(tableName, "r");
-    char **rows = malloc(sizeof(char ) * 1);
-    size_t rowCount = 0;
+    uint64_t *rowsToDelete = malloc(sizeof(uint64_t) * 1);
+    uint64_t *ids = malloc(sizeof(uint64_t) * 1);
+    char **oldRows = malloc(sizeof(char *) * 1);
+    int pkIdx = getColumnIndex(tableNode, "id");
+    size_t lIdx = 0;
+    int isFailed = 0;
+    TableScan scan;
+    Predicate predicate;
+    if(!predicateCompile(&predicate, sqlNode, tableNode)){
+        dbOp.code = FAIL;
+        appendToBuilder(&dbOp.error, "MEM Failed");
+        free(rowsToDelete);
+        free(ids);
+        free(oldRows);
+        return dbOp;
+    }
+    if(scanOpen(&scan, sqlNode, tableNode)){
+        size_t lineCount = 0;
+        ParallelScan parallel;
+        int isParallel = parallelScanOpen(&parallel, &scan, &predicate, tableNode);
+        while (scanNextMatch(&scan, &predicate, isParallel ? &parallel : NULL, &lineCount)){
+            const char *id;
+            size_t idLen;
+            rowsToDelete[lIdx] = scan.location;
+            ids[lIdx] = pkIdx != -1 && scanField(&scan, pkIdx, &id, &idLen) ? strtoull(id, NULL, 10) : 0;
+            oldRows[lIdx] = scanRowText(&scan);
+            lIdx++;
+            uint64_t *nL = realloc(rowsToDelete, sizeof(uint64_t) * (lIdx + 1));
+            uint64_t *nI = realloc(ids, sizeof(uint64_t) * (lIdx + 1));
+            char **nR = realloc(oldRows, sizeof(char *) * (lIdx + 1));
+            if(nL != NULL){
+                rowsToDelete = nL;
+            }
+            if(nI != NULL){
+                ids = nI;
+            }
+            if(nR != NULL){
+                oldRows = nR;
+            }
+            if(nL == NULL || nI == NULL || nR == NULL){
+                for (size_t i = 0; i < lIdx; ++i) {
+                    free(oldRows[i]);
+                }
+                free(oldRows);
+                free(rowsToDelete);
+                free(ids);
+                predicateFree(&predicate);
+                if(isParallel){
+                    parallelScanFree(&parallel);
+                }
+                scanClose(&scan);
+                return dbOp;
+            }
+        }
+        if(isParallel && parallel.isFailed){
+            // Rows of a morsel that couldn't be read are not deleted, the statement is not applied
+            for (size_t i = 0; i < lIdx; ++i) {
+                free(oldRows[i]);
+            }
+            lIdx = 0;
+            isFailed = 1;
+            dbOp.code = FAIL;
+        }
+        if(isParallel){
+            parallelScanFree(&parallel);
+        }
+        scanClose(&scan);
+        dbOp.lineCount += lineCount;
+    }
+    predicateFree(&predicate);
+    // The rows are logged and removed from the table file by the next checkpoint
+    int isLogged = 1;
+    for (size_t i = 0; i < lIdx; ++i) {
+        isLogged = isLogged && walLogDelete(tableNode->table.value, rowsToDelete[i], oldRows[i]);
+        free(oldRows[i]);
+    }
+    if(!isLogged){
+        walAbort();
+    }
+    if(!isFailed && isLogged && (lIdx == 0 || walCommit())){
+        // The index only points to live rows, OFFSET skips its entries without reading the rows
+        BTree *index = lIdx > 0 ? openPkIndex(tableNode) : NULL;
+        if(index != NULL){
+            for (size_t i = 0; i < lIdx; ++i) {
+                btreeDelete(index, ids[i]);
+            }
+            btreeClose(index);
+        }
+        addRowCount(tableNode, -(long long)lIdx);
+        appendToBuilder(&dbOp.successMsg, "Deleted `%zd` rows in table %s", lIdx, sNode->table.value);
+    }
+    else{
+        dbOp.code = FAIL;
+        appendToBuilder(&dbOp.error, "Unable to delete row in table `%s`", tableNode->table.value);
+    }
+    free(oldRows);
+    free(rowsToDelete);
+    free(ids);
+    return dbOp;
+}
+
+
+/**
+ * Checks a value of a unique column against the rows inserted before it by the same statement,
+ * the value is remembered for the rows after it
+ * @param slots Open addressing table of row numbers + 1, 0 for an empty slot
+ * @param slotCount Slots, a power of two larger than the rows
+ * @param values Values of the rows of the statement
+ * @param stride Values of a row
+ * @param col Value of the column in a row
+ * @param row Row of the value
+ * @return 1 if a row before it has the value, 0 otherwise
+ */
+static int isInsertedValue(uint32_t *slots, size_t slotCount, const Token *values, size_t stride, int col, size_t row){
+    const char *value = values[row * stride + col].value;
+    size_t slot = hashKey(value) & (slotCount - 1);
+    while (slots[slot] != 0){
+        if(strcmp(values[(slots[slot] - 1) * stride + col].value, value) == 0){
+            return 1;
+        }
+        slot = (slot + 1) & (slotCount - 1);
+    }
+    slots[slot] = (uint32_t)row + 1;
+    return 0;
+}
+
+/**
+ * Inserts the rows of an insert, `INSERT INTO t (...) VALUES (...), (...)`. The rows are built in one
+ * buffer and written together, their ids are taken from the sequence of the table at once
+ * @param sqlNode SQL AST Node
+ * @param tableNode Table reference node
+ * @return Result of the insert, the inserted rows
+ */
+DBOp dbInsert(const Node *sqlNode, const Node *tableNode){
+    DBOp dbOp = createDbOpWithHeader(sqlNode, tableNode);
+    char* tableName = getTableDataFileName(sqlNode);
+    if(dbOp.code != SUCCESS){
+        free(tableName);
+        return dbOp;
+    }
+    if(!fileExists(tableName)){
+        dbOp.code = INTERNAL_ERROR;
+        appendToBuilder(&dbOp.error, "Table `%s` doesn't exist", tableNode->table.value);
+        free(tableName);
+        return dbOp;
+    }
+    free(tableName);
+    size_t rowCount = (size_t)sqlNode->rowsLen;
+    size_t stride = (size_t)sqlNode->colsLen;
+    Token *values = sqlNode->values;
+    HashIndex *uniqueIndexes[tableNode->colsLen + 1];
+    uint32_t *insertedValues[tableNode->colsLen + 1];
+    int valueCols[tableNode->colsLen + 1];
+    size_t slotCount = 1;
+    while (slotCount < rowCount * 2){
+        slotCount <<= 1;
+    }
+    TableScan scan;
+    int isScanOpen = 0;
+    for (int i = 0; i < tableNode->colsLen; ++i) {
+        uniqueIndexes[i] = openUniqueIndex(tableNode, i);
+        valueCols[i] = getColumnIndex(sqlNode, tableNode->columns[i].columnToken.value);
+        insertedValues[i] = NULL;
+        if(tableNode->columns[i].isUnique == 1 && valueCols[i] != -1 &&
+           caseInsensitiveCompare(tableNode->columns[i].columnToken.value, "id") != 0){
+            insertedValues[i] = rowCount > 1 ? calloc(slotCount, sizeof(uint32_t)) : NULL;
+            // The values are looked up in the hash indexes of the columns through one scan
+            if(uniqueIndexes[i] != NULL && !isScanOpen){
+                isScanOpen = scanOpen(&scan, tableNode, tableNode);
+                dbOp.code = isScanOpen ? dbOp.code : FAIL;
+            }
+            if(rowCount > 1 && insertedValues[i] == NULL){
+                dbOp.code = FAIL;
+            }
+        }
+    }
+    Sequence *sequence = getTableSequence(tableNode);
+    uint64_t firstId = 0;
+    if(dbOp.code != SUCCESS){
+        appendToBuilder(&dbOp.error, "Unable to check the unique columns of table `%s`", tableNode->table.value);
+    }
+    // The rows of the statement take consecutive ids from the sequence of the table
+    else if(getColumnIndex(tableNode, "id") != -1 && (sequence == NULL || !sequenceNext(sequence, rowCount, &firstId))){
+        dbOp.code = INTERNAL_ERROR;
+        appendToBuilder(&dbOp.error, "Unable to take the ids of table `%s`", tableNode->table.value);
+    }
+    StringBuilder rows = createStringBuilder();
+    size_t *starts = malloc(sizeof(size_t) * (rowCount + 1));
+    uint64_t *locations = malloc(sizeof(uint64_t) * (rowCount + 1));
+    if(starts == NULL || locations == NULL){
+        dbOp.code = FAIL;
+        appendToBuilder(&dbOp.error, "MEM Failed");
+    }
+    for (size_t row = 0; dbOp.code == SUCCESS && row < rowCount; ++row) {
+        starts[row] = rows.len;
+        appendRawToBuilder(&rows, "1,", 2);
+        size_t resultStart = dbOp.result.len;
+        for (int i = 0; i < tableNode->colsLen; ++i) {
+            int col_idx = valueCols[i];
+            Token *value = col_idx != -1 ? &values[row * stride + col_idx] : NULL;
+            if(caseInsensitiveCompare(tableNode->columns[i].columnToken.value, "id") == 0){
+                // The id comes from the sequence, a value given for it is ignored
+                unsigned long long id = (unsigned long long)(firstId + row);
+                appendToBuilder(&dbOp.result, "%llu", id);
+                appendToBuilder(&rows, "%llu", id);
+            }
+            else if(value != NULL){
+                removeSingleQuotes(value->value);
+                if(tableNode->columns[i].isUnique == 1 &&
+                   ((insertedValues[i] != NULL && isInsertedValue(insertedValues[i], slotCount, values, stride, col_idx, row)) ||
+                    (uniqueIndexes[i] != NULL ? findColumnValue(&scan, uniqueIndexes[i], i, value->value) :
+                     matchColumnValue(tableNode, i, value->value) == 1))){
+                    appendUniqueError(&dbOp.error, tableNode, i, value->value);
+                    dbOp.code = FAIL;
+                    break;
+                }
+                appendToBuilder(&rows, "%s", value->value);
+                appendToBuilder(&dbOp.result, "%s", value->value);
+            }
+            else if(tableNode->columns[i].defaultToken.type == TOKEN_BUILT_IN_FUNC){
+                char* val = defaultValue(tableNode->columns[i].defaultToken);
+                appendToBuilder(&dbOp.result, "%s", val);
+                appendToBuilder(&rows, "%s",val);
+                free(val);
+            }
+            if(i != tableNode->colsLen - 1){
+                appendRawToBuilder(&rows, ",", 1);
+                appendRawToBuilder(&dbOp.result, ",", 1);
+            }
+        }
+        appendRawToBuilder(&rows, "\n", 1);
+        appendRawToBuilder(&dbOp.result, "\n", 1);
+        if(dbOp.code != SUCCESS){
+            dbOp.result.len = resultStart;
+            dbOp.result.data[resultStart] = '\0';
+        }
+    }
+    if(isScanOpen){
+        scanClose(&scan);
+    }
+    if(dbOp.code == SUCCESS){
+        // The rows are logged and the log is synced once before the table file changes, so after a
+        // crash the table never holds rows the log doesn't know
+        int ok = planRows(tableNode, rows.data, starts, rowCount, locations);
+        StringBuilder row = createStringBuilder();
+        for (size_t i = 0; ok && i < rowCount; ++i) {
+            size_t end = i + 1 < rowCount ? starts[i + 1] : rows.len;
+            resetStringBuilder(&row);
+            appendRawToBuilder(&row, rows.data + starts[i], end - starts[i]);
+            ok = walLogInsert(tableNode->table.value, locations[i], row.data);
+        }
+        if(!ok){
+            walAbort();
+        }
+        ok = ok && walCommit();
+        uint64_t *written = ok ? malloc(sizeof(uint64_t) * (rowCount + 1)) : NULL;
+        int isAppended = written != NULL && appendRows(tableNode, rows.data, rows.len, starts, rowCount, written);
+        if(ok && (!isAppended || memcmp(written, locations, sizeof(uint64_t) * rowCount) != 0)){
+            // The committed inserts are logged as deleted so the log matches the table again
+            for (size_t i = 0; i < rowCount; ++i) {
+                size_t end = i + 1 < rowCount ? starts[i + 1] : rows.len;
+                resetStringBuilder(&row);
+                appendRawToBuilder(&row, rows.data + starts[i], end - starts[i]);
+                if(!walLogDelete(tableNode->table.value, locations[i], row.data)){
+                    walAbort();
+                    break;
+                }
+            }
+            walCommit();
+            if(isAppended){
+                replaceRows(tableNode, written, NULL, rowCount);
+            }
+            ok = 0;
+        }
+        clearStringBuilder(&row);
+        free(written);
+        if(!ok){
+            dbOp.code = INTERNAL_ERROR;
+            appendToBuilder(&dbOp.error, "Insertion failed for table `%s`", tableNode->table.value);
+        }
+    }
+    if(dbOp.code == SUCCESS){
+        if(rowCount == 1){
+            appendToBuilder(&dbOp.successMsg, "Created record in table `%s`", tableNode->table.value);
+        }
+        else{
+            appendToBuilder(&dbOp.successMsg, "Created `%zu` records in table `%s`", rowCount, tableNode->table.value);
+        }
+        dbOp.lineCount += rowCount;
+        addRowCount(tableNode, (long long)rowCount);
+        if(sequence != NULL){
+            BTree *index = openPkIndex(tableNode);
+            if(index != NULL){
+                for (size_t i = 0; i < rowCount; ++i) {
+                    btreeInsert(index, firstId + i, locations[i]);
+                }
+                btreeClose(index);
+            }
+        }
+        FieldSlice fields[tableNode->colsLen + 1];
+        for (size_t row = 0; row < rowCount; ++row) {
+            size_t fieldCount = splitRow(rows.data + starts[row], fields, (size_t)tableNode->colsLen);
+            for (size_t i = 0; i < fieldCount; ++i) {
+                if(uniqueIndexes[i] != NULL){
+                    char value[fields[i].len + 1];
+                    memcpy(value, fields[i].data, fields[i].len);
+                    value[fields[i].len] = '\0';
+                    hashIndexInsert(uniqueIndexes[i], value, locations[row]);
+                }
+            }
+        }
+    }
+    for (int i = 0; i < tableNode->colsLen; ++i) {
+        hashIndexClose(uniqueIndexes[i]);
+        free(insertedValues[i]);
+    }
+    clearStringBuilder(&rows);
+    free(starts);
+    free(locations);
+    return dbOp;
+}
+
+/**
+ * Copies the rows of a table to a temporary file in a storage format, the copy replaces the
+ * data file once complete and the indexes are rebuilt with the new row locations
+ * @param tableNode Table reference node
+ * @param scan Opened scan of the table, closed by the copy
+ * @param storage Storage format of the new data file
+ * @param rowCount Number of copied rows
+ * @return 1 if the data file was replaced, 0 otherwise
+ */
+static int rewriteTable(const Node *tableNode, TableScan *scan, StorageType storage, size_t *rowCount){
+    char *tableName = getTableDataFileName(tableNode);
+    char *tempName = createBuffer();
+    insertInBuffer(&tempName, "%s.tmp", tableName);
+    PageFile *pageFile = NULL;
+    FILE *file = NULL;
+    int ok;
+    if(storage == STORAGE_PAGE){
+        pageFile = pageFileCreate(tempName);
+        ok = pageFile != NULL;
+    }
+    else{
+        file = fopen(tempName, "wb");
+        ok = file != NULL;
+    }
+    *rowCount = 0;
+    char record[PAGE_SIZE];
+    while (ok && scanNext(scan)){
+        char *line = scanRowText(scan);
+        if(pageFile != NULL){
+            size_t len = encodeRowLine(tableNode, line, record, sizeof(record));
+            ok = len > 0 && pageFileAppend(pageFile, record, (uint16_t)len) != PAGE_NO_LOCATION;
+        }
+        else{
+            ok = fputs(line, file) != EOF;
+        }
+        free(line);
+        (*rowCount)++;
+    }
+    scanClose(scan);
+    if(pageFile != NULL){
+        ok = ok && pageFileSync(pageFile);
+        pageFileClose(pageFile);
+    }
+    if(file != NULL){
+        ok = ok && syncFile(file);
+        ok = fclose(file) == 0 && ok;
+    }
+    bufferPoolInvalidate(tempName, 0);
+    bufferPoolInvalidate(tableName, 0);
+    if(ok){
+        ok = replaceFile(tempName, tableName) == 0;
+    }
+    else{
+        remove(tempName);
+    }
+    if(ok){
+        // Row locations changed with the new file
+        rebuildIndexes(tableNode);
+    }
+    free(tableName);
+    free(tempName);
+    return ok;
+}
+
+/**
+ * Converts the data file of a table to another storage format, `ALTER TABLE t STORAGE PAGE|TEXT;`
+ * the rows are copied to a temporary file that replaces the data file once complete
+ * @param sqlNode SQL AST Node
+ * @param tableNode Table reference node
+ * @return Database operation result
+ */
+DBOp dbAlterStorage(const Node *sqlNode, const Node *tableNode){
+    DBOp dbOp = createDBOp();
+    TableScan scan;
+    if(!scanOpen(&scan, tableNode, tableNode)){
+        dbOp.code = INTERNAL_ERROR;
+        appendToBuilder(&dbOp.error, "Database Table `%s` corrupted", tableNode->table.value);
+        return dbOp;
+    }
+    int isPaged = scan.pageFile != NULL;
+    if(isPaged == (sqlNode->storage == STORAGE_PAGE)){
+        scanClose(&scan);
+        appendToBuilder(&dbOp.successMsg, "Table `%s` already uses %s storage", tableNode->table.value, isPaged ? "page" : "text");
+        return dbOp;
+    }
+    size_t rowCount;
+    if(rewriteTable(tableNode, &scan, sqlNode->storage, &rowCount)){
+        dbOp.lineCount = (int)rowCount;
+        appendToBuilder(&dbOp.successMsg, "Converted `%zd` rows of table `%s` to %s storage", rowCount, tableNode->table.value,
+                       sqlNode->storage == STORAGE_PAGE ? "page" : "text");
+    }
+    else{
+        dbOp.code = INTERNAL_ERROR;
+        appendToBuilder(&dbOp.error, "Unable to convert the storage of table `%s`", tableNode->table.value);
+    }
+    return dbOp;
+}
+
+/**
+ * Reclaims the space of deleted rows, `VACUUM t;` copies the live rows of the table to a new
+ * data file in the same storage format
+ * @param sqlNode SQL AST Node
+ * @param tableNode Table reference node
+ * @return Database operation result
+ */
+DBOp dbVacuum(const Node *sqlNode, const Node *tableNode){
+    DBOp dbOp = createDBOp();
+    char *tableName = getTableDataFileName(tableNode);
+    long before = getFileSize(tableName);
+    TableScan scan;
+    if(!scanOpen(&scan, tableNode, tableNode)){
+        dbOp.code = INTERNAL_ERROR;
+        appendToBuilder(&dbOp.error, "Database Table `%s` corrupted", tableNode->table.value);
+        free(tableName);
+        return dbOp;
+    }
+    size_t rowCount;
+    if(rewriteTable(tableNode, &scan, scan.pageFile != NULL ? STORAGE_PAGE : STORAGE_TEXT, &rowCount)){
+        long after = getFileSize(tableName);
+        dbOp.lineCount = (int)rowCount;
+        appendToBuilder(&dbOp.successMsg, "Vacuumed table `%s`, kept `%zd` rows and reclaimed `%ld` bytes", tableNode->table.value,
+                       rowCount, before > after ? before - after : 0);
+    }
+    else{
+        dbOp.code = INTERNAL_ERROR;
+        appendToBuilder(&dbOp.error, "Unable to vacuum table `%s`", sqlNode->table.value);
+    }
+    free(tableName);
+    return dbOp;
+}
+
+/**
+ * File of a copy, the quotes of the string are removed and its commas unescaped
+ * @param sqlNode SQL AST Node
+ * @return File name
+ */
+static char *getCopyFileName(const Node *sqlNode){
+    char *fileName = createBuffer();
+    insertInBuffer(&fileName, "%s", sqlNode->copyFile.value);
+    removeSingleQuotes(fileName);
+    size_t j = 0;
+    for (size_t i = 0; fileName[i] != '\0'; ++i) {
+        if(fileName[i] == '\\' && fileName[i+1] == ','){
+            continue;
+        }
+        fileName[j++] = fileName[i];
+    }
+    fileName[j] = '\0';
+    return fileName;
+}
 
-    if(tableFile != NULL){
-        char *line = NULL;
-        size_t len = 0;
-        int lineCount = 0;
-        while (getLine(&line, &len, tableFile) != -1){
-            lineCount++;
-            char* rowBuffer = createBuffer();
-            int shouldInsertInRow = 1;
-            for (size_t fil = 0; fil < sqlNode.filtersLen; ++fil) {
-                size_t start = 0;
-                size_t i = 0;
-                size_t commas = 0;
-                int col_idx = getColumnIndex(&tableNode, sqlNode.filters[fil].columnToken.value);
-                while (1){
-                    if((i>0 && line[i] == ',' && line[i-1] != '\\') || line[i] == '\n'){
-                        commas++;
-                        if(commas - 2 == col_idx){
-                            char *value = createBufferWithSize(i - start);
-                            strncpy(value, line + start, i - start);
-                            shouldInsertInRow = filterValue(sqlNode.filters[fil], value);
-                            free(value);
-                            break;
-                        }
-                        else{
-                            start = i + 1;
-                        }
-                        if(line[i] == '\n'){
-                            break;
-                        }
-                    }
-                    i++;
-                }
-                if(sqlNode.filters[fil].nextLogicalOp.value != NULL && caseInsensitiveCompare(sqlNode.filters[fil].nextLogicalOp.value, "AND") == 0){
-                    if(shouldInsertInRow == 0){
+/**
+ * Loads the rows of a csv file in a table, `COPY t [(columns)] FROM 'file' [HEADER];`. The file
+ * is read in blocks whose lines are parsed by the worker pool, the rows are appended to the table
+ * file without going through the write-ahead log and the indexes are rebuilt once every row is stored.
+ * Nothing is kept of a copy that fails
+ * @param sqlNode SQL AST Node
+ * @param tableNode Table reference node
+ * @return Result of the copy
+ */
+DBOp dbCopyFrom(const Node *sqlNode, const Node *tableNode){
+    DBOp dbOp = createDBOp();
+    for (int i = 0; i < sqlNode->colsLen; ++i) {
+        if(getColumnIndex(tableNode, sqlNode->columns[i].columnToken.value) == -1){
+            dbOp.code = FAIL;
+            appendToBuilder(&dbOp.error, "Column `%s` doesn't exist in table `%s`", sqlNode->columns[i].columnToken.value,
+                            tableNode->table.value);
+            return dbOp;
+        }
+    }
+    int colCount = tableNode->colsLen;
+    size_t fieldCount = sqlNode->colsLen > 0 ? (size_t)sqlNode->colsLen : (size_t)colCount;
+    CopyColumn columns[colCount + 1];
+    char *defaults[colCount + 1];
+    int uniqueCols[colCount + 1];
+    HashIndex *uniqueIndexes[colCount + 1];
+    CopyValueSet loadedValues[colCount + 1];
+    int uniqueCount = 0;
+    uint64_t rowCount = 0;
+    // The values of the unique columns are only looked up in the table if it has rows
+    int isEmpty = getRowCount(tableNode, &rowCount) && rowCount == 0;
+    for (int i = 0; i < colCount; ++i) {
+        const Column *column = &tableNode->columns[i];
+        columns[i].isId = caseInsensitiveCompare(column->columnToken.value, "id") == 0;
+        columns[i].field = sqlNode->colsLen > 0 ? getColumnIndex(sqlNode, column->columnToken.value) : i;
+        columns[i].value = "";
+        defaults[i] = NULL;
+        if(columns[i].field == -1 && column->defaultToken.type == TOKEN_BUILT_IN_FUNC){
+            // The default of a column missing from the file is computed once for every row
+            defaults[i] = defaultValue(column->defaultToken);
+            columns[i].value = defaults[i];
+        }
+        if(column->isUnique == 1 && !columns[i].isId && columns[i].field != -1){
+            uniqueIndexes[uniqueCount] = isEmpty ? NULL : openUniqueIndex(tableNode, i);
+            if(!copyValueSetInit(&loadedValues[uniqueCount])){
+                dbOp.code = INTERNAL_ERROR;
+            }
+            uniqueCols[uniqueCount++] = i;
+        }
+    }
+    Sequence *sequence = getColumnIndex(tableNode, "id") != -1 ? getTableSequence(tableNode) : NULL;
+    char *tableName = getTableDataFileName(tableNode);
+    PageFile *pageFile = pageFileOpen(tableName);
+    FILE *file = pageFile == NULL ? fopen(tableName, "ab") : NULL;
+    long start = file != NULL && fseek(file, 0, SEEK_END) == 0 ? ftell(file) : -1;
+    if(dbOp.code != SUCCESS || (sequence == NULL && getColumnIndex(tableNode, "id") != -1) || (pageFile == NULL && start < 0)){
+        dbOp.code = INTERNAL_ERROR;
+        appendToBuilder(&dbOp.error, "Database Table `%s` corrupted", tableNode->table.value);
+    }
+    TableScan scan;
+    int isScanOpen = 0;
+    if(dbOp.code == SUCCESS && uniqueCount > 0 && !isEmpty){
+        isScanOpen = scanOpen(&scan, tableNode, tableNode);
+        dbOp.code = isScanOpen ? SUCCESS : INTERNAL_ERROR;
+    }
+    char *fileName = getCopyFileName(sqlNode);
+    CopyReader reader;
+    int isReaderOpen = dbOp.code == SUCCESS && copyReaderOpen(&reader, fileName, tableNode, columns, fieldCount,
+                                                                pageFile != NULL, sqlNode->isCopyHeader, sequence);
+    if(dbOp.code == SUCCESS && !isReaderOpen){
+        dbOp.code = FAIL;
+        appendToBuilder(&dbOp.error, "Unable to open `%s`", fileName);
+    }
+    uint64_t *locations = NULL;
+    size_t copied = 0, locationCapacity = 0;
+    FieldSlice fields[colCount + 1];
+    while (dbOp.code == SUCCESS && copyReaderNext(&reader)){
+        for (size_t p = 0; dbOp.code == SUCCESS && uniqueCount > 0 && p < reader.partCount; ++p) {
+            CopyPart *part = &reader.parts[p];
+            for (size_t r = 0; dbOp.code == SUCCESS && r < part->count; ++r) {
+                size_t end = r + 1 < part->count ? part->starts[r + 1] : part->rows.len;
+                size_t fieldsFound = simdSplitRow(part->rows.data + part->starts[r], end - part->starts[r], fields, (size_t)colCount);
+                for (int u = 0; u < uniqueCount && (size_t)uniqueCols[u] < fieldsFound; ++u) {
+                    int i = uniqueCols[u];
+                    char value[fields[i].len + 1];
+                    memcpy(value, fields[i].data, fields[i].len);
+                    value[fields[i].len] = '\0';
+                    int isAdded = copyValueSetAdd(&loadedValues[u], value);
+                    if(isAdded == -1){
+                        dbOp.code = INTERNAL_ERROR;
+                        appendToBuilder(&dbOp.error, "MEM Failed");
                         break;
                     }
-                }else{
-                    if(shouldInsertInRow == 1){
+                    if(isAdded == 0 || (!isEmpty && (uniqueIndexes[u] != NULL ? findColumnValue(&scan, uniqueIndexes[u], i, value) :
+                                                     matchColumnValue(tableNode, i, value) == 1))){
+                        dbOp.code = FAIL;
+                        appendUniqueError(&dbOp.error, tableNode, i, value);
                         break;
                     }
                 }
             }
-            if(shouldInsertInRow == 1){
-                for (int col = 0; col < sNode.colsLen; ++col) {
-                    int col_idx = getColumnIndex(&tableNode, sNode.columns[col].columnToken.value);
-                    size_t start = 0;
-                    size_t i = 0;
-                    size_t commas = 0;
-                    while (1){
-                        if((i>0 && line[i] == ',' && line[i-1] != '\\') || line[i] == '\n'){
-                            commas++;
-                            char *value = createBufferWithSize(i - start);
-                            strncpy(value, line + start, i - start);
-                            value[i - start] = '\0';
-                            if(commas == col_idx + 2){
-                                insertInBuffer(&rowBuffer, "%s", value);
-                                dbOp.maxColSpace = getMaxColSize(dbOp.maxColSpace, strlen(value));
-                                clearBuffer(&value);
-                            }
-                            else{
-                                start = i + 1;
-                            }
-                            clearBuffer(&value);
-                            if(line[i] == '\n'){
-                                break;
-                            }
-                        }
-                        i++;
-                    }
-                    if(col != sNode.colsLen - 1){
-                        insertInBuffer(&rowBuffer, ",");
-                    }
-                }
-                insertInBuffer(&rowBuffer, "\n");
-                insertInBuffer(&dbOp.result, "%s", rowBuffer);
-                rows[rowCount] = createBuffer();
-                insertInBuffer(&rows[rowCount], line);
-                rowCount++;
-                char **tempRow = realloc(rows, sizeof(char) * rowCount);
-                if(tempRow != NULL){
-                    rows = tempRow;
-                }
-                else{
-                    dbOp.code = FAIL;
-                    insertInBuffer(&dbOp.error, "MEM Failed");
-                    free(tableName);
-                    free(line);
-                    return dbOp;
+        }
+        if(dbOp.code != SUCCESS){
+            break;
+        }
+        for (size_t p = 0; dbOp.code == SUCCESS && p < reader.partCount; ++p) {
+            CopyPart *part = &reader.parts[p];
+            if(file != NULL){
+                dbOp.code = fwrite(part->rows.data, 1, part->rows.len, file) == part->rows.len ? SUCCESS : INTERNAL_ERROR;
+            }
+            if(pageFile != NULL && copied + part->count > locationCapacity){
+                // Locations of the stored records, to remove them if the copy fails
+                size_t capacity = locationCapacity == 0 ? 1024 : locationCapacity;
+                while (capacity < copied + part->count){
+                    capacity *= 2;
                 }
-                clearBuffer(&rowBuffer);
+                uint64_t *temp = realloc(locations, sizeof(uint64_t) * capacity);
+                dbOp.code = temp != NULL ? SUCCESS : INTERNAL_ERROR;
+                locations = temp != NULL ? temp : locations;
+                locationCapacity = temp != NULL ? capacity : locationCapacity;
+            }
+            for (size_t r = 0; pageFile != NULL && dbOp.code == SUCCESS && r < part->count; ++r) {
+                uint16_t recordLen = (uint16_t)(part->recordStarts[r + 1] - part->recordStarts[r]);
+                uint64_t location = pageFileAppend(pageFile, part->records.data + part->recordStarts[r], recordLen);
+                dbOp.code = location != PAGE_NO_LOCATION ? SUCCESS : INTERNAL_ERROR;
+                locations[copied + r] = location;
+            }
+            if(dbOp.code == SUCCESS){
+                copied += part->count;
             }
         }
-        fclose(tableFile);
-        dbOp.lineCount += lineCount;
+        if(dbOp.code != SUCCESS && dbOp.error.len == 0){
+            appendToBuilder(&dbOp.error, "Unable to store the rows of table `%s`", tableNode->table.value);
+        }
     }
-    dbOp.rows = rows;
-    dbOp.rowCount = rowCount;
+    if(isReaderOpen && reader.error.len > 0 && dbOp.code == SUCCESS){
+        dbOp.code = FAIL;
+        appendRawToBuilder(&dbOp.error, reader.error.data, reader.error.len);
+    }
+    if(isReaderOpen){
+        copyReaderClose(&reader);
+    }
+    if(isScanOpen){
+        scanClose(&scan);
+    }
+    if(file != NULL){
+        if(dbOp.code != SUCCESS){
+            truncateFile(file, start);
+        }
+        else if(!syncFile(file)){
+            dbOp.code = INTERNAL_ERROR;
+        }
+        if(fclose(file) != 0){
+            dbOp.code = INTERNAL_ERROR;
+        }
+        // Only the last page of the file and the pages after it changed
+        bufferPoolInvalidate(tableName, (uint64_t)start / PAGE_SIZE);
+    }
+    if(pageFile != NULL){
+        if(dbOp.code != SUCCESS){
+            for (size_t i = 0; i < copied; ++i) {
+                pageFileRemove(pageFile, locations[i]);
+            }
+        }
+        else if(!pageFileSync(pageFile)){
+            dbOp.code = INTERNAL_ERROR;
+        }
+        pageFileClose(pageFile);
+    }
+    if(dbOp.code == SUCCESS){
+        // The indexes are built from the rows of the table with a sort rather than an insert per row
+        rebuildIndexes(tableNode);
+        dbOp.lineCount = copied;
+        appendToBuilder(&dbOp.successMsg, "Copied `%zu` rows from `%s` to table `%s`", copied, fileName, tableNode->table.value);
+    }
+    else if(dbOp.error.len == 0){
+        appendToBuilder(&dbOp.error, "Unable to copy `%s` to table `%s`", fileName, tableNode->table.value);
+    }
+    for (int i = 0; i < colCount; ++i) {
+        free(defaults[i]);
+    }
+    for (int u = 0; u < uniqueCount; ++u) {
+        hashIndexClose(uniqueIndexes[u]);
+        copyValueSetFree(&loadedValues[u]);
+    }
+    free(locations);
+    free(fileName);
+    free(tableName);
     return dbOp;
 }
 
-DBOp dbDelete(Node sqlNode, Node tableNode){
-    Node sNode = sqlNode;
-    if(sqlNode.isAllCol){
-        sNode = tableNode;
+/*
+ * Rows of a morsel of a table written as csv lines by a task of an export
+ */
+struct {
+    uint64_t start;
+    uint64_t end;
+    StringBuilder text;
+    size_t rowCount;
+    int isFailed;
+} typedef ExportMorsel;
+
+/*
+ * Export of the rows of a table to a csv file, the morsels of a batch are formatted by the
+ * worker pool and written in table order
+ */
+struct {
+    const Node *tableNode;
+    const int *cols; // Table column of every field
+    size_t fieldCount;
+    ExportMorsel *morsels;
+} typedef TableExport;
+
+/**
+ * Formats the rows of a morsel as csv lines, run by the worker pool
+ * @param arg Export
+ * @param worker Thread
+ * @param index Morsel of the current batch
+ */
+static void exportMorselTask(void *arg, size_t worker, size_t index){
+    TableExport *tableExport = arg;
+    ExportMorsel *morsel = &tableExport->morsels[index];
+    TableScan scan;
+    (void)worker;
+    resetStringBuilder(&morsel->text);
+    morsel->rowCount = 0;
+    morsel->isFailed = !scanOpenRange(&scan, tableExport->tableNode, morsel->start, morsel->end);
+    if(morsel->isFailed){
+        return;
     }
-    DBOp dbOp = createDbOpWithHeader(sqlNode, tableNode);
-    size_t *linesToDelete = malloc(sizeof(size_t) * 1);
-    size_t lIdx = 0;
-    char *tableName = getTableDataFileName(sqlNode);
-    FILE *tableFile = fopen(tableName, "r");
-    if(tableFile != NULL){
-        char *line = NULL;
-        size_t len = 0;
-        int lineCount = 0;
-        while (getLine(&line, &len, tableFile) != -1){
-            lineCount++;
-            int shouldInsertInRow = 1;
-            for (int fil = 0; fil < sNode.filtersLen; ++fil) {
-                Column filter = sNode.filters[fil];
-                int colIdx = getColumnIndex(&tableNode, sNode.filters[fil].columnToken.value);
-                size_t start = 0;
-                size_t i = 0;
-                size_t commas = 0;
-                while (1){
-                    if((i>0 && line[i] == ',' && line[i-1] != '\\') || line[i] == '\n'){
-                        commas++;
-                        if(colIdx == commas - 2){
-                            char *value = createBufferWithSize(i - start);
-                            strncpy(value, line + start, i - start);
-                            value[i - start] = '\0';
-                            removeSingleQuotes(filter.valueToken.value);
-                            shouldInsertInRow = filterValue(filter, value);
-                            clearBuffer(&value);
-                            break;
-                        }
-                        else{
-                            start = i + 1;
-                        }
-                    }
-                    i++;
-                }
-                if(shouldInsertInRow == 0){
-                    break;
-                }
+    while (scanNext(&scan)){
+        for (size_t f = 0; f < tableExport->fieldCount; ++f) {
+            const char *data;
+            size_t len;
+            if(!scanField(&scan, tableExport->cols[f], &data, &len)){
+                data = "";
+                len = 0;
             }
-            if(shouldInsertInRow == 1){
-                linesToDelete[lIdx] = lineCount;
-                lIdx++;
-                size_t *nL = realloc(linesToDelete, sizeof(size_t)*lIdx);
-                if(nL != NULL){
-                    linesToDelete=nL;
-                }
-                else{
-                    return dbOp;
-                }
+            if(f > 0){
+                appendRawToBuilder(&morsel->text, ",", 1);
             }
+            copyAppendField(&morsel->text, data, len);
+        }
+        appendRawToBuilder(&morsel->text, "\n", 1);
+        morsel->rowCount++;
+    }
+    scanClose(&scan);
+}
 
+/**
+ * Writes the rows of a table to a csv file, `COPY t [(columns)] TO 'file' [HEADER];`. The table is
+ * read in morsels formatted by the worker pool, batch after batch, and the lines of a batch are
+ * written in table order
+ * @param sqlNode SQL AST Node
+ * @param tableNode Table reference node
+ * @return Result of the copy
+ */
+DBOp dbCopyTo(const Node *sqlNode, const Node *tableNode){
+    DBOp dbOp = createDBOp();
+    size_t fieldCount = sqlNode->colsLen > 0 ? (size_t)sqlNode->colsLen : (size_t)tableNode->colsLen;
+    int cols[fieldCount + 1];
+    for (size_t f = 0; f < fieldCount; ++f) {
+        cols[f] = sqlNode->colsLen > 0 ? getColumnIndex(tableNode, sqlNode->columns[f].columnToken.value) : (int)f;
+        if(cols[f] == -1){
+            dbOp.code = FAIL;
+            appendToBuilder(&dbOp.error, "Column `%s` doesn't exist in table `%s`", sqlNode->columns[f].columnToken.value,
+                            tableNode->table.value);
+            return dbOp;
         }
-        fclose(tableFile);
-        dbOp.lineCount += lineCount;
     }
-    int r = deleteLine(tableName, linesToDelete, lIdx);
-    if(r == 0){
-        insertInBuffer(&dbOp.successMsg, "Deleted `%zd` rows in table %s", lIdx, sNode.table.value);
+    TableScan scan;
+    if(!scanOpen(&scan, tableNode, tableNode)){
+        dbOp.code = INTERNAL_ERROR;
+        appendToBuilder(&dbOp.error, "Database Table `%s` corrupted", tableNode->table.value);
+        return dbOp;
+    }
+    // Morsels like the ones of a parallel scan, in bytes of a text table or pages of a paged table
+    uint64_t first = 0, size, morselSize = PARALLEL_SCAN_MORSEL_SIZE;
+    if(scan.pageFile != NULL){
+        first = 1;
+        size = scan.pageFile->pageCount;
+        morselSize /= PAGE_SIZE;
     }
     else{
-        insertInBuffer(&dbOp.error, "Unable to delete row in table `%s`", tableName);
+        char *tableName = getTableDataFileName(tableNode);
+        long fileSize = getFileSize(tableName);
+        size = fileSize > 0 ? (uint64_t)fileSize : 0;
+        free(tableName);
     }
-    free(linesToDelete);
-    free(tableName);
+    scanClose(&scan);
+    char *fileName = getCopyFileName(sqlNode);
+    FILE *file = fopen(fileName, "wb");
+    size_t workerCount = workerPoolSize();
+    // Every thread pins a page of the table, the pool needs room for all of them
+    int isParallel = workerCount > 1 && bufferPoolGetStats().frameCount >= workerCount * 4;
+    TableExport tableExport;
+    tableExport.tableNode = tableNode;
+    tableExport.cols = cols;
+    tableExport.fieldCount = fieldCount;
+    size_t morselCapacity = isParallel ? workerCount * PARALLEL_SCAN_BATCH_MORSELS : 1;
+    tableExport.morsels = calloc(morselCapacity, sizeof(ExportMorsel));
+    int ok = file != NULL && tableExport.morsels != NULL;
+    if(ok && sqlNode->isCopyHeader){
+        StringBuilder header = createStringBuilder();
+        for (size_t f = 0; f < fieldCount; ++f) {
+            const char *name = tableNode->columns[cols[f]].columnToken.value;
+            if(f > 0){
+                appendRawToBuilder(&header, ",", 1);
+            }
+            copyAppendField(&header, name, strlen(name));
+        }
+        appendRawToBuilder(&header, "\n", 1);
+        ok = fwrite(header.data, 1, header.len, file) == header.len;
+        clearStringBuilder(&header);
+    }
+    for (size_t m = 0; tableExport.morsels != NULL && m < morselCapacity; ++m) {
+        tableExport.morsels[m].text = createStringBuilder();
+    }
+    size_t rowCount = 0;
+    uint64_t next = first;
+    while (ok && next < size){
+        size_t morselCount = 0;
+        while (morselCount < morselCapacity && next < size){
+            ExportMorsel *morsel = &tableExport.morsels[morselCount++];
+            morsel->start = next;
+            morsel->end = size - next > morselSize ? next + morselSize : size;
+            next = morsel->end;
+        }
+        if(isParallel){
+            workerPoolRun(exportMorselTask, &tableExport, morselCount);
+        }
+        else{
+            exportMorselTask(&tableExport, 0, 0);
+        }
+        for (size_t m = 0; ok && m < morselCount; ++m) {
+            ExportMorsel *morsel = &tableExport.morsels[m];
+            ok = !morsel->isFailed && fwrite(morsel->text.data, 1, morsel->text.len, file) == morsel->text.len;
+            rowCount += morsel->rowCount;
+        }
+    }
+    if(file != NULL){
+        ok = fclose(file) == 0 && ok;
+    }
+    if(ok){
+        dbOp.lineCount = rowCount;
+        appendToBuilder(&dbOp.successMsg, "Copied `%zu` rows of table `%s` to `%s`", rowCount, tableNode->table.value, fileName);
+    }
+    else{
+        dbOp.code = INTERNAL_ERROR;
+        appendToBuilder(&dbOp.error, "Unable to write table `%s` to `%s`", tableNode->table.value, fileName);
+    }
+    for (size_t m = 0; tableExport.morsels != NULL && m < morselCapacity; ++m) {
+        clearStringBuilder(&tableExport.morsels[m].text);
+    }
+    free(tableExport.morsels);
+    free(fileName);
     return dbOp;
 }
 
+/**
+ * Raises the primary key counter of a table to the id of a recovered row
+ * @param tableNode Table reference node
+ * @param row Row in the text row format
+ */
+static void raisePk(const Node *tableNode, char *row){
+    int pkIdx = getColumnIndex(tableNode, "id");
+    char *value = pkIdx != -1 ? getRowValue(&row, 0, pkIdx, 1) : NULL;
+    Sequence *sequence = value != NULL ? getTableSequence(tableNode) : NULL;
+    if(sequence != NULL){
+        sequenceRaise(sequence, strtoull(value, NULL, 10));
+    }
+    free(value);
+}
 
-DBOp dbInsert(Node sqlNode, Node tableNode){
-    DBOp dbOp = createDbOpWithHeader(sqlNode, tableNode);
-    char* tableName = getTableDataFileName(sqlNode);
-    if(dbOp.code != SUCCESS){
-        return dbOp;
+/**
+ * Rewrites the end of a text table from the first logged insert it doesn't hold, a crash during an
+ * append leaves a partial row or misses rows the log committed. The inserts are written again in
+ * location order so they keep their logged locations
+ * @param tableNode Table reference node
+ * @param walTable Logged changes of the table
+ * @param locations Location of every change in the table file, updated for the rewritten inserts
+ * @return 1 if the table holds every logged insert, 0 otherwise
+ */
+static int repairTextInserts(const Node *tableNode, WalTable *walTable, uint64_t *locations){
+    TableScan scan;
+    if(!scanOpen(&scan, tableNode, tableNode)){
+        return 0;
     }
-    size_t _id = -1;
-    FILE *pkFile;
-    char **rows = malloc(sizeof(char) * 1);
-    size_t rowCount = 0;
-    if(fileExists(tableName)){
-        FILE *table = fopen(tableName, "a+");
-        if(table != NULL){
-            char* rowBuffer = createBuffer();
-            insertInBuffer(&rowBuffer, "1,");
-            for (int i = 0; i < tableNode.colsLen; ++i) {
-                int col_idx = getColumnIndex(&sqlNode, tableNode.columns[i].columnToken.value);
-                if(caseInsensitiveCompare(tableNode.columns[i].columnToken.value, "id") == 0){
-                    char *pkFileName = getTablePkName(sqlNode);
-                    pkFile = fopen(pkFileName, "r+");
-                    _id = getPkFromPkFile(pkFile);
-                    _id++;
-                    if (_id != -1) {
-                        insertInBuffer(&dbOp.result, "%zd", _id);
-                        insertInBuffer(&rowBuffer, "%zd", _id);
-                    }
-                    else{
-                        if(col_idx != - 1){
-                            insertInBuffer(&rowBuffer, "%s", sqlNode.columns[col_idx].valueToken.value);
-                            insertInBuffer(&dbOp.result, "%s", sqlNode.columns[col_idx].valueToken.value);
-                        }
-                    }
-                }
-                else{
-                    if(col_idx >= COL_MAX_SIZE){
-                        dbOp.code = FAIL;
-                        insertInBuffer(&dbOp.error,
-                                       "Insertion failed for table `%s` surpassed the column size %d",
-                                       tableName,
-                                       COL_MAX_SIZE
-                                       );
-                        break;
-                    }
-                    else if(col_idx > -1){
-                        removeSingleQuotes(sqlNode.columns[col_idx].valueToken.value);
-                        if(tableNode.columns[i].isUnique == 1){
-                            int match = matchColumnValue(tableName, i, sqlNode.columns[col_idx].valueToken.value);
-                            if(match == 1){
-                                fclose(table);
-                                insertInBuffer(
-                                        &dbOp.error,
-                                        "Duplicate value `%s` violates unique constraint on column `%s` for table `%s`;",
-                                        sqlNode.columns[col_idx].valueToken.value,
-                                        sqlNode.columns[col_idx].columnToken.value,
-                                        tableNode.table.value
-                                );
-                                dbOp.code = FAIL;
-                                break;
-                            }
-                        }
-                        insertInBuffer(&rowBuffer, "%s", sqlNode.columns[col_idx].valueToken.value);
-                        insertInBuffer(&dbOp.result, "%s", sqlNode.columns[col_idx].valueToken.value);
-                    }
-                    else{
-                        if(tableNode.columns[i].defaultToken.type == TOKEN_BUILT_IN_FUNC){
-                            char* val = defaultValue(tableNode.columns[i].defaultToken);
-                            insertInBuffer(&dbOp.result, "%s", val);
-                            insertInBuffer(&rowBuffer, "%s",val);
-                            free(val);
-                        }
-                    }
-                }
-                if(i != tableNode.colsLen - 1){
-                    insertInBuffer(&rowBuffer, ",");
-                    insertInBuffer(&dbOp.result, ",");
-                }
-            }
-            insertInBuffer(&rowBuffer, "\n");
-            if(dbOp.code == SUCCESS){
-                insertInBuffer(&dbOp.result, "\n");
-                rows[rowCount] = createBuffer();
-                insertInBuffer(&rows[rowCount], "%s", rowBuffer);
-                rowCount++;
-                char **tempRow = realloc(rows, sizeof(char) * rowCount);
-                if(tempRow != NULL){
-                    rows = tempRow;
-                }
-                else{
-                    dbOp.code = FAIL;
-                    insertInBuffer(&dbOp.error, "MEM Failed");
-                    free(tableName);
-                    return dbOp;
-                }
-                fputs(rowBuffer, table);
+    scan.isRaw = 1;
+    // (location, change index) pairs
+    uint64_t *inserts = scan.pageFile == NULL ? malloc(sizeof(uint64_t) * 2 * (walTable->size + 1)) : NULL;
+    if(inserts == NULL){
+        int isPaged = scan.pageFile != NULL;
+        scanClose(&scan);
+        return isPaged;
+    }
+    size_t insertCount = 0;
+    for (size_t i = 0; i < walTable->size; ++i) {
+        if(walTable->changes[i].type == WAL_INSERT){
+            inserts[insertCount * 2] = walTable->changes[i].location;
+            inserts[insertCount * 2 + 1] = i;
+            insertCount++;
+        }
+    }
+    qsort(inserts, insertCount, sizeof(uint64_t) * 2, comparePkEntries);
+    size_t first = insertCount;
+    for (size_t i = 0; first == insertCount && i < insertCount; ++i) {
+        const WalChange *change = &walTable->changes[inserts[i * 2 + 1]];
+        char *row = scanFetch(&scan, change->location) ? scanRowText(&scan) : NULL;
+        if(row == NULL || strcmp(row, change->oldRow) != 0){
+            first = i;
+        }
+        free(row);
+    }
+    scanClose(&scan);
+    int ok = 1;
+    if(first < insertCount){
+        char *tableName = getTableDataFileName(tableNode);
+        long start = (long)inserts[first * 2];
+        FILE *file = fopen(tableName, "r+b");
+        long size = file != NULL && fseek(file, 0, SEEK_END) == 0 ? ftell(file) : -1;
+        char *tail = size >= start ? malloc((size_t)(size - start) + 1) : NULL;
+        size_t tailLen = tail != NULL && fseek(file, start, SEEK_SET) == 0 ? fread(tail, 1, (size_t)(size - start), file) : 0;
+        // The file is only cut when its complete rows after the first missing insert are the logged
+        // inserts, bytes after the last line break are a partial row
+        while(tailLen > 0 && tail[tailLen - 1] != '\n'){
+            tailLen--;
+        }
+        int isPrefix = tail != NULL;
+        size_t compared = 0;
+        for (size_t i = first; isPrefix && compared < tailLen && i < insertCount; ++i) {
+            const char *row = walTable->changes[inserts[i * 2 + 1]].oldRow;
+            size_t len = strlen(row) < tailLen - compared ? strlen(row) : tailLen - compared;
+            isPrefix = inserts[i * 2] == (uint64_t)start + compared && memcmp(tail + compared, row, len) == 0;
+            compared += len;
+        }
+        isPrefix = isPrefix && compared == tailLen;
+        free(tail);
+        if(isPrefix){
+            ok = truncateFile(file, start);
+            bufferPoolInvalidate(tableName, (uint64_t)start / PAGE_SIZE);
+        }
+        else{
+            // Rows logged elsewhere are appended again by checkpointTable after the complete rows
+            ok = file == NULL || (long)tailLen == size - start || truncateFile(file, start + (long)tailLen);
+            bufferPoolInvalidate(tableName, (uint64_t)start / PAGE_SIZE);
+            first = insertCount;
+        }
+        ok = (file == NULL || fclose(file) == 0) && ok;
+        free(tableName);
+    }
+    for (size_t i = first; ok && i < insertCount; ++i) {
+        size_t idx = (size_t)inserts[i * 2 + 1];
+        locations[idx] = appendRow(tableNode, walTable->changes[idx].oldRow);
+        ok = locations[idx] != PAGE_NO_LOCATION;
+        raisePk(tableNode, walTable->changes[idx].oldRow);
+    }
+    free(inserts);
+    return ok;
+}
+
+/**
+ * Applies the logged changes of a table to its file, a change is only applied if the
+ * table still holds the row the change was made on so a checkpoint can be run again after a crash
+ * @param tableNode Table reference node
+ * @param walTable Logged changes of the table
+ * @return 1 if the table file holds every change, 0 otherwise
+ */
+static int checkpointTable(const Node *tableNode, WalTable *walTable){
+    uint64_t *at = malloc(sizeof(uint64_t) * (walTable->size + 1));
+    for (size_t i = 0; at != NULL && i < walTable->size; ++i) {
+        at[i] = walTable->changes[i].location;
+    }
+    TableScan scan;
+    if(at == NULL || !repairTextInserts(tableNode, walTable, at) || !scanOpen(&scan, tableNode, tableNode)){
+        free(at);
+        return 0;
+    }
+    scan.isRaw = 1;
+    uint64_t *locations = malloc(sizeof(uint64_t) * (walTable->size + 1));
+    char **lines = malloc(sizeof(char *) * (walTable->size + 1));
+    char **inserts = malloc(sizeof(char *) * (walTable->size + 1));
+    size_t lineCount = 0, insertCount = 0;
+    if(locations == NULL || lines == NULL || inserts == NULL){
+        scanClose(&scan);
+        free(at);
+        free(locations);
+        free(lines);
+        free(inserts);
+        return 0;
+    }
+    for (size_t i = 0; i < walTable->size; ++i) {
+        WalChange *change = &walTable->changes[i];
+        char *row = scanFetch(&scan, at[i]) ? scanRowText(&scan) : NULL;
+        if(row != NULL && strcmp(row, change->oldRow) == 0){
+            if(change->newRow == NULL || strcmp(row, change->newRow) != 0){
+                locations[lineCount] = at[i];
+                lines[lineCount++] = change->newRow;
             }
-            clearBuffer(&rowBuffer);
-            fclose(table);
+        }
+        else if(change->type == WAL_INSERT && change->newRow != NULL){
+            // The row was logged but never reached the paged table file
+            inserts[insertCount++] = change->newRow;
+        }
+        free(row);
+    }
+    scanClose(&scan);
+    int ok = lineCount == 0 || replaceRows(tableNode, locations, lines, lineCount) == 0;
+    for (size_t i = 0; ok && i < insertCount; ++i) {
+        ok = appendRow(tableNode, inserts[i]) != PAGE_NO_LOCATION;
+        raisePk(tableNode, inserts[i]);
+    }
+    free(at);
+    free(locations);
+    free(lines);
+    free(inserts);
+    if(ok){
+        char *tableName = getTableDataFileName(tableNode);
+        PageFile *pageFile = pageFileOpen(tableName);
+        FILE *file = pageFile == NULL ? fopen(tableName, "r+b") : NULL;
+        ok = pageFile != NULL ? pageFileSync(pageFile) : file != NULL && syncFile(file);
+        if(pageFile != NULL){
+            pageFileClose(pageFile);
+        }
+        if(file != NULL){
+            fclose(file);
+        }
+        free(tableName);
+    }
+    return ok;
+}
 
+/**
+ * Applies the write-ahead log to the table files and empties it
+ * @param tableList List of every table
+ * @return 1 if the log was applied, 0 otherwise
+ */
+int dbCheckpoint(NodeList *tableList){
+    size_t count;
+    WalTable **tables = walTables(&count);
+    int ok = 1;
+    for (size_t i = 0; i < count; ++i) {
+        if(tables[i]->size == 0){
+            continue;
         }
-        else{
-            dbOp.code = INTERNAL_ERROR;
-            insertInBuffer(&dbOp.successMsg, "Insertion failed for table `%s`", tableNode.table.value);
+        Node *tableNode = getNodeFromList(tableList, tables[i]->table);
+        if(tableNode != NULL && !checkpointTable(tableNode, tables[i])){
+            printError("Checkpoint failed for table `%s`", tables[i]->table);
+            ok = 0;
+            continue;
+        }
+        // The table file holds the changes, the log and the indexes stop referring to the old rows
+        ok = walLogCheckpoint(tables[i]->table) && walCommit() && ok;
+        if(tableNode != NULL){
+            rebuildIndexes(tableNode);
         }
     }
-    else{
-        dbOp.code = INTERNAL_ERROR;
-        insertInBuffer(&dbOp.error, "Table `%s` doesn't exist", tableNode.table.value);
+    return ok && walTruncate();
+}
+
+/**
+ * Replays the write-ahead log left by the last run and applies it to the table files
+ * @param tableList List of every table
+ * @return 1 if the tables are up to date, 0 otherwise
+ */
+int dbRecover(NodeList *tableList){
+    if(!walOpen(DATA_DIR)){
+        printError("Unable to open the write-ahead log");
+        return 0;
     }
-    if(dbOp.code == SUCCESS){
-        insertInBuffer(&dbOp.successMsg, "Created record in table `%s`", tableNode.table.value);
-        dbOp.lineCount++;
-        if(pkFile != NULL){
-            fseek(pkFile, 0, SEEK_SET);
-            fprintf(pkFile, "%zd", _id);
-            fclose(pkFile);
+    return dbCheckpoint(tableList);
+}
+
+/**
+ * Compaction pass over every table, the fragmented pages of paged tables are compacted in place,
+ * their records keep their locations so only those pages are written. Text tables are not compacted
+ * by region: a text row is found by its byte offset, so dropping the dead rows of a region moves every
+ * row after it and the indexes of the whole table change. A table is instead vacuumed whole once it
+ * holds as many deleted rows or free space as live rows, every row copied by the rewrite is then paid
+ * by at least one delete. Paged tables need the same rewrite to give back the free space of their
+ * pages since appends only fill the last page
+ * @param tableList List of every table
+ * @return Number of vacuumed tables
+ */
+int dbCompact(NodeList *tableList){
+    int vacuumed = 0;
+    for (size_t i = 0; i < tableList->size; ++i) {
+        Node *tableNode = tableList->nodes[i];
+        TableScan scan;
+        if(!scanOpen(&scan, tableNode, tableNode)){
+            continue;
+        }
+        int isFragmented;
+        if(scan.pageFile != NULL){
+            size_t freeSpace;
+            pageFileVacuum(scan.pageFile, PAGE_SIZE / 4, &freeSpace);
+            isFragmented = scan.pageFile->pageCount > 2 && freeSpace * 2 >= (scan.pageFile->pageCount - 1) * PAGE_SIZE;
+        }
+        else{
+            size_t liveRows = 0;
+            while (scanNext(&scan)){
+                liveRows++;
+            }
+            isFragmented = scan.deadRows > 0 && scan.deadRows >= liveRows;
+        }
+        scanClose(&scan);
+        // Vacuumed rows change location, the logged changes are applied first
+        if(isFragmented && dbCheckpoint(tableList)){
+            DBOp dbOp = dbVacuum(tableNode, tableNode);
+            vacuumed += dbOp.code == SUCCESS;
+            clearDBOp(&dbOp);
         }
     }
-    else if(dbOp.code == FAIL){
+    return vacuumed;
+}
 
+static pthread_mutex_t dbMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t compactionCond = PTHREAD_COND_INITIALIZER;
+
+/**
+ * Serializes the statements of the prompt with the background compaction
+ */
+void dbLock(){
+    pthread_mutex_lock(&dbMutex);
+}
+
+/**
+ * Releases the lock taken by `dbLock`
+ */
+void dbUnlock(){
+    pthread_mutex_unlock(&dbMutex);
+}
+
+struct {
+    NodeList *tableList;
+    unsigned int seconds;
+} typedef CompactionTask;
+
+static void *compactionLoop(void *arg){
+    CompactionTask *task = arg;
+    pthread_mutex_lock(&dbMutex);
+    while (1){
+        struct timespec deadline;
+        timespec_get(&deadline, TIME_UTC);
+        deadline.tv_sec += task->seconds;
+        // The wait releases the lock so statements run between two passes
+        while (pthread_cond_timedwait(&compactionCond, &dbMutex, &deadline) != ETIMEDOUT){
+        }
+        dbCompact(task->tableList);
     }
-    dbOp.rows = rows;
-    dbOp.rowCount = rowCount;
-    free(tableName);
-    return dbOp;
+    return NULL;
+}
+
+/**
+ * Starts a thread that runs a compaction pass over every table periodically
+ * @param tableList List of every table, read while the database lock is held
+ * @param seconds Time between two passes
+ * @return 1 if the thread was started, 0 otherwise
+ */
+int dbStartCompaction(NodeList *tableList, unsigned int seconds){
+    static CompactionTask task;
+    pthread_t thread;
+    task.tableList = tableList;
+    task.seconds = seconds > 0 ? seconds : 1;
+    if(pthread_create(&thread, NULL, compactionLoop, &task) != 0){
+        return 0;
+    }
+    pthread_detach(thread);
+    return 1;
 }
 
 void printTables(NodeList nodeList){
@@ -984,40 +4106,68 @@ void printTables(NodeList nodeList){
 }
 
 
-DBOp execSQL(char* input, NodeList *tableList){
-    TokenRet tokenRet = lexAnalyze(input);
-    Node node = createASTNode(tokenRet);
-    if(node.isInvalid == 0){
-        Node *tableNode = getNodeFromList(tableList, node.table.value);
+/**
+ * Executes a parsed statement
+ * @param node SQL AST Node
+ * @param tableList Loaded tables
+ * @return Result of the statement
+ */
+static DBOp execNode(const Node *node, NodeList *tableList){
+    if(node->isInvalid == 0){
+        Node *tableNode = getNodeFromList(tableList, node->table.value);
         if(tableNode != NULL){
-            if(isSelectKeyword(node.action.value)){
-                DBOp dbOp = dbSelect(node, *tableNode);
+            if(node->action.keyword == KW_SELECT && node->joinTable.type != TOKEN_EMPTY){
+                Node *joinNode = getNodeFromList(tableList, node->joinTable.value);
+                if(joinNode == NULL){
+                    printError("Table `%s` doesn't exist", node->joinTable.value);
+                    return createDBOp();
+                }
+                return dbSelectJoin(node, tableNode, joinNode);
+            }
+            if(node->action.keyword == KW_SELECT){
+                DBOp dbOp = dbSelect(node, tableNode);
+                return dbOp;
+            }
+            else if(node->action.keyword == KW_INSERT){
+                DBOp dbOp = dbInsert(node, tableNode);
+                return dbOp;
+            }
+            else if(node->action.keyword == KW_DELETE){
+                DBOp dbOp = dbDelete(node, tableNode);
                 return dbOp;
             }
-            else if(isInsertKeyword(node.action.value)){
-                DBOp dbOp = dbInsert(node, *tableNode);
+            else if(node->action.keyword == KW_UPDATE){
+                DBOp dbOp = dbUpdate(node, tableNode);
                 return dbOp;
             }
-            else if(isDeleteKeyword(node.action.value)){
-                DBOp dbOp = dbDelete(node, *tableNode);
+            else if(node->action.keyword == KW_VACUUM){
+                // Row locations change, pending changes are applied first
+                dbCheckpoint(tableList);
+                DBOp dbOp = dbVacuum(node, tableNode);
                 return dbOp;
             }
-            else if(isUpdateKeyword(node.action.value)){
-                DBOp dbOp = dbUpdate(node, *tableNode);
+            else if(node->action.keyword == KW_COPY){
+                DBOp dbOp = node->isCopyTo ? dbCopyTo(node, tableNode) : dbCopyFrom(node, tableNode);
                 return dbOp;
             }
-            else if(isCreateKeyword(node.action.value)){
-                printf("Info: Table `%s` exists", node.table.value);
+            else if(node->action.keyword == KW_ALTER){
+                // Row locations change with the storage, pending changes are applied first
+                dbCheckpoint(tableList);
+                DBOp dbOp = dbAlterStorage(node, tableNode);
+                return dbOp;
+            }
+            else if(node->action.keyword == KW_CREATE){
+                printf("Info: Table `%s` exists", node->table.value);
             }
         }
         else{
-            if(isCreateKeyword(node.action.value)){
+            if(node->action.keyword == KW_CREATE){
                 DBOp dbOp = dbCreateTable(node);
                 *tableList = loadTables();
                 return dbOp;
             }
             else{
-                printError("Table `%s` doesn't exist", node.table.value);
+                printError("Table `%s` doesn't exist", node->table.value);
             }
         }
 
@@ -1025,17 +4175,47 @@ DBOp execSQL(char* input, NodeList *tableList){
     return createDBOp();
 }
 
+DBOp execSQL(char* input, NodeList *tableList){
+    if(isStatementCommand(input)){
+        return execStatementCommand(input, tableList);
+    }
+    if(walNeedsCheckpoint()){
+        dbCheckpoint(tableList);
+    }
+    TokenRet tokenRet = lexAnalyze(input);
+    for (size_t t = 0; t < tokenRet.len; ++t) {
+        if(tokenRet.tokens[t].type == TOKEN_PARAM){
+            DBOp dbOp = createDBOp();
+            appendToBuilder(&dbOp.error, "Parameters `?` can only be used in a prepared statement");
+            dbOp.code = FAIL;
+            freeTokenRet(&tokenRet);
+            return dbOp;
+        }
+    }
+    DBOp dbOp = execNode(createASTNode(&tokenRet), tableList);
+    // The node points to the tokens of the statement, they are freed once it is executed
+    // or with the cursor reading its rows
+    if(dbOp.cursor != NULL){
+        dbOp.cursor->tokens = tokenRet;
+    }
+    else{
+        freeTokenRet(&tokenRet);
+    }
+    return dbOp;
+}
+
 
-void printDbOp(DBOp *dbOp){
-    char* result = dbOp->result;
+/**
+ * Prints rows in the result format as table cells
+ * @param result Rows
+ * @param len Length of the rows
+ * @param colCount Number of columns
+ * @param mSpace Width of a cell
+ */
+static void printRows(const char *result, size_t len, int colCount, size_t mSpace){
     size_t start = 0;
-    size_t mSpace = dbOp->maxColSpace;
     int isEvenTOff;
-    for (int i = 0; i < dbOp->colCount * mSpace + dbOp->colCount; ++i) {
-        printf("_");
-    }
-    printf("\n");
-    for (int i = 0; i < strlen(result); ++i) {
+    for (size_t i = 0; i < len; ++i) {
         if((i>0 && result[i] == ',' && result[i-1] != '\\') || result[i] == '\n'){
             isEvenTOff = 0;
             size_t t_off = (i - start);
@@ -1055,16 +4235,14 @@ void printDbOp(DBOp *dbOp){
             if(isEvenTOff == 1){
                 printf(" ");
             }
-            for (size_t l = start; l < i; ++l) {
-                printf("%c", result[l]);
-            }
+            fwrite(result + start, 1, i - start, stdout);
             for (int j = 0; j < offset/2; ++j) {
                 printf(" ");
             }
             printf("|");
             if(result[i] == '\n'){
                 printf("\n");
-                for (int x = 0; x < dbOp->colCount * mSpace + dbOp->colCount; ++x) {
+                for (int x = 0; x < colCount * mSpace + colCount; ++x) {
                     printf("-");
                 }
                 printf("\n");
@@ -1074,45 +4252,40 @@ void printDbOp(DBOp *dbOp){
     }
 }
 
-char* getRowValue(char** rows, size_t rowIdx, size_t columnIdx, size_t rowCount) {
-    size_t i = 0;
-    size_t commas = 0;
-    if (rowIdx > rowCount){
-        return NULL;
+/**
+ * Prints the result of a statement as a table, the rows of a select are pulled from its cursor
+ * a batch at a time and the cell width is set by the header and the first batch
+ * @param dbOp Database operation
+ */
+void printDbOp(DBOp *dbOp){
+    StringBuilder batch = createStringBuilder();
+    size_t mSpace = dbOp->maxColSpace;
+    size_t batchRows = 0;
+    if(dbOp->cursor != NULL){
+        batchRows = cursorFetch(dbOp->cursor, &batch, CURSOR_BATCH_ROWS, &mSpace);
     }
-    size_t start = 0;
-    char* row = rows[rowIdx];
-    while (1) {
-        if ((i > 0 && row[i] == ',' && row[i - 1] != '\\') || row[i] == '\n') {
-            commas++;
-            if(commas - 2 == columnIdx){
-                char *value = createBufferWithSize(i - start);
-                strncpy(value, row + start, i - start);
-                value[i - start] = '\0';
-                return value;
-            }
-            else{
-                start = i + 1;
-            }
-            if(row[i] == '\n'){
-                break;
-            }
-        }
-        i++;
+    for (int i = 0; i < dbOp->colCount * mSpace + dbOp->colCount; ++i) {
+        printf("_");
     }
-    return NULL;
+    printf("\n");
+    printRows(dbOp->result.data, dbOp->result.len, dbOp->colCount, mSpace);
+    while (batchRows > 0){
+        printRows(batch.data, batch.len, dbOp->colCount, mSpace);
+        batchRows = cursorFetch(dbOp->cursor, &batch, CURSOR_BATCH_ROWS, NULL);
+    }
+    clearStringBuilder(&batch);
 }
 
-int doesTableExist(char* table){
-    int exists = 0;
-    NodeList tables = loadTables();
-    Node *node = getNodeFromList(&tables, table);
-    if(node != NULL){
-        exists = 1;
-        free(node);
-        free(tables.nodes);
-        free(tables.tables);
+char* getRowValue(char** rows, size_t rowIdx, size_t columnIdx, size_t rowCount) {
+    if (rowIdx > rowCount){
+        return NULL;
+    }
+    FieldSlice fields[columnIdx + 1];
+    if (splitRow(rows[rowIdx], fields, columnIdx + 1) <= columnIdx) {
+        return NULL;
     }
-    return exists;
+    char *value = createBufferWithSize(fields[columnIdx].len);
+    memcpy(value, fields[columnIdx].data, fields[columnIdx].len);
+    value[fields[columnIdx].len] = '\0';
+    return value;
 }
-
@@ -3,22 +3,32 @@
 #include <stdio.h>
 #include <string.h>
 #include "lexer.h"
+#include "btree.h"
+#include "hashindex.h"
+#include "page.h"
+#include "wal.h"
+#include "simd.h"
+#include "utils.h"
 
 #ifndef MINISQL_DB_H
 #define MINISQL_DB_H
 
 #define MAX_COL_SIZE 25
 #define MIN_COL_SIZE 15
+// Text of an integer column of a paged row
+#define SCAN_NUMBER_SIZE 24
+// Tables at least this large are read by the worker pool when a select filters their rows
+#define PARALLEL_SCAN_DEFAULT_THRESHOLD (32 * 1024 * 1024)
+// Piece of a table file read by one task of a parallel scan, a thread takes its next morsel once it is done
+#define PARALLEL_SCAN_MORSEL_SIZE (64 * 1024)
+// Morsels per thread whose matching rows a parallel scan holds before they are read back
+#define PARALLEL_SCAN_BATCH_MORSELS 16
 
-int getColumnIndex(Node* node, char* column);
-int matchColumnValue(char* table, size_t colIdx, char* str);
+int getColumnIndex(const Node *node, const char *column);
+int matchColumnValue(const Node *tableNode, int colIdx, const char *str);
 
 NodeList loadTables();
-
-struct {
-    Column columns[COL_MAX_SIZE];
-    int size;
-}typedef TempRow;
+uint64_t dbCatalogVersion();
 
 typedef enum {
         SUCCESS,
@@ -28,10 +38,18 @@ typedef enum {
 
 size_t getMaxColSize(size_t a, size_t b);
 
+// Rows formatted by a cursor fetch
+#define CURSOR_BATCH_ROWS 256
+
+/*
+ * Open result of a select, defined in database.c
+ */
+struct Cursor typedef Cursor;
+
 struct {
-    char* result;
-    char* error;
-    char* successMsg;
+    StringBuilder result;
+    StringBuilder error;
+    StringBuilder successMsg;
     char** rows;
     size_t rowCount;
     size_t maxColSpace;
@@ -39,26 +57,102 @@ struct {
     size_t lineCount;
     int colCount;
     char* action;
+    Cursor *cursor; // Rows of a select, read from the table as they are fetched, NULL for other statements
 } typedef DBOp ; // DB Operation Return type
 
 
-int deleteLine(const char *filename, const size_t *lines, size_t num);
+size_t splitRow(const char *line, FieldSlice *fields, size_t capacity);
+
+/*
+ * Row source of a statement, either the whole table or the rows the primary key index
+ * or a unique column's hash index points to. Text tables are read line by line and
+ * paged tables record by record, the pages of both are read through the buffer pool
+ */
+struct {
+    int fileId; // Buffer pool file id of the table
+    char *page; // Pinned page
+    uint64_t pageNo;
+    size_t pageLength;
+    char *line; // Text table
+    size_t lineSize;
+    size_t lineLength;
+    uint64_t offset; // Offset of the next row
+    PageFile *pageFile; // Paged table
+    uint32_t slot;
+    const char *record;
+    BTree *index;
+    BTreeCursor cursor;
+    uint64_t high; // Last id of the index range
+    HashIndex *hashIndex;
+    HashCursor hashCursor;
+    uint64_t location; // Location of the current row, byte offset or page location
+    WalTable *walTable; // Logged changes not yet in the table file
+    const char *overlay; // Logged content of the current row
+    int isRaw; // Reads the table file without the logged changes
+    size_t deadRows; // Deleted rows of a text table skipped by the scan
+    FieldSlice *fields; // Columns of the current text row, split once per row
+    size_t fieldCount;
+    size_t fieldCapacity;
+    int isSplit;
+    char *numbers; // Text of the integer columns read from a record, SCAN_NUMBER_SIZE bytes per column
+    uint64_t rangeStart; // First page of a paged table scan
+    uint64_t rangeEnd; // Rows starting at or past this byte offset or page are left to the next range of the table
+} typedef TableScan;
+
+int replaceLines(const char *filename, const long *offsets, char **lines, size_t size);
+int deleteLine(const char *filename, const long *offsets, size_t size);
+
+BTree *openPkIndex(const Node *tableNode);
+HashIndex *openUniqueIndex(const Node *tableNode, int colIdx);
+int rebuildIndexes(const Node *tableNode);
+int getRowCount(const Node *tableNode, uint64_t *count);
+int getUniqueFilter(const Node *sqlNode, const Node *tableNode, int *colIdx);
+int getPkRange(const Node *sqlNode, const Node *tableNode, uint64_t *low, uint64_t *high);
+int scanOpen(TableScan *scan, const Node *sqlNode, const Node *tableNode);
+int scanOpenRange(TableScan *scan, const Node *tableNode, uint64_t start, uint64_t end);
+void scanSetParallelThreshold(size_t size);
+int scanFetch(TableScan *scan, uint64_t location);
+int scanNext(TableScan *scan);
+int scanField(TableScan *scan, int colIdx, const char **data, size_t *len);
+char *scanValue(TableScan *scan, int colIdx);
+char *scanRowText(TableScan *scan);
+void scanClose(TableScan *scan);
+size_t encodeRowLine(const Node *tableNode, const char *line, char *out, size_t size);
+int appendRows(const Node *tableNode, const char *rows, size_t len, const size_t *starts, size_t count, uint64_t *locations);
+int planRows(const Node *tableNode, const char *rows, const size_t *starts, size_t count, uint64_t *locations);
+uint64_t appendRow(const Node *tableNode, const char *line);
+int replaceRows(const Node *tableNode, const uint64_t *locations, char **lines, size_t size);
 
 DBOp createDBOp();
-DBOp createDbOpWithHeader(Node sqlNode, Node tableNode);
+DBOp createDbOpWithHeader(const Node *sqlNode, const Node *tableNode);
 
-DBOp dbCreateTable(Node node);
-DBOp dbInsert(Node sqlNode, Node tableNode);
-DBOp dbSelect(Node sqlNode, Node tableNode);
-DBOp dbUpdate(Node sqlNode, Node tableNode);
-DBOp dbDelete(Node sqlNode, Node tableNode);
+DBOp dbCreateTable(const Node *node);
+DBOp dbInsert(const Node *sqlNode, const Node *tableNode);
+DBOp dbSelect(const Node *sqlNode, const Node *tableNode);
+DBOp dbSelectJoin(const Node *sqlNode, const Node *leftNode, const Node *rightNode);
+DBOp dbUpdate(const Node *sqlNode, const Node *tableNode);
+DBOp dbDelete(const Node *sqlNode, const Node *tableNode);
+DBOp dbAlterStorage(const Node *sqlNode, const Node *tableNode);
+int dbCheckpoint(NodeList *tableList);
+int dbRecover(NodeList *tableList);
+DBOp dbVacuum(const Node *sqlNode, const Node *tableNode);
+DBOp dbCopyFrom(const Node *sqlNode, const Node *tableNode);
+DBOp dbCopyTo(const Node *sqlNode, const Node *tableNode);
+int dbCompact(NodeList *tableList);
+void dbLock();
+void dbUnlock();
+int dbStartCompaction(NodeList *tableList, unsigned int seconds);
 
 
 DBOp execSQL(char* input, NodeList *tableList);
 
+int cursorNext(Cursor *cursor);
+int cursorField(Cursor *cursor, int col, const char **data, size_t *len);
+size_t cursorFetch(Cursor *cursor, StringBuilder *batch, size_t maxRows, size_t *maxColSpace);
+void cursorClose(Cursor *cursor);
+
 char* getRowValue(char** rows, size_t rowIdx, size_t columnIdx, size_t rowCount);
 void clearDBOp(DBOp *dbOp);
 void printDbOp(DBOp *dbOp);
 void printTables(NodeList nodeList);
-int doesTableExist(char* table);
 #endif //MINISQL_DB_H
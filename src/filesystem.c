@@ -1,9 +1,11 @@
 #include <stdio.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <errno.h>
 
 #ifdef _WIN32
 #include <windows.h>
+#include <io.h>
 #else
 #include <sys/stat.h>
 #include <unistd.h>
@@ -51,6 +53,22 @@ int fileExists(char* filename){
 
 
 
+/**
+ * Size of a file in bytes
+ * @param filename Name of the file
+ * @return Size of the file or -1 if it can't be opened
+ */
+long getFileSize(const char *filename){
+    FILE *file = fopen(filename, "rb");
+    if(file == NULL){
+        return -1;
+    }
+    long size = fseek(file, 0, SEEK_END) == 0 ? ftell(file) : -1;
+    fclose(file);
+    return size;
+}
+
+
 /**
  * Opens a file given a filename, and write in the file
  * @param filename Name of the file
@@ -132,3 +150,84 @@ int putInFile(char *fileName, char* text, int addNewLine){
     return 0;
 }
 
+
+/**
+ * Flushes a file to the disk, the data survives a crash once this returns
+ * @param file Opened file
+ * @returns 1 if the file was synced, 0 otherwise
+ */
+int syncFile(FILE *file){
+    if(fflush(file) != 0){
+        return 0;
+    }
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+/**
+ * Reads from an offset of a file without moving its stream, several threads can read
+ * the same file at once. Data written to the stream must be flushed first
+ * @param file Opened file
+ * @param buffer Output buffer
+ * @param size Bytes to read
+ * @param offset Offset in the file
+ * @returns Bytes read, less than size at the end of the file or on error
+ */
+size_t readFileAt(FILE *file, void *buffer, size_t size, uint64_t offset){
+    size_t total = 0;
+    while (total < size){
+#ifdef _WIN32
+        OVERLAPPED overlapped = {0};
+        overlapped.Offset = (DWORD)(offset + total);
+        overlapped.OffsetHigh = (DWORD)((offset + total) >> 32);
+        DWORD read = 0;
+        if(!ReadFile((HANDLE)_get_osfhandle(_fileno(file)), (char *)buffer + total, (DWORD)(size - total), &read, &overlapped) || read == 0){
+            break;
+        }
+#else
+        ssize_t read = pread(fileno(file), (char *)buffer + total, size - total, (off_t)(offset + total));
+        if(read == -1 && errno == EINTR){
+            continue;
+        }
+        if(read <= 0){
+            break;
+        }
+#endif
+        total += (size_t)read;
+    }
+    return total;
+}
+
+/**
+ * Cuts a file to a size
+ * @param file Opened file
+ * @param size New size of the file in bytes
+ * @returns 1 if the file was truncated, 0 otherwise
+ */
+int truncateFile(FILE *file, long size){
+    if(fflush(file) != 0){
+        return 0;
+    }
+#ifdef _WIN32
+    return _chsize(_fileno(file), size) == 0;
+#else
+    return ftruncate(fileno(file), size) == 0;
+#endif
+}
+
+/**
+ * Renames a file over another one, atomic where the platform allows replacing on rename
+ * @param fileName Name of the new file
+ * @param target Name of the replaced file
+ * @returns 0 if the file was replaced
+ */
+int replaceFile(const char *fileName, const char *target){
+    if(rename(fileName, target) == 0){
+        return 0;
+    }
+    remove(target);
+    return rename(fileName, target);
+}
@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <errno.h>
 
 #ifndef MINISQL_FILESYSTEM_H
@@ -8,5 +9,10 @@
 int directory_exists(const char* path);
 int create_directory(const char* path);
 int fileExists(char* filename);
+long getFileSize(const char *filename);
+int syncFile(FILE *file);
+size_t readFileAt(FILE *file, void *buffer, size_t size, uint64_t offset);
+int truncateFile(FILE *file, long size);
+int replaceFile(const char *fileName, const char *target);
 
 #endif //MINISQL_FILESYSTEM_H
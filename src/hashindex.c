@@ -0,0 +1,304 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "hashindex.h"
+
+#define HASH_MAGIC 0x4d53514c48415348ULL
+
+/*
+ * Header stored in page 0 of the index file
+ */
+struct {
+    uint64_t magic;
+    uint64_t bucketCount;
+    uint64_t entryCount;
+    uint64_t pageCount;
+} typedef HashHeader;
+
+
+/**
+ * FNV-1a hash of a column value
+ * @param key Column value
+ * @return 64 bit hash
+ */
+uint64_t hashKey(const char *key){
+    uint64_t hash = 14695981039346656037ULL;
+    for (const unsigned char *c = (const unsigned char *)key; *c; ++c) {
+        hash ^= *c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static int readHashPage(HashIndex *index, uint64_t pageNo, HashPage *page){
+    if(fseek(index->file, (long)(pageNo * HASH_PAGE_SIZE), SEEK_SET) != 0){
+        return 0;
+    }
+    return fread(page, sizeof(HashPage), 1, index->file) == 1;
+}
+
+static int writeHashPage(HashIndex *index, uint64_t pageNo, const HashPage *page){
+    if(fseek(index->file, (long)(pageNo * HASH_PAGE_SIZE), SEEK_SET) != 0){
+        return 0;
+    }
+    return fwrite(page, sizeof(HashPage), 1, index->file) == 1;
+}
+
+static int writeHashHeader(HashIndex *index){
+    HashHeader header = {HASH_MAGIC, index->bucketCount, index->entryCount, index->pageCount};
+    if(fseek(index->file, 0, SEEK_SET) != 0){
+        return 0;
+    }
+    return fwrite(&header, sizeof(HashHeader), 1, index->file) == 1;
+}
+
+/**
+ * Writes a whole index in an empty file, the bucket count is picked
+ * so buckets are about half full
+ * @param index Index with an opened, truncated file
+ * @param hashes Hash of every entry
+ * @param values Value of every entry
+ * @param size Number of entries
+ * @return 1 if the index was written, 0 otherwise
+ */
+static int writeHashEntries(HashIndex *index, const uint64_t *hashes, const uint64_t *values, size_t size){
+    uint64_t bucketCount = HASH_INITIAL_BUCKETS;
+    while(size > bucketCount * HASH_PAGE_ENTRIES / 2){
+        bucketCount *= 2;
+    }
+    size_t capacity = bucketCount + bucketCount / 4 + 1;
+    size_t pageCount = bucketCount;
+    HashPage *pages = calloc(capacity, sizeof(HashPage));
+    uint64_t *tails = malloc(sizeof(uint64_t) * bucketCount);
+    if(pages == NULL || tails == NULL){
+        free(pages);
+        free(tails);
+        return 0;
+    }
+    for (uint64_t b = 0; b < bucketCount; ++b) {
+        tails[b] = b;
+    }
+    for (size_t i = 0; i < size; ++i) {
+        uint64_t bucket = hashes[i] % bucketCount;
+        HashPage *tail = &pages[tails[bucket]];
+        if(tail->count == HASH_PAGE_ENTRIES){
+            if(pageCount == capacity){
+                capacity *= 2;
+                HashPage *temp = realloc(pages, sizeof(HashPage) * capacity);
+                if(temp == NULL){
+                    free(pages);
+                    free(tails);
+                    return 0;
+                }
+                pages = temp;
+            }
+            memset(&pages[pageCount], 0, sizeof(HashPage));
+            // In memory page i is page i + 1 in the file, page 0 is the header
+            pages[tails[bucket]].next = pageCount + 1;
+            tails[bucket] = pageCount;
+            tail = &pages[pageCount];
+            pageCount++;
+        }
+        tail->hashes[tail->count] = hashes[i];
+        tail->values[tail->count] = values[i];
+        tail->count++;
+    }
+    index->bucketCount = bucketCount;
+    index->entryCount = size;
+    index->pageCount = pageCount + 1;
+    int ok = writeHashHeader(index);
+    for (size_t p = 0; p < pageCount && ok; ++p) {
+        ok = writeHashPage(index, p + 1, &pages[p]);
+    }
+    free(pages);
+    free(tails);
+    return ok;
+}
+
+/**
+ * Doubles the buckets of an index once they are more than half full,
+ * the stored hashes are redistributed without reading the table
+ * @param index Hash index
+ * @return 1 if the index was rebuilt, 0 otherwise
+ */
+static int growHashIndex(HashIndex *index){
+    uint64_t *hashes = malloc(sizeof(uint64_t) * (index->entryCount + 1));
+    uint64_t *values = malloc(sizeof(uint64_t) * (index->entryCount + 1));
+    size_t size = 0;
+    int ok = hashes != NULL && values != NULL;
+    HashPage page;
+    for (uint64_t p = 1; p < index->pageCount && ok; ++p) {
+        ok = readHashPage(index, p, &page);
+        for (uint32_t i = 0; ok && i < page.count && size < index->entryCount; ++i) {
+            hashes[size] = page.hashes[i];
+            values[size] = page.values[i];
+            size++;
+        }
+    }
+    if(ok){
+        FILE *file = freopen(index->fileName, "w+b", index->file);
+        index->file = file;
+        ok = file != NULL && writeHashEntries(index, hashes, values, size);
+    }
+    free(hashes);
+    free(values);
+    return ok;
+}
+
+/**
+ * Opens a hash index file, creates an empty index if the file doesn't exist
+ * @param fileName Index file name
+ * @return Hash index or NULL if the file is not a valid index
+ */
+HashIndex *hashIndexOpen(const char *fileName){
+    HashIndex *index = malloc(sizeof(HashIndex));
+    if(index == NULL){
+        return NULL;
+    }
+    index->fileName = malloc(strlen(fileName) + 1);
+    if(index->fileName == NULL){
+        free(index);
+        return NULL;
+    }
+    strcpy(index->fileName, fileName);
+    index->file = fopen(fileName, "r+b");
+    if(index->file != NULL){
+        HashHeader header;
+        if(fread(&header, sizeof(HashHeader), 1, index->file) == 1 && header.magic == HASH_MAGIC){
+            index->bucketCount = header.bucketCount;
+            index->entryCount = header.entryCount;
+            index->pageCount = header.pageCount;
+            return index;
+        }
+    }
+    else{
+        index->file = fopen(fileName, "w+b");
+        if(index->file != NULL && writeHashEntries(index, NULL, NULL, 0)){
+            return index;
+        }
+    }
+    if(index->file != NULL){
+        fclose(index->file);
+    }
+    free(index->fileName);
+    free(index);
+    return NULL;
+}
+
+/**
+ * Closes the index file
+ * @param index Hash index
+ */
+void hashIndexClose(HashIndex *index){
+    if(index == NULL){
+        return;
+    }
+    if(index->file != NULL){
+        fclose(index->file);
+    }
+    free(index->fileName);
+    free(index);
+}
+
+/**
+ * Adds an entry to the bucket of the key, an overflow page is chained when the bucket is full
+ * @param index Hash index
+ * @param key Column value
+ * @param value Row offset
+ * @return 1 if the entry was stored, 0 on io error
+ */
+int hashIndexInsert(HashIndex *index, const char *key, uint64_t value){
+    uint64_t hash = hashKey(key);
+    uint64_t pageNo = 1 + hash % index->bucketCount;
+    HashPage page;
+    while(1){
+        if(!readHashPage(index, pageNo, &page)){
+            return 0;
+        }
+        if(page.count < HASH_PAGE_ENTRIES){
+            break;
+        }
+        if(page.next == 0){
+            uint64_t overflow = index->pageCount++;
+            page.next = overflow;
+            if(!writeHashPage(index, pageNo, &page)){
+                return 0;
+            }
+            memset(&page, 0, sizeof(HashPage));
+            pageNo = overflow;
+            break;
+        }
+        pageNo = page.next;
+    }
+    page.hashes[page.count] = hash;
+    page.values[page.count] = value;
+    page.count++;
+    index->entryCount++;
+    if(!writeHashPage(index, pageNo, &page) || !writeHashHeader(index)){
+        return 0;
+    }
+    if(index->entryCount > index->bucketCount * HASH_PAGE_ENTRIES / 2){
+        return growHashIndex(index);
+    }
+    return 1;
+}
+
+/**
+ * Positions a cursor on the bucket of a key
+ * @param index Hash index
+ * @param key Column value
+ * @return Cursor to iterate with `hashIndexNext`
+ */
+HashCursor hashIndexFind(HashIndex *index, const char *key){
+    HashCursor cursor;
+    cursor.index = index;
+    cursor.hash = hashKey(key);
+    cursor.idx = 0;
+    cursor.isValid = readHashPage(index, 1 + cursor.hash % index->bucketCount, &cursor.page);
+    return cursor;
+}
+
+/**
+ * Returns the next row offset whose value has the same hash as the key,
+ * the caller compares the row value to rule out collisions
+ * @param cursor Cursor created by `hashIndexFind`
+ * @param value Row offset
+ * @return 1 if an entry was found, 0 at the end of the bucket
+ */
+int hashIndexNext(HashCursor *cursor, uint64_t *value){
+    while(cursor->isValid){
+        while(cursor->idx < cursor->page.count){
+            uint32_t idx = cursor->idx++;
+            if(cursor->page.hashes[idx] == cursor->hash){
+                *value = cursor->page.values[idx];
+                return 1;
+            }
+        }
+        if(cursor->page.next == 0 || !readHashPage(cursor->index, cursor->page.next, &cursor->page)){
+            cursor->isValid = 0;
+            break;
+        }
+        cursor->idx = 0;
+    }
+    return 0;
+}
+
+/**
+ * Builds a new index file from all the entries at once
+ * @param fileName Index file name, replaced if it exists
+ * @param hashes Hash of every entry, see `hashKey`
+ * @param values Row offset of every entry
+ * @param size Number of entries
+ * @return 1 if the index was built, 0 on io error
+ */
+int hashIndexBuild(const char *fileName, const uint64_t *hashes, const uint64_t *values, size_t size){
+    HashIndex index;
+    index.file = fopen(fileName, "w+b");
+    if(index.file == NULL){
+        return 0;
+    }
+    int ok = writeHashEntries(&index, hashes, values, size);
+    fclose(index.file);
+    return ok;
+}
@@ -0,0 +1,50 @@
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef MINISQL_HASHINDEX_H
+#define MINISQL_HASHINDEX_H
+
+#define HASH_PAGE_SIZE 4096
+// Entries a bucket page holds, sized so a page fits in HASH_PAGE_SIZE
+#define HASH_PAGE_ENTRIES 255
+#define HASH_INITIAL_BUCKETS 16
+
+/*
+ * Bucket page of a hash index, page 0 of the file is the index header,
+ * pages 1 to bucketCount are the buckets and the rest are overflow pages chained by `next`
+ * Only the hash of a value is stored, the row at `values[i]` has the actual value
+ */
+struct {
+    uint64_t next;
+    uint32_t count;
+    uint32_t reserved;
+    uint64_t hashes[HASH_PAGE_ENTRIES];
+    uint64_t values[HASH_PAGE_ENTRIES];
+} typedef HashPage;
+
+struct {
+    FILE *file;
+    char *fileName;
+    uint64_t bucketCount;
+    uint64_t entryCount;
+    uint64_t pageCount;
+} typedef HashIndex;
+
+struct {
+    HashIndex *index;
+    HashPage page;
+    uint64_t hash;
+    uint32_t idx;
+    int isValid;
+} typedef HashCursor;
+
+uint64_t hashKey(const char *key);
+HashIndex *hashIndexOpen(const char *fileName);
+void hashIndexClose(HashIndex *index);
+int hashIndexInsert(HashIndex *index, const char *key, uint64_t value);
+HashCursor hashIndexFind(HashIndex *index, const char *key);
+int hashIndexNext(HashCursor *cursor, uint64_t *value);
+int hashIndexBuild(const char *fileName, const uint64_t *hashes, const uint64_t *values, size_t size);
+
+#endif //MINISQL_HASHINDEX_H
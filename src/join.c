@@ -0,0 +1,435 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "join.h"
+#include "const.h"
+#include "utils.h"
+
+static size_t memoryBudget = JOIN_DEFAULT_BUDGET;
+// Numbers the partition files, every partition of the process has its own file
+static size_t partitionId = 0;
+
+
+/**
+ * Sets the memory the build side of a join can use before the join is partitioned
+ * @param budget Bytes
+ */
+void joinSetMemoryBudget(size_t budget){
+    memoryBudget = budget;
+}
+
+/**
+ * FNV-1a hash of a join key, mixed so the partitions can take its high bits
+ * @param key Key
+ * @return Hash
+ */
+static uint64_t hashJoinKey(const FieldSlice *key){
+    uint64_t hash = 1469598103934665603ULL;
+    for (size_t i = 0; i < key->len; ++i) {
+        hash ^= (unsigned char)key->data[i];
+        hash *= 1099511628211ULL;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+/**
+ * Partition of a key hash
+ * @param hash Hash of the key
+ * @return Partition index
+ */
+static size_t getPartition(uint64_t hash){
+    return (size_t)(hash >> 40) & (JOIN_PARTITIONS - 1);
+}
+
+/**
+ * Creates a hash join
+ * @param join Join to initialize, freed with `hashJoinFree`
+ * @param buildFieldCount Fields of a build row
+ * @param probeFieldCount Fields of a probe row
+ */
+void hashJoinInit(HashJoin *join, size_t buildFieldCount, size_t probeFieldCount){
+    memset(join, 0, sizeof(HashJoin));
+    join->buildFieldCount = buildFieldCount;
+    join->probeFieldCount = probeFieldCount;
+    join->budget = memoryBudget;
+}
+
+/**
+ * Adds a build row to the rows in memory, its key and fields are copied to the arena
+ * @param join Join
+ * @param hash Hash of the key
+ * @param key Key
+ * @param fields Fields of the row
+ * @return 1 if the row is added, 0 if out of memory
+ */
+static int addRow(HashJoin *join, uint64_t hash, const FieldSlice *key, const FieldSlice *fields){
+    if(join->arena == NULL){
+        join->arena = arenaCreate(4096);
+        if(join->arena == NULL){
+            return 0;
+        }
+    }
+    if(join->size == join->capacity){
+        size_t capacity = join->capacity == 0 ? 64 : join->capacity * 2;
+        JoinRow *rows = realloc(join->rows, sizeof(JoinRow) * capacity);
+        if(rows == NULL){
+            return 0;
+        }
+        join->rows = rows;
+        join->capacity = capacity;
+    }
+    JoinRow *row = &join->rows[join->size];
+    size_t fieldCount = join->buildFieldCount;
+    row->hash = hash;
+    row->next = 0;
+    row->key.len = key->len;
+    row->key.data = arenaCopy(join->arena, key->data, key->len);
+    row->fields = arenaAlloc(join->arena, sizeof(FieldSlice) * (fieldCount > 0 ? fieldCount : 1));
+    if(row->key.data == NULL || row->fields == NULL){
+        return 0;
+    }
+    size_t memory = sizeof(JoinRow) + sizeof(uint32_t) * 2 + key->len + sizeof(FieldSlice) * fieldCount;
+    for (size_t i = 0; i < fieldCount; ++i) {
+        row->fields[i].len = fields[i].len;
+        row->fields[i].data = arenaCopy(join->arena, fields[i].data, fields[i].len);
+        if(row->fields[i].data == NULL){
+            return 0;
+        }
+        memory += fields[i].len + 1;
+    }
+    join->size++;
+    join->memory += memory;
+    return 1;
+}
+
+/**
+ * Writes a row to a partition file as its key and fields, each one prefixed with its length
+ * @param file Partition file, opened on the first row
+ * @param name Name of the partition file
+ * @param key Key
+ * @param fields Fields of the row
+ * @param fieldCount Number of fields
+ * @return 1 if the row is written, 0 on io error
+ */
+static int writeRow(FILE **file, char **name, const FieldSlice *key, const FieldSlice *fields, size_t fieldCount){
+    if(*file == NULL){
+        *name = createBuffer();
+        insertInBuffer(name, "%s/join_%zu.tmp", DATA_DIR, partitionId++);
+        *file = fopen(*name, "wb");
+        if(*file == NULL){
+            clearBuffer(name);
+            return 0;
+        }
+    }
+    size_t total = sizeof(size_t) + key->len;
+    for (size_t i = 0; i < fieldCount; ++i) {
+        total += sizeof(size_t) + fields[i].len;
+    }
+    if(fwrite(&total, sizeof(total), 1, *file) != 1 || fwrite(&key->len, sizeof(size_t), 1, *file) != 1 ||
+       fwrite(key->data, 1, key->len, *file) != key->len){
+        return 0;
+    }
+    for (size_t i = 0; i < fieldCount; ++i) {
+        if(fwrite(&fields[i].len, sizeof(size_t), 1, *file) != 1 || fwrite(fields[i].data, 1, fields[i].len, *file) != fields[i].len){
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * Reads the next row of a partition file, the key and the fields point into the line of the join
+ * @param join Join
+ * @param file Partition file
+ * @param fieldCount Number of fields
+ * @return 1 if a row is read, 0 at the end of the file or on memory error
+ */
+static int readRow(HashJoin *join, FILE *file, size_t fieldCount){
+    size_t total;
+    if(fread(&total, sizeof(total), 1, file) != 1){
+        return 0;
+    }
+    if(total > join->lineSize){
+        char *line = realloc(join->line, total);
+        if(line == NULL){
+            return 0;
+        }
+        join->line = line;
+        join->lineSize = total;
+    }
+    if(join->lineFields == NULL){
+        size_t count = (join->buildFieldCount > join->probeFieldCount ? join->buildFieldCount : join->probeFieldCount) + 1;
+        join->lineFields = malloc(sizeof(FieldSlice) * count);
+        if(join->lineFields == NULL){
+            return 0;
+        }
+    }
+    if(fread(join->line, 1, total, file) != total){
+        return 0;
+    }
+    size_t offset = 0;
+    for (size_t i = 0; i < fieldCount + 1; ++i) {
+        memcpy(&join->lineFields[i].len, join->line + offset, sizeof(size_t));
+        offset += sizeof(size_t);
+        join->lineFields[i].data = join->line + offset;
+        offset += join->lineFields[i].len;
+    }
+    return 1;
+}
+
+/**
+ * Releases the build rows in memory
+ * @param join Join
+ */
+static void resetRows(HashJoin *join){
+    arenaFree(join->arena);
+    join->arena = NULL;
+    free(join->buckets);
+    join->buckets = NULL;
+    join->bucketCount = 0;
+    join->size = 0;
+    join->memory = 0;
+    join->match = 0;
+}
+
+/**
+ * Moves the build rows in memory to the partition files, the join is partitioned from then on
+ * @param join Join
+ * @return 1 if the rows are written, 0 on io error
+ */
+static int partitionRows(HashJoin *join){
+    join->isPartitioned = 1;
+    for (size_t i = 0; i < join->size; ++i) {
+        JoinPartition *partition = &join->partitions[getPartition(join->rows[i].hash)];
+        if(!writeRow(&partition->build, &partition->buildName, &join->rows[i].key, join->rows[i].fields, join->buildFieldCount)){
+            return 0;
+        }
+    }
+    resetRows(join);
+    return 1;
+}
+
+/**
+ * Adds a row of the build side, a row with an empty key never matches and is dropped
+ * @param join Join
+ * @param key Key of the row
+ * @param fields Fields of the row
+ * @return 1 if the row is added, 0 on memory or io error
+ */
+int hashJoinBuild(HashJoin *join, const FieldSlice *key, const FieldSlice *fields){
+    if(key->len == 0){
+        return 1;
+    }
+    uint64_t hash = hashJoinKey(key);
+    if(join->isPartitioned){
+        JoinPartition *partition = &join->partitions[getPartition(hash)];
+        return writeRow(&partition->build, &partition->buildName, key, fields, join->buildFieldCount);
+    }
+    if(!addRow(join, hash, key, fields)){
+        return 0;
+    }
+    return join->memory <= join->budget || partitionRows(join);
+}
+
+/**
+ * Chains the build rows in memory by the bucket of their key
+ * @param join Join
+ * @return 1 if the buckets are built, 0 if out of memory
+ */
+static int buildBuckets(HashJoin *join){
+    size_t bucketCount = 16;
+    while (bucketCount < join->size * 2){
+        bucketCount *= 2;
+    }
+    join->buckets = calloc(bucketCount, sizeof(uint32_t));
+    if(join->buckets == NULL){
+        return 0;
+    }
+    join->bucketCount = bucketCount;
+    for (size_t i = 0; i < join->size; ++i) {
+        size_t bucket = join->rows[i].hash & (bucketCount - 1);
+        join->rows[i].next = join->buckets[bucket];
+        join->buckets[bucket] = (uint32_t)(i + 1);
+    }
+    return 1;
+}
+
+/**
+ * Ends the build side, the probe rows can be added
+ * @param join Join
+ * @return 1 if the build side is ready, 0 on memory or io error
+ */
+int hashJoinFinishBuild(HashJoin *join){
+    if(!join->isPartitioned){
+        return buildBuckets(join);
+    }
+    int ok = 1;
+    for (size_t p = 0; p < JOIN_PARTITIONS; ++p) {
+        if(join->partitions[p].build != NULL){
+            ok = fclose(join->partitions[p].build) == 0 && ok;
+            join->partitions[p].build = NULL;
+        }
+    }
+    return ok;
+}
+
+/**
+ * Adds a row of the probe side. Without partitions its matches are returned by `hashJoinNext`
+ * before the next probe row, otherwise it is written to its partition and matched once the probe side is finished
+ * @param join Join with a finished build side
+ * @param key Key of the row
+ * @param fields Fields of the row, kept until the next probe row
+ * @return 1 if the row is added, 0 on io error
+ */
+int hashJoinProbe(HashJoin *join, const FieldSlice *key, const FieldSlice *fields){
+    join->match = 0;
+    if(key->len == 0){
+        return 1;
+    }
+    uint64_t hash = hashJoinKey(key);
+    if(join->isPartitioned){
+        JoinPartition *partition = &join->partitions[getPartition(hash)];
+        // A probe row without build rows in its partition has no match
+        return partition->buildName == NULL ||
+               writeRow(&partition->probe, &partition->probeName, key, fields, join->probeFieldCount);
+    }
+    join->probeKey = *key;
+    join->probeFields = fields;
+    join->probeHash = hash;
+    join->match = join->bucketCount > 0 ? join->buckets[hash & (join->bucketCount - 1)] : 0;
+    return 1;
+}
+
+/**
+ * Ends the probe side, the partitions are joined by the next calls to `hashJoinNext`
+ * @param join Join
+ * @return 1 if the partitions can be read, 0 on io error
+ */
+int hashJoinFinishProbe(HashJoin *join){
+    join->isProbeFinished = 1;
+    join->match = 0;
+    int ok = 1;
+    for (size_t p = 0; p < JOIN_PARTITIONS; ++p) {
+        if(join->partitions[p].probe != NULL){
+            ok = fclose(join->partitions[p].probe) == 0 && ok;
+            join->partitions[p].probe = NULL;
+        }
+    }
+    return ok;
+}
+
+/**
+ * Removes the files of a partition
+ * @param partition Partition
+ */
+static void removePartition(JoinPartition *partition){
+    if(partition->build != NULL){
+        fclose(partition->build);
+        partition->build = NULL;
+    }
+    if(partition->probe != NULL){
+        fclose(partition->probe);
+        partition->probe = NULL;
+    }
+    if(partition->buildName != NULL){
+        remove(partition->buildName);
+        clearBuffer(&partition->buildName);
+    }
+    if(partition->probeName != NULL){
+        remove(partition->probeName);
+        clearBuffer(&partition->probeName);
+    }
+}
+
+/**
+ * Loads the build rows of the next partition with probe rows and opens its probe rows,
+ * a partition larger than the memory budget is still joined in memory
+ * @param join Join with a finished probe side
+ * @return 1 if a partition is loaded, 0 once every partition is joined or on io error
+ */
+static int loadPartition(HashJoin *join){
+    while (join->partition < JOIN_PARTITIONS){
+        JoinPartition *partition = &join->partitions[join->partition];
+        if(partition->buildName == NULL || partition->probeName == NULL){
+            removePartition(partition);
+            join->partition++;
+            continue;
+        }
+        resetRows(join);
+        FILE *file = fopen(partition->buildName, "rb");
+        int ok = file != NULL;
+        while (ok && readRow(join, file, join->buildFieldCount)){
+            ok = addRow(join, hashJoinKey(&join->lineFields[0]), &join->lineFields[0], &join->lineFields[1]);
+        }
+        if(file != NULL){
+            fclose(file);
+        }
+        join->probeFile = ok && buildBuckets(join) ? fopen(partition->probeName, "rb") : NULL;
+        if(join->probeFile == NULL){
+            printError("Unable to read a join partition");
+            return 0;
+        }
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Next match of the join, the matches of the current probe row then, once the probe side is finished,
+ * the matches of every partition
+ * @param join Join
+ * @return 1 if `buildFields` and `probeFields` hold a match, 0 if the probe row has no more matches
+ *           or once every partition is joined
+ */
+int hashJoinNext(HashJoin *join){
+    while (1){
+        while (join->match != 0){
+            const JoinRow *row = &join->rows[join->match - 1];
+            join->match = row->next;
+            if(row->hash == join->probeHash && row->key.len == join->probeKey.len &&
+               memcmp(row->key.data, join->probeKey.data, row->key.len) == 0){
+                join->buildFields = row->fields;
+                return 1;
+            }
+        }
+        if(!join->isPartitioned || !join->isProbeFinished){
+            return 0;
+        }
+        if(join->probeFile != NULL && readRow(join, join->probeFile, join->probeFieldCount)){
+            join->probeKey = join->lineFields[0];
+            join->probeFields = &join->lineFields[1];
+            join->probeHash = hashJoinKey(&join->probeKey);
+            join->match = join->buckets[join->probeHash & (join->bucketCount - 1)];
+            continue;
+        }
+        if(join->probeFile != NULL){
+            fclose(join->probeFile);
+            join->probeFile = NULL;
+            removePartition(&join->partitions[join->partition++]);
+        }
+        if(!loadPartition(join)){
+            return 0;
+        }
+    }
+}
+
+/**
+ * Frees the rows of a join and removes its partition files
+ * @param join Join
+ */
+void hashJoinFree(HashJoin *join){
+    resetRows(join);
+    if(join->probeFile != NULL){
+        fclose(join->probeFile);
+    }
+    for (size_t p = 0; p < JOIN_PARTITIONS; ++p) {
+        removePartition(&join->partitions[p]);
+    }
+    free(join->rows);
+    free(join->line);
+    free(join->lineFields);
+    memset(join, 0, sizeof(HashJoin));
+}
@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
+#include "simd.h"
+
+#ifndef MINISQL_JOIN_H
+#define MINISQL_JOIN_H
+
+// Memory the build side of a join can use before both sides are partitioned to files
+#define JOIN_DEFAULT_BUDGET (64 * 1024 * 1024)
+// Partition files of each side of a grace hash join
+#define JOIN_PARTITIONS 16
+
+/*
+ * Row of the build side held in memory, the rows of a bucket are chained
+ */
+struct {
+    uint64_t hash;
+    FieldSlice key;
+    FieldSlice *fields;
+    uint32_t next; // Next row of the bucket + 1, 0 at the end of the chain
+} typedef JoinRow;
+
+/*
+ * Build and probe rows whose key hashes to a partition of a grace hash join
+ */
+struct {
+    FILE *build;
+    char *buildName;
+    FILE *probe;
+    char *probeName;
+} typedef JoinPartition;
+
+/*
+ * Hash join of the rows of two tables on equal keys. The build side is held in a chained hash
+ * table and every probe row is matched as it is read. Once the build side uses more memory
+ * than the budget, the rows of both sides are written to partition files by the hash of their key
+ * and the partitions are joined one at a time after the probe side is read
+ */
+struct {
+    size_t buildFieldCount;
+    size_t probeFieldCount;
+    size_t budget;
+    Arena *arena; // Keys and fields of the build rows in memory
+    JoinRow *rows;
+    size_t size;
+    size_t capacity;
+    uint32_t *buckets; // First row of a bucket + 1
+    size_t bucketCount;
+    size_t memory;
+    int isPartitioned;
+    JoinPartition partitions[JOIN_PARTITIONS];
+    size_t partition; // Partition being joined once the probe side is read
+    FILE *probeFile; // Probe rows of the partition being joined
+    FieldSlice probeKey;
+    const FieldSlice *probeFields; // Current probe row
+    uint64_t probeHash;
+    uint32_t match; // Next candidate build row of the probe row + 1
+    const FieldSlice *buildFields; // Build row of the last match
+    char *line; // Row read back from a partition
+    size_t lineSize;
+    FieldSlice *lineFields;
+    int isProbeFinished;
+} typedef HashJoin;
+
+void joinSetMemoryBudget(size_t budget);
+void hashJoinInit(HashJoin *join, size_t buildFieldCount, size_t probeFieldCount);
+int hashJoinBuild(HashJoin *join, const FieldSlice *key, const FieldSlice *fields);
+int hashJoinFinishBuild(HashJoin *join);
+int hashJoinProbe(HashJoin *join, const FieldSlice *key, const FieldSlice *fields);
+int hashJoinFinishProbe(HashJoin *join);
+int hashJoinNext(HashJoin *join);
+void hashJoinFree(HashJoin *join);
+
+#endif //MINISQL_JOIN_H
@@ -6,17 +6,180 @@
 #include "utils.h"
 #include "lexer.h"
 #include "const.h"
+#include "arena.h"
 
 
-TokenType getTokenType(const char *token){
-    if (isKeyword(token)){
-        return TOKEN_KEYWORD;
+// Slots of the keyword table, a power of two
+#define KEYWORD_TABLE_SIZE 128
+#define KEYWORD_MAX_LEN 8
+
+/*
+ * Perfect hash table of the reserved words, every word has its own slot for `hashKeyword`
+ * The multipliers were found by trying small values until no two words shared a slot,
+ * a new word needs new multipliers or a larger table if it collides
+ */
+static const Keyword KEYWORD_TABLE[KEYWORD_TABLE_SIZE] = {
+        [2] = {"STORAGE", 7, TOKEN_KEYWORD, KW_STORAGE},
+        [3] = {"ORDER", 5, TOKEN_KEYWORD, KW_ORDER},
+        [4] = {"INSERT", 6, TOKEN_KEYWORD, KW_INSERT},
+        [5] = {"INTEGER", 7, TOKEN_DATA_TYPE, KW_INTEGER},
+        [10] = {"ON", 2, TOKEN_KEYWORD, KW_ON},
+        [16] = {"SET", 3, TOKEN_KEYWORD, KW_SET},
+        [17] = {"SERIAL", 6, TOKEN_DATA_TYPE, KW_SERIAL},
+        [20] = {"PRIMARY", 7, TOKEN_BUILT_IN_FUNC, KW_PRIMARY},
+        [23] = {"TEXT", 4, TOKEN_DATA_TYPE, KW_TEXT},
+        [25] = {"SELECT", 6, TOKEN_KEYWORD, KW_SELECT},
+        [27] = {"UPDATE", 6, TOKEN_KEYWORD, KW_UPDATE},
+        [31] = {"TABLE", 5, TOKEN_KEYWORD, KW_TABLE},
+        [32] = {"BOOLEAN", 7, TOKEN_DATA_TYPE, KW_BOOLEAN},
+        [34] = {"RANDOM", 6, TOKEN_BUILT_IN_FUNC, KW_RANDOM},
+        [37] = {"UNIQUE", 6, TOKEN_BUILT_IN_FUNC, KW_UNIQUE},
+        [38] = {"COPY", 4, TOKEN_KEYWORD, KW_COPY},
+        [39] = {"NULL", 4, TOKEN_BUILT_IN_FUNC, KW_NULL},
+        [48] = {"FOREIGN", 7, TOKEN_BUILT_IN_FUNC, KW_FOREIGN},
+        [50] = {"VACUUM", 6, TOKEN_KEYWORD, KW_VACUUM},
+        [55] = {"JOIN", 4, TOKEN_KEYWORD, KW_JOIN},
+        [56] = {"VALUES", 6, TOKEN_KEYWORD, KW_VALUES},
+        [58] = {"VARCHAR", 7, TOKEN_DATA_TYPE, KW_VARCHAR},
+        [59] = {"UUID", 4, TOKEN_BUILT_IN_FUNC, KW_UUID},
+        [68] = {"OFFSET", 6, TOKEN_KEYWORD, KW_OFFSET},
+        [70] = {"DESC", 4, TOKEN_KEYWORD, KW_DESC},
+        [72] = {"WHERE", 5, TOKEN_KEYWORD, KW_WHERE},
+        [73] = {"CREATE", 6, TOKEN_KEYWORD, KW_CREATE},
+        [74] = {"NOT", 3, TOKEN_BUILT_IN_FUNC, KW_NOT},
+        [75] = {"AND", 3, TOKEN_KEYWORD, KW_AND},
+        [77] = {"NOW", 3, TOKEN_BUILT_IN_FUNC, KW_NOW},
+        [78] = {"DELETE", 6, TOKEN_KEYWORD, KW_DELETE},
+        [87] = {"FROM", 4, TOKEN_KEYWORD, KW_FROM},
+        [92] = {"DATE", 4, TOKEN_DATA_TYPE, KW_DATE},
+        [96] = {"DEFAULT", 7, TOKEN_BUILT_IN_FUNC, KW_DEFAULT},
+        [97] = {"GROUP", 5, TOKEN_KEYWORD, KW_GROUP},
+        [102] = {"LIMIT", 5, TOKEN_KEYWORD, KW_LIMIT},
+        [104] = {"DATETIME", 8, TOKEN_DATA_TYPE, KW_DATETIME},
+        [105] = {"ALTER", 5, TOKEN_KEYWORD, KW_ALTER},
+        [106] = {"BY", 2, TOKEN_KEYWORD, KW_BY},
+        [113] = {"ASC", 3, TOKEN_KEYWORD, KW_ASC},
+        [116] = {"TIME", 4, TOKEN_DATA_TYPE, KW_TIME},
+        [117] = {"KEY", 3, TOKEN_BUILT_IN_FUNC, KW_KEY},
+        [121] = {"INTO", 4, TOKEN_KEYWORD, KW_INTO},
+        [122] = {"OR", 2, TOKEN_KEYWORD, KW_OR},
+        [123] = {"INT", 3, TOKEN_DATA_TYPE, KW_INT},
+        [126] = {"AS", 2, TOKEN_KEYWORD, KW_AS},
+        [127] = {"FLOAT", 5, TOKEN_DATA_TYPE, KW_FLOAT},
+};
+
+
+/**
+ * Hash of a word for the keyword table, letters are folded to lower case
+ * @param str Word
+ * @param len Length of the word, at least 2
+ * @return Slot of the keyword table
+ */
+static size_t hashKeyword(const char *str, size_t len){
+    size_t hash = len * 3 + (size_t)(str[0] | 0x20) * 4 + (size_t)(str[1] | 0x20) * 59 + (size_t)(str[len - 1] | 0x20);
+    return hash & (KEYWORD_TABLE_SIZE - 1);
+}
+
+/**
+ * Finds a keyword, data type or built-in function, case insensitive
+ * @param str Word
+ * @param len Length of the word
+ * @return Reserved word or NULL if the word is not reserved
+ */
+const Keyword *findKeyword(const char *str, size_t len){
+    if(len < 2 || len > KEYWORD_MAX_LEN){
+        return NULL;
+    }
+    const Keyword *keyword = &KEYWORD_TABLE[hashKeyword(str, len)];
+    if(keyword->len != len){
+        return NULL;
+    }
+    for (size_t i = 0; i < len; ++i) {
+        if(tolower((unsigned char)str[i]) != tolower((unsigned char)keyword->name[i])){
+            return NULL;
+        }
     }
-    else if (isDataType(token)){
-        return TOKEN_DATA_TYPE;
+    return keyword;
+}
+
+/**
+ * Aggregate function of a select column, the names are not reserved words
+ * @param name Name of the function
+ * @return Aggregate function or AGG_NONE if the name is not an aggregate
+ */
+static AggregateFunc getAggregateFunc(const char *name){
+    if(caseInsensitiveCompare(name, "COUNT") == 0){
+        return AGG_COUNT;
+    }
+    if(caseInsensitiveCompare(name, "SUM") == 0){
+        return AGG_SUM;
+    }
+    if(caseInsensitiveCompare(name, "AVG") == 0){
+        return AGG_AVG;
+    }
+    if(caseInsensitiveCompare(name, "MIN") == 0){
+        return AGG_MIN;
     }
-    else if (isBuiltInFunc(token)){
-        return TOKEN_BUILT_IN_FUNC;
+    if(caseInsensitiveCompare(name, "MAX") == 0){
+        return AGG_MAX;
+    }
+    return AGG_NONE;
+}
+
+/**
+ * Reads a column reference, `column` or `table.column`
+ * @param tokens Tokens of the statement
+ * @param len Number of tokens
+ * @param i Token of the column or of its table
+ * @param tableToken Table of a qualified column, TOKEN_EMPTY otherwise
+ * @param columnToken Column
+ * @return Last token of the reference
+ */
+static size_t parseColumnRef(const Token *tokens, size_t len, size_t i, Token *tableToken, Token *columnToken){
+    // A lone `.` is lexed as a number
+    if(i + 2 < len && strcmp(tokens[i+1].value, ".") == 0 &&
+       tokens[i+2].type == TOKEN_IDENTIFIER){
+        *tableToken = tokens[i];
+        *columnToken = tokens[i+2];
+        return i + 2;
+    }
+    memset(tableToken, 0, sizeof(Token));
+    tableToken->type = TOKEN_EMPTY;
+    *columnToken = tokens[i];
+    return i;
+}
+
+/**
+ * If the identifier after a keyword is a table, `SELECT * FROM user`
+ * @param keyword Reserved word
+ * @return 1 for UPDATE, DELETE, FROM, INTO and TABLE, 0 otherwise
+ */
+static int isPreTableSelector(KeywordId keyword){
+    return keyword == KW_UPDATE || keyword == KW_DELETE || keyword == KW_FROM || keyword == KW_INTO || keyword == KW_TABLE;
+}
+
+/**
+ * If a keyword joins two filters
+ * @param keyword Reserved word
+ * @return 1 for AND and OR, 0 otherwise
+ */
+static int isLogicalOperator(KeywordId keyword){
+    return keyword == KW_AND || keyword == KW_OR;
+}
+
+/**
+ * If a built-in function generates a default value
+ * @param keyword Reserved word
+ * @return 1 for NOW, RANDOM, UUID and NULL, 0 otherwise
+ */
+static int isValueFunc(KeywordId keyword){
+    return keyword == KW_NOW || keyword == KW_RANDOM || keyword == KW_UUID || keyword == KW_NULL;
+}
+
+TokenType getTokenType(const char *token){
+    const Keyword *keyword = findKeyword(token, strlen(token));
+    if (keyword != NULL){
+        return keyword->type;
     }
     else if (token[0] == '('){
         return TOKEN_L_PAR;
@@ -27,6 +190,9 @@ TokenType getTokenType(const char *token){
     else if (token[0] == '\'' && token[strlen(token) - 1] == '\''){
         return TOKEN_STRING;
     }
+    else if (token[0] == '?' && token[1] == '\0'){
+        return TOKEN_PARAM;
+    }
     else if (isNumber(token)){
         return TOKEN_NUMBER;
     }
@@ -38,35 +204,27 @@ TokenType getTokenType(const char *token){
     }
 }
 
-void freeTokenParseMemory(char* input, char* inpArray, Token* tokens, size_t numTokens){
-    free(input);
-    free(inpArray);
-    for (size_t i = 0; i < numTokens; i++) {
-        free(tokens[i].value);
-    }
-    free(tokens);
-}
-
-void handleTokenParseMemError(char* input, char* inpArray, Token* tokens, size_t numTokens, const char* errorMessage) {
-    perror(errorMessage);
-    freeTokenParseMemory(input, inpArray, tokens, numTokens);
-    exit(1);
+/**
+ * Frees the tokens of a statement and every token value in one call
+ * @param tokenRet Lexed statement
+ */
+void freeTokenRet(TokenRet *tokenRet){
+    arenaFree(tokenRet->arena);
+    tokenRet->arena = NULL;
+    tokenRet->tokens = NULL;
+    tokenRet->len = 0;
 }
 
 
-TokenRet createEmptyTokenRet(){
-    TokenRet t = {NULL, 0};
+TokenRet createEmptyTokenRet(char *input){
+    TokenRet t = {NULL, 0, input, NULL};
     return t;
 }
 
 
-TokenRet createEmptyTokenRetAfterFree(char *input, Token* tokens, size_t token_len){
-    free(input);
-    for (size_t i = 0; i < token_len; i++) {
-        free(tokens[i].value);
-    }
-    free(tokens);
-    return createEmptyTokenRet();
+TokenRet createEmptyTokenRetAfterFree(TokenRet *tokenRet){
+    freeTokenRet(tokenRet);
+    return createEmptyTokenRet(tokenRet->sql);
 }
 
 void printErrorMsg(const char *input, size_t start, const char* extra){
@@ -80,20 +238,121 @@ void printErrorMsg(const char *input, size_t start, const char* extra){
     printf("\033[0m\n");
 }
 
+/**
+ * Appends a token to a statement, the token array is moved to a twice larger array of the arena when it is full
+ * @param tokenRet Statement being lexed
+ * @param capacity Tokens the array holds
+ * @param type Token type
+ * @param keyword Reserved word of the token
+ * @param value Token value, allocated in the arena
+ * @param start Position of the token in the statement
+ * @param end Position after the token
+ * @return 1 if the token is added, 0 if out of memory
+ */
+static int pushToken(TokenRet *tokenRet, size_t *capacity, TokenType type, KeywordId keyword, char *value, size_t start, size_t end){
+    if(value == NULL){
+        return 0;
+    }
+    if(tokenRet->len == *capacity){
+        Token *tokens = arenaAlloc(tokenRet->arena, sizeof(Token) * *capacity * 2);
+        if(tokens == NULL){
+            return 0;
+        }
+        memcpy(tokens, tokenRet->tokens, sizeof(Token) * tokenRet->len);
+        tokenRet->tokens = tokens;
+        *capacity *= 2;
+    }
+    Token *token = &tokenRet->tokens[tokenRet->len++];
+    token->type = type;
+    token->keyword = keyword;
+    token->value = value;
+    token->start = start;
+    token->end = end;
+    return 1;
+}
+
+/**
+ * Copies a string literal to the arena, commas are escaped the way they are stored in table rows
+ * @param arena Statement arena
+ * @param data String literal with its quotes
+ * @param len Length of the literal
+ * @return Escaped copy or NULL if out of memory
+ */
+static char *copyStringLiteral(Arena *arena, const char *data, size_t len){
+    size_t commas = 0;
+    for (size_t i = 0; i < len; ++i) {
+        commas += data[i] == ',';
+    }
+    if(commas == 0){
+        return arenaCopy(arena, data, len);
+    }
+    char *value = arenaAlloc(arena, len + commas + 1);
+    if(value == NULL){
+        return NULL;
+    }
+    size_t j = 0;
+    for (size_t i = 0; i < len; ++i) {
+        if(data[i] == ','){
+            value[j++] = '\\';
+        }
+        value[j++] = data[i];
+    }
+    value[j] = '\0';
+    return value;
+}
+
+/**
+ * Adds the word ending before a separator as a token
+ * @param tokenRet Statement being lexed
+ * @param capacity Tokens the array holds
+ * @param start Position of the word
+ * @param end Position after the word
+ * @return 1 if the token is added, 0 if out of memory
+ */
+static int pushWord(TokenRet *tokenRet, size_t *capacity, size_t start, size_t end){
+    const char *word = tokenRet->sql + start;
+    size_t len = end - start;
+    if(word[0] == '\'' && word[len - 1] == '\''){
+        return pushToken(tokenRet, capacity, TOKEN_STRING, KW_NONE, copyStringLiteral(tokenRet->arena, word, len), start, end);
+    }
+    char *value = arenaCopy(tokenRet->arena, word, len);
+    if(value == NULL){
+        return 0;
+    }
+    const Keyword *keyword = findKeyword(value, len);
+    if(keyword != NULL){
+        stringToLower(value);
+        return pushToken(tokenRet, capacity, keyword->type, keyword->id, value, start, end);
+    }
+    return pushToken(tokenRet, capacity, getTokenType(value), KW_NONE, value, start, end);
+}
+
+/**
+ * Splits a statement into tokens, the tokens keep their position in the statement and their values
+ * are allocated in an arena owned by the result, freed with `freeTokenRet`
+ * @param input SQL statement, it must outlive the tokens
+ * @return Tokens of the statement, no tokens on a syntax error
+ */
 TokenRet lexAnalyze(char *input) {
-    char *inp = malloc(sizeof(char) * (strlen(input) + 1));
-    strcpy(inp, input);
-    size_t length = 0, prev = 0, tok_size = sizeof(Token), tok_idx = 0;
-    int isInStr = 0, isInPar=0;
-    size_t strStart = -1, parStart = -1;
-    char c;
-    Token *tokens = malloc(tok_size);
-    if (!tokens) {
-        handleTokenParseMemError(input, inp, tokens, tok_idx, "Error: Memory allocation failed for token storage");
+    size_t inputLen = strlen(input);
+    // Most statements fit in the first block: the token values are at most the statement
+    // with its commas escaped and the token array starts with a token every 4 bytes
+    size_t capacity = inputLen / 4 + 8;
+    TokenRet tokenRet = createEmptyTokenRet(input);
+    tokenRet.arena = arenaCreate(inputLen * 2 + sizeof(Token) * capacity + 64);
+    if(tokenRet.arena != NULL){
+        tokenRet.tokens = arenaAlloc(tokenRet.arena, sizeof(Token) * capacity);
+    }
+    if(tokenRet.tokens == NULL){
+        printError("Error: Memory allocation failed for token storage");
+        return createEmptyTokenRetAfterFree(&tokenRet);
     }
+    size_t prev = 0;
+    int isInStr = 0, isInPar = 0;
+    size_t strStart = -1, parStart = -1;
 
-    while (*inp) {
-        c = *inp;
+    for (size_t length = 0; length < inputLen; ++length) {
+        char c = input[length];
 
         if(isInStr == 0){
             if(c == '(' || c == ')'){
@@ -110,19 +369,12 @@ TokenRet lexAnalyze(char *input) {
         // Throw parsing errors
         if(isInStr && c==';'){
             printErrorMsg(input, strStart, "");
-            return createEmptyTokenRetAfterFree(input, tokens, tok_idx);
+            return createEmptyTokenRetAfterFree(&tokenRet);
         }
 
         if(isInPar && c==';'){
             printErrorMsg(input, parStart, "");
-            return createEmptyTokenRetAfterFree(input, tokens, tok_idx);
-        }
-
-        // Skip new line and tabs, which will cause parsing error
-        if (isInStr == 0 && (c == '\n' || c == '\t')) {
-            inp++;
-            prev++;
-            continue;
+            return createEmptyTokenRetAfterFree(&tokenRet);
         }
 
         // Toggle isInStr flag when encountering a single quote.
@@ -138,101 +390,63 @@ TokenRet lexAnalyze(char *input) {
             }
         }
 
-        if (isInStr == 0 && (c == ' ' || c == ';' || isSpecialPunct(c) )) {
+        // New lines and tabs separate tokens like spaces
+        if (isInStr == 0 && (c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == ';' || isSpecialPunct(c))) {
             // If the token that is being selected is a full string, not a punctuation then
-            if (length != prev) {
-                char token[length - prev + 1];
-                strncpy(token, input + prev, length - prev);
-                token[length - prev] = '\0';
-                TokenType type = getTokenType(token);
-                char* string = NULL;
-
-                tokens[tok_idx].start = prev;
-                tokens[tok_idx].value = malloc(strlen(token) + 1);
-                if (!tokens[tok_idx].value) {
-                    handleTokenParseMemError(input, inp, tokens, tok_idx, "Error: Memory allocation failed for token parsing");
-                }
-                if(type == TOKEN_KEYWORD || type == TOKEN_DATA_TYPE || type == TOKEN_BUILT_IN_FUNC){
-                    stringToLower(token);
-                }
-                if(type == TOKEN_STRING){
-                    string = escapeCommas(token);
-                }
-                if(string != NULL){
-                    strcpy(tokens[tok_idx].value, string);
-                    free(string);
-                }
-                else{
-                    strcpy(tokens[tok_idx].value, token);
-                }
-                tokens[tok_idx].type = type;
-                tokens[tok_idx].end = length;
-                tok_idx++;
-                Token *temp_tok = realloc(tokens, tok_size * (tok_idx + 1));
-                if(temp_tok == NULL){
-                    handleTokenParseMemError(input, inp, tokens, tok_idx, "Error: Memory allocation failed for token allocation");
-                }
-                tokens = temp_tok;
+            if (length != prev && !pushWord(&tokenRet, &capacity, prev, length)) {
+                printError("Error: Memory allocation failed for token parsing");
+                return createEmptyTokenRetAfterFree(&tokenRet);
             }
 
             // Special handling for punctuations for example '(' , ')' , ',' , '.'
             if(isSpecialPunct(c) && c != ';') {
-                char token[2] = {c, '\0'};
-                TokenType type = getTokenType(token);
-                tokens[tok_idx].start = length;
-                tokens[tok_idx].value = malloc(2);
-                if (!tokens[tok_idx].value) {
-                    handleTokenParseMemError(input, inp, tokens, tok_idx, "Error: Memory allocation failed for token parsing");
-                }
-                strcpy(tokens[tok_idx].value, token);
-                tokens[tok_idx].type = type;
-                tokens[tok_idx].end = length + 1;
-                tok_idx++;
-                Token *temp_tok = realloc(tokens, tok_size * (tok_idx + 1));
-                if(temp_tok == NULL){
-                    handleTokenParseMemError(input, inp, tokens, tok_idx, "Error: Memory allocation failed for token allocation");
-                }
-                tokens = temp_tok;
+                // `>=`, `<=` and `!=` are a single symbol
+                size_t symbolLen = (c == '>' || c == '<' || c == '!') && length + 1 < inputLen && input[length + 1] == '=' ? 2 : 1;
+                char token[3] = {c, symbolLen == 2 ? '=' : '\0', '\0'};
+                if(!pushToken(&tokenRet, &capacity, getTokenType(token), KW_NONE, arenaCopy(tokenRet.arena, token, symbolLen), length, length + symbolLen)){
+                    printError("Error: Memory allocation failed for token parsing");
+                    return createEmptyTokenRetAfterFree(&tokenRet);
+                }
+                length += symbolLen - 1;
             }
             prev = length + 1;
         }
-
-        inp++;
-        length++;
     }
-    TokenRet tokenRet = {tokens, tok_idx, input};
     return tokenRet;
 }
 
 
-Node createInvalidNode(){
-    Node node;
-    node.isInvalid = 1;
-    return node;
+/**
+ * Node of a statement that failed to parse, shared by every invalid statement
+ * @return Invalid node
+ */
+Node *createInvalidNode(){
+    static Node invalidNode = { .isInvalid = 1 };
+    return &invalidNode;
 }
 
 
-Node handleWhereClauseError(const char* sql, size_t start){
+Node *handleWhereClauseError(const char* sql, size_t start){
     printErrorMsg(sql, start, "invalid `where` clause");
     return createInvalidNode();
 }
 
 int isPostColumnSelector(Token action, Token table, Token *tokens, size_t i){
-    if(caseInsensitiveCompare(action.value, "DELETE") == 0){
+    if(action.keyword == KW_DELETE){
         return 0;
     }
     if(
-            isSelectKeyword(action.value) && tokens[i].type == TOKEN_IDENTIFIER ||
+            action.keyword == KW_SELECT && tokens[i].type == TOKEN_IDENTIFIER ||
             (
-                    caseInsensitiveCompare(action.value, "UPDATE") == 0 &&
-                    caseInsensitiveCompare(tokens[i].value, "SET") == 0
+                    action.keyword == KW_UPDATE &&
+                    tokens[i].keyword == KW_SET
             ) ||
             (
-                    caseInsensitiveCompare(action.value, "CREATE") == 0 && table.type != TOKEN_EMPTY &&
+                    action.keyword == KW_CREATE && table.type != TOKEN_EMPTY &&
                     tokens[i].type == TOKEN_L_PAR
             ) ||
             (
-                    caseInsensitiveCompare(action.value, "INSERT") == 0 &&
+                    action.keyword == KW_INSERT &&
                             tokens[i].type == TOKEN_L_PAR
             )
     )
@@ -244,76 +458,287 @@ int isPostColumnSelector(Token action, Token table, Token *tokens, size_t i){
 
 Token emptyToken(){
     Token token;
+    memset(&token, 0, sizeof(Token));
     token.type = TOKEN_EMPTY;
     return token;
 }
 
-Node createASTNode(TokenRet tokenRet){
-    Node node;
+/**
+ * Parses the tokens of a statement, the node is allocated in the arena of the tokens
+ * with as many columns and filters as the statement can have
+ * @param tokenRet Tokens of the statement
+ * @return Node of the statement, `isInvalid` is set on a syntax error
+ */
+Node *createASTNode(TokenRet *tokenRet){
+    if(tokenRet->len == 0){
+        return createInvalidNode();
+    }
+    // Columns and values are separated by commas and filters by AND or OR, the rows of an insert
+    // are kept apart from its columns
+    size_t colsCapacity = 1, filtersCapacity = 1;
+    int isInValues = 0;
+    for (size_t t = 0; t < tokenRet->len; ++t) {
+        isInValues = isInValues || tokenRet->tokens[t].keyword == KW_VALUES;
+        colsCapacity += !isInValues && tokenRet->tokens[t].type == TOKEN_SYMBOL && tokenRet->tokens[t].value[0] == ',';
+        filtersCapacity += isLogicalOperator(tokenRet->tokens[t].keyword);
+    }
+    Node *node = arenaAlloc(tokenRet->arena, sizeof(Node));
+    Column *columns = arenaAlloc(tokenRet->arena, sizeof(Column) * colsCapacity);
+    Column *filters = arenaAlloc(tokenRet->arena, sizeof(Column) * filtersCapacity);
+    OrderColumn *orderBy = arenaAlloc(tokenRet->arena, sizeof(OrderColumn) * colsCapacity);
+    Token *groupBy = arenaAlloc(tokenRet->arena, sizeof(Token) * colsCapacity);
+    if(node == NULL || columns == NULL || filters == NULL || orderBy == NULL || groupBy == NULL){
+        printError("Error: Memory allocation failed for the statement");
+        return createInvalidNode();
+    }
+    memset(columns, 0, sizeof(Column) * colsCapacity);
+    memset(filters, 0, sizeof(Column) * filtersCapacity);
+    node->columns = columns;
+    node->filters = filters;
 
-    node.colsLen = 0;
-    node.filtersLen = 0;
-    node.isInvalid = 0;
-    node.isAllCol = 0;
+    node->colsLen = 0;
+    node->filtersLen = 0;
+    node->isInvalid = 0;
+    node->isAllCol = 0;
+    node->storage = STORAGE_TEXT;
+    node->limit = -1;
+    node->offset = 0;
+    node->orderBy = orderBy;
+    node->orderLen = 0;
+    node->groupBy = groupBy;
+    node->groupLen = 0;
+    node->isAggregate = 0;
+    memset(&node->joinLeft, 0, sizeof(Column));
+    memset(&node->joinRight, 0, sizeof(Column));
+    node->values = NULL;
+    node->rowsLen = 0;
+    node->copyFile = emptyToken();
+    node->isCopyTo = 0;
+    node->isCopyHeader = 0;
 
     size_t i = 0;
     Token action = emptyToken();
     Token table = emptyToken();
     Token primaryKey = emptyToken();
-    size_t len = tokenRet.len;
-    Token *tokens = tokenRet.tokens;
-    node.table = table;
-    node.action = action;
-    node.primaryKey = primaryKey;
+    size_t len = tokenRet->len;
+    Token *tokens = tokenRet->tokens;
+    node->table = table;
+    node->action = action;
+    node->primaryKey = primaryKey;
+    node->joinTable = table;
     int colsSet = 0;
     while(i < len){
         Token cur = tokens[i];
         if(i == 0){
             if(cur.type != TOKEN_KEYWORD){
-                printErrorMsg(tokenRet.sql, cur.start, "");
+                printErrorMsg(tokenRet->sql, cur.start, "");
                 return createInvalidNode();
             }
 
-            node.action = cur;
+            node->action = cur;
             action = cur;
         }
         else{
 
-            if(cur.type == TOKEN_SYMBOL && strcmp(cur.value, "*") == 0 && isSelectKeyword(action.value) == 1){
-                node.isAllCol = 1;
+            if(cur.type == TOKEN_SYMBOL && strcmp(cur.value, "*") == 0 && action.keyword == KW_SELECT){
+                node->isAllCol = 1;
                 colsSet = 1;
             }
 
-            else if(i == 1 && (isUpdateKeyword(action.value) || isDeleteKeyword(action.value))){
+            else if(i == 1 && action.keyword == KW_COPY){
+                // COPY table [(column, ...)] FROM|TO 'file' [HEADER]
+                if(cur.type != TOKEN_IDENTIFIER){
+                    printErrorMsg(tokenRet->sql, cur.start, "Invalid table name.");
+                    return createInvalidNode();
+                }
+                node->table = cur;
+                table = cur;
+                i++;
+                if(i < len && tokens[i].type == TOKEN_L_PAR){
+                    i++;
+                    while(1){
+                        if(i >= len || tokens[i].type != TOKEN_IDENTIFIER){
+                            printErrorMsg(tokenRet->sql, i < len ? tokens[i].start : cur.end, "Invalid column name");
+                            return createInvalidNode();
+                        }
+                        memset(&node->columns[node->colsLen], 0, sizeof(Column));
+                        node->columns[node->colsLen++].columnToken = tokens[i++];
+                        if(i < len && tokens[i].type == TOKEN_SYMBOL && tokens[i].value[0] == ','){
+                            i++;
+                            continue;
+                        }
+                        break;
+                    }
+                    if(i >= len || tokens[i].type != TOKEN_R_PAR){
+                        printErrorMsg(tokenRet->sql, i < len ? tokens[i].start : cur.end, "Expected ) after the columns");
+                        return createInvalidNode();
+                    }
+                    i++;
+                }
+                if(i + 1 >= len || (tokens[i].keyword != KW_FROM && caseInsensitiveCompare(tokens[i].value, "TO") != 0) ||
+                   tokens[i+1].type != TOKEN_STRING){
+                    printErrorMsg(tokenRet->sql, i < len ? tokens[i].start : cur.end, "Expected FROM or TO and a file between quotes");
+                    return createInvalidNode();
+                }
+                node->isCopyTo = tokens[i].keyword != KW_FROM;
+                node->copyFile = tokens[i+1];
+                i += 2;
+                if(i < len && caseInsensitiveCompare(tokens[i].value, "HEADER") == 0){
+                    node->isCopyHeader = 1;
+                    i++;
+                }
+                if(i < len){
+                    printErrorMsg(tokenRet->sql, tokens[i].start, "Expected HEADER or the end of the statement");
+                    return createInvalidNode();
+                }
+                break;
+            }
+
+            else if(i == 1 && (action.keyword == KW_UPDATE || action.keyword == KW_VACUUM ||
+                                (action.keyword == KW_DELETE && cur.type != TOKEN_KEYWORD))){
                 if(tokens[i].type != TOKEN_IDENTIFIER){
                     if(tokens[i+1].type == TOKEN_KEYWORD){
-                        printErrorMsg(tokenRet.sql, tokens[i+1].start, "Invalid table name, SQL Keywords cannot be a table.");
+                        printErrorMsg(tokenRet->sql, tokens[i+1].start, "Invalid table name, SQL Keywords cannot be a table.");
                     }
                     else{
-                        printErrorMsg(tokenRet.sql, tokens[i+1].start, "Invalid table name.");
+                        printErrorMsg(tokenRet->sql, tokens[i+1].start, "Invalid table name.");
                     }
                     return createInvalidNode();
                 }
-                node.table = tokens[i];
+                node->table = tokens[i];
                 table = tokens[i];
             }
 
-            else if(isPreTableSelectorKeyword(cur.value)){
+            else if(isPreTableSelector(cur.keyword)){
                 // Show error
                 if (tokens[i+1].type != TOKEN_IDENTIFIER){
                     if(tokens[i+1].type == TOKEN_KEYWORD){
-                        printErrorMsg(tokenRet.sql, tokens[i+1].start, "Invalid table name, SQL Keywords cannot be a table.");
+                        printErrorMsg(tokenRet->sql, tokens[i+1].start, "Invalid table name, SQL Keywords cannot be a table.");
                     }
                     else{
-                        printErrorMsg(tokenRet.sql, tokens[i+1].start, "Invalid table name.");
+                        printErrorMsg(tokenRet->sql, tokens[i+1].start, "Invalid table name.");
                     }
                     return createInvalidNode();
                 }
-                node.table = tokens[i+1];
+                node->table = tokens[i+1];
                 table = tokens[i+1];
                 i++;
             }
 
+            else if(cur.keyword == KW_STORAGE){
+                if(i + 1 < len && caseInsensitiveCompare(tokens[i+1].value, "PAGE") == 0){
+                    node->storage = STORAGE_PAGE;
+                }
+                else if(i + 1 < len && tokens[i+1].keyword == KW_TEXT){
+                    node->storage = STORAGE_TEXT;
+                }
+                else{
+                    printErrorMsg(tokenRet->sql, i + 1 < len ? tokens[i+1].start : cur.end, "Invalid storage, expected PAGE or TEXT");
+                    return createInvalidNode();
+                }
+                i++;
+            }
+
+            else if(cur.keyword == KW_ORDER){
+                if(action.keyword != KW_SELECT){
+                    printErrorMsg(tokenRet->sql, cur.start, "ORDER BY can only be used in a select");
+                    return createInvalidNode();
+                }
+                if(i + 1 >= len || tokens[i+1].keyword != KW_BY){
+                    printErrorMsg(tokenRet->sql, i + 1 < len ? tokens[i+1].start : cur.end, "Expected BY after ORDER");
+                    return createInvalidNode();
+                }
+                i += 2;
+                // ORDER BY col [ASC|DESC], ...
+                while(1){
+                    if(i >= len || tokens[i].type != TOKEN_IDENTIFIER){
+                        printErrorMsg(tokenRet->sql, i < len ? tokens[i].start : cur.end, "Invalid column in ORDER BY");
+                        return createInvalidNode();
+                    }
+                    OrderColumn *order = &node->orderBy[node->orderLen++];
+                    i = parseColumnRef(tokens, len, i, &order->tableToken, &order->columnToken);
+                    order->isDesc = 0;
+                    if(i + 1 < len && (tokens[i+1].keyword == KW_ASC || tokens[i+1].keyword == KW_DESC)){
+                        order->isDesc = tokens[i+1].keyword == KW_DESC;
+                        i++;
+                    }
+                    if(i + 1 < len && tokens[i+1].type == TOKEN_SYMBOL && tokens[i+1].value[0] == ','){
+                        i += 2;
+                        continue;
+                    }
+                    break;
+                }
+            }
+
+            else if(cur.keyword == KW_JOIN){
+                if(action.keyword != KW_SELECT || table.type == TOKEN_EMPTY){
+                    printErrorMsg(tokenRet->sql, cur.start, "JOIN can only follow the table of a select");
+                    return createInvalidNode();
+                }
+                if(i + 1 >= len || tokens[i+1].type != TOKEN_IDENTIFIER){
+                    printErrorMsg(tokenRet->sql, i + 1 < len ? tokens[i+1].start : cur.end, "Invalid table name.");
+                    return createInvalidNode();
+                }
+                node->joinTable = tokens[i+1];
+                i += 2;
+                // JOIN table ON [table.]column = [table.]column
+                if(i >= len || tokens[i].keyword != KW_ON || i + 1 >= len || tokens[i+1].type != TOKEN_IDENTIFIER){
+                    printErrorMsg(tokenRet->sql, i < len ? tokens[i].start : cur.end, "Expected ON column = column after JOIN");
+                    return createInvalidNode();
+                }
+                i = parseColumnRef(tokens, len, i + 1, &node->joinLeft.tableToken, &node->joinLeft.columnToken);
+                if(i + 2 >= len || tokens[i+1].type != TOKEN_SYMBOL || strcmp(tokens[i+1].value, "=") != 0 ||
+                   tokens[i+2].type != TOKEN_IDENTIFIER){
+                    printErrorMsg(tokenRet->sql, i + 1 < len ? tokens[i+1].start : cur.end, "Expected ON column = column after JOIN");
+                    return createInvalidNode();
+                }
+                node->joinLeft.symbol = tokens[i+1];
+                i = parseColumnRef(tokens, len, i + 2, &node->joinRight.tableToken, &node->joinRight.columnToken);
+            }
+
+            else if(cur.keyword == KW_GROUP){
+                if(action.keyword != KW_SELECT){
+                    printErrorMsg(tokenRet->sql, cur.start, "GROUP BY can only be used in a select");
+                    return createInvalidNode();
+                }
+                if(i + 1 >= len || tokens[i+1].keyword != KW_BY){
+                    printErrorMsg(tokenRet->sql, i + 1 < len ? tokens[i+1].start : cur.end, "Expected BY after GROUP");
+                    return createInvalidNode();
+                }
+                i += 2;
+                // GROUP BY col, ...
+                while(1){
+                    if(i >= len || tokens[i].type != TOKEN_IDENTIFIER){
+                        printErrorMsg(tokenRet->sql, i < len ? tokens[i].start : cur.end, "Invalid column in GROUP BY");
+                        return createInvalidNode();
+                    }
+                    node->groupBy[node->groupLen++] = tokens[i];
+                    if(i + 1 < len && tokens[i+1].type == TOKEN_SYMBOL && tokens[i+1].value[0] == ','){
+                        i += 2;
+                        continue;
+                    }
+                    break;
+                }
+            }
+
+            else if(cur.keyword == KW_LIMIT || cur.keyword == KW_OFFSET){
+                if(action.keyword != KW_SELECT){
+                    printErrorMsg(tokenRet->sql, cur.start, "LIMIT and OFFSET can only be used in a select");
+                    return createInvalidNode();
+                }
+                if(i + 1 >= len || tokens[i+1].type != TOKEN_NUMBER || strchr(tokens[i+1].value, '.') != NULL){
+                    printErrorMsg(tokenRet->sql, i + 1 < len ? tokens[i+1].start : cur.end, "Expected a number of rows");
+                    return createInvalidNode();
+                }
+                if(cur.keyword == KW_LIMIT){
+                    node->limit = strtoll(tokens[i+1].value, NULL, 10);
+                }
+                else{
+                    node->offset = strtoll(tokens[i+1].value, NULL, 10);
+                }
+                i++;
+            }
+
             else if(colsSet == 0 && isPostColumnSelector(action, table, tokens, i)){
                 int isInPar = 0;
                 if(cur.type == TOKEN_L_PAR){
@@ -322,12 +747,12 @@ Node createASTNode(TokenRet tokenRet){
                 if(tokens[i].type == TOKEN_KEYWORD || tokens[i].type == TOKEN_L_PAR){
                     i++;
                 }
-                if(tokens[i+1].type == TOKEN_L_PAR){
+                if(action.keyword != KW_SELECT && tokens[i+1].type == TOKEN_L_PAR){
                     isInPar = 1;
                     i+=2;
                 }
                 int isInsert = 0;
-                if(caseInsensitiveCompare(action.value, "INSERT") == 0){
+                if(action.keyword == KW_INSERT){
                     isInsert = 1;
                 }
                 int start = (int)i;
@@ -337,12 +762,12 @@ Node createASTNode(TokenRet tokenRet){
                 while (i < len){
                     if( tokens[i].type == TOKEN_R_PAR ||
                         tokens[i].type == TOKEN_KEYWORD){
-                        if(caseInsensitiveCompare(tokens[i].value, "AS") == 0){
+                        if(tokens[i].keyword == KW_AS){
                             if(i+1 < len && tokens[i+1].type == TOKEN_IDENTIFIER){
-                                node.columns[i].display = tokens[i].value;
+                                node->columns[cols_index].display = tokens[i+1].value;
                             }
                             else{
-                                printErrorMsg(tokenRet.sql, tokens[i].start, "Invalid column as");
+                                printErrorMsg(tokenRet->sql, tokens[i].start, "Invalid column as");
                                 return createInvalidNode();
                             }
                         }
@@ -354,63 +779,84 @@ Node createASTNode(TokenRet tokenRet){
                         }
                     }
                     if(start == i && tokens[i].type != TOKEN_IDENTIFIER){
-                        printErrorMsg(tokenRet.sql, tokens[i].start, "Invalid column name");
+                        printErrorMsg(tokenRet->sql, tokens[i].start, "Invalid column name");
                         return createInvalidNode();
                     }
 
                     if(tokens[i].type == TOKEN_IDENTIFIER){
                         if(prevType != TOKEN_EMPTY){
-                            printErrorMsg(tokenRet.sql, tokens[i].start, "Invalid select statement");
+                            printErrorMsg(tokenRet->sql, tokens[i].start, "Invalid select statement");
                             return createInvalidNode();
                         }
-                        node.columns[cols_index].columnToken = tokens[i];
-                        node.columns[cols_index].isUnique = 0;
+                        memset(&node->columns[cols_index], 0, sizeof(Column));
+                        node->columns[cols_index].columnToken = tokens[i];
                         prevType = TOKEN_IDENTIFIER;
+                        if(action.keyword == KW_SELECT){
+                            i = parseColumnRef(tokens, len, i, &node->columns[cols_index].tableToken, &node->columns[cols_index].columnToken);
+                        }
+                        // COUNT(*), COUNT(col), SUM(col), AVG(col), MIN(col), MAX(col)
+                        if(action.keyword == KW_SELECT && i + 1 < len && tokens[i+1].type == TOKEN_L_PAR){
+                            AggregateFunc func = getAggregateFunc(tokens[i].value);
+                            if(func == AGG_NONE){
+                                printErrorMsg(tokenRet->sql, tokens[i].start, "Unknown aggregate function");
+                                return createInvalidNode();
+                            }
+                            int isAllRows = i + 2 < len && tokens[i+2].type == TOKEN_SYMBOL && strcmp(tokens[i+2].value, "*") == 0;
+                            if(i + 3 >= len || (tokens[i+2].type != TOKEN_IDENTIFIER && !(isAllRows && func == AGG_COUNT)) ||
+                               tokens[i+3].type != TOKEN_R_PAR){
+                                printErrorMsg(tokenRet->sql, i + 2 < len ? tokens[i+2].start : tokens[i].end, "Invalid aggregate argument");
+                                return createInvalidNode();
+                            }
+                            node->columns[cols_index].aggregate = func;
+                            node->columns[cols_index].columnToken = tokens[i+2];
+                            node->isAggregate = 1;
+                            i += 3;
+                        }
                     }
 
                     if(tokens[i].type == TOKEN_DATA_TYPE){
                         if(prevType != TOKEN_IDENTIFIER){
                             printErrorMsg(
-                                    tokenRet.sql,
+                                    tokenRet->sql,
                                     tokens[i].start,
                                     "Data type order mismatch, data type must be followed by the name of the column"
                                     );
                             return createInvalidNode();
                         }
-                        node.columns[cols_index].dataTypeToken = tokens[i];
+                        node->columns[cols_index].dataTypeToken = tokens[i];
                         prevType = TOKEN_DATA_TYPE;
                     }
 
 
                     if(tokens[i].type == TOKEN_BUILT_IN_FUNC){
                         if(prevType != TOKEN_BUILT_IN_FUNC && prevType != TOKEN_DATA_TYPE){
-                            printErrorMsg(tokenRet.sql, tokens[i].start, "Column options must be followed by the column data type");
+                            printErrorMsg(tokenRet->sql, tokens[i].start, "Column options must be followed by the column data type");
                             return createInvalidNode();
                         }
 
-                        if(caseInsensitiveCompare(tokens[i].value, "UNIQUE") == 0){
-                            node.columns[cols_index].isUnique = 1;
+                        if(tokens[i].keyword == KW_UNIQUE){
+                            node->columns[cols_index].isUnique = 1;
                             prevType = TOKEN_BUILT_IN_FUNC;
                         }
 
-                        else if(caseInsensitiveCompare(tokens[i].value, "DEFAULT") == 0 && i < len - 1 && tokens[i+1].type == TOKEN_BUILT_IN_FUNC){
-                            if(isValueFunc(tokens[i+1].value)){
-                                node.columns[cols_index].defaultToken = tokens[i+1];
+                        else if(tokens[i].keyword == KW_DEFAULT && i < len - 1 && tokens[i+1].type == TOKEN_BUILT_IN_FUNC){
+                            if(isValueFunc(tokens[i+1].keyword)){
+                                node->columns[cols_index].defaultToken = tokens[i+1];
                                 i++;
                             }
                             else{
                                 const char* err = " :is not a valid default";
                                 char *newString = (char *)malloc(strlen(tokens[i].value) + strlen(err) + 1);
                                 sprintf(newString, "%s%s", tokens[i].value, err);
-                                printErrorMsg(tokenRet.sql, tokens[i].start, newString);
+                                printErrorMsg(tokenRet->sql, tokens[i].start, newString);
                                 free(newString);
                                 return createInvalidNode();
                             }
                         }
-                        else if(caseInsensitiveCompare(tokens[i].value, "PRIMARY") == 0 && i < len - 1 &&
-                                caseInsensitiveCompare(tokens[i+1].value, "KEY") == 0){
-                            node.primaryKey = node.columns[cols_index].columnToken;
-                            primaryKey = node.columns[cols_index].columnToken;
+                        else if(tokens[i].keyword == KW_PRIMARY && i < len - 1 &&
+                                tokens[i+1].keyword == KW_KEY){
+                            node->primaryKey = node->columns[cols_index].columnToken;
+                            primaryKey = node->columns[cols_index].columnToken;
                             i++;
                         }
                     }
@@ -418,9 +864,9 @@ Node createASTNode(TokenRet tokenRet){
                     else if(tokens[i].type == TOKEN_SYMBOL){
                         if(strcmp(tokens[i].value, "=") == 0){
                             if(prevType != TOKEN_IDENTIFIER){
-                                printErrorMsg(tokenRet.sql, tokens[i].start, "Invalid column selected before assignment");
+                                printErrorMsg(tokenRet->sql, tokens[i].start, "Invalid column selected before assignment");
                             }
-                            node.columns[cols_index].symbol = tokens[i];
+                            node->columns[cols_index].symbol = tokens[i];
                             prevType = TOKEN_SYMBOL;
                         }
                         else if(strcmp(tokens[i].value, ",") == 0){
@@ -429,11 +875,11 @@ Node createASTNode(TokenRet tokenRet){
                         }
                     }
 
-                    else if(tokens[i].type == TOKEN_STRING || tokens[i].type == TOKEN_NUMBER){
+                    else if(tokens[i].type == TOKEN_STRING || tokens[i].type == TOKEN_NUMBER || tokens[i].type == TOKEN_PARAM){
                         if(prevType != TOKEN_SYMBOL){
-                            printErrorMsg(tokenRet.sql, tokens[i].start, "Is not a valid string or number assignment");
+                            printErrorMsg(tokenRet->sql, tokens[i].start, "Is not a valid string or number assignment");
                         }
-                        node.columns[cols_index].valueToken = tokens[i];
+                        node->columns[cols_index].valueToken = tokens[i];
                         prevType = tokens[i].type;
                     }
                     i++;
@@ -442,43 +888,68 @@ Node createASTNode(TokenRet tokenRet){
                 if(isInsert){
                     i++;
                     if(i + 1 == len - 1 ){
-                        printErrorMsg(tokenRet.sql, tokens[i].start, "Values are missing");
+                        printErrorMsg(tokenRet->sql, tokens[i].start, "Values are missing");
                         return createInvalidNode();
                     }
                     size_t valIdx = 0;
-                    if(caseInsensitiveCompare(tokens[i].value, "VALUES") == 0){
+                    if(tokens[i].keyword == KW_VALUES){
+                        // Every row has a value for each column, a value takes at least a token
+                        node->values = arenaAlloc(tokenRet->arena, sizeof(Token) * len);
+                        if(node->values == NULL){
+                            printError("Error: Memory allocation failed for the statement");
+                            return createInvalidNode();
+                        }
                         while (i < len){
                             if(tokens[i].type == TOKEN_L_PAR || tokens[i].type == TOKEN_SYMBOL){
                                 if(tokens[i].value[0] != ',' && tokens[i].value[0] != '('){
-                                    printErrorMsg(tokenRet.sql, tokens[i].start, "Invalid symbol");
+                                    printErrorMsg(tokenRet->sql, tokens[i].start, "Invalid symbol");
                                     return createInvalidNode();
                                 }
 
                             }
-                            else if(tokens[i].type == TOKEN_STRING || tokens[i].type == TOKEN_NUMBER || tokens[i].type == TOKEN_BUILT_IN_FUNC){
-                                node.columns[valIdx].valueToken = tokens[i];
+                            else if(tokens[i].type == TOKEN_STRING || tokens[i].type == TOKEN_NUMBER ||
+                                    tokens[i].type == TOKEN_BUILT_IN_FUNC || tokens[i].type == TOKEN_PARAM){
+                                if(valIdx > cols_index){
+                                    break;
+                                }
+                                node->values[(size_t)node->rowsLen * (cols_index + 1) + valIdx] = tokens[i];
                                 valIdx++;
                             }
                             else if(tokens[i].type == TOKEN_R_PAR){
+                                if(valIdx != cols_index + 1){
+                                    break;
+                                }
+                                node->rowsLen++;
+                                valIdx = 0;
+                                // VALUES (...), (...), every row is in its own parentheses
+                                if(i + 2 < len && tokens[i+1].type == TOKEN_SYMBOL && tokens[i+1].value[0] == ',' &&
+                                   tokens[i+2].type == TOKEN_L_PAR){
+                                    i += 2;
+                                    continue;
+                                }
+                                if(i + 1 < len && tokens[i+1].type == TOKEN_L_PAR){
+                                    printErrorMsg(tokenRet->sql, tokens[i+1].start, "Rows of the values must be separated by commas");
+                                    return createInvalidNode();
+                                }
                                 break;
                             }
                             i++;
                         }
                     }
-                    if(valIdx != cols_index + 1){
-                        printErrorMsg(tokenRet.sql, tokens[i].start, "Values are missing, values doesn't match the number of columns");
+                    if(node->rowsLen == 0 || valIdx != 0){
+                        printErrorMsg(tokenRet->sql, tokens[i < len ? i : len - 1].start, "Values are missing, values doesn't match the number of columns");
                         return createInvalidNode();
                     }
                 }
-                node.isAllCol = 0;
-                node.colsLen = cols_index + 1;
+                node->isAllCol = 0;
+                node->colsLen = cols_index + 1;
                 colsSet = 1;
             }
 
 
 
             // Filter keyword selector
-            else if(isFilterKeyword(cur.value)){
+            else if(cur.keyword == KW_WHERE){
                 int cols_index = 0;
                 i++;
                 int start = (int)i;
@@ -486,49 +957,55 @@ Node createASTNode(TokenRet tokenRet){
                 TokenType prevType = TOKEN_EMPTY;
                 while(i < len){
                     if(start == i && tokens[i].type != TOKEN_IDENTIFIER){
-                        return handleWhereClauseError(tokenRet.sql, tokens[i].start);
+                        return handleWhereClauseError(tokenRet->sql, tokens[i].start);
+                    }
+                    // The where clause ends at the clauses that follow it
+                    if(tokens[i].keyword == KW_GROUP || tokens[i].keyword == KW_ORDER || tokens[i].keyword == KW_LIMIT || tokens[i].keyword == KW_OFFSET){
+                        i--;
+                        break;
                     }
                     if(tokens[i].type == TOKEN_IDENTIFIER){
                         if(prevType != TOKEN_EMPTY){
-                            return handleWhereClauseError(tokenRet.sql, tokens[i].start);
+                            return handleWhereClauseError(tokenRet->sql, tokens[i].start);
                         }
-                        node.filters[cols_index].columnToken = tokens[i];
+                        memset(&node->filters[cols_index], 0, sizeof(Column));
+                        i = parseColumnRef(tokens, len, i, &node->filters[cols_index].tableToken, &node->filters[cols_index].columnToken);
                         prevType = TOKEN_IDENTIFIER;
                     }
 
                     else if(tokens[i].type == TOKEN_SYMBOL){
                         if(prevType != TOKEN_IDENTIFIER){
-                            return handleWhereClauseError(tokenRet.sql, tokens[i].start);
+                            return handleWhereClauseError(tokenRet->sql, tokens[i].start);
                         }
-                        node.filters[cols_index].symbol = tokens[i];
+                        node->filters[cols_index].symbol = tokens[i];
 
                         prevType = TOKEN_SYMBOL;
                     }
 
-                    else if(tokens[i].type == TOKEN_STRING || tokens[i].type == TOKEN_NUMBER){
+                    else if(tokens[i].type == TOKEN_STRING || tokens[i].type == TOKEN_NUMBER || tokens[i].type == TOKEN_PARAM){
                         if(prevType != TOKEN_SYMBOL){
-                            return handleWhereClauseError(tokenRet.sql, tokens[i].start);
+                            return handleWhereClauseError(tokenRet->sql, tokens[i].start);
                         }
-                        node.filters[cols_index].valueToken = tokens[i];
+                        node->filters[cols_index].valueToken = tokens[i];
                         prevType = tokens[i].type;
                     }
 
-                    else if(tokens[i].type == TOKEN_KEYWORD && isLogicalOperator(tokens[i].value)){
-                        if(prevType != TOKEN_NUMBER && prevType != TOKEN_STRING){
-                            return handleWhereClauseError(tokenRet.sql, tokens[i].start);
+                    else if(isLogicalOperator(tokens[i].keyword)){
+                        if(prevType != TOKEN_NUMBER && prevType != TOKEN_STRING && prevType != TOKEN_PARAM){
+                            return handleWhereClauseError(tokenRet->sql, tokens[i].start);
                         }
-                        if(isLogicalOperator(tokens[i].value)){
-                            node.filters[cols_index].nextLogicalOp = tokens[i];
+                        if(isLogicalOperator(tokens[i].keyword)){
+                            node->filters[cols_index].nextLogicalOp = tokens[i];
                             cols_index++;
                             prevType = TOKEN_EMPTY;
                         }
                         else{
-                            return handleWhereClauseError(tokenRet.sql, tokens[i].start);
+                            return handleWhereClauseError(tokenRet->sql, tokens[i].start);
                         }
                     }
 
                     if(tokens[i].type == TOKEN_STRING && i < len - 2){
-                        if(tokens[i+1].type != TOKEN_KEYWORD && isLogicalOperator(tokens[i+1].value)){
+                        if(tokens[i+1].type != TOKEN_KEYWORD && isLogicalOperator(tokens[i+1].keyword)){
                             cols_index++;
 
                         }
@@ -536,13 +1013,13 @@ Node createASTNode(TokenRet tokenRet){
 
                     i++;
                 }
-                node.filtersLen = cols_index + 1;
+                node->filtersLen = cols_index + 1;
             }
 
         }
         i++;
     }
-    node.sql = tokenRet.sql;
+    node->sql = tokenRet->sql;
     return node;
 }
 
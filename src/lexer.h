@@ -1,9 +1,8 @@
 #ifndef PARSER_H
 #define PARSER_H
 
-#define COL_MAX_SIZE 1000
-
 #include <stdlib.h>
+#include "arena.h"
 
 
 // Token types
@@ -18,12 +17,75 @@ typedef enum {
     TOKEN_R_PAR,     // 7 Right parentheses ')'
     TOKEN_DATA_TYPE,  // 8 Data Types as if INTEGER, BOOLEAN, FLOAT
     TOKEN_BUILT_IN_FUNC,  // Data Types as if INTEGER, BOOLEAN, FLOAT
+    TOKEN_PARAM,     // 10 '?' parameter of a prepared statement, bound to a string or a number before it is executed
 } TokenType;
 
+// Reserved words, keywords then data types then built-in functions
+typedef enum {
+    KW_NONE, // Not a reserved word
+    KW_SELECT,
+    KW_INSERT,
+    KW_UPDATE,
+    KW_DELETE,
+    KW_CREATE,
+    KW_FROM,
+    KW_WHERE,
+    KW_SET,
+    KW_VALUES,
+    KW_INTO,
+    KW_TABLE,
+    KW_LIMIT,
+    KW_OFFSET,
+    KW_ALTER,
+    KW_STORAGE,
+    KW_VACUUM,
+    KW_COPY,
+    KW_AND,
+    KW_OR,
+    KW_AS,
+    KW_ORDER,
+    KW_BY,
+    KW_ASC,
+    KW_DESC,
+    KW_GROUP,
+    KW_JOIN,
+    KW_ON,
+    KW_INTEGER,
+    KW_FLOAT,
+    KW_TEXT,
+    KW_VARCHAR,
+    KW_BOOLEAN,
+    KW_DATETIME,
+    KW_DATE,
+    KW_TIME,
+    KW_SERIAL,
+    KW_INT,
+    KW_UNIQUE,
+    KW_NOW,
+    KW_RANDOM,
+    KW_UUID,
+    KW_NULL,
+    KW_PRIMARY,
+    KW_KEY,
+    KW_FOREIGN,
+    KW_NOT,
+    KW_DEFAULT,
+} KeywordId;
+
+// Reserved word of the keyword table
+typedef struct {
+    const char *name;
+    size_t len;
+    TokenType type;
+    KeywordId id;
+} Keyword;
+
 // Token structure
 typedef struct {
     // Indicates if it is a keyword or identifier or anything else
     TokenType type;
+    // Reserved word of a keyword, data type or built-in function token, KW_NONE otherwise
+    KeywordId keyword;
     // Value that is stored
     char* value;
     // Start of syntax
@@ -37,10 +99,28 @@ typedef struct {
     Token* tokens;
     size_t len;
     char* sql;
+    Arena* arena; // Tokens and token values of the statement
 } TokenRet;
 
+// Storage format of a table data file
+typedef enum {
+    STORAGE_TEXT, // Comma separated text rows
+    STORAGE_PAGE, // Binary slotted pages
+} StorageType;
+
+// Aggregate function of a select column, `SELECT COUNT(*), SUM(score)`
+typedef enum {
+    AGG_NONE,
+    AGG_COUNT,
+    AGG_SUM,
+    AGG_AVG,
+    AGG_MIN,
+    AGG_MAX,
+} AggregateFunc;
+
 struct {
     char* display;
+    Token tableToken; // Table of a qualified column `table.column`, TOKEN_EMPTY otherwise
     Token columnToken;
     Token valueToken;
     Token dataTypeToken;
@@ -49,21 +129,44 @@ struct {
     Token nextLogicalOp;
     Token defaultToken; // Default value function
     int isUnique;
+    AggregateFunc aggregate; // Select column computed over the rows of a group, the column token is its argument
 } typedef Column; // Column operation
 
 
 
 
+struct {
+    Token tableToken; // Table of a qualified column `table.column`, TOKEN_EMPTY otherwise
+    Token columnToken;
+    int isDesc; // ORDER BY ... DESC
+} typedef OrderColumn; // Sort key of a select
+
 struct {
     int isInvalid; // Invalid node or not
     int isAllCol; // Select * ( Or selecting all columns )
     Token action; // Always will be a keyword
     Token table; // Token representing the table it will perform action
-    Column columns[COL_MAX_SIZE]; // List of column operation
-    Column filters[COL_MAX_SIZE];
+    Column *columns; // List of column operation, allocated in the arena of the statement
+    Column *filters;
     Token primaryKey; // Primary key column
     int colsLen;
     int filtersLen;
+    StorageType storage; // CREATE TABLE ... STORAGE PAGE|TEXT, ALTER TABLE ... STORAGE PAGE|TEXT
+    long long limit; // SELECT ... LIMIT n, -1 without a limit
+    long long offset; // SELECT ... OFFSET n, rows skipped before the first returned row
+    OrderColumn *orderBy; // SELECT ... ORDER BY columns, allocated in the arena of the statement
+    int orderLen;
+    Token *groupBy; // SELECT ... GROUP BY columns, allocated in the arena of the statement
+    int groupLen;
+    int isAggregate; // A select column is an aggregate
+    Token joinTable; // SELECT ... FROM table JOIN joinTable ON ..., TOKEN_EMPTY without a join
+    Column joinLeft; // ON joinLeft = joinRight, each column is of one of the tables
+    Column joinRight;
+    Token *values; // INSERT ... VALUES (...), (...), colsLen values of every row, allocated in the arena of the statement
+    int rowsLen; // Rows of an insert
+    Token copyFile; // COPY table FROM|TO 'file', TOKEN_EMPTY for other statements
+    int isCopyTo; // COPY ... TO writes the rows of the table to the file
+    int isCopyHeader; // COPY ... HEADER, the first line of the file names the columns
     char* sql;
     // List of filters
 
@@ -78,13 +181,13 @@ struct {
 
 NodeList emptyNodeList();
 TokenType getTokenType(const char *token);
-void freeTokenParseMemory(char* input, char* inpArray, Token* tokens, size_t numTokens);
-void handleTokenParseMemError(char* input, char* inpArray, Token* tokens, size_t numTokens, const char* errorMessage);
+const Keyword *findKeyword(const char *str, size_t len);
 TokenRet lexAnalyze(char *input);
+void freeTokenRet(TokenRet *tokenRet);
 
-Node createInvalidNode();
+Node *createInvalidNode();
 
-Node createASTNode(TokenRet tokenRet);
+Node *createASTNode(TokenRet *tokenRet);
 void insertInNodeList(NodeList *nodeList, Node *node);
 Node *getNodeFromList(NodeList *nodeList, char* table);
 
@@ -8,6 +8,12 @@
 #include "io.h"
 #include "filesystem.h"
 #include "database.h"
+#include "bufferpool.h"
+#include "sort.h"
+#include "aggregate.h"
+#include "join.h"
+#include "workerpool.h"
+#include "statement.h"
 #include "stdbool.h"
 #define MAX_LENGTH 32
 
@@ -85,17 +91,19 @@ User getUserInfo(int confirmPassword){
 
 }
 
-int createUser(Node *refNode){
+int createUser(NodeList *tableList){
     printf("Create your account\n");
     User user = getUserInfo(1);
-    char *buffer = createBuffer();
-    insertInBuffer(&buffer, "INSERT INTO user (username, password) VALUES ('%s', '%s');", user.username, user.password);
-    TokenRet tokenRet= lexAnalyze(
-            buffer
-    );
-    Node node__ = createASTNode(tokenRet);
-    DBOp dbOp = dbInsert(node__, *refNode);
-    printDbOp(&dbOp);
+    PreparedStatement *statement = statementPrepare("INSERT INTO user (username, password) VALUES (?, ?);");
+    if(statement == NULL){
+        return 0;
+    }
+    if(statementBindText(statement, 0, user.username) && statementBindText(statement, 1, user.password)){
+        DBOp dbOp = statementExecute(statement, tableList);
+        printDbOp(&dbOp);
+        clearDBOp(&dbOp);
+    }
+    statementRelease(statement);
     return 1;
 }
 
@@ -118,8 +126,9 @@ int initialize(){
         TokenRet tokenRet= lexAnalyze(
                 "CREATE TABLE user (id integer primary key, username varchar unique, password varchar, created datetime default now)"
         );
-        Node node = createASTNode(tokenRet);
+        Node *node = createASTNode(&tokenRet);
         dbCreateTable(node);
+        freeTokenRet(&tokenRet);
         return 0;
     }
     return 1;
@@ -127,27 +136,28 @@ int initialize(){
 }
 
 
-int authenticate(User user, Node *refNode){
-    char *buffer = createBuffer();
-    insertInBuffer(&buffer, "SELECT username, password FROM user where username = '%s';", user.username);
-    TokenRet tokenRet= lexAnalyze(
-            buffer
-    );
-    Node node = createASTNode(tokenRet);
-    DBOp dbOp = dbSelect(node, *refNode);
-    if(dbOp.rowCount != 1){
-        clearBuffer(&buffer);
+int authenticate(User user, NodeList *tableList){
+    // Parsed on the first login, the next logins take the plan from the cache
+    PreparedStatement *statement = statementPrepare("SELECT username, password FROM user WHERE username = ?;");
+    if(statement == NULL || !statementBindText(statement, 0, user.username)){
+        statementRelease(statement);
         return -1;
     }
-    else{
-        char* pass = getRowValue(dbOp.rows, 0, 2, dbOp.rowCount);
-        if(strcmp(pass, user.password) == 0){
-            clearBuffer(&buffer);
-            return 1;
+    DBOp dbOp = statementExecute(statement, tableList);
+    int auth = -1;
+    if(dbOp.cursor != NULL && cursorNext(dbOp.cursor)){
+        const char *pass;
+        size_t len;
+        auth = cursorField(dbOp.cursor, 1, &pass, &len) && len == strlen(user.password) &&
+               memcmp(pass, user.password, len) == 0 ? 1 : 0;
+        // A username matching more than one row is not a valid user
+        if(cursorNext(dbOp.cursor)){
+            auth = -1;
         }
     }
-    clearBuffer(&buffer);
-    return 0;
+    clearDBOp(&dbOp);
+    statementRelease(statement);
+    return auth;
 }
 
 
@@ -155,16 +165,43 @@ int authenticate(User user, Node *refNode){
 int main() {
 
     printIntroText();
+    // Memory budget of the buffer pool in MB, MINISQL_BUFFER_POOL_MB=64
+    char *poolSize = getenv("MINISQL_BUFFER_POOL_MB");
+    bufferPoolInit(poolSize != NULL ? (size_t)strtoul(poolSize, NULL, 10) * 1024 * 1024 : BUFFER_POOL_DEFAULT_SIZE);
+    // Memory an ORDER BY can use before it sorts with run files, MINISQL_SORT_MEMORY_MB=64
+    char *sortSize = getenv("MINISQL_SORT_MEMORY_MB");
+    if (sortSize != NULL) {
+        sortSetMemoryBudget((size_t)strtoul(sortSize, NULL, 10) * 1024 * 1024);
+    }
+    // Memory the groups of a GROUP BY can use before they are partitioned to files, MINISQL_AGGREGATE_MEMORY_MB=64
+    char *aggregateSize = getenv("MINISQL_AGGREGATE_MEMORY_MB");
+    if (aggregateSize != NULL) {
+        aggregateSetMemoryBudget((size_t)strtoul(aggregateSize, NULL, 10) * 1024 * 1024);
+    }
+    // Memory the smaller table of a JOIN can use before both tables are partitioned to files, MINISQL_JOIN_MEMORY_MB=64
+    char *joinSize = getenv("MINISQL_JOIN_MEMORY_MB");
+    if (joinSize != NULL) {
+        joinSetMemoryBudget((size_t)strtoul(joinSize, NULL, 10) * 1024 * 1024);
+    }
+    // Threads a large filtered select is read with, MINISQL_WORKERS=8, one per processor by default
+    char *workerCount = getenv("MINISQL_WORKERS");
+    workerPoolInit(workerCount != NULL ? (size_t)strtoul(workerCount, NULL, 10) : 0);
+    // Size of the tables read by the worker pool when a select filters their rows, MINISQL_PARALLEL_SCAN_MB=32
+    char *parallelSize = getenv("MINISQL_PARALLEL_SCAN_MB");
+    if (parallelSize != NULL) {
+        scanSetParallelThreshold((size_t)strtoul(parallelSize, NULL, 10) * 1024 * 1024);
+    }
     int setup = initialize();
     NodeList tableList = loadTables();
-    Node *userTable = getNodeFromList(&tableList, "user");
+    // Changes logged before a crash are applied before the tables are used
+    dbRecover(&tableList);
     if (setup == 0) {
-        createUser(userTable);
+        createUser(&tableList);
     }
     while (1) {
         printf("Login to your account\n");
         User user = getUserInfo(0);
-        int auth = authenticate(user, userTable);
+        int auth = authenticate(user, &tableList);
         if (auth == 1) {
             printSuccess("Logged in successfully");
             break;
@@ -174,32 +211,47 @@ int main() {
             printError("User password doesn't match");
         }
     }
+    // Seconds between two background compaction passes, MINISQL_AUTOVACUUM_SECONDS=60, disabled by default
+    char *autoVacuum = getenv("MINISQL_AUTOVACUUM_SECONDS");
+    if (autoVacuum != NULL && strtoul(autoVacuum, NULL, 10) > 0) {
+        dbStartCompaction(&tableList, (unsigned int)strtoul(autoVacuum, NULL, 10));
+    }
     while (1) {
         printf("\n$>> ");
         char *input = handleInput();
         if (input != NULL) {
+            dbLock();
             if (caseInsensitiveCompare(input, "quit;") == 0) {
                 exit(0);
             } else if (caseInsensitiveCompare(input, "create user;") == 0) {
-                createUser(userTable);
+                createUser(&tableList);
+            } else if (caseInsensitiveCompare(input, "pool stats;") == 0) {
+                printBufferPoolStats();
+            } else if (caseInsensitiveCompare(input, "checkpoint;") == 0) {
+                if (dbCheckpoint(&tableList)) {
+                    printSuccess("Checkpoint done");
+                } else {
+                    printError("Checkpoint failed");
+                }
             } else if (caseInsensitiveCompare(input, "list tables;") == 0) {
                 printTables(tableList);
                 tableList = loadTables();
             } else {
                 DBOp dbOp = execSQL(input, &tableList);
                 if (dbOp.code == SUCCESS) {
-                    printSuccess("%s", dbOp.successMsg);
+                    printSuccess("%s", dbOp.successMsg.data);
                     if(isSelectKeyword(dbOp.action) || isInsertKeyword(dbOp.action)){
                         printDbOp(&dbOp);
                     }
 
                 } else {
-                    printError("%s", dbOp.error);
+                    printError("%s", dbOp.error.data);
                 }
                 clearDBOp(&dbOp);
                 fflush(stdin);
                 printf(" ");
             }
+            dbUnlock();
 
         }
 
@@ -0,0 +1,551 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "page.h"
+
+/*
+ * Header stored in page 0 of a paged table file
+ */
+struct {
+    char magic[8];
+    uint64_t pageCount;
+} typedef PageFileHeader;
+
+
+static PageHeader *getPageHeader(const char *page){
+    return (PageHeader *)page;
+}
+
+static Slot *getSlots(const char *page){
+    return (Slot *)(page + sizeof(PageHeader));
+}
+
+/**
+ * Initializes an empty page
+ * @param page Page buffer of PAGE_SIZE bytes
+ */
+void pageInit(char *page){
+    memset(page, 0, PAGE_SIZE);
+    PageHeader *header = getPageHeader(page);
+    header->freeStart = sizeof(PageHeader);
+    header->freeEnd = PAGE_SIZE;
+}
+
+/**
+ * Number of slots in a page, including removed records
+ * @param page Page buffer
+ * @return Slot count
+ */
+uint16_t pageSlotCount(const char *page){
+    return getPageHeader(page)->slotCount;
+}
+
+/**
+ * Contiguous free space between the slot directory and the records
+ * @param page Page buffer
+ * @return Free bytes
+ */
+size_t pageFreeSpace(const char *page){
+    PageHeader *header = getPageHeader(page);
+    return header->freeEnd - header->freeStart;
+}
+
+/**
+ * Moves the live records to the end of the page so the space of removed
+ * or shrunk records becomes contiguous again, slot numbers don't change
+ * @param page Page buffer
+ */
+static void pageCompact(char *page){
+    char copy[PAGE_SIZE];
+    memcpy(copy, page, PAGE_SIZE);
+    PageHeader *header = getPageHeader(page);
+    Slot *slots = getSlots(page);
+    uint16_t freeEnd = PAGE_SIZE;
+    for (uint16_t i = 0; i < header->slotCount; ++i) {
+        if(slots[i].length == 0){
+            continue;
+        }
+        freeEnd -= slots[i].length;
+        memcpy(page + freeEnd, copy + slots[i].offset, slots[i].length);
+        slots[i].offset = freeEnd;
+    }
+    header->freeEnd = freeEnd;
+}
+
+/**
+ * Bytes of the page held by removed or shrunk records and by removed slots at the end of the directory
+ * @param page Page buffer
+ * @return Bytes a compaction of the page gives back
+ */
+size_t pageDeadSpace(const char *page){
+    PageHeader *header = getPageHeader(page);
+    Slot *slots = getSlots(page);
+    size_t live = 0;
+    for (uint16_t i = 0; i < header->slotCount; ++i) {
+        live += slots[i].length;
+    }
+    size_t dead = PAGE_SIZE - header->freeEnd - live;
+    for (uint16_t i = header->slotCount; i > 0 && slots[i - 1].length == 0; --i) {
+        dead += sizeof(Slot);
+    }
+    return dead;
+}
+
+/**
+ * Compacts a page and drops the removed slots at the end of its directory, the other
+ * slots keep their numbers so the records don't move to another location
+ * @param page Page buffer
+ * @return Bytes given back to the free space
+ */
+size_t pageVacuum(char *page){
+    size_t before = pageFreeSpace(page);
+    PageHeader *header = getPageHeader(page);
+    Slot *slots = getSlots(page);
+    pageCompact(page);
+    while(header->slotCount > 0 && slots[header->slotCount - 1].length == 0){
+        header->slotCount--;
+        header->freeStart -= sizeof(Slot);
+    }
+    return pageFreeSpace(page) - before;
+}
+
+/**
+ * Reserves `len` bytes in the record area, compacting the page if needed
+ * @param page Page buffer
+ * @param len Record length
+ * @param extra Bytes needed in the slot directory as well
+ * @return Offset of the reserved space or 0 if the page is full
+ */
+static uint16_t pageReserve(char *page, uint16_t len, uint16_t extra){
+    PageHeader *header = getPageHeader(page);
+    if(pageFreeSpace(page) < (size_t)len + extra){
+        pageCompact(page);
+        if(pageFreeSpace(page) < (size_t)len + extra){
+            return 0;
+        }
+    }
+    header->freeEnd -= len;
+    return header->freeEnd;
+}
+
+/**
+ * Adds a record to a page
+ * @param page Page buffer
+ * @param record Encoded record
+ * @param len Record length
+ * @return Slot of the record or -1 if the page is full
+ */
+int pageAddRecord(char *page, const char *record, uint16_t len){
+    if(len == 0){
+        return -1;
+    }
+    uint16_t offset = pageReserve(page, len, sizeof(Slot));
+    if(offset == 0){
+        return -1;
+    }
+    PageHeader *header = getPageHeader(page);
+    Slot *slot = &getSlots(page)[header->slotCount];
+    slot->offset = offset;
+    slot->length = len;
+    memcpy(page + offset, record, len);
+    header->freeStart += sizeof(Slot);
+    return header->slotCount++;
+}
+
+/**
+ * Record stored in a slot
+ * @param page Page buffer
+ * @param slot Slot number
+ * @param len Record length
+ * @return Record or NULL if the slot is empty
+ */
+const char *pageGetRecord(const char *page, uint32_t slot, uint16_t *len){
+    if(slot >= pageSlotCount(page)){
+        return NULL;
+    }
+    Slot *slots = getSlots(page);
+    if(slots[slot].length == 0){
+        return NULL;
+    }
+    *len = slots[slot].length;
+    return page + slots[slot].offset;
+}
+
+/**
+ * Removes a record, its space is reclaimed by the next compaction of the page
+ * @param page Page buffer
+ * @param slot Slot number
+ * @return 1 if a record was removed, 0 otherwise
+ */
+int pageRemoveRecord(char *page, uint32_t slot){
+    if(slot >= pageSlotCount(page) || getSlots(page)[slot].length == 0){
+        return 0;
+    }
+    getSlots(page)[slot].length = 0;
+    return 1;
+}
+
+/**
+ * Replaces a record keeping its slot
+ * @param page Page buffer
+ * @param slot Slot number
+ * @param record Encoded record
+ * @param len Record length
+ * @return 1 if the record was replaced, 0 if it doesn't fit in the page and was removed,
+ * -1 if the slot is empty
+ */
+static int pageReplaceRecord(char *page, uint32_t slot, const char *record, uint16_t len){
+    Slot *slots = getSlots(page);
+    if(slot >= pageSlotCount(page) || slots[slot].length == 0){
+        return -1;
+    }
+    if(len <= slots[slot].length){
+        memcpy(page + slots[slot].offset, record, len);
+        slots[slot].length = len;
+        return 1;
+    }
+    // The old record is dropped first so a compaction can reuse its space
+    slots[slot].length = 0;
+    uint16_t offset = pageReserve(page, len, 0);
+    if(offset == 0){
+        return 0;
+    }
+    slots[slot].offset = offset;
+    slots[slot].length = len;
+    memcpy(page + offset, record, len);
+    return 1;
+}
+
+/**
+ * Encodes a row as a record, layout: field count, offset of every field plus the end offset,
+ * type of every field, then the field data. Any field is located with one offset lookup
+ * @param out Output buffer
+ * @param size Size of the output buffer
+ * @param types Type of every field
+ * @param values Data of every field, FIELD_INT values are 8 byte integers
+ * @param lens Length of every field
+ * @param count Number of fields
+ * @return Length of the record or 0 if it doesn't fit in `size`
+ */
+size_t recordEncode(char *out, size_t size, const FieldType *types, const char *const *values, const size_t *lens, int count){
+    size_t headerSize = sizeof(uint16_t) * (count + 2) + count;
+    size_t total = headerSize;
+    for (int i = 0; i < count; ++i) {
+        total += lens[i];
+    }
+    if(total > size || total > UINT16_MAX){
+        return 0;
+    }
+    uint16_t value = (uint16_t)count;
+    memcpy(out, &value, sizeof(uint16_t));
+    size_t offset = headerSize;
+    for (int i = 0; i < count; ++i) {
+        value = (uint16_t)offset;
+        memcpy(out + sizeof(uint16_t) * (i + 1), &value, sizeof(uint16_t));
+        out[sizeof(uint16_t) * (count + 2) + i] = (char)types[i];
+        memcpy(out + offset, values[i], lens[i]);
+        offset += lens[i];
+    }
+    value = (uint16_t)offset;
+    memcpy(out + sizeof(uint16_t) * (count + 1), &value, sizeof(uint16_t));
+    return total;
+}
+
+/**
+ * Number of fields in a record
+ * @param record Encoded record
+ * @return Field count
+ */
+int recordFieldCount(const char *record){
+    uint16_t count;
+    memcpy(&count, record, sizeof(uint16_t));
+    return count;
+}
+
+/**
+ * Locates a field of a record
+ * @param record Encoded record
+ * @param idx Field index
+ * @param data Start of the field data
+ * @param len Length of the field data
+ * @return Type of the field, FIELD_NULL if the record doesn't have the field
+ */
+FieldType recordField(const char *record, int idx, const char **data, size_t *len){
+    int count = recordFieldCount(record);
+    if(idx < 0 || idx >= count){
+        *data = record;
+        *len = 0;
+        return FIELD_NULL;
+    }
+    uint16_t start, end;
+    memcpy(&start, record + sizeof(uint16_t) * (idx + 1), sizeof(uint16_t));
+    memcpy(&end, record + sizeof(uint16_t) * (idx + 2), sizeof(uint16_t));
+    *data = record + start;
+    *len = end - start;
+    return (FieldType)record[sizeof(uint16_t) * (count + 2) + idx];
+}
+
+/**
+ * Reads the value of a FIELD_INT field
+ * @param data Field data
+ * @return Integer value
+ */
+int64_t recordInt(const char *data){
+    int64_t value;
+    memcpy(&value, data, sizeof(int64_t));
+    return value;
+}
+
+static int writePageFileHeader(PageFile *pageFile){
+    char *page = bufferPoolPin(pageFile->fileId, 0, NULL);
+    if(page == NULL){
+        return 0;
+    }
+    PageFileHeader header;
+    memcpy(header.magic, PAGE_FILE_MAGIC, sizeof(header.magic));
+    header.pageCount = pageFile->pageCount;
+    memcpy(page, &header, sizeof(PageFileHeader));
+    bufferPoolUnpin(page, 1);
+    return 1;
+}
+
+/**
+ * Opens an existing paged table file, its pages are read through the buffer pool
+ * @param fileName Table file name
+ * @return Page file or NULL if the file is not a paged table
+ */
+PageFile *pageFileOpen(const char *fileName){
+    PageFile *pageFile = malloc(sizeof(PageFile));
+    if(pageFile == NULL){
+        return NULL;
+    }
+    pageFile->fileId = bufferPoolOpen(fileName);
+    size_t length = 0;
+    char *page = pageFile->fileId != -1 ? bufferPoolPin(pageFile->fileId, 0, &length) : NULL;
+    PageFileHeader header;
+    int isValid = page != NULL && length >= sizeof(PageFileHeader);
+    if(isValid){
+        memcpy(&header, page, sizeof(PageFileHeader));
+        isValid = memcmp(header.magic, PAGE_FILE_MAGIC, sizeof(header.magic)) == 0;
+    }
+    bufferPoolUnpin(page, 0);
+    if(!isValid){
+        bufferPoolClose(pageFile->fileId);
+        free(pageFile);
+        return NULL;
+    }
+    pageFile->pageCount = header.pageCount;
+    return pageFile;
+}
+
+/**
+ * Creates an empty paged table file, replacing the file if it exists
+ * @param fileName Table file name
+ * @return Page file or NULL if the file couldn't be created
+ */
+PageFile *pageFileCreate(const char *fileName){
+    bufferPoolInvalidate(fileName, 0);
+    FILE *file = fopen(fileName, "wb");
+    if(file == NULL){
+        return NULL;
+    }
+    fclose(file);
+    PageFile *pageFile = malloc(sizeof(PageFile));
+    if(pageFile == NULL){
+        return NULL;
+    }
+    pageFile->fileId = bufferPoolOpen(fileName);
+    pageFile->pageCount = 1;
+    if(pageFile->fileId == -1 || !writePageFileHeader(pageFile) || !bufferPoolFlush(pageFile->fileId)){
+        bufferPoolClose(pageFile->fileId);
+        free(pageFile);
+        return NULL;
+    }
+    return pageFile;
+}
+
+/**
+ * Closes a paged table file, its dirty pages are written back
+ * @param pageFile Page file
+ */
+void pageFileClose(PageFile *pageFile){
+    if(pageFile == NULL){
+        return;
+    }
+    bufferPoolClose(pageFile->fileId);
+    free(pageFile);
+}
+
+/**
+ * Writes the changed pages of a paged table and syncs the file to the disk
+ * @param pageFile Page file
+ * @return 1 if the file is on the disk, 0 otherwise
+ */
+int pageFileSync(PageFile *pageFile){
+    return bufferPoolSync(pageFile->fileId);
+}
+
+/**
+ * Pins a page of a paged table in the buffer pool
+ * @param pageFile Page file
+ * @param pageNo Page number, page 0 is the file header
+ * @return Page of PAGE_SIZE bytes or NULL if the page doesn't exist
+ */
+char *pagePin(PageFile *pageFile, uint64_t pageNo){
+    if(pageNo == 0 || pageNo >= pageFile->pageCount){
+        return NULL;
+    }
+    return bufferPoolPin(pageFile->fileId, pageNo, NULL);
+}
+
+/**
+ * Releases a page pinned by `pagePin`
+ * @param page Pinned page
+ * @param isDirty 1 if the page was changed
+ */
+void pageUnpin(const char *page, int isDirty){
+    bufferPoolUnpin(page, isDirty);
+}
+
+/**
+ * Appends a record to the last page of a table, a new page is added when it is full
+ * @param pageFile Page file
+ * @param record Encoded record
+ * @param len Record length
+ * @return Location of the record or PAGE_NO_LOCATION if it couldn't be stored
+ */
+uint64_t pageFileAppend(PageFile *pageFile, const char *record, uint16_t len){
+    uint64_t pageNo = pageFile->pageCount - 1;
+    int slot = -1;
+    char *page = pagePin(pageFile, pageNo);
+    if(page != NULL){
+        slot = pageAddRecord(page, record, len);
+        pageUnpin(page, slot != -1);
+    }
+    if(slot == -1){
+        pageNo = pageFile->pageCount;
+        page = bufferPoolPin(pageFile->fileId, pageNo, NULL);
+        if(page == NULL){
+            return PAGE_NO_LOCATION;
+        }
+        pageInit(page);
+        slot = pageAddRecord(page, record, len);
+        pageUnpin(page, 1);
+        if(slot == -1){
+            return PAGE_NO_LOCATION;
+        }
+        pageFile->pageCount++;
+        if(!writePageFileHeader(pageFile)){
+            return PAGE_NO_LOCATION;
+        }
+    }
+    return PAGE_LOCATION(pageNo, slot);
+}
+
+/**
+ * Starts planning appends to a table, the plan works on a copy of the last page
+ * @param pageFile Page file
+ * @param plan Plan to start
+ */
+void pageFilePlanStart(PageFile *pageFile, PageAppendPlan *plan){
+    plan->pageNo = pageFile->pageCount - 1;
+    plan->hasPage = 0;
+    const char *page = pagePin(pageFile, plan->pageNo);
+    if(page != NULL){
+        memcpy(plan->page, page, PAGE_SIZE);
+        pageUnpin(page, 0);
+        plan->hasPage = 1;
+    }
+}
+
+/**
+ * Finds the location `pageFileAppend` gives a record, appends planned before it are taken into account
+ * @param pageFile Page file
+ * @param plan Started plan
+ * @param record Encoded record
+ * @param len Record length
+ * @return Location the record gets or PAGE_NO_LOCATION if it doesn't fit in a page
+ */
+uint64_t pageFilePlanAppend(PageFile *pageFile, PageAppendPlan *plan, const char *record, uint16_t len){
+    int slot = plan->hasPage ? pageAddRecord(plan->page, record, len) : -1;
+    if(slot == -1){
+        // Same as pageFileAppend, a full last page starts a new one
+        plan->pageNo = plan->hasPage ? plan->pageNo + 1 : pageFile->pageCount;
+        plan->hasPage = 1;
+        pageInit(plan->page);
+        slot = pageAddRecord(plan->page, record, len);
+        if(slot == -1){
+            return PAGE_NO_LOCATION;
+        }
+    }
+    return PAGE_LOCATION(plan->pageNo, slot);
+}
+
+/**
+ * Compacts in place the pages of a table with enough dead space, the records keep
+ * their locations so the indexes of the table stay valid
+ * @param pageFile Page file
+ * @param minDeadSpace Dead bytes that make a page worth compacting
+ * @param freeSpace Free bytes of the pages after the pass
+ * @return Number of compacted pages
+ */
+size_t pageFileVacuum(PageFile *pageFile, size_t minDeadSpace, size_t *freeSpace){
+    size_t compacted = 0;
+    *freeSpace = 0;
+    for (uint64_t pageNo = 1; pageNo < pageFile->pageCount; ++pageNo) {
+        char *page = pagePin(pageFile, pageNo);
+        if(page == NULL){
+            continue;
+        }
+        size_t dead = pageDeadSpace(page);
+        int isDirty = dead > 0 && dead >= minDeadSpace;
+        if(isDirty){
+            pageVacuum(page);
+            compacted++;
+        }
+        *freeSpace += pageFreeSpace(page);
+        pageUnpin(page, isDirty);
+    }
+    return compacted;
+}
+
+/**
+ * Removes the record at a location
+ * @param pageFile Page file
+ * @param location Record location
+ * @return 1 if the record was removed, 0 otherwise
+ */
+int pageFileRemove(PageFile *pageFile, uint64_t location){
+    char *page = pagePin(pageFile, PAGE_LOCATION_PAGE(location));
+    if(page == NULL){
+        return 0;
+    }
+    int removed = pageRemoveRecord(page, PAGE_LOCATION_SLOT(location));
+    pageUnpin(page, removed);
+    return removed;
+}
+
+/**
+ * Replaces the record at a location, the record keeps its location unless its page is full
+ * @param pageFile Page file
+ * @param location Record location
+ * @param record Encoded record
+ * @param len Record length
+ * @return New location of the record or PAGE_NO_LOCATION if it couldn't be stored
+ */
+uint64_t pageFileReplace(PageFile *pageFile, uint64_t location, const char *record, uint16_t len){
+    char *page = pagePin(pageFile, PAGE_LOCATION_PAGE(location));
+    if(page == NULL){
+        return PAGE_NO_LOCATION;
+    }
+    int replaced = pageReplaceRecord(page, PAGE_LOCATION_SLOT(location), record, len);
+    pageUnpin(page, replaced != -1);
+    if(replaced == -1){
+        return PAGE_NO_LOCATION;
+    }
+    if(replaced == 1){
+        return location;
+    }
+    return pageFileAppend(pageFile, record, len);
+}
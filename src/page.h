@@ -0,0 +1,84 @@
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "bufferpool.h"
+
+#ifndef MINISQL_PAGE_H
+#define MINISQL_PAGE_H
+
+#define PAGE_SIZE BUFFER_POOL_PAGE_SIZE
+#define PAGE_FILE_MAGIC "MSQLPAGE"
+// Row location in a paged table, page number in the high bits and slot in the low 16 bits
+#define PAGE_LOCATION(pageNo, slot) (((uint64_t)(pageNo) << 16) | (uint64_t)(slot))
+#define PAGE_LOCATION_PAGE(location) ((location) >> 16)
+#define PAGE_LOCATION_SLOT(location) ((uint32_t)((location) & 0xFFFF))
+#define PAGE_NO_LOCATION UINT64_MAX
+
+typedef enum {
+    FIELD_NULL,
+    FIELD_INT,  // 8 byte signed integer
+    FIELD_TEXT, // Raw bytes of the value
+} FieldType;
+
+/*
+ * Page layout: header, slot directory growing forward, records growing backward from the end
+ * A slot with length 0 is a removed record
+ */
+struct {
+    uint16_t slotCount;
+    uint16_t freeStart; // End of the slot directory
+    uint16_t freeEnd;   // Start of the record area
+    uint16_t flags;
+} typedef PageHeader;
+
+struct {
+    uint16_t offset;
+    uint16_t length;
+} typedef Slot;
+
+/*
+ * Paged table file, page 0 holds the file header and the rows start in page 1
+ * Pages are read and written through the buffer pool
+ */
+struct {
+    int fileId; // Buffer pool file id
+    uint64_t pageCount;
+} typedef PageFile;
+
+/*
+ * Copy of the last page of a table used to find the locations appends will get without writing them
+ */
+struct {
+    char page[PAGE_SIZE];
+    uint64_t pageNo;
+    int hasPage; // 0 until the last page is loaded or a new one is started
+} typedef PageAppendPlan;
+
+void pageInit(char *page);
+int pageAddRecord(char *page, const char *record, uint16_t len);
+const char *pageGetRecord(const char *page, uint32_t slot, uint16_t *len);
+int pageRemoveRecord(char *page, uint32_t slot);
+uint16_t pageSlotCount(const char *page);
+size_t pageFreeSpace(const char *page);
+size_t pageDeadSpace(const char *page);
+size_t pageVacuum(char *page);
+
+size_t recordEncode(char *out, size_t size, const FieldType *types, const char *const *values, const size_t *lens, int count);
+int recordFieldCount(const char *record);
+FieldType recordField(const char *record, int idx, const char **data, size_t *len);
+int64_t recordInt(const char *data);
+
+PageFile *pageFileOpen(const char *fileName);
+PageFile *pageFileCreate(const char *fileName);
+void pageFileClose(PageFile *pageFile);
+int pageFileSync(PageFile *pageFile);
+char *pagePin(PageFile *pageFile, uint64_t pageNo);
+void pageUnpin(const char *page, int isDirty);
+uint64_t pageFileAppend(PageFile *pageFile, const char *record, uint16_t len);
+void pageFilePlanStart(PageFile *pageFile, PageAppendPlan *plan);
+uint64_t pageFilePlanAppend(PageFile *pageFile, PageAppendPlan *plan, const char *record, uint16_t len);
+size_t pageFileVacuum(PageFile *pageFile, size_t minDeadSpace, size_t *freeSpace);
+int pageFileRemove(PageFile *pageFile, uint64_t location);
+uint64_t pageFileReplace(PageFile *pageFile, uint64_t location, const char *record, uint16_t len);
+
+#endif //MINISQL_PAGE_H
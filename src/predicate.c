@@ -0,0 +1,167 @@
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "predicate.h"
+#include "utils.h"
+
+
+/**
+ * Operator of a filter
+ * @param symbol Symbol token value
+ * @return Operator, PRED_NONE if the symbol is not a comparison
+ */
+static PredicateOp getPredicateOp(const char *symbol){
+    if(symbol == NULL){
+        return PRED_NONE;
+    }
+    switch (symbol[0]) {
+        case '=':
+            return symbol[1] == '\0' ? PRED_EQ : PRED_NONE;
+        case '!':
+            return strcmp(symbol, "!=") == 0 ? PRED_NE : PRED_NONE;
+        case '<':
+            return symbol[1] == '\0' ? PRED_LT : strcmp(symbol, "<=") == 0 ? PRED_LE : PRED_NONE;
+        case '>':
+            return symbol[1] == '\0' ? PRED_GT : strcmp(symbol, ">=") == 0 ? PRED_GE : PRED_NONE;
+        default:
+            return PRED_NONE;
+    }
+}
+
+/**
+ * Reads a column value as an integer, a value is numeric if `isNumber` accepts it
+ * and its integer part is compared, the same way `strtol` reads it
+ * @param data Column value, not NUL terminated
+ * @param len Length of the value
+ * @param number Integer part of the value
+ * @return 1 if the value is numeric, 0 otherwise
+ */
+static int parseNumber(const char *data, size_t len, long long *number){
+    size_t i = 0;
+    int isNegative = 0;
+    int isFraction = 0;
+    unsigned long long value = 0;
+    if(i < len && (data[i] == '-' || data[i] == '+')){
+        isNegative = data[i] == '-';
+        i++;
+    }
+    for (; i < len; ++i) {
+        if(data[i] == '.'){
+            if(isFraction){
+                return 0;
+            }
+            isFraction = 1;
+        }
+        else if(data[i] < '0' || data[i] > '9'){
+            return 0;
+        }
+        else if(!isFraction && value <= (unsigned long long)LLONG_MAX){
+            value = value * 10 + (unsigned long long)(data[i] - '0');
+        }
+    }
+    if(value > (unsigned long long)LLONG_MAX){
+        *number = isNegative ? LLONG_MIN : LLONG_MAX;
+    }
+    else{
+        *number = isNegative ? -(long long)value : (long long)value;
+    }
+    return 1;
+}
+
+/**
+ * Compiles the where clause of a statement against the table it reads
+ * @param predicate Predicate to initialize, freed with `predicateFree`
+ * @param sqlNode SQL AST Node
+ * @param tableNode Table reference node
+ * @return 1 if the predicate is compiled, 0 if it is out of memory
+ */
+int predicateCompile(Predicate *predicate, const Node *sqlNode, const Node *tableNode){
+    predicate->size = 0;
+    predicate->terms = NULL;
+    if(sqlNode->filtersLen <= 0){
+        return 1;
+    }
+    predicate->terms = calloc((size_t)sqlNode->filtersLen, sizeof(PredicateTerm));
+    if(predicate->terms == NULL){
+        return 0;
+    }
+    for (int fil = 0; fil < sqlNode->filtersLen; ++fil) {
+        const Column *filter = &sqlNode->filters[fil];
+        PredicateTerm *term = &predicate->terms[fil];
+        predicate->size++;
+        term->colIdx = getColumnIndex(tableNode, filter->columnToken.value);
+        term->op = getPredicateOp(filter->symbol.value);
+        term->isAnd = filter->nextLogicalOp.keyword == KW_AND;
+        term->text = strdup(filter->valueToken.value != NULL ? filter->valueToken.value : "");
+        if(term->text == NULL){
+            predicateFree(predicate);
+            return 0;
+        }
+        removeSingleQuotes(term->text);
+        term->textLen = strlen(term->text);
+        term->isNumber = filter->valueToken.type == TOKEN_NUMBER;
+        term->number = term->isNumber ? strtoll(term->text, NULL, 10) : 0;
+    }
+    return 1;
+}
+
+/**
+ * Checks a column value against a term, numeric values are compared with the operator
+ * and any other value has to be equal to the constant, or differ from it for `!=`
+ * @param term Compiled filter
+ * @param data Column value
+ * @param len Length of the value
+ * @return 1 if the value matches, 0 otherwise
+ */
+static int matchTerm(const PredicateTerm *term, const char *data, size_t len){
+    long long value;
+    if(term->isNumber && parseNumber(data, len, &value)){
+        switch (term->op) {
+            case PRED_EQ:
+                return value == term->number;
+            case PRED_NE:
+                return value != term->number;
+            case PRED_LT:
+                return value < term->number;
+            case PRED_LE:
+                return value <= term->number;
+            case PRED_GT:
+                return value > term->number;
+            case PRED_GE:
+                return value >= term->number;
+            default:
+                return 0;
+        }
+    }
+    int isEqual = term->textLen == len && memcmp(term->text, data, len) == 0;
+    return term->op == PRED_NE ? !isEqual : isEqual;
+}
+
+/**
+ * Evaluates a compiled where clause on the current row of a scan
+ * @param predicate Compiled where clause
+ * @param scan Scan positioned on a row
+ * @return 1 if the row matches, 0 otherwise
+ */
+int predicateMatch(const Predicate *predicate, TableScan *scan){
+    int isMatch = 1;
+    for (size_t i = 0; i < predicate->size; ++i) {
+        const PredicateTerm *term = &predicate->terms[i];
+        const char *data;
+        size_t len;
+        isMatch = term->colIdx != -1 && scanField(scan, term->colIdx, &data, &len) && matchTerm(term, data, len);
+        if(term->isAnd ? !isMatch : isMatch){
+            break;
+        }
+    }
+    return isMatch;
+}
+
+void predicateFree(Predicate *predicate){
+    for (size_t i = 0; i < predicate->size; ++i) {
+        free(predicate->terms[i].text);
+    }
+    free(predicate->terms);
+    predicate->terms = NULL;
+    predicate->size = 0;
+}
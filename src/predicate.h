@@ -0,0 +1,45 @@
+#include <stddef.h>
+#include "lexer.h"
+#include "database.h"
+
+#ifndef MINISQL_PREDICATE_H
+#define MINISQL_PREDICATE_H
+
+typedef enum {
+    PRED_NONE, // Unknown operator, only matches a text value equal to the constant
+    PRED_EQ,
+    PRED_NE,
+    PRED_LT,
+    PRED_LE,
+    PRED_GT,
+    PRED_GE,
+} PredicateOp;
+
+/*
+ * Filter of a where clause resolved against the table, the column ordinal and the constant
+ * are found once per statement instead of once per row
+ */
+struct {
+    int colIdx; // -1 if the table has no such column, the term never matches
+    PredicateOp op;
+    int isNumber; // The constant is a number, compared as an integer with numeric values
+    long long number;
+    char *text; // Constant without its quotes
+    size_t textLen;
+    int isAnd; // Joined to the next term with AND, otherwise with OR
+} typedef PredicateTerm;
+
+/*
+ * Compiled where clause, the terms are evaluated left to right: a false term followed by AND
+ * makes the row fail and a true term followed by OR makes it match
+ */
+struct {
+    PredicateTerm *terms;
+    size_t size;
+} typedef Predicate;
+
+int predicateCompile(Predicate *predicate, const Node *sqlNode, const Node *tableNode);
+int predicateMatch(const Predicate *predicate, TableScan *scan);
+void predicateFree(Predicate *predicate);
+
+#endif //MINISQL_PREDICATE_H
@@ -0,0 +1,158 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "sequence.h"
+#include "filesystem.h"
+#include "utils.h"
+
+/*
+ * Ids are handed out from memory with an atomic increment. The pk file holds the last id of the
+ * range reserved so far and is synced before an id of a new range is handed out, so the ids given
+ * before a crash are never given again, the next run starts after the reserved range
+ */
+struct Sequence {
+    char *fileName;
+    FILE *file;
+    atomic_uint_least64_t next; // Next id
+    atomic_uint_least64_t reserved; // Last id of the reserved range, the content of the pk file
+    pthread_mutex_t lock; // Held to reserve a range
+};
+
+/*
+ * Sequences opened by this run, a table keeps its sequence until minisql stops
+ */
+struct {
+    Sequence **sequences;
+    size_t size;
+    pthread_mutex_t lock;
+} typedef SequenceList;
+
+static SequenceList sequenceList = {.lock = PTHREAD_MUTEX_INITIALIZER};
+
+/**
+ * Writes the last reserved id to the pk file, the ids only grow so the new number covers the old one
+ * @param sequence Sequence
+ * @param reserved Last reserved id
+ * @return 1 if the id is on the disk, 0 otherwise
+ */
+static int writeReserved(Sequence *sequence, uint64_t reserved){
+    if(fseek(sequence->file, 0, SEEK_SET) != 0){
+        return 0;
+    }
+    return fprintf(sequence->file, "%llu", (unsigned long long)reserved) > 0 && syncFile(sequence->file);
+}
+
+/**
+ * Opens the sequence of a pk file, the ids given by the last run are skipped
+ * @param fileName Pk file
+ * @return Sequence or NULL if the file can't be read
+ */
+static Sequence *sequenceOpen(const char *fileName){
+    FILE *file = fopen(fileName, "r+");
+    char buffer[64];
+    char *end;
+    if(file == NULL){
+        return NULL;
+    }
+    if(fgets(buffer, sizeof(buffer), file) == NULL){
+        printError("Invalid pk file, pk file is corrupted\n");
+        fclose(file);
+        return NULL;
+    }
+    unsigned long long last = strtoull(buffer, &end, 10);
+    Sequence *sequence = malloc(sizeof(Sequence));
+    if((*end != '\0' && *end != '\n') || sequence == NULL){
+        printError("Invalid pk file, pk file is corrupted\n");
+        fclose(file);
+        free(sequence);
+        return NULL;
+    }
+    sequence->fileName = createBuffer();
+    insertInBuffer(&sequence->fileName, "%s", fileName);
+    sequence->file = file;
+    atomic_init(&sequence->next, (uint64_t)last + 1);
+    atomic_init(&sequence->reserved, (uint64_t)last);
+    pthread_mutex_init(&sequence->lock, NULL);
+    return sequence;
+}
+
+/**
+ * Sequence of a pk file, opened on its first use
+ * @param fileName Pk file
+ * @return Sequence or NULL if the file can't be read
+ */
+Sequence *sequenceGet(const char *fileName){
+    pthread_mutex_lock(&sequenceList.lock);
+    for (size_t i = 0; i < sequenceList.size; ++i) {
+        if(strcmp(sequenceList.sequences[i]->fileName, fileName) == 0){
+            Sequence *sequence = sequenceList.sequences[i];
+            pthread_mutex_unlock(&sequenceList.lock);
+            return sequence;
+        }
+    }
+    Sequence *sequence = sequenceOpen(fileName);
+    Sequence **sequences = sequence != NULL ? realloc(sequenceList.sequences, sizeof(Sequence *) * (sequenceList.size + 1)) : NULL;
+    if(sequences != NULL){
+        sequences[sequenceList.size++] = sequence;
+        sequenceList.sequences = sequences;
+    }
+    else if(sequence != NULL){
+        fclose(sequence->file);
+        free(sequence->fileName);
+        free(sequence);
+        sequence = NULL;
+    }
+    pthread_mutex_unlock(&sequenceList.lock);
+    return sequence;
+}
+
+/**
+ * Takes consecutive ids, a new range is reserved in the pk file when the ids go past the reserved one
+ * @param sequence Sequence
+ * @param count Number of ids
+ * @param first First id taken
+ * @return 1 if the ids are reserved, 0 if the pk file couldn't be written
+ */
+int sequenceNext(Sequence *sequence, uint64_t count, uint64_t *first){
+    *first = atomic_fetch_add(&sequence->next, count);
+    uint64_t last = *first + count - 1;
+    if(count == 0 || last <= atomic_load(&sequence->reserved)){
+        return 1;
+    }
+    int ok = 1;
+    pthread_mutex_lock(&sequence->lock);
+    if(last > atomic_load(&sequence->reserved)){
+        uint64_t reserved = last + SEQUENCE_RANGE_SIZE;
+        ok = writeReserved(sequence, reserved);
+        if(ok){
+            atomic_store(&sequence->reserved, reserved);
+        }
+    }
+    pthread_mutex_unlock(&sequence->lock);
+    return ok;
+}
+
+/**
+ * Moves a sequence past an id found in a table, used by recovery for the rows of the log
+ * @param sequence Sequence
+ * @param id Id in use
+ * @return 1 if the id won't be given, 0 if the pk file couldn't be written
+ */
+int sequenceRaise(Sequence *sequence, uint64_t id){
+    int ok = 1;
+    pthread_mutex_lock(&sequence->lock);
+    uint64_t next = atomic_load(&sequence->next);
+    while (next <= id && !atomic_compare_exchange_weak(&sequence->next, &next, id + 1)){
+    }
+    if(id > atomic_load(&sequence->reserved)){
+        ok = writeReserved(sequence, id);
+        if(ok){
+            atomic_store(&sequence->reserved, id);
+        }
+    }
+    pthread_mutex_unlock(&sequence->lock);
+    return ok;
+}
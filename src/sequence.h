@@ -0,0 +1,19 @@
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef MINISQL_SEQUENCE_H
+#define MINISQL_SEQUENCE_H
+
+// Ids a sequence reserves at once, the pk file is only written when a new range is reserved
+#define SEQUENCE_RANGE_SIZE 1000
+
+/*
+ * Id generator of a table backed by its pk file, defined in sequence.c
+ */
+struct Sequence typedef Sequence;
+
+Sequence *sequenceGet(const char *fileName);
+int sequenceNext(Sequence *sequence, uint64_t count, uint64_t *first);
+int sequenceRaise(Sequence *sequence, uint64_t id);
+
+#endif //MINISQL_SEQUENCE_H
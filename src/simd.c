@@ -0,0 +1,293 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include "simd.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define SIMD_X86
+#include <immintrin.h>
+#endif
+
+/*
+ * Row being split into fields, rows are stored as `1,col_0,col_1,...\n`
+ * and a comma inside a value is escaped as `\,`
+ */
+struct {
+    const char *line;
+    const char *fieldStart; // NULL in the leading flag of the row
+    FieldSlice *fields;
+    size_t count;
+    size_t capacity;
+} typedef RowSplit;
+
+static SimdLevel level = SIMD_SCALAR;
+static int isLevelSet = 0;
+
+
+/**
+ * Ends the current field at a delimiter
+ * @param split Row being split
+ * @param pos Position of the delimiter in the row
+ * @return 1 once the row is split, at its newline or when every requested field is found
+ */
+static inline int splitAt(RowSplit *split, size_t pos){
+    if(split->fieldStart != NULL){
+        split->fields[split->count].data = split->fieldStart;
+        split->fields[split->count].len = (size_t)(split->line + pos - split->fieldStart);
+        split->count++;
+    }
+    if(split->line[pos] == '\n' || split->count == split->capacity){
+        return 1;
+    }
+    split->fieldStart = split->line + pos + 1;
+    return 0;
+}
+
+/**
+ * Ends the last field of a row at the end of its text
+ * @param split Row being split
+ * @param length Length of the row
+ * @return Number of fields found
+ */
+static size_t splitEnd(RowSplit *split, size_t length){
+    // Row without a trailing newline
+    if(split->fieldStart != NULL && split->count < split->capacity){
+        split->fields[split->count].data = split->fieldStart;
+        split->fields[split->count].len = (size_t)(split->line + length - split->fieldStart);
+        split->count++;
+    }
+    return split->count;
+}
+
+/**
+ * Splits a row one byte at a time
+ * @param split Row being split
+ * @param length Length of the row
+ * @return Number of fields found
+ */
+static size_t splitScalar(RowSplit *split, size_t length){
+    const char *line = split->line;
+    for (size_t i = 0; i < length; ++i) {
+        if((line[i] == '\n' || (line[i] == ',' && i > 0 && line[i-1] != '\\')) && splitAt(split, i)){
+            return split->count;
+        }
+    }
+    return splitEnd(split, length);
+}
+
+#ifdef SIMD_X86
+
+__attribute__((target("sse2")))
+static inline uint32_t maskSse2(__m128i block, char c){
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8(c)));
+}
+
+__attribute__((target("avx2")))
+static inline uint32_t maskAvx2(__m256i block, char c){
+    return (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, _mm256_set1_epi8(c)));
+}
+
+/**
+ * Splits a row 16 bytes at a time, the delimiters of a block are found with one bitmask
+ * and a comma is escaped if the bit before it is set in the backslash mask
+ * The last block is copied to a zeroed buffer so no byte after the row is read
+ * @param split Row being split
+ * @param length Length of the row
+ * @return Number of fields found
+ */
+__attribute__((target("sse2")))
+static size_t splitRowSse2(RowSplit *split, size_t length){
+    // A comma can't start a row, the first byte counts as escaped
+    uint32_t carry = 1;
+    char tail[16];
+    for (size_t i = 0; i < length; i += 16) {
+        const char *block = split->line + i;
+        if(i + 16 > length){
+            memset(tail, 0, sizeof(tail));
+            memcpy(tail, block, length - i);
+            block = tail;
+        }
+        __m128i bytes = _mm_loadu_si128((const __m128i *)block);
+        uint32_t slashes = maskSse2(bytes, '\\');
+        uint32_t escaped = (slashes << 1) | carry;
+        carry = slashes >> 15;
+        uint32_t delimiters = ((maskSse2(bytes, ',') & ~escaped) | maskSse2(bytes, '\n')) & 0xFFFF;
+        while (delimiters != 0){
+            size_t pos = i + (size_t)__builtin_ctz(delimiters);
+            delimiters &= delimiters - 1;
+            if(splitAt(split, pos)){
+                return split->count;
+            }
+        }
+    }
+    return splitEnd(split, length);
+}
+
+/**
+ * Splits a row 32 bytes at a time, same as `splitRowSse2` with 256 bit registers
+ */
+__attribute__((target("avx2")))
+static size_t splitRowAvx2(RowSplit *split, size_t length){
+    uint32_t carry = 1;
+    char tail[32];
+    for (size_t i = 0; i < length; i += 32) {
+        const char *block = split->line + i;
+        if(i + 32 > length){
+            memset(tail, 0, sizeof(tail));
+            memcpy(tail, block, length - i);
+            block = tail;
+        }
+        __m256i bytes = _mm256_loadu_si256((const __m256i *)block);
+        uint32_t slashes = maskAvx2(bytes, '\\');
+        uint32_t escaped = (slashes << 1) | carry;
+        carry = slashes >> 31;
+        uint32_t delimiters = (maskAvx2(bytes, ',') & ~escaped) | maskAvx2(bytes, '\n');
+        while (delimiters != 0){
+            size_t pos = i + (size_t)__builtin_ctz(delimiters);
+            delimiters &= delimiters - 1;
+            if(splitAt(split, pos)){
+                return split->count;
+            }
+        }
+    }
+    return splitEnd(split, length);
+}
+
+__attribute__((target("sse2")))
+static const char *findNewLineSse2(const char *data, size_t len){
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        uint32_t mask = maskSse2(_mm_loadu_si128((const __m128i *)(data + i)), '\n');
+        if(mask != 0){
+            return data + i + __builtin_ctz(mask);
+        }
+    }
+    return memchr(data + i, '\n', len - i);
+}
+
+__attribute__((target("avx2")))
+static const char *findNewLineAvx2(const char *data, size_t len){
+    size_t i = 0;
+    for (; i + 64 <= len; i += 64) {
+        uint64_t low = maskAvx2(_mm256_loadu_si256((const __m256i *)(data + i)), '\n');
+        uint64_t high = maskAvx2(_mm256_loadu_si256((const __m256i *)(data + i + 32)), '\n');
+        uint64_t mask = low | (high << 32);
+        if(mask != 0){
+            return data + i + __builtin_ctzll(mask);
+        }
+    }
+    return memchr(data + i, '\n', len - i);
+}
+
+#endif
+
+/**
+ * If the CPU can run an instruction set
+ * @param simdLevel Instruction set
+ * @return 1 if it is supported, 0 otherwise
+ */
+static int isLevelSupported(SimdLevel simdLevel){
+#ifdef SIMD_X86
+    __builtin_cpu_init();
+    if(simdLevel == SIMD_AVX2){
+        return __builtin_cpu_supports("avx2");
+    }
+    if(simdLevel == SIMD_SSE2){
+        return __builtin_cpu_supports("sse2");
+    }
+#endif
+    return simdLevel == SIMD_SCALAR;
+}
+
+/**
+ * Instruction set used by the scanner, detected with CPUID on first use
+ * @return Instruction set
+ */
+SimdLevel simdGetLevel(){
+    if(!isLevelSet){
+        if(isLevelSupported(SIMD_AVX2)){
+            level = SIMD_AVX2;
+        }
+        else if(isLevelSupported(SIMD_SSE2)){
+            level = SIMD_SSE2;
+        }
+        isLevelSet = 1;
+    }
+    return level;
+}
+
+/**
+ * Forces the instruction set used by the scanner, used to compare them
+ * @param simdLevel Instruction set
+ * @return 1 if the instruction set is supported and selected, 0 otherwise
+ */
+int simdSetLevel(SimdLevel simdLevel){
+    if(!isLevelSupported(simdLevel)){
+        return 0;
+    }
+    level = simdLevel;
+    isLevelSet = 1;
+    return 1;
+}
+
+/**
+ * Name of an instruction set
+ * @param simdLevel Instruction set
+ * @return Name
+ */
+const char *simdLevelName(SimdLevel simdLevel){
+    switch (simdLevel) {
+        case SIMD_AVX2:
+            return "AVX2";
+        case SIMD_SSE2:
+            return "SSE2";
+        default:
+            return "scalar";
+    }
+}
+
+/**
+ * Finds the first newline of a block of a table file
+ * @param data Block
+ * @param len Length of the block
+ * @return Position of the newline or NULL if the block has none
+ */
+const char *simdFindNewLine(const char *data, size_t len){
+#ifdef SIMD_X86
+    switch (simdGetLevel()) {
+        case SIMD_AVX2:
+            return findNewLineAvx2(data, len);
+        case SIMD_SSE2:
+            return findNewLineSse2(data, len);
+        default:
+            break;
+    }
+#endif
+    return memchr(data, '\n', len);
+}
+
+/**
+ * Splits a stored row into its column values, the delimiters are found a block of bytes at a time
+ * @param line Stored row
+ * @param length Length of the row
+ * @param fields Column values, they point into the row
+ * @param capacity Number of columns to split, the rest of the row is not read
+ * @return Number of columns found
+ */
+size_t simdSplitRow(const char *line, size_t length, FieldSlice *fields, size_t capacity){
+    RowSplit split = {line, NULL, fields, 0, capacity};
+    if(capacity == 0){
+        return 0;
+    }
+#ifdef SIMD_X86
+    switch (simdGetLevel()) {
+        case SIMD_AVX2:
+            return splitRowAvx2(&split, length);
+        case SIMD_SSE2:
+            return splitRowSse2(&split, length);
+        default:
+            break;
+    }
+#endif
+    return splitScalar(&split, length);
+}
@@ -0,0 +1,31 @@
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef MINISQL_SIMD_H
+#define MINISQL_SIMD_H
+
+/*
+ * Instruction set used to find the delimiters of the table files, the best one
+ * supported by the CPU is selected on first use
+ */
+typedef enum {
+    SIMD_SCALAR,
+    SIMD_SSE2,  // 16 bytes per step
+    SIMD_AVX2,  // 32 bytes per step
+} SimdLevel;
+
+/*
+ * Column value of a stored row, points into the row it was split from
+ */
+struct {
+    const char *data;
+    size_t len;
+} typedef FieldSlice;
+
+SimdLevel simdGetLevel();
+int simdSetLevel(SimdLevel level);
+const char *simdLevelName(SimdLevel level);
+const char *simdFindNewLine(const char *data, size_t len);
+size_t simdSplitRow(const char *line, size_t length, FieldSlice *fields, size_t capacity);
+
+#endif //MINISQL_SIMD_H
@@ -0,0 +1,466 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "sort.h"
+#include "const.h"
+#include "utils.h"
+
+static size_t memoryBudget = SORT_DEFAULT_BUDGET;
+// Numbers the run files, every run of the process has its own file
+static size_t runId = 0;
+
+
+/**
+ * Sets the memory the rows of a sort can use before they are written to run files
+ * @param budget Bytes, at least one row is always kept in memory
+ */
+void sortSetMemoryBudget(size_t budget){
+    memoryBudget = budget;
+}
+
+/**
+ * Reads a value of a numeric key
+ * @param field Value
+ * @param number Value as a number
+ * @return 1 if the value is a number, 0 otherwise
+ */
+static int parseKey(const FieldSlice *field, double *number){
+    char buffer[64];
+    if(field->len == 0 || field->len >= sizeof(buffer)){
+        return 0;
+    }
+    memcpy(buffer, field->data, field->len);
+    buffer[field->len] = '\0';
+    char *end;
+    *number = strtod(buffer, &end);
+    return end != buffer && *end == '\0';
+}
+
+/**
+ * Reads a value of an integer key, integers are compared exactly instead of as doubles
+ * @param field Value
+ * @param number Value as an integer
+ * @return 1 if the value is an integer, 0 otherwise
+ */
+static int parseIntegerKey(const FieldSlice *field, long long *number){
+    char buffer[32];
+    if(field->len == 0 || field->len >= sizeof(buffer)){
+        return 0;
+    }
+    memcpy(buffer, field->data, field->len);
+    buffer[field->len] = '\0';
+    char *end;
+    *number = strtoll(buffer, &end, 10);
+    return end != buffer && *end == '\0';
+}
+
+/**
+ * Compares two values of a key as text, a shorter value sorts first when it is a prefix of the other
+ */
+static int compareText(const FieldSlice *a, const FieldSlice *b){
+    size_t len = a->len < b->len ? a->len : b->len;
+    int cmp = len > 0 ? memcmp(a->data, b->data, len) : 0;
+    if(cmp != 0){
+        return cmp;
+    }
+    return a->len < b->len ? -1 : a->len > b->len;
+}
+
+/**
+ * Compares two values of a key, values that are not numbers sort before the numbers of a numeric key
+ * @param type Type of the key
+ * @param a Value
+ * @param b Value
+ * @return Negative if a sorts first, positive if b sorts first, 0 if they are equal
+ */
+static int compareKey(SortType type, const FieldSlice *a, const FieldSlice *b){
+    if(type == SORT_INTEGER){
+        long long x, y;
+        int isNumberA = parseIntegerKey(a, &x), isNumberB = parseIntegerKey(b, &y);
+        if(isNumberA && isNumberB){
+            return x < y ? -1 : x > y;
+        }
+        if(isNumberA != isNumberB){
+            return isNumberA ? 1 : -1;
+        }
+    }
+    else if(type == SORT_FLOAT){
+        double x, y;
+        int isNumberA = parseKey(a, &x), isNumberB = parseKey(b, &y);
+        if(isNumberA && isNumberB){
+            return x < y ? -1 : x > y;
+        }
+        if(isNumberA != isNumberB){
+            return isNumberA ? 1 : -1;
+        }
+    }
+    return compareText(a, b);
+}
+
+/**
+ * Compares two rows by their keys then by their position in the input
+ * @param sorter Sorter
+ * @param a Row
+ * @param b Row
+ * @return Negative if a comes first, positive if b comes first
+ */
+static int compareRows(const RowSorter *sorter, const SortRow *a, const SortRow *b){
+    for (size_t k = 0; k < sorter->keyCount; ++k) {
+        int cmp = compareKey(sorter->keys[k].type, &a->fields[k], &b->fields[k]);
+        if(cmp != 0){
+            return sorter->keys[k].isDesc ? -cmp : cmp;
+        }
+    }
+    return a->seq < b->seq ? -1 : a->seq > b->seq;
+}
+
+/**
+ * Splits the line of a row into its keys and values, missing fields are empty
+ * @param sorter Sorter
+ * @param row Row with its line set
+ */
+static void splitSortRow(const RowSorter *sorter, SortRow *row){
+    size_t count = simdSplitRow(row->line, row->len, row->fields, sorter->fieldCount);
+    for (size_t i = count; i < sorter->fieldCount; ++i) {
+        row->fields[i].data = row->line + row->len;
+        row->fields[i].len = 0;
+    }
+}
+
+/**
+ * Copies a row for a sort
+ * @param sorter Sorter
+ * @param row Row to initialize
+ * @param line Row text
+ * @param len Length of the row
+ * @return 1 if the row is copied, 0 if it is out of memory
+ */
+static int createSortRow(RowSorter *sorter, SortRow *row, const char *line, size_t len){
+    row->line = malloc(len + 1);
+    row->fields = malloc(sizeof(FieldSlice) * (sorter->fieldCount > 0 ? sorter->fieldCount : 1));
+    if(row->line == NULL || row->fields == NULL){
+        free(row->line);
+        free(row->fields);
+        return 0;
+    }
+    memcpy(row->line, line, len);
+    row->line[len] = '\0';
+    row->len = len;
+    row->seq = sorter->seq++;
+    splitSortRow(sorter, row);
+    return 1;
+}
+
+static void freeSortRow(SortRow *row){
+    free(row->line);
+    free(row->fields);
+    row->line = NULL;
+    row->fields = NULL;
+}
+
+static size_t sortRowSize(const RowSorter *sorter, const SortRow *row){
+    return sizeof(SortRow) + row->len + 1 + sizeof(FieldSlice) * sorter->fieldCount;
+}
+
+/**
+ * Moves a row down a heap of rows until both its children come after it, the row
+ * sorting last is at the top of the heap
+ * @param sorter Sorter
+ * @param rows Heap
+ * @param size Number of rows in the heap
+ * @param i Row to move
+ */
+static void siftDownRows(const RowSorter *sorter, SortRow *rows, size_t size, size_t i){
+    while (1){
+        size_t largest = i, left = 2 * i + 1, right = 2 * i + 2;
+        if(left < size && compareRows(sorter, &rows[left], &rows[largest]) > 0){
+            largest = left;
+        }
+        if(right < size && compareRows(sorter, &rows[right], &rows[largest]) > 0){
+            largest = right;
+        }
+        if(largest == i){
+            return;
+        }
+        SortRow temp = rows[i];
+        rows[i] = rows[largest];
+        rows[largest] = temp;
+        i = largest;
+    }
+}
+
+static void siftUpRows(const RowSorter *sorter, SortRow *rows, size_t i){
+    while (i > 0){
+        size_t parent = (i - 1) / 2;
+        if(compareRows(sorter, &rows[i], &rows[parent]) <= 0){
+            return;
+        }
+        SortRow temp = rows[i];
+        rows[i] = rows[parent];
+        rows[parent] = temp;
+        i = parent;
+    }
+}
+
+/**
+ * Sorts rows in place with a heap sort, rows never compare equal so the order is stable
+ * @param sorter Sorter
+ * @param rows Rows
+ * @param size Number of rows
+ * @param isHeap The rows already form a heap
+ */
+static void sortRows(const RowSorter *sorter, SortRow *rows, size_t size, int isHeap){
+    if(!isHeap){
+        for (size_t i = size / 2; i > 0; --i) {
+            siftDownRows(sorter, rows, size, i - 1);
+        }
+    }
+    for (size_t end = size; end > 1; --end) {
+        SortRow temp = rows[0];
+        rows[0] = rows[end - 1];
+        rows[end - 1] = temp;
+        siftDownRows(sorter, rows, end - 1, 0);
+    }
+}
+
+/**
+ * Creates a sorter
+ * @param sorter Sorter to initialize, freed with `sorterFree`
+ * @param keys Keys of the sort, the first fields of every row
+ * @param keyCount Number of keys
+ * @param fieldCount Number of keys and values of a row
+ * @param limit Number of rows needed, 0 for every row
+ */
+void sorterInit(RowSorter *sorter, const SortKey *keys, size_t keyCount, size_t fieldCount, size_t limit){
+    memset(sorter, 0, sizeof(RowSorter));
+    sorter->keys = keys;
+    sorter->keyCount = keyCount;
+    sorter->fieldCount = fieldCount;
+    sorter->limit = limit;
+    sorter->budget = memoryBudget;
+    sorter->current = SIZE_MAX;
+}
+
+/**
+ * Writes the rows held in memory to a sorted run file and releases them
+ * @param sorter Sorter
+ * @return 1 if the run is written, 0 on io error
+ */
+static int spillRun(RowSorter *sorter){
+    SortRun *runs = realloc(sorter->runs, sizeof(SortRun) * (sorter->runCount + 1));
+    if(runs == NULL){
+        return 0;
+    }
+    sorter->runs = runs;
+    SortRun *run = &sorter->runs[sorter->runCount];
+    memset(run, 0, sizeof(SortRun));
+    run->name = createBuffer();
+    insertInBuffer(&run->name, "%s/sort_%zu.tmp", DATA_DIR, runId++);
+    run->file = fopen(run->name, "w+b");
+    if(run->file == NULL){
+        free(run->name);
+        return 0;
+    }
+    sorter->runCount++;
+    sortRows(sorter, sorter->rows, sorter->size, 0);
+    int ok = 1;
+    for (size_t i = 0; i < sorter->size; ++i) {
+        SortRow *row = &sorter->rows[i];
+        ok = ok && fwrite(&row->len, sizeof(row->len), 1, run->file) == 1 && fwrite(row->line, 1, row->len, run->file) == row->len;
+        freeSortRow(row);
+    }
+    sorter->size = 0;
+    sorter->memory = 0;
+    return ok && fflush(run->file) == 0;
+}
+
+/**
+ * Adds a row to a sort
+ * @param sorter Sorter
+ * @param line Row in the format `1,key_0,...,key_n,value_0,...\n`
+ * @param len Length of the row
+ * @return 1 if the row is added, 0 on memory or io error
+ */
+int sorterAdd(RowSorter *sorter, const char *line, size_t len){
+    SortRow row;
+    if(!createSortRow(sorter, &row, line, len)){
+        return 0;
+    }
+    // Top-N, the heap holds the best rows seen so far with the worst of them on top
+    if(sorter->limit > 0 && sorter->size == sorter->limit){
+        if(compareRows(sorter, &row, &sorter->rows[0]) < 0){
+            freeSortRow(&sorter->rows[0]);
+            sorter->rows[0] = row;
+            siftDownRows(sorter, sorter->rows, sorter->size, 0);
+        }
+        else{
+            freeSortRow(&row);
+        }
+        return 1;
+    }
+    if(sorter->size == sorter->capacity){
+        size_t capacity = sorter->capacity == 0 ? 64 : sorter->capacity * 2;
+        SortRow *rows = realloc(sorter->rows, sizeof(SortRow) * capacity);
+        if(rows == NULL){
+            freeSortRow(&row);
+            return 0;
+        }
+        sorter->rows = rows;
+        sorter->capacity = capacity;
+    }
+    sorter->rows[sorter->size++] = row;
+    sorter->memory += sortRowSize(sorter, &row);
+    if(sorter->limit > 0){
+        siftUpRows(sorter, sorter->rows, sorter->size - 1);
+    }
+    else if(sorter->memory > sorter->budget){
+        return spillRun(sorter);
+    }
+    return 1;
+}
+
+/**
+ * Reads the next row of a run
+ * @param sorter Sorter
+ * @param run Run
+ * @return 1 if a row is read or the run is over, 0 on memory or io error
+ */
+static int readRunRow(RowSorter *sorter, SortRun *run){
+    size_t len;
+    run->hasHead = 0;
+    if(fread(&len, sizeof(len), 1, run->file) != 1){
+        return feof(run->file);
+    }
+    char *line = realloc(run->head.line, len + 1);
+    if(line == NULL){
+        return 0;
+    }
+    run->head.line = line;
+    if(fread(line, 1, len, run->file) != len){
+        return 0;
+    }
+    line[len] = '\0';
+    run->head.len = len;
+    splitSortRow(sorter, &run->head);
+    run->hasHead = 1;
+    return 1;
+}
+
+static int compareRuns(const RowSorter *sorter, size_t a, size_t b){
+    return compareRows(sorter, &sorter->runs[a].head, &sorter->runs[b].head);
+}
+
+/**
+ * Moves a run down the merge heap, the run with the first row is at the top
+ * @param sorter Sorter
+ * @param i Position of the run in the heap
+ */
+static void siftDownRuns(RowSorter *sorter, size_t i){
+    size_t *heap = sorter->heap;
+    while (1){
+        size_t smallest = i, left = 2 * i + 1, right = 2 * i + 2;
+        if(left < sorter->heapSize && compareRuns(sorter, heap[left], heap[smallest]) < 0){
+            smallest = left;
+        }
+        if(right < sorter->heapSize && compareRuns(sorter, heap[right], heap[smallest]) < 0){
+            smallest = right;
+        }
+        if(smallest == i){
+            return;
+        }
+        size_t temp = heap[i];
+        heap[i] = heap[smallest];
+        heap[smallest] = temp;
+        i = smallest;
+    }
+}
+
+/**
+ * Ends the input of a sort, the rows in memory are sorted and written runs are opened for the merge
+ * @param sorter Sorter
+ * @return 1 if the rows can be read with `sorterNext`, 0 on memory or io error
+ */
+int sorterFinish(RowSorter *sorter){
+    sorter->isFinished = 1;
+    if(sorter->runCount == 0){
+        sortRows(sorter, sorter->rows, sorter->size, sorter->limit > 0);
+        return 1;
+    }
+    if(sorter->size > 0 && !spillRun(sorter)){
+        return 0;
+    }
+    sorter->heap = malloc(sizeof(size_t) * sorter->runCount);
+    if(sorter->heap == NULL){
+        return 0;
+    }
+    for (size_t i = 0; i < sorter->runCount; ++i) {
+        SortRun *run = &sorter->runs[i];
+        run->head.fields = malloc(sizeof(FieldSlice) * (sorter->fieldCount > 0 ? sorter->fieldCount : 1));
+        // Rows with equal keys come out of the earlier run first
+        run->head.seq = i;
+        if(run->head.fields == NULL || fseek(run->file, 0, SEEK_SET) != 0 || !readRunRow(sorter, run)){
+            return 0;
+        }
+        if(run->hasHead){
+            sorter->heap[sorter->heapSize++] = i;
+        }
+    }
+    for (size_t i = sorter->heapSize / 2; i > 0; --i) {
+        siftDownRuns(sorter, i - 1);
+    }
+    sorter->isMerging = 1;
+    return 1;
+}
+
+/**
+ * Next row of a finished sort
+ * @param sorter Sorter
+ * @return Keys and values of the row, valid until the next call, NULL once every row is read
+ */
+const FieldSlice *sorterNext(RowSorter *sorter){
+    if(!sorter->isFinished){
+        return NULL;
+    }
+    if(!sorter->isMerging){
+        return sorter->next < sorter->size ? sorter->rows[sorter->next++].fields : NULL;
+    }
+    // The run of the last returned row moves to its next row
+    if(sorter->current != SIZE_MAX){
+        SortRun *run = &sorter->runs[sorter->current];
+        if(!readRunRow(sorter, run)){
+            printError("Unable to read a sort run `%s`", run->name);
+            sorter->heapSize = 0;
+        }
+        else if(!run->hasHead){
+            sorter->heap[0] = sorter->heap[--sorter->heapSize];
+        }
+        siftDownRuns(sorter, 0);
+        sorter->current = SIZE_MAX;
+    }
+    if(sorter->heapSize == 0){
+        return NULL;
+    }
+    sorter->current = sorter->heap[0];
+    return sorter->runs[sorter->current].head.fields;
+}
+
+/**
+ * Frees the rows of a sort and removes its run files
+ * @param sorter Sorter
+ */
+void sorterFree(RowSorter *sorter){
+    for (size_t i = 0; i < sorter->size; ++i) {
+        freeSortRow(&sorter->rows[i]);
+    }
+    free(sorter->rows);
+    for (size_t i = 0; i < sorter->runCount; ++i) {
+        SortRun *run = &sorter->runs[i];
+        fclose(run->file);
+        remove(run->name);
+        free(run->name);
+        freeSortRow(&run->head);
+    }
+    free(sorter->runs);
+    free(sorter->heap);
+    memset(sorter, 0, sizeof(RowSorter));
+}
@@ -0,0 +1,80 @@
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "simd.h"
+
+#ifndef MINISQL_SORT_H
+#define MINISQL_SORT_H
+
+// Memory the rows of a sort can use before they are spilled to run files
+#define SORT_DEFAULT_BUDGET (64 * 1024 * 1024)
+
+/*
+ * How the values of a sort key compare, taken from the declared type of the column
+ */
+typedef enum {
+    SORT_TEXT, // Byte order
+    SORT_INTEGER,
+    SORT_FLOAT,
+} SortType;
+
+struct {
+    SortType type;
+    int isDesc;
+} typedef SortKey;
+
+/*
+ * Row of a sort in the text row format `1,key_0,...,key_n,value_0,...\n`, the keys come first
+ * and the fields point into the line
+ */
+struct {
+    char *line;
+    size_t len;
+    uint64_t seq; // Position of the row in the input, rows with equal keys keep their order
+    FieldSlice *fields;
+} typedef SortRow;
+
+/*
+ * Run of sorted rows written to a temporary file, read back one row at a time by the merge
+ */
+struct {
+    FILE *file;
+    char *name;
+    SortRow head; // Next row of the run
+    int hasHead;
+} typedef SortRun;
+
+/*
+ * Sorts the rows of a statement. With a limit the best rows are kept in a bounded heap,
+ * otherwise the rows are sorted in memory until they exceed the memory budget, then sorted runs
+ * are written to temporary files in the data directory and merged with a heap of their first rows
+ */
+struct {
+    const SortKey *keys;
+    size_t keyCount;
+    size_t fieldCount; // Keys and values of a row
+    size_t limit; // Rows kept by the top-N heap, 0 to sort every row
+    size_t budget;
+    SortRow *rows;
+    size_t size;
+    size_t capacity;
+    size_t memory; // Bytes held by the rows
+    uint64_t seq;
+    SortRun *runs;
+    size_t runCount;
+    size_t *heap; // Runs ordered by their first row during the merge
+    size_t heapSize;
+    size_t next; // Next row of the in memory rows once sorted
+    size_t current; // Run of the last returned row, refilled on the next call
+    int isMerging;
+    int isFinished;
+} typedef RowSorter;
+
+void sortSetMemoryBudget(size_t budget);
+void sorterInit(RowSorter *sorter, const SortKey *keys, size_t keyCount, size_t fieldCount, size_t limit);
+int sorterAdd(RowSorter *sorter, const char *line, size_t len);
+int sorterFinish(RowSorter *sorter);
+const FieldSlice *sorterNext(RowSorter *sorter);
+void sorterFree(RowSorter *sorter);
+
+#endif //MINISQL_SORT_H
@@ -0,0 +1,632 @@
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdio.h>
+#include <stdint.h>
+#include "statement.h"
+#include "hashindex.h"
+#include "wal.h"
+
+/*
+ * Prepared statement of the session named by `PREPARE name AS ...`
+ */
+struct {
+    char *name;
+    PreparedStatement *statement;
+} typedef NamedStatement;
+
+// Plan cache, looked up by the hash of the normalized statement
+static StatementPlan **plans = NULL;
+static size_t planCount = 0;
+static size_t planCapacity = 0;
+static uint64_t useClock = 0;
+static NamedStatement *namedStatements = NULL;
+static size_t namedCount = 0;
+
+
+/**
+ * Normalizes a statement to the key of its plan, spaces outside string literals are collapsed
+ * and the statement ends with a single `;`
+ * @param sql Statement
+ * @return Normalized statement or NULL if out of memory
+ */
+static char *normalizeSql(const char *sql){
+    StringBuilder out = createStringBuilder();
+    int isInStr = 0, isSpace = 0;
+    for (const char *c = sql; *c != '\0'; ++c) {
+        if(!isInStr && isspace((unsigned char)*c)){
+            isSpace = out.len > 0;
+            continue;
+        }
+        if(*c == '\''){
+            isInStr = !isInStr;
+        }
+        if(isSpace){
+            appendRawToBuilder(&out, " ", 1);
+            isSpace = 0;
+        }
+        appendRawToBuilder(&out, c, 1);
+    }
+    while (out.len > 0 && (out.data[out.len - 1] == ';' || out.data[out.len - 1] == ' ')){
+        out.data[--out.len] = '\0';
+    }
+    // The lexer ends the last token at a separator
+    appendRawToBuilder(&out, ";", 1);
+    return detachStringBuilder(&out);
+}
+
+/**
+ * Frees a plan and its tokens
+ * @param plan Plan
+ */
+static void freePlan(StatementPlan *plan){
+    freeTokenRet(&plan->tokens);
+    free(plan->params);
+    free(plan->sql);
+    free(plan);
+}
+
+/**
+ * Finds the value tokens of the parameters of a parsed statement, in the order of the statement
+ * @param plan Plan with its node
+ * @return 1 if every parameter is the value of a column, an inserted row or a filter, 0 otherwise
+ */
+static int collectParams(StatementPlan *plan){
+    size_t count = 0;
+    for (size_t t = 0; t < plan->tokens.len; ++t) {
+        count += plan->tokens.tokens[t].type == TOKEN_PARAM;
+    }
+    plan->params = malloc(sizeof(Token *) * (count + 1));
+    if(plan->params == NULL){
+        return 0;
+    }
+    Node *node = plan->node;
+    for (int col = 0; col < node->colsLen; ++col) {
+        if(node->columns[col].valueToken.type == TOKEN_PARAM && plan->paramCount < count){
+            plan->params[plan->paramCount++] = &node->columns[col].valueToken;
+        }
+    }
+    for (size_t v = 0; v < (size_t)node->rowsLen * (size_t)node->colsLen; ++v) {
+        if(node->values[v].type == TOKEN_PARAM && plan->paramCount < count){
+            plan->params[plan->paramCount++] = &node->values[v];
+        }
+    }
+    for (int fil = 0; fil < node->filtersLen; ++fil) {
+        if(node->filters[fil].valueToken.type == TOKEN_PARAM && plan->paramCount < count){
+            plan->params[plan->paramCount++] = &node->filters[fil].valueToken;
+        }
+    }
+    // Values of an update come before its filters, the parameters are numbered by their position
+    for (size_t i = 1; i < plan->paramCount; ++i) {
+        Token *param = plan->params[i];
+        size_t j = i;
+        for (; j > 0 && plan->params[j - 1]->start > param->start; --j) {
+            plan->params[j] = plan->params[j - 1];
+        }
+        plan->params[j] = param;
+    }
+    return plan->paramCount == count;
+}
+
+/**
+ * Adds a plan to the plan cache, the least recently used plan nobody uses is dropped
+ * once the cache is full
+ * @param plan Plan
+ * @return 1 if the plan is cached, 0 if out of memory
+ */
+static int cachePlan(StatementPlan *plan){
+    if(planCount >= STATEMENT_CACHE_SIZE){
+        size_t victim = planCount;
+        for (size_t i = 0; i < planCount; ++i) {
+            if(plans[i]->refCount == 0 && (victim == planCount || plans[i]->lastUse < plans[victim]->lastUse)){
+                victim = i;
+            }
+        }
+        if(victim < planCount){
+            freePlan(plans[victim]);
+            plans[victim] = plans[--planCount];
+        }
+    }
+    if(planCount == planCapacity){
+        size_t capacity = planCapacity == 0 ? 16 : planCapacity * 2;
+        StatementPlan **temp = realloc(plans, sizeof(StatementPlan *) * capacity);
+        if(temp == NULL){
+            return 0;
+        }
+        plans = temp;
+        planCapacity = capacity;
+    }
+    plans[planCount++] = plan;
+    return 1;
+}
+
+/**
+ * Finds the plan of a statement in the plan cache or parses the statement
+ * @param sql Statement
+ * @return Plan or NULL on a syntax error
+ */
+static StatementPlan *getPlan(const char *sql){
+    char *text = normalizeSql(sql);
+    if(text == NULL){
+        printError("Error: Memory allocation failed for the statement");
+        return NULL;
+    }
+    uint64_t hash = hashKey(text);
+    for (size_t i = 0; i < planCount; ++i) {
+        if(plans[i]->hash == hash && strcmp(plans[i]->sql, text) == 0){
+            free(text);
+            return plans[i];
+        }
+    }
+    StatementPlan *plan = calloc(1, sizeof(StatementPlan));
+    if(plan == NULL){
+        free(text);
+        printError("Error: Memory allocation failed for the statement");
+        return NULL;
+    }
+    plan->sql = text;
+    plan->hash = hash;
+    plan->tokens = lexAnalyze(text);
+    plan->node = createASTNode(&plan->tokens);
+    KeywordId action = plan->node->action.keyword;
+    if(plan->node->isInvalid){
+        freePlan(plan);
+        return NULL;
+    }
+    if(action != KW_SELECT && action != KW_INSERT && action != KW_UPDATE && action != KW_DELETE){
+        printError("Only SELECT, INSERT, UPDATE and DELETE statements can be prepared");
+        freePlan(plan);
+        return NULL;
+    }
+    if(!collectParams(plan)){
+        printError("Parameters `?` can only be the values of columns and filters");
+        freePlan(plan);
+        return NULL;
+    }
+    if(!cachePlan(plan)){
+        printError("Error: Memory allocation failed for the statement");
+        freePlan(plan);
+        return NULL;
+    }
+    return plan;
+}
+
+/**
+ * Prepares a statement with `?` parameters, the statement is parsed once and a statement prepared
+ * before with the same normalized text shares its plan. Only selects, inserts, updates and deletes
+ * can be prepared
+ * @param sql Statement, `?` stands for the value of a column or a filter
+ * @return Statement of the caller until `statementRelease`, NULL on a syntax error
+ */
+PreparedStatement *statementPrepare(const char *sql){
+    StatementPlan *plan = getPlan(sql);
+    if(plan == NULL){
+        return NULL;
+    }
+    PreparedStatement *statement = malloc(sizeof(PreparedStatement));
+    BoundValue *values = malloc(sizeof(BoundValue) * (plan->paramCount + 1));
+    if(statement == NULL || values == NULL){
+        free(statement);
+        free(values);
+        printError("Error: Memory allocation failed for the statement");
+        return NULL;
+    }
+    for (size_t i = 0; i < plan->paramCount; ++i) {
+        values[i].type = TOKEN_EMPTY;
+        values[i].text = createStringBuilder();
+    }
+    statement->plan = plan;
+    statement->values = values;
+    statement->paramText = createStringBuilder();
+    plan->refCount++;
+    plan->lastUse = ++useClock;
+    return statement;
+}
+
+/**
+ * Binds a value to a parameter, the value is kept until the parameter is bound again
+ * @param statement Statement
+ * @param index Parameter, 0 for the first `?` of the statement
+ * @param type TOKEN_NUMBER or TOKEN_STRING
+ * @param text Value in the form of a literal
+ * @param len Length of the value
+ * @return 1 if the value is bound, 0 if the statement has no such parameter
+ */
+static int bindValue(PreparedStatement *statement, size_t index, TokenType type, const char *text, size_t len){
+    if(index >= statement->plan->paramCount){
+        printError("Parameter %zu is out of range, the statement has %zu parameters", index + 1, statement->plan->paramCount);
+        return 0;
+    }
+    BoundValue *value = &statement->values[index];
+    resetStringBuilder(&value->text);
+    appendRawToBuilder(&value->text, text, len);
+    value->type = type;
+    return 1;
+}
+
+/**
+ * Binds an integer to a parameter
+ * @param statement Statement
+ * @param index Parameter, 0 for the first `?` of the statement
+ * @param value Integer
+ * @return 1 if the value is bound, 0 if the statement has no such parameter
+ */
+int statementBindInteger(PreparedStatement *statement, size_t index, long long value){
+    char text[32];
+    int len = snprintf(text, sizeof(text), "%lld", value);
+    return bindValue(statement, index, TOKEN_NUMBER, text, (size_t)len);
+}
+
+/**
+ * Binds a float to a parameter
+ * @param statement Statement
+ * @param index Parameter, 0 for the first `?` of the statement
+ * @param value Float
+ * @return 1 if the value is bound, 0 if the statement has no such parameter
+ */
+int statementBindFloat(PreparedStatement *statement, size_t index, double value){
+    char text[32];
+    int len = snprintf(text, sizeof(text), "%.15g", value);
+    return bindValue(statement, index, TOKEN_NUMBER, text, (size_t)len);
+}
+
+/**
+ * Binds a string to a parameter, its commas are escaped the way they are stored in table rows
+ * @param statement Statement
+ * @param index Parameter, 0 for the first `?` of the statement
+ * @param value String, it can't hold a line break
+ * @return 1 if the value is bound, 0 if the statement has no such parameter or the string holds a line break
+ */
+int statementBindText(PreparedStatement *statement, size_t index, const char *value){
+    if(strpbrk(value, "\r\n") != NULL){
+        printError("Parameter %zu can't hold a line break", index + 1);
+        return 0;
+    }
+    StringBuilder literal = createStringBuilder();
+    appendRawToBuilder(&literal, "'", 1);
+    for (const char *c = value; *c != '\0'; ++c) {
+        if(*c == ','){
+            appendRawToBuilder(&literal, "\\", 1);
+        }
+        appendRawToBuilder(&literal, c, 1);
+    }
+    appendRawToBuilder(&literal, "'", 1);
+    int ok = bindValue(statement, index, TOKEN_STRING, literal.data, literal.len);
+    clearStringBuilder(&literal);
+    return ok;
+}
+
+/**
+ * Executes a statement with its bound values, the tables of the statement are looked up again
+ * when the tables were loaded since its last execution
+ * @param statement Statement with every parameter bound
+ * @param tableList Tables of the database
+ * @return Result of the statement, the cursor of a select reads the node of the statement
+ * which has to stay prepared until the cursor is closed
+ */
+DBOp statementExecute(PreparedStatement *statement, NodeList *tableList){
+    StatementPlan *plan = statement->plan;
+    Node *node = plan->node;
+    size_t starts[plan->paramCount + 1];
+    resetStringBuilder(&statement->paramText);
+    for (size_t i = 0; i < plan->paramCount; ++i) {
+        if(statement->values[i].type == TOKEN_EMPTY){
+            DBOp dbOp = createDBOp();
+            appendToBuilder(&dbOp.error, "Parameter %zu of the statement is not bound", i + 1);
+            dbOp.code = FAIL;
+            return dbOp;
+        }
+        starts[i] = statement->paramText.len;
+        // Every execution reads fresh copies of the values, the executors unquote them in place
+        appendRawToBuilder(&statement->paramText, statement->values[i].text.data, statement->values[i].text.len + 1);
+    }
+    // Statements run one at a time, the parameters of the plan point to the values of this execution until it returns
+    for (size_t i = 0; i < plan->paramCount; ++i) {
+        plan->params[i]->type = statement->values[i].type;
+        plan->params[i]->value = statement->paramText.data + starts[i];
+    }
+    if(plan->tableNode == NULL || plan->catalogVersion != dbCatalogVersion()){
+        plan->tableNode = getNodeFromList(tableList, node->table.value);
+        plan->joinNode = NULL;
+        const char *missing = plan->tableNode == NULL ? node->table.value : NULL;
+        if(missing == NULL && node->joinTable.type != TOKEN_EMPTY){
+            plan->joinNode = getNodeFromList(tableList, node->joinTable.value);
+            missing = plan->joinNode == NULL ? node->joinTable.value : NULL;
+        }
+        if(missing != NULL){
+            plan->tableNode = NULL;
+            DBOp dbOp = createDBOp();
+            appendToBuilder(&dbOp.error, "Table `%s` doesn't exist", missing);
+            dbOp.code = FAIL;
+            return dbOp;
+        }
+        plan->catalogVersion = dbCatalogVersion();
+    }
+    if(walNeedsCheckpoint()){
+        dbCheckpoint(tableList);
+    }
+    switch (node->action.keyword) {
+        case KW_SELECT:
+            if(plan->joinNode != NULL){
+                return dbSelectJoin(node, plan->tableNode, plan->joinNode);
+            }
+            return dbSelect(node, plan->tableNode);
+        case KW_INSERT:
+            return dbInsert(node, plan->tableNode);
+        case KW_UPDATE:
+            return dbUpdate(node, plan->tableNode);
+        default:
+            return dbDelete(node, plan->tableNode);
+    }
+}
+
+/**
+ * Frees a statement and its values, its plan stays in the plan cache until it is the least recently used one
+ * @param statement Statement returned by `statementPrepare`, can be NULL
+ */
+void statementRelease(PreparedStatement *statement){
+    if(statement == NULL){
+        return;
+    }
+    for (size_t i = 0; i < statement->plan->paramCount; ++i) {
+        clearStringBuilder(&statement->values[i].text);
+    }
+    statement->plan->refCount--;
+    clearStringBuilder(&statement->paramText);
+    free(statement->values);
+    free(statement);
+}
+
+/**
+ * Reads a word of a command, words hold letters, digits and underscores
+ * @param input Command
+ * @param pos Position in the command, moved past the word and the spaces after it
+ * @param len Length of the word, 0 if there is no word at the position
+ * @return Start of the word
+ */
+static const char *readWord(const char *input, size_t *pos, size_t *len){
+    while (isspace((unsigned char)input[*pos])){
+        ++*pos;
+    }
+    const char *word = input + *pos;
+    *len = 0;
+    while (isalnum((unsigned char)input[*pos]) || input[*pos] == '_'){
+        ++*pos;
+        ++*len;
+    }
+    while (isspace((unsigned char)input[*pos])){
+        ++*pos;
+    }
+    return word;
+}
+
+/**
+ * Compares a word of a command to a keyword, case insensitive
+ * @param word Word
+ * @param len Length of the word
+ * @param keyword Keyword
+ * @return 1 if the word is the keyword, 0 otherwise
+ */
+static int isWord(const char *word, size_t len, const char *keyword){
+    if(len != strlen(keyword)){
+        return 0;
+    }
+    for (size_t i = 0; i < len; ++i) {
+        if(toupper((unsigned char)word[i]) != toupper((unsigned char)keyword[i])){
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * Finds a statement prepared with `PREPARE`
+ * @param name Name of the statement
+ * @param len Length of the name
+ * @return Named statement or NULL if no statement has the name
+ */
+static NamedStatement *findNamed(const char *name, size_t len){
+    for (size_t i = 0; i < namedCount; ++i) {
+        if(isWord(name, len, namedStatements[i].name)){
+            return &namedStatements[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Checks if a command prepares, executes or deallocates a named statement
+ * @param input Command
+ * @return 1 for `PREPARE`, `EXECUTE` and `DEALLOCATE`, 0 otherwise
+ */
+int isStatementCommand(const char *input){
+    size_t pos = 0, len;
+    const char *word = readWord(input, &pos, &len);
+    return isWord(word, len, "PREPARE") || isWord(word, len, "EXECUTE") || isWord(word, len, "DEALLOCATE");
+}
+
+/**
+ * Prepares a named statement, `PREPARE name AS statement`
+ * @param input Command
+ * @param pos Position after `PREPARE`
+ * @return Result of the command
+ */
+static DBOp prepareCommand(const char *input, size_t pos){
+    DBOp dbOp = createDBOp();
+    size_t nameLen, len;
+    const char *name = readWord(input, &pos, &nameLen);
+    const char *as = readWord(input, &pos, &len);
+    if(nameLen == 0 || !isWord(as, len, "AS")){
+        appendToBuilder(&dbOp.error, "Expected PREPARE name AS statement");
+        dbOp.code = FAIL;
+        return dbOp;
+    }
+    PreparedStatement *statement = statementPrepare(input + pos);
+    if(statement == NULL){
+        appendToBuilder(&dbOp.error, "Unable to prepare statement `%.*s`", (int)nameLen, name);
+        dbOp.code = FAIL;
+        return dbOp;
+    }
+    NamedStatement *named = findNamed(name, nameLen);
+    if(named != NULL){
+        statementRelease(named->statement);
+    }
+    else{
+        NamedStatement *temp = realloc(namedStatements, sizeof(NamedStatement) * (namedCount + 1));
+        char *copy = malloc(nameLen + 1);
+        if(temp == NULL || copy == NULL){
+            if(temp != NULL){
+                namedStatements = temp;
+            }
+            free(copy);
+            statementRelease(statement);
+            appendToBuilder(&dbOp.error, "Error: Memory allocation failed for the statement");
+            dbOp.code = FAIL;
+            return dbOp;
+        }
+        memcpy(copy, name, nameLen);
+        copy[nameLen] = '\0';
+        namedStatements = temp;
+        named = &namedStatements[namedCount++];
+        named->name = copy;
+    }
+    named->statement = statement;
+    appendToBuilder(&dbOp.successMsg, "Statement `%s` prepared with %zu parameters", named->name, statement->plan->paramCount);
+    return dbOp;
+}
+
+/**
+ * Binds the value of an `EXECUTE` list at a position to a parameter, a string literal or a number
+ * @param statement Statement
+ * @param index Parameter
+ * @param input Command
+ * @param pos Position of the value, moved past it
+ * @return 1 if the value is bound, 0 if it isn't a valid value
+ */
+static int bindCommandValue(PreparedStatement *statement, size_t index, const char *input, size_t *pos){
+    StringBuilder value = createStringBuilder();
+    int ok;
+    if(input[*pos] == '\''){
+        const char *end = strchr(input + *pos + 1, '\'');
+        if(end == NULL){
+            clearStringBuilder(&value);
+            return 0;
+        }
+        appendRawToBuilder(&value, input + *pos + 1, (size_t)(end - input - *pos - 1));
+        *pos = (size_t)(end - input) + 1;
+        ok = statementBindText(statement, index, value.data);
+    }
+    else{
+        size_t start = *pos;
+        while (input[*pos] != '\0' && input[*pos] != ',' && input[*pos] != ')' && !isspace((unsigned char)input[*pos])){
+            ++*pos;
+        }
+        appendRawToBuilder(&value, input + start, *pos - start);
+        if(isWord(value.data, value.len, "NULL")){
+            ok = statementBindText(statement, index, "");
+        }
+        else{
+            ok = value.len > 0 && isNumber(value.data) && bindValue(statement, index, TOKEN_NUMBER, value.data, value.len);
+        }
+    }
+    clearStringBuilder(&value);
+    return ok;
+}
+
+/**
+ * Executes a named statement with a list of values, `EXECUTE name (value, ...)`
+ * @param input Command
+ * @param pos Position after `EXECUTE`
+ * @param tableList Tables of the database
+ * @return Result of the statement
+ */
+static DBOp executeCommand(const char *input, size_t pos, NodeList *tableList){
+    size_t nameLen;
+    const char *name = readWord(input, &pos, &nameLen);
+    NamedStatement *named = findNamed(name, nameLen);
+    const char *error = NULL;
+    size_t count = 0;
+    if(named == NULL){
+        error = "is not prepared";
+    }
+    else if(input[pos] == '('){
+        ++pos;
+        while (isspace((unsigned char)input[pos])){
+            ++pos;
+        }
+        while (input[pos] != ')'){
+            if(count >= named->statement->plan->paramCount){
+                error = "has fewer parameters than values";
+                break;
+            }
+            if(!bindCommandValue(named->statement, count++, input, &pos)){
+                error = "got an invalid value";
+                break;
+            }
+            while (isspace((unsigned char)input[pos])){
+                ++pos;
+            }
+            if(input[pos] == ','){
+                ++pos;
+                while (isspace((unsigned char)input[pos])){
+                    ++pos;
+                }
+            }
+            else if(input[pos] != ')'){
+                error = "expects values separated by commas";
+                break;
+            }
+        }
+    }
+    if(error == NULL && count != named->statement->plan->paramCount){
+        error = "has more parameters than values";
+    }
+    if(error != NULL){
+        DBOp dbOp = createDBOp();
+        appendToBuilder(&dbOp.error, "Statement `%.*s` %s", (int)nameLen, name, error);
+        dbOp.code = FAIL;
+        return dbOp;
+    }
+    return statementExecute(named->statement, tableList);
+}
+
+/**
+ * Drops a named statement, `DEALLOCATE name`
+ * @param input Command
+ * @param pos Position after `DEALLOCATE`
+ * @return Result of the command
+ */
+static DBOp deallocateCommand(const char *input, size_t pos){
+    DBOp dbOp = createDBOp();
+    size_t nameLen;
+    const char *name = readWord(input, &pos, &nameLen);
+    NamedStatement *named = findNamed(name, nameLen);
+    if(named == NULL){
+        appendToBuilder(&dbOp.error, "Statement `%.*s` is not prepared", (int)nameLen, name);
+        dbOp.code = FAIL;
+        return dbOp;
+    }
+    appendToBuilder(&dbOp.successMsg, "Statement `%s` deallocated", named->name);
+    statementRelease(named->statement);
+    free(named->name);
+    *named = namedStatements[--namedCount];
+    return dbOp;
+}
+
+/**
+ * Runs a `PREPARE`, `EXECUTE` or `DEALLOCATE` command
+ * @param input Command
+ * @param tableList Tables of the database
+ * @return Result of the command, the result of the statement for `EXECUTE`
+ */
+DBOp execStatementCommand(const char *input, NodeList *tableList){
+    size_t pos = 0, len;
+    const char *word = readWord(input, &pos, &len);
+    if(isWord(word, len, "PREPARE")){
+        return prepareCommand(input, pos);
+    }
+    if(isWord(word, len, "EXECUTE")){
+        return executeCommand(input, pos, tableList);
+    }
+    return deallocateCommand(input, pos);
+}
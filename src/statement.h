@@ -0,0 +1,59 @@
+#include <stddef.h>
+#include <stdint.h>
+#include "lexer.h"
+#include "database.h"
+#include "utils.h"
+
+#ifndef MINISQL_STATEMENT_H
+#define MINISQL_STATEMENT_H
+
+// Plans kept by the plan cache, the least recently used plan nobody uses is dropped to make room
+#define STATEMENT_CACHE_SIZE 64
+
+/*
+ * Value bound to a `?` parameter, kept as the literal it replaces: numbers as their
+ * text and strings between quotes with their commas escaped
+ */
+struct {
+    TokenType type; // TOKEN_NUMBER or TOKEN_STRING, TOKEN_EMPTY while unbound
+    StringBuilder text;
+} typedef BoundValue;
+
+/*
+ * Statement parsed once and shared by every caller preparing the same normalized text, it is only
+ * read once prepared. The tables it uses are looked up again once the catalog changes
+ */
+struct {
+    char *sql; // Normalized statement, the key of the plan cache
+    uint64_t hash;
+    TokenRet tokens;
+    Node *node;
+    Token **params; // Value tokens of the parameters in the order of the statement, set for each execution
+    size_t paramCount;
+    Node *tableNode;
+    Node *joinNode;
+    uint64_t catalogVersion; // Catalog the tables were looked up in
+    size_t refCount; // Statements using the plan, a used plan stays in the cache
+    uint64_t lastUse;
+} typedef StatementPlan;
+
+/*
+ * Prepared statement of a caller, executed with new values for its `?` parameters. The values
+ * are the caller's own while the plan is shared
+ */
+struct {
+    StatementPlan *plan;
+    BoundValue *values;
+    StringBuilder paramText; // Values of the parameters of the current execution, the executors unquote them in place
+} typedef PreparedStatement;
+
+PreparedStatement *statementPrepare(const char *sql);
+int statementBindInteger(PreparedStatement *statement, size_t index, long long value);
+int statementBindFloat(PreparedStatement *statement, size_t index, double value);
+int statementBindText(PreparedStatement *statement, size_t index, const char *value);
+DBOp statementExecute(PreparedStatement *statement, NodeList *tableList);
+void statementRelease(PreparedStatement *statement);
+int isStatementCommand(const char *input);
+DBOp execStatementCommand(const char *input, NodeList *tableList);
+
+#endif //MINISQL_STATEMENT_H
@@ -1,5 +1,6 @@
 #include <ctype.h>
 #include "const.h"
+#include "utils.h"
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -43,22 +44,6 @@ int caseInsensitiveCompare(const char *str1, const char *str2) {
 }
 
 
-/**
- * Checks if a string is in CONST `DATA_TYPES`
- * Checks if a string is an SQL data type, data types: varchar, text, number, integer, boolean etc
- * @param str Comparable string
- * @return whether or not the string is in the array of DATA_TYPES;
- *
- */
-int isDataType(const char* str) {
-    for (int i = 0; i < LEN_DATA_TYPES; i++) {
-        if (caseInsensitiveCompare(str, DATA_TYPES[i]) == 0) {
-            return 1;
-        }
-    }
-    return 0;
-}
-
 /**
  * Converts a string number to a unsigned long long int number
  * String "12" will be converted to -> 12 (decimal)
@@ -74,95 +59,6 @@ size_t strToLongInt(const char *str) {
 }
 
 
-/**
- * Returns 0 or 1 based on string is in CONST `BUILT_IN_FUNC` or not
- * Checks if a string is an sql built in function
- * @param str Comparable string
- * @return whether or not the string is in the array of BUILT_IN_FUNC
- *
- */
-int isBuiltInFunc(const char* str) {
-    for (int i = 0; i < LEN_BUILT_IN_FUNC; i++) {
-        if (caseInsensitiveCompare(str, BUILT_IN_FUNC[i]) == 0) {
-            return 1;
-        }
-    }
-    return 0;
-}
-
-
-/**
- * Returns 0 or 1 based on string is in CONST `VALUE_FUNC` or not
- * Checks if a string is a default value generator function for sql
- * @param str Comparable string
- * @return whether or not the string is in the array of VALUE_FUNC;
- *
- */
-int isValueFunc(const char* str) {
-    for (int i = 0; i < VALUE_FUNC_LEN; i++) {
-        if (caseInsensitiveCompare(str, VALUE_FUNC[i]) == 0) {
-            return 1;
-        }
-    }
-    return 0;
-}
-
-
-/**
- * Returns 0 or 1 based on string is in CONST `KEYWORDS` or not
- * Checks if a string is an sql keyword or not
- * @param str Comparable string
- * @return whether or not the string is in the array of KEYWORD
- *
- */
-int isKeyword(const char* str) {
-    for (int i = 0; i < LEN_KEYWORDS; i++) {
-        if (caseInsensitiveCompare(str, KEYWORDS[i]) == 0) {
-            return 1;
-        }
-    }
-    return 0;
-}
-
-
-/**
- * Returns 0 or 1 based on string is in CONST `PRE_TB_SELECTOR_KEYWORDS` or not
- * A pre table selector checks if the argument string is an sql table selector keyword,
- * Example: `SELECT * FROM TABLE_1` here `FROM` is a table selector, by this FROM keyword
- * it can be determined that any identifier next to a table selector points to a database table
- * @param str Comparable string
- * @return whether or not the string is in the array of PRE_TB_SELECTOR_KEYWORDS
- *
- */
-int isPreTableSelectorKeyword(const char* str) {
-    for (int i = 0; i < LEN_PRE_TB_SELECTOR_KEYWORDS; i++) {
-        if (caseInsensitiveCompare(str, PRE_TB_SELECTOR_KEYWORDS[i]) == 0) {
-            return 1;
-        }
-    }
-    return 0;
-}
-
-
-/**
- * Returns 0 or 1 based on string is in CONST `LOGICAL_OP` or not
- * Logical connection between two filter statement, AND and OR
- * Note: This functionality not yet implemented
- * @param str Comparable string
- * @return whether or not the string is in the array of LOGICAL_OP
- *
- */
-int isLogicalOperator(const char* str) {
-    for (size_t i = 0; i < LEN_LOGICAL_OP; i++) {
-        if (caseInsensitiveCompare(str, LOGICAL_OP[i]) == 0) {
-            return 1;
-        }
-    }
-    return 0;
-}
-
-
-
 /**
  * Concat array of string to a new string
  * @param strings[] Array of strings
@@ -254,13 +150,15 @@ char *replaceString(char *str, size_t idx, size_t endIdx, const char *subString)
     size_t newLen = strlen(subString);
     size_t ogSubLen = endIdx - idx + 1;
     size_t newTotalLen = len - ogSubLen + newLen;
-    char *toCreate = malloc(newTotalLen + 1);
-    strcpy(toCreate, str);
     if (idx >= len) {
+        char *toCreate = malloc(len + 1);
+        strcpy(toCreate, str);
         return toCreate;
     }
-    memmove(toCreate + idx + newLen, toCreate + idx + ogSubLen, len - idx - ogSubLen + 1);
+    char *toCreate = malloc(newTotalLen + 1);
+    memcpy(toCreate, str, idx);
     memcpy(toCreate + idx, subString, newLen);
+    memcpy(toCreate + idx + newLen, str + idx + ogSubLen, len - idx - ogSubLen + 1);
     return toCreate;
 }
 
@@ -298,51 +196,6 @@ int isInsertKeyword(const char* str){
 }
 
 
-/**
- * If the string is "CREATE" keyword
- * @param str Base string
- * @return None
- *
- */
-int isCreateKeyword(const char* str){
-    return caseInsensitiveCompare(str, "CREATE") == 0;
-}
-
-
-
-/**
- * If the string is "WHERE" keyword
- * @param str Base string
- * @return None
- *
- */
-int isFilterKeyword(const char* str){
-    return caseInsensitiveCompare(str, "WHERE") == 0;
-}
-
-
-/**
- * If the string is "UPDATE" keyword
- * @param str Base string
- * @return None
- *
- */
-int isUpdateKeyword(const char* str){
-    return caseInsensitiveCompare(str, "UPDATE") == 0;
-}
-
-
-/**
- * If the string is "DELETE" keyword
- * @param str Base string
- * @return None
- *
- */
-int isDeleteKeyword(const char* str){
-    return caseInsensitiveCompare(str, "DELETE") == 0;
-}
-
-
 /**
  * Print error in red text
  * @param str format, string format
@@ -401,7 +254,8 @@ char *createBufferWithSize(size_t size){
         perror("Memory reallocation failed for string buffer");
         exit(EXIT_FAILURE);
     }
-    buffer[size + 1] = '\0';
+    buffer[0] = '\0';
+    buffer[size] = '\0';
     return buffer;
 }
 
@@ -421,14 +275,15 @@ void insertInBuffer(char **buffer, const char *format, ...) {
         fprintf(stderr, "Formatting error\n");
         return;
     }
-    char *newBuffer = realloc(*buffer, strlen(*buffer) + neededSize);
+    size_t len = strlen(*buffer);
+    char *newBuffer = realloc(*buffer, len + neededSize);
     if (newBuffer == NULL) {
         perror("Memory reallocation failed for string buffer");
         exit(EXIT_FAILURE);
     }
     *buffer = newBuffer;
     va_start(args, format);
-    vsprintf(*buffer + strlen(*buffer), format, args);
+    vsprintf(*buffer + len, format, args);
     va_end(args);
 }
 
@@ -442,6 +297,115 @@ void clearBuffer(char **buffer) {
     *buffer = NULL;
 }
 
+/**
+ * Creates an empty string builder
+ * @return String builder
+ */
+StringBuilder createStringBuilder(){
+    StringBuilder builder = {createBufferWithSize(15), 0, 16};
+    return builder;
+}
+
+/**
+ * Makes room for more bytes in a string builder, the capacity at least doubles
+ * @param builder String builder
+ * @param extra Bytes that will be appended, without the NUL terminator
+ */
+static void reserveBuilder(StringBuilder *builder, size_t extra){
+    if(builder->len + extra < builder->capacity){
+        return;
+    }
+    size_t capacity = builder->capacity > 0 ? builder->capacity * 2 : 16;
+    while (capacity <= builder->len + extra){
+        capacity *= 2;
+    }
+    char *data = realloc(builder->data, capacity);
+    if (data == NULL) {
+        perror("Memory reallocation failed for string buffer");
+        exit(EXIT_FAILURE);
+    }
+    builder->data = data;
+    builder->capacity = capacity;
+}
+
+/**
+ * Appends formatted text to a string builder, the text is formatted in place
+ * and formatted again only when the builder has to grow
+ * @param builder String builder
+ * @param format String format
+ * @param ... Argument variables
+ */
+void appendToBuilder(StringBuilder *builder, const char *format, ...) {
+    if(builder->data == NULL){
+        reserveBuilder(builder, 0);
+    }
+    va_list args;
+    va_start(args, format);
+    int neededSize = vsnprintf(builder->data + builder->len, builder->capacity - builder->len, format, args);
+    va_end(args);
+    if (neededSize < 0) {
+        fprintf(stderr, "Formatting error\n");
+        builder->data[builder->len] = '\0';
+        return;
+    }
+    if ((size_t)neededSize >= builder->capacity - builder->len) {
+        reserveBuilder(builder, (size_t)neededSize);
+        va_start(args, format);
+        vsnprintf(builder->data + builder->len, builder->capacity - builder->len, format, args);
+        va_end(args);
+    }
+    builder->len += (size_t)neededSize;
+}
+
+/**
+ * Appends bytes to a string builder
+ * @param builder String builder
+ * @param data Bytes, not NUL terminated
+ * @param len Number of bytes
+ */
+void appendRawToBuilder(StringBuilder *builder, const char *data, size_t len){
+    reserveBuilder(builder, len);
+    memcpy(builder->data + builder->len, data, len);
+    builder->len += len;
+    builder->data[builder->len] = '\0';
+}
+
+/**
+ * Empties a string builder and keeps its memory
+ * @param builder String builder
+ */
+void resetStringBuilder(StringBuilder *builder){
+    builder->len = 0;
+    if(builder->data != NULL){
+        builder->data[0] = '\0';
+    }
+}
+
+/**
+ * Hands the string of a builder to the caller, the builder is empty afterwards
+ * and allocates again on the next append
+ * @param builder String builder
+ * @return String to free with `free`
+ */
+char *detachStringBuilder(StringBuilder *builder){
+    char *data = builder->data;
+    builder->data = NULL;
+    builder->len = 0;
+    builder->capacity = 0;
+    return data;
+}
+
+/**
+ * Frees a string builder
+ * @param builder String builder
+ */
+void clearStringBuilder(StringBuilder *builder){
+    free(builder->data);
+    builder->data = NULL;
+    builder->len = 0;
+    builder->capacity = 0;
+}
+
 /**
  * Maximum value between two number
  * @param a
@@ -10,31 +10,31 @@
 #ifndef MINISQL_UTILS_H
 #define MINISQL_UTILS_H
 
+/*
+ * Growable string that keeps its length, the capacity doubles when it is full
+ * so appending n bytes costs O(n) in total, `data` is always NUL terminated
+ */
+struct {
+    char *data;
+    size_t len;
+    size_t capacity;
+} typedef StringBuilder;
+
 
 void removeSingleQuotes(char *str);
 int caseInsensitiveCompare(const char *str1, const char *str2) ;
 
-int isKeyword(const char* str) ;
-int isDataType(const char* str) ;
-int isBuiltInFunc(const char* str) ;
-int isPreTableSelectorKeyword(const char* str);
 int isNumber(const char *str) ;
 
-int isFilterKeyword(const char* str);
-int isLogicalOperator(const char* str);
 int isSpecialPunct(char c);
 
 void stringToLower(char *str);
 int isSelectKeyword(const char *str);
 
 int isInsertKeyword(const char* str);
-int isCreateKeyword(const char* str);
 size_t strToLongInt(const char *str);
-int isUpdateKeyword(const char* str);
-int isDeleteKeyword(const char* str);
 int isSymbol(const char *str);
 char *replaceString(char *str, size_t idx, size_t endIdx, const char *subString);
-int isValueFunc(const char* str);
 char* concatStrings(const char *strings[], int count);
 
 
@@ -51,5 +51,12 @@ char* escapeCommas(const char* input);
 size_t max(size_t a, size_t b);
 size_t isEven(size_t a);
 void clearBuffer(char **buffer);
+
+StringBuilder createStringBuilder();
+void appendToBuilder(StringBuilder *builder, const char *format, ...);
+void appendRawToBuilder(StringBuilder *builder, const char *data, size_t len);
+void resetStringBuilder(StringBuilder *builder);
+char *detachStringBuilder(StringBuilder *builder);
+void clearStringBuilder(StringBuilder *builder);
 #endif
 //MINISQL_UTILS_H
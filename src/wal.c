@@ -0,0 +1,654 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "wal.h"
+#include "const.h"
+#include "utils.h"
+#include "filesystem.h"
+
+// Largest record accepted while replaying, anything bigger is a torn write
+#define WAL_MAX_RECORD_SIZE (64 * 1024 * 1024)
+
+/*
+ * Header of a log record, followed by the table name, the old row and the new row
+ */
+struct {
+    uint32_t size; // Record size with the header
+    uint32_t checksum; // FNV-1a of the record after this field
+    uint32_t type;
+    uint32_t tableLen;
+    uint64_t location;
+    uint32_t oldLen;
+    uint32_t newLen;
+} typedef WalRecordHeader;
+
+/*
+ * Records of the statement run by a thread, they are added to the log with its commit record
+ * and applied to the in memory view of the tables once they are synced
+ */
+struct {
+    char *data;
+    size_t size;
+    size_t capacity;
+} typedef WalStatement;
+
+/*
+ * Lsn range of a group of statements that couldn't be written to the log, their commits fail
+ */
+struct {
+    uint64_t start;
+    uint64_t end;
+} typedef WalFailedRange;
+
+/*
+ * Log file with the records of the statements that are not yet synced,
+ * writers append to `buffer` and a single writer syncs everything buffered
+ */
+struct {
+    FILE *file;
+    int isOpen;
+    char *buffer;
+    size_t bufferSize;
+    size_t bufferCapacity;
+    char *spare; // Buffer being written by the syncing writer
+    size_t spareCapacity;
+    uint64_t appendedLsn; // Bytes appended since the process started
+    uint64_t flushedLsn; // Bytes synced to the disk
+    int isFlushing;
+    WalFailedRange *failedRanges; // Groups that couldn't be written, kept for the writers still waiting
+    size_t failedCount;
+    size_t committing; // Writers in walCommit, the failed groups are freed when the last one returns
+    uint64_t logSize;
+    WalTable **tables;
+    size_t tableCount;
+    pthread_mutex_t lock;
+    pthread_cond_t flushed;
+} typedef WriteAheadLog;
+
+static WriteAheadLog wal = {.lock = PTHREAD_MUTEX_INITIALIZER, .flushed = PTHREAD_COND_INITIALIZER};
+static _Thread_local WalStatement statement;
+
+
+static uint32_t walChecksum(uint32_t hash, const char *data, size_t len){
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= (unsigned char)data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static char *copyRow(const char *row){
+    if(row == NULL){
+        return NULL;
+    }
+    char *copy = malloc(strlen(row) + 1);
+    if(copy != NULL){
+        strcpy(copy, row);
+    }
+    return copy;
+}
+
+static size_t slotOf(WalTable *walTable, uint64_t location){
+    uint64_t hash = location * 0x9E3779B97F4A7C15ULL;
+    return (size_t)(hash ^ (hash >> 31)) & (walTable->slotCount - 1);
+}
+
+static WalChange *findChange(WalTable *walTable, uint64_t location){
+    if(walTable == NULL || walTable->size == 0){
+        return NULL;
+    }
+    size_t slot = slotOf(walTable, location);
+    while(walTable->slots[slot] != 0){
+        WalChange *change = &walTable->changes[walTable->slots[slot] - 1];
+        if(change->location == location){
+            return change;
+        }
+        slot = (slot + 1) & (walTable->slotCount - 1);
+    }
+    return NULL;
+}
+
+/**
+ * Adds a change to a table, the slot table is doubled once it is half full
+ * @param walTable Pending changes of a table
+ * @param change Change, owns its rows
+ * @return 1 if the change was added, 0 on memory error
+ */
+static int addChange(WalTable *walTable, WalChange change){
+    if((walTable->size + 1) * 2 > walTable->slotCount){
+        size_t slotCount = walTable->slotCount == 0 ? 64 : walTable->slotCount * 2;
+        size_t *slots = calloc(slotCount, sizeof(size_t));
+        if(slots == NULL){
+            return 0;
+        }
+        free(walTable->slots);
+        walTable->slots = slots;
+        walTable->slotCount = slotCount;
+        for (size_t i = 0; i < walTable->size; ++i) {
+            size_t slot = slotOf(walTable, walTable->changes[i].location);
+            while(slots[slot] != 0){
+                slot = (slot + 1) & (slotCount - 1);
+            }
+            slots[slot] = i + 1;
+        }
+    }
+    if(walTable->size == walTable->capacity){
+        size_t capacity = walTable->capacity == 0 ? 32 : walTable->capacity * 2;
+        WalChange *changes = realloc(walTable->changes, sizeof(WalChange) * capacity);
+        if(changes == NULL){
+            return 0;
+        }
+        walTable->changes = changes;
+        walTable->capacity = capacity;
+    }
+    walTable->changes[walTable->size] = change;
+    walTable->size++;
+    size_t slot = slotOf(walTable, change.location);
+    while(walTable->slots[slot] != 0){
+        slot = (slot + 1) & (walTable->slotCount - 1);
+    }
+    walTable->slots[slot] = walTable->size;
+    return 1;
+}
+
+static void clearTable(WalTable *walTable){
+    for (size_t i = 0; i < walTable->size; ++i) {
+        free(walTable->changes[i].oldRow);
+        free(walTable->changes[i].newRow);
+    }
+    walTable->size = 0;
+    if(walTable->slots != NULL){
+        memset(walTable->slots, 0, sizeof(size_t) * walTable->slotCount);
+    }
+}
+
+static WalTable *findTable(const char *table){
+    for (size_t i = 0; i < wal.tableCount; ++i) {
+        if(strcmp(wal.tables[i]->table, table) == 0){
+            return wal.tables[i];
+        }
+    }
+    return NULL;
+}
+
+static WalTable *addTable(const char *table){
+    WalTable *walTable = findTable(table);
+    if(walTable != NULL){
+        return walTable;
+    }
+    WalTable **tables = realloc(wal.tables, sizeof(WalTable *) * (wal.tableCount + 1));
+    if(tables == NULL){
+        return NULL;
+    }
+    wal.tables = tables;
+    walTable = calloc(1, sizeof(WalTable));
+    if(walTable == NULL || (walTable->table = copyRow(table)) == NULL){
+        free(walTable);
+        return NULL;
+    }
+    wal.tables[wal.tableCount++] = walTable;
+    return walTable;
+}
+
+/**
+ * Applies a logged change to the in memory view of the tables, a row that was already
+ * changed keeps the row of the table file as its old row
+ * @param type Record type
+ * @param table Table name
+ * @param location Row location
+ * @param oldRow Row before the change
+ * @param newRow Row after the change
+ * @param isReplay 1 while recovering, inserts are only kept to check they reached the table file
+ * @return 1 if the change was applied, 0 on memory error
+ */
+static int applyChange(WalType type, const char *table, uint64_t location, const char *oldRow, const char *newRow, int isReplay){
+    if(type == WAL_COMMIT){
+        return 1;
+    }
+    // Inserts only matter outside recovery when they reuse the location of a rolled back row
+    int isLookup = type == WAL_CHECKPOINT || (type == WAL_INSERT && !isReplay);
+    WalTable *walTable = isLookup ? findTable(table) : addTable(table);
+    if(type == WAL_CHECKPOINT){
+        if(walTable != NULL){
+            clearTable(walTable);
+        }
+        return 1;
+    }
+    if(walTable == NULL){
+        return isLookup;
+    }
+    WalChange *change = findChange(walTable, location);
+    if(change != NULL && type == WAL_INSERT){
+        // A row inserted where a logged row was rolled back replaces it
+        char *row = copyRow(newRow), *expected = copyRow(newRow);
+        if(row == NULL || expected == NULL){
+            free(row);
+            free(expected);
+            return 0;
+        }
+        free(change->oldRow);
+        free(change->newRow);
+        change->oldRow = expected;
+        change->newRow = row;
+        change->type = isReplay ? WAL_INSERT : WAL_UPDATE;
+        return 1;
+    }
+    if(type == WAL_INSERT && !isReplay){
+        return 1;
+    }
+    if(change != NULL && change->newRow != NULL){
+        char *row = type == WAL_DELETE ? NULL : copyRow(newRow);
+        if(type != WAL_DELETE && row == NULL){
+            return 0;
+        }
+        free(change->newRow);
+        change->newRow = row;
+        if(type == WAL_DELETE && change->type != WAL_INSERT){
+            // A deleted insert stays an insert so recovery still knows the bytes it wrote
+            change->type = WAL_DELETE;
+        }
+        return 1;
+    }
+    if(change != NULL){
+        return 1;
+    }
+    // The old row of an insert is the row expected in the table file
+    WalChange added = {type, location, copyRow(type == WAL_INSERT ? newRow : oldRow), type == WAL_DELETE ? NULL : copyRow(newRow)};
+    if(!addChange(walTable, added)){
+        free(added.oldRow);
+        free(added.newRow);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * Grows a buffer to hold a number of bytes
+ * @param data Buffer
+ * @param capacity Capacity of the buffer
+ * @param size Bytes the buffer must hold
+ * @return 1 if the buffer is large enough, 0 on memory error
+ */
+static int reserveBuffer(char **data, size_t *capacity, size_t size){
+    if(size <= *capacity){
+        return 1;
+    }
+    size_t newCapacity = *capacity == 0 ? 4096 : *capacity;
+    while(newCapacity < size){
+        newCapacity *= 2;
+    }
+    char *buffer = realloc(*data, newCapacity);
+    if(buffer == NULL){
+        return 0;
+    }
+    *data = buffer;
+    *capacity = newCapacity;
+    return 1;
+}
+
+/**
+ * Adds a record to the statement of the calling thread, the record reaches the log with its commit
+ * @return 1 if the record was buffered, 0 on memory error
+ */
+static int appendRecord(WalType type, const char *table, uint64_t location, const char *oldRow, const char *newRow){
+    WalRecordHeader header;
+    header.type = type;
+    header.tableLen = (uint32_t)strlen(table);
+    header.location = location;
+    header.oldLen = oldRow != NULL ? (uint32_t)strlen(oldRow) : 0;
+    header.newLen = newRow != NULL ? (uint32_t)strlen(newRow) : 0;
+    header.size = (uint32_t)(sizeof(WalRecordHeader) + header.tableLen + header.oldLen + header.newLen);
+    if(!reserveBuffer(&statement.data, &statement.capacity, statement.size + header.size)){
+        return 0;
+    }
+    char *record = statement.data + statement.size;
+    char *data = record + sizeof(WalRecordHeader);
+    memcpy(data, table, header.tableLen);
+    if(oldRow != NULL){
+        memcpy(data + header.tableLen, oldRow, header.oldLen);
+    }
+    if(newRow != NULL){
+        memcpy(data + header.tableLen + header.oldLen, newRow, header.newLen);
+    }
+    header.checksum = walChecksum(2166136261u, (const char *)&header.type, sizeof(WalRecordHeader) - 2 * sizeof(uint32_t));
+    header.checksum = walChecksum(header.checksum, data, header.size - sizeof(WalRecordHeader));
+    memcpy(record, &header, sizeof(WalRecordHeader));
+    statement.size += header.size;
+    return 1;
+}
+
+/**
+ * Applies the records of a committed statement to the in memory view of the tables
+ * @param data Records of the statement
+ * @param size Size of the records
+ * @return 1 if every change was applied, 0 on memory error
+ */
+static int applyRecords(const char *data, size_t size){
+    int ok = 1;
+    WalRecordHeader header;
+    for (size_t offset = 0; offset + sizeof(WalRecordHeader) <= size; offset += header.size) {
+        memcpy(&header, data + offset, sizeof(WalRecordHeader));
+        const char *table = data + offset + sizeof(WalRecordHeader);
+        char *tableName = createBufferWithSize(header.tableLen);
+        char *oldRow = createBufferWithSize(header.oldLen);
+        char *newRow = createBufferWithSize(header.newLen);
+        memcpy(tableName, table, header.tableLen);
+        tableName[header.tableLen] = '\0';
+        memcpy(oldRow, table + header.tableLen, header.oldLen);
+        oldRow[header.oldLen] = '\0';
+        memcpy(newRow, table + header.tableLen + header.oldLen, header.newLen);
+        newRow[header.newLen] = '\0';
+        ok = applyChange(header.type, tableName, header.location, oldRow, newRow, 0) && ok;
+        free(tableName);
+        free(oldRow);
+        free(newRow);
+    }
+    return ok;
+}
+
+/**
+ * Reads the committed records of the log back into memory, records of a statement
+ * without a commit record are ignored and cut from the log
+ * @return 1 if the log was read, 0 on memory error
+ */
+static int replayLog(){
+    struct {
+        WalRecordHeader header;
+        char *data;
+    } typedef PendingRecord;
+    PendingRecord *pending = NULL;
+    size_t pendingSize = 0;
+    long validEnd = 0;
+    int ok = 1;
+    WalRecordHeader header;
+    rewind(wal.file);
+    while(ok && fread(&header, sizeof(WalRecordHeader), 1, wal.file) == 1){
+        size_t len = header.size - sizeof(WalRecordHeader);
+        if(header.size < sizeof(WalRecordHeader) || header.size > WAL_MAX_RECORD_SIZE ||
+           (size_t)header.tableLen + header.oldLen + header.newLen != len){
+            break;
+        }
+        char *data = malloc(len + 1);
+        if(data == NULL){
+            ok = 0;
+            break;
+        }
+        uint32_t checksum = walChecksum(2166136261u, (const char *)&header.type, sizeof(WalRecordHeader) - 2 * sizeof(uint32_t));
+        if(fread(data, 1, len, wal.file) != len || walChecksum(checksum, data, len) != header.checksum){
+            free(data);
+            break;
+        }
+        if(header.type != WAL_COMMIT){
+            PendingRecord *temp = realloc(pending, sizeof(PendingRecord) * (pendingSize + 1));
+            if(temp == NULL){
+                free(data);
+                ok = 0;
+                break;
+            }
+            pending = temp;
+            pending[pendingSize].header = header;
+            pending[pendingSize].data = data;
+            pendingSize++;
+            continue;
+        }
+        free(data);
+        for (size_t i = 0; i < pendingSize; ++i) {
+            WalRecordHeader *record = &pending[i].header;
+            char *table = pending[i].data;
+            char *oldRow = createBufferWithSize(record->oldLen);
+            char *newRow = createBufferWithSize(record->newLen);
+            memcpy(oldRow, table + record->tableLen, record->oldLen);
+            oldRow[record->oldLen] = '\0';
+            memcpy(newRow, table + record->tableLen + record->oldLen, record->newLen);
+            newRow[record->newLen] = '\0';
+            table[record->tableLen] = '\0';
+            ok = applyChange(record->type, table, record->location, oldRow, newRow, 1) && ok;
+            free(oldRow);
+            free(newRow);
+            free(pending[i].data);
+        }
+        pendingSize = 0;
+        validEnd = ftell(wal.file);
+    }
+    for (size_t i = 0; i < pendingSize; ++i) {
+        free(pending[i].data);
+    }
+    free(pending);
+    fseek(wal.file, 0, SEEK_END);
+    if(ftell(wal.file) > validEnd){
+        truncateFile(wal.file, validEnd);
+    }
+    fseek(wal.file, validEnd, SEEK_SET);
+    wal.logSize = (uint64_t)validEnd;
+    return ok;
+}
+
+/**
+ * Opens the log of a data directory and replays its committed changes,
+ * they are visible to readers until a checkpoint writes them in the table files
+ * @param dir Data directory
+ * @return 1 if the log was opened, 0 otherwise
+ */
+int walOpen(const char *dir){
+    pthread_mutex_lock(&wal.lock);
+    if(wal.isOpen){
+        pthread_mutex_unlock(&wal.lock);
+        return 1;
+    }
+    char *fileName = createBuffer();
+    insertInBuffer(&fileName, "%s/%s", dir, WAL_FILE_NAME);
+    wal.file = fopen(fileName, "r+b");
+    if(wal.file == NULL){
+        wal.file = fopen(fileName, "w+b");
+    }
+    free(fileName);
+    if(wal.file != NULL){
+        wal.isOpen = 1;
+        replayLog();
+    }
+    pthread_mutex_unlock(&wal.lock);
+    return wal.isOpen;
+}
+
+static int logChange(WalType type, const char *table, uint64_t location, const char *oldRow, const char *newRow){
+    if(!wal.isOpen && !walOpen(DATA_DIR)){
+        return 0;
+    }
+    return appendRecord(type, table, location, oldRow, newRow);
+}
+
+/**
+ * Logs a row appended to a table
+ * @param table Table name
+ * @param location Location of the row
+ * @param row Row in the text row format
+ * @return 1 if the change was logged, 0 otherwise
+ */
+int walLogInsert(const char *table, uint64_t location, const char *row){
+    return logChange(WAL_INSERT, table, location, NULL, row);
+}
+
+/**
+ * Logs a row update, once committed readers see the new row until the next checkpoint writes it in the table file
+ * @param table Table name
+ * @param location Location of the row
+ * @param oldRow Row before the update
+ * @param newRow Row after the update
+ * @return 1 if the change was logged, 0 otherwise
+ */
+int walLogUpdate(const char *table, uint64_t location, const char *oldRow, const char *newRow){
+    return logChange(WAL_UPDATE, table, location, oldRow, newRow);
+}
+
+/**
+ * Logs a row delete, once committed readers skip the row until the next checkpoint removes it from the table file
+ * @param table Table name
+ * @param location Location of the row
+ * @param oldRow Deleted row
+ * @return 1 if the change was logged, 0 otherwise
+ */
+int walLogDelete(const char *table, uint64_t location, const char *oldRow){
+    return logChange(WAL_DELETE, table, location, oldRow, NULL);
+}
+
+/**
+ * Logs that the changes of a table were written in its table file, they are dropped from memory on commit
+ * @param table Table name
+ * @return 1 if the checkpoint was logged, 0 otherwise
+ */
+int walLogCheckpoint(const char *table){
+    return logChange(WAL_CHECKPOINT, table, 0, NULL, NULL);
+}
+
+/**
+ * Drops the records logged by the statement of the calling thread, used when the statement fails before its commit
+ */
+void walAbort(){
+    statement.size = 0;
+}
+
+/**
+ * Ends a statement and waits until its records are on the disk, the first waiting writer
+ * writes the records of every writer and syncs the log once for all of them. The changes of
+ * the statement are visible to readers only once its records are durable
+ * @return 1 if the records are durable, 0 on io or memory error
+ */
+int walCommit(){
+    if(!wal.isOpen && !walOpen(DATA_DIR)){
+        walAbort();
+        return 0;
+    }
+    int ok = appendRecord(WAL_COMMIT, "", 0, NULL, NULL);
+    pthread_mutex_lock(&wal.lock);
+    wal.committing++;
+    // The records of a statement are added at once so a commit record only ends records of its statement
+    ok = ok && reserveBuffer(&wal.buffer, &wal.bufferCapacity, wal.bufferSize + statement.size);
+    if(ok){
+        memcpy(wal.buffer + wal.bufferSize, statement.data, statement.size);
+        wal.bufferSize += statement.size;
+        wal.appendedLsn += statement.size;
+        wal.logSize += statement.size;
+    }
+    uint64_t target = wal.appendedLsn;
+    while(ok && wal.flushedLsn < target){
+        if(wal.isFlushing){
+            pthread_cond_wait(&wal.flushed, &wal.lock);
+            continue;
+        }
+        wal.isFlushing = 1;
+        char *data = wal.buffer;
+        size_t size = wal.bufferSize;
+        size_t capacity = wal.bufferCapacity;
+        uint64_t start = wal.flushedLsn, end = wal.appendedLsn;
+        wal.buffer = wal.spare;
+        wal.bufferCapacity = wal.spareCapacity;
+        wal.bufferSize = 0;
+        pthread_mutex_unlock(&wal.lock);
+        long offset = ftell(wal.file);
+        int isWritten = offset >= 0 && fwrite(data, 1, size, wal.file) == size && syncFile(wal.file);
+        if(!isWritten && offset >= 0){
+            // The statements of the group are cut from the log so a replay doesn't apply them
+            truncateFile(wal.file, offset);
+            clearerr(wal.file);
+            fseek(wal.file, offset, SEEK_SET);
+        }
+        pthread_mutex_lock(&wal.lock);
+        wal.spare = data;
+        wal.spareCapacity = capacity;
+        wal.isFlushing = 0;
+        wal.flushedLsn = end;
+        if(!isWritten){
+            wal.logSize -= size;
+            WalFailedRange *ranges = realloc(wal.failedRanges, sizeof(WalFailedRange) * (wal.failedCount + 1));
+            if(ranges != NULL){
+                wal.failedRanges = ranges;
+                wal.failedRanges[wal.failedCount++] = (WalFailedRange){start, end};
+            }
+        }
+        pthread_cond_broadcast(&wal.flushed);
+    }
+    for (size_t i = 0; ok && i < wal.failedCount; ++i) {
+        ok = target <= wal.failedRanges[i].start || target > wal.failedRanges[i].end;
+    }
+    if(ok){
+        ok = applyRecords(statement.data, statement.size);
+    }
+    if(--wal.committing == 0){
+        free(wal.failedRanges);
+        wal.failedRanges = NULL;
+        wal.failedCount = 0;
+    }
+    pthread_mutex_unlock(&wal.lock);
+    walAbort();
+    return ok;
+}
+
+/**
+ * Pending changes of a table
+ * @param table Table name
+ * @return Changes of the table or NULL if the table has none
+ */
+WalTable *walGetTable(const char *table){
+    if(!wal.isOpen && !walOpen(DATA_DIR)){
+        return NULL;
+    }
+    pthread_mutex_lock(&wal.lock);
+    WalTable *walTable = findTable(table);
+    pthread_mutex_unlock(&wal.lock);
+    return walTable;
+}
+
+/**
+ * Logged change of a row
+ * @param walTable Pending changes of a table, see `walGetTable`
+ * @param location Row location
+ * @return Change or NULL if the row didn't change since the last checkpoint
+ */
+const WalChange *walFind(WalTable *walTable, uint64_t location){
+    return findChange(walTable, location);
+}
+
+/**
+ * Every table with logged changes, used by checkpoints
+ * @param count Number of tables
+ * @return Tables
+ */
+WalTable **walTables(size_t *count){
+    *count = wal.tableCount;
+    return wal.tables;
+}
+
+/**
+ * If the log grew enough to be applied to the table files
+ * @return 1 if a checkpoint is due
+ */
+int walNeedsCheckpoint(){
+    return wal.logSize >= WAL_CHECKPOINT_SIZE;
+}
+
+/**
+ * Empties the log once every change is in the table files
+ * @return 1 if the log was emptied, 0 otherwise
+ */
+int walTruncate(){
+    if(!wal.isOpen){
+        return 0;
+    }
+    pthread_mutex_lock(&wal.lock);
+    while(wal.isFlushing){
+        pthread_cond_wait(&wal.flushed, &wal.lock);
+    }
+    // Records buffered by another writer still need the log, the changes stay visible until they are checkpointed
+    int ok = wal.bufferSize == 0 && truncateFile(wal.file, 0) && syncFile(wal.file);
+    if(ok){
+        rewind(wal.file);
+        wal.logSize = 0;
+        for (size_t i = 0; i < wal.tableCount; ++i) {
+            clearTable(wal.tables[i]);
+        }
+    }
+    pthread_mutex_unlock(&wal.lock);
+    return ok;
+}
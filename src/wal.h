@@ -0,0 +1,58 @@
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef MINISQL_WAL_H
+#define MINISQL_WAL_H
+
+#define WAL_FILE_NAME "wal"
+// Size of the log that triggers a checkpoint
+#define WAL_CHECKPOINT_SIZE (4 * 1024 * 1024)
+
+typedef enum {
+    WAL_INSERT = 1,
+    WAL_UPDATE,
+    WAL_DELETE,
+    WAL_COMMIT,     // End of a statement, its changes are durable
+    WAL_CHECKPOINT, // Changes of a table before this record are in the table file
+} WalType;
+
+/*
+ * Logged change of a row not yet applied to the table file, `oldRow` is the row
+ * expected in the table file and `newRow` the row readers see
+ * Inserts are only kept while recovering, to append the rows that didn't reach the table file,
+ * a deleted insert keeps its type with a NULL `newRow`
+ */
+struct {
+    WalType type;
+    uint64_t location;
+    char *oldRow;
+    char *newRow; // NULL for a deleted row
+} typedef WalChange;
+
+/*
+ * Pending changes of a table, indexed by row location
+ */
+struct {
+    char *table;
+    WalChange *changes;
+    size_t size;
+    size_t capacity;
+    size_t *slots; // Open addressing table of change index + 1
+    size_t slotCount;
+} typedef WalTable;
+
+int walOpen(const char *dir);
+int walLogInsert(const char *table, uint64_t location, const char *row);
+int walLogUpdate(const char *table, uint64_t location, const char *oldRow, const char *newRow);
+int walLogDelete(const char *table, uint64_t location, const char *oldRow);
+int walLogCheckpoint(const char *table);
+void walAbort();
+int walCommit();
+WalTable *walGetTable(const char *table);
+const WalChange *walFind(WalTable *walTable, uint64_t location);
+WalTable **walTables(size_t *count);
+int walNeedsCheckpoint();
+int walTruncate();
+
+#endif //MINISQL_WAL_H
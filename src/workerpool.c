@@ -0,0 +1,237 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "workerpool.h"
+
+/*
+ * Tasks left to a thread in a run, a range of task indexes. The thread takes its tasks from
+ * the front so it reads the table in order, an idle thread steals the back half
+ */
+struct {
+    _Alignas(64) pthread_mutex_t lock; // Every deque on its own cache line
+    size_t front;
+    size_t back; // Past the last task
+} typedef WorkerDeque;
+
+/*
+ * Threads shared by every statement of the process. A run splits its tasks in one range per thread,
+ * a thread that runs out of tasks steals from the others until every deque is empty
+ */
+struct {
+    pthread_t *threads;
+    size_t threadCount; // Started threads, the thread of a run is not one of them
+    int isStarted;
+    int isStopping;
+    int isRunning;
+    uint64_t generation; // Run number, a thread joins every run once
+    size_t activeThreads; // Started threads working on the current run
+    WorkerTask task;
+    void *arg;
+    WorkerDeque deques[WORKER_POOL_MAX_SIZE]; // Deque 0 belongs to the thread of the run
+    pthread_mutex_t lock;
+    pthread_cond_t work; // A run started or the pool is stopping
+    pthread_cond_t done; // A thread left the run or the run ended
+} typedef WorkerPool;
+
+static WorkerPool workers = {.lock = PTHREAD_MUTEX_INITIALIZER, .work = PTHREAD_COND_INITIALIZER,
+                             .done = PTHREAD_COND_INITIALIZER};
+
+
+/**
+ * Takes the next task of a deque
+ * @param deque Deque
+ * @param index Task
+ * @return 1 if a task was taken, 0 if the deque is empty
+ */
+static int popTask(WorkerDeque *deque, size_t *index){
+    pthread_mutex_lock(&deque->lock);
+    int ok = deque->front < deque->back;
+    if(ok){
+        *index = deque->front++;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return ok;
+}
+
+/**
+ * Moves the back half of the tasks of another thread to the empty deque of a thread,
+ * the threads are tried in turn starting after the thread
+ * @param self Thread
+ * @param size Threads of the run
+ * @return 1 if tasks were stolen, 0 if every deque is empty
+ */
+static int stealTasks(size_t self, size_t size){
+    for (size_t i = 1; i < size; ++i) {
+        WorkerDeque *victim = &workers.deques[(self + i) % size];
+        pthread_mutex_lock(&victim->lock);
+        size_t left = victim->back - victim->front;
+        if(left == 0){
+            pthread_mutex_unlock(&victim->lock);
+            continue;
+        }
+        size_t back = victim->back;
+        victim->back -= (left + 1) / 2;
+        size_t front = victim->back;
+        pthread_mutex_unlock(&victim->lock);
+        WorkerDeque *deque = &workers.deques[self];
+        pthread_mutex_lock(&deque->lock);
+        deque->front = front;
+        deque->back = back;
+        pthread_mutex_unlock(&deque->lock);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Runs the tasks of a thread then the tasks it steals until every deque is empty
+ * @param self Thread
+ * @param size Threads of the run
+ * @param task Task
+ * @param arg Argument of the task
+ */
+static void runTasks(size_t self, size_t size, WorkerTask task, void *arg){
+    size_t index;
+    while (1){
+        if(popTask(&workers.deques[self], &index)){
+            task(arg, self, index);
+        }
+        else if(!stealTasks(self, size)){
+            break;
+        }
+    }
+}
+
+static void *workerLoop(void *arg){
+    size_t self = (size_t)(uintptr_t)arg;
+    uint64_t seen = 0;
+    pthread_mutex_lock(&workers.lock);
+    while (!workers.isStopping){
+        if(workers.isRunning && workers.generation != seen){
+            seen = workers.generation;
+            workers.activeThreads++;
+            WorkerTask task = workers.task;
+            void *taskArg = workers.arg;
+            size_t size = workers.threadCount + 1;
+            pthread_mutex_unlock(&workers.lock);
+            runTasks(self, size, task, taskArg);
+            pthread_mutex_lock(&workers.lock);
+            if(--workers.activeThreads == 0){
+                pthread_cond_broadcast(&workers.done);
+            }
+            continue;
+        }
+        pthread_cond_wait(&workers.work, &workers.lock);
+    }
+    pthread_mutex_unlock(&workers.lock);
+    return NULL;
+}
+
+/**
+ * Stops the threads of the pool once they finished their task
+ */
+static void stopWorkers(){
+    pthread_mutex_lock(&workers.lock);
+    workers.isStopping = 1;
+    pthread_cond_broadcast(&workers.work);
+    pthread_mutex_unlock(&workers.lock);
+    for (size_t i = 0; i < workers.threadCount; ++i) {
+        pthread_join(workers.threads[i], NULL);
+    }
+    free(workers.threads);
+    workers.threads = NULL;
+    workers.threadCount = 0;
+    workers.isStopping = 0;
+}
+
+/**
+ * Starts the threads of the pool, the threads of a previous size are stopped
+ * @param size Threads running the tasks of a run, the thread that starts it included,
+ * 0 for one thread per processor
+ * @return 1 if every thread started, 0 if the pool runs on fewer threads
+ */
+int workerPoolInit(size_t size){
+    if(size == 0){
+        long processors = sysconf(_SC_NPROCESSORS_ONLN);
+        size = processors > 0 ? (size_t)processors : 1;
+    }
+    if(size > WORKER_POOL_MAX_SIZE){
+        size = WORKER_POOL_MAX_SIZE;
+    }
+    if(workers.isStarted){
+        stopWorkers();
+    }
+    else{
+        for (size_t i = 0; i < WORKER_POOL_MAX_SIZE; ++i) {
+            pthread_mutex_init(&workers.deques[i].lock, NULL);
+        }
+    }
+    workers.isStarted = 1;
+    workers.threads = malloc(sizeof(pthread_t) * size);
+    if(workers.threads == NULL){
+        return 0;
+    }
+    while (workers.threadCount + 1 < size){
+        void *self = (void *)(uintptr_t)(workers.threadCount + 1);
+        if(pthread_create(&workers.threads[workers.threadCount], NULL, workerLoop, self) != 0){
+            return 0;
+        }
+        workers.threadCount++;
+    }
+    return 1;
+}
+
+/**
+ * Threads a run is spread over, the pool is started with one thread per processor on first use
+ * @return Number of threads, the thread that starts a run included
+ */
+size_t workerPoolSize(){
+    if(!workers.isStarted){
+        workerPoolInit(0);
+    }
+    return workers.threadCount + 1;
+}
+
+/**
+ * Runs every task of a run on the threads of the pool and waits for them, the calling
+ * thread runs tasks as well. Runs started at the same time are run one after the other
+ * @param task Task
+ * @param arg Argument of every task
+ * @param taskCount Number of tasks, the tasks are called with the indexes 0 to taskCount - 1
+ */
+void workerPoolRun(WorkerTask task, void *arg, size_t taskCount){
+    size_t size = workerPoolSize();
+    if(size == 1 || taskCount < 2){
+        for (size_t i = 0; i < taskCount; ++i) {
+            task(arg, 0, i);
+        }
+        return;
+    }
+    pthread_mutex_lock(&workers.lock);
+    while (workers.isRunning){
+        pthread_cond_wait(&workers.done, &workers.lock);
+    }
+    workers.isRunning = 1;
+    workers.task = task;
+    workers.arg = arg;
+    // Every thread starts on its own part of the tasks
+    for (size_t i = 0; i < size; ++i) {
+        pthread_mutex_lock(&workers.deques[i].lock);
+        workers.deques[i].front = taskCount * i / size;
+        workers.deques[i].back = taskCount * (i + 1) / size;
+        pthread_mutex_unlock(&workers.deques[i].lock);
+    }
+    workers.generation++;
+    pthread_cond_broadcast(&workers.work);
+    pthread_mutex_unlock(&workers.lock);
+    runTasks(0, size, task, arg);
+    pthread_mutex_lock(&workers.lock);
+    while (workers.activeThreads > 0){
+        pthread_cond_wait(&workers.done, &workers.lock);
+    }
+    workers.isRunning = 0;
+    workers.task = NULL;
+    pthread_cond_broadcast(&workers.done);
+    pthread_mutex_unlock(&workers.lock);
+}
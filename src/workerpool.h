@@ -0,0 +1,19 @@
+#include <stddef.h>
+
+#ifndef MINISQL_WORKERPOOL_H
+#define MINISQL_WORKERPOOL_H
+
+// Most threads the pool runs tasks on, the thread that starts a run included
+#define WORKER_POOL_MAX_SIZE 64
+
+/*
+ * Task of a run, called once for every index of the run on one of the threads of the pool,
+ * `worker` numbers the thread from 0 to `workerPoolSize() - 1` for state kept per thread
+ */
+typedef void (*WorkerTask)(void *arg, size_t worker, size_t index);
+
+int workerPoolInit(size_t size);
+size_t workerPoolSize();
+void workerPoolRun(WorkerTask task, void *arg, size_t taskCount);
+
+#endif //MINISQL_WORKERPOOL_H
@@ -0,0 +1,60 @@
+#include <stdio.h>
+#include <string.h>
+#include "test.h"
+#include "const.h"
+
+/**
+ * A table created over several lines is stored on one line and is found again when the tables are loaded
+ * @return 0 if the test passed
+ */
+static int testMultiLineCreate(){
+    NodeList tableList = emptyNodeList();
+    StringBuilder rows = createStringBuilder();
+    CHECK(testExec("\nCREATE TABLE notes (\n\tid INTEGER PRIMARY KEY,\r\n  body   VARCHAR,\n  created DATETIME DEFAULT now\n);", &tableList, NULL));
+    char definition[256] = {0};
+    FILE *file = fopen("data/table_notes_sql", "r");
+    CHECK(file != NULL);
+    CHECK(fgets(definition, sizeof(definition), file) != NULL);
+    fclose(file);
+    CHECK(strcmp(definition, "CREATE TABLE notes ( id INTEGER PRIMARY KEY, body VARCHAR, created DATETIME DEFAULT now );") == 0);
+    tableList = loadTables();
+    CHECK(getNodeFromList(&tableList, "notes") != NULL);
+    CHECK(testExec("INSERT INTO notes (body) VALUES ('first');", &tableList, NULL));
+    CHECK(testExec("SELECT body FROM notes;", &tableList, &rows));
+    CHECK(strcmp(rows.data, "first\n") == 0);
+    clearStringBuilder(&rows);
+    return 0;
+}
+
+/**
+ * A definition written over several lines by an older version is still loaded
+ * @return 0 if the test passed
+ */
+static int testMultiLineDefinitionFile(){
+    FILE *file = fopen("data/table_legacy_sql", "w");
+    CHECK(file != NULL);
+    fputs("CREATE TABLE legacy (id INTEGER PRIMARY KEY,\nname VARCHAR)", file);
+    fclose(file);
+    file = fopen("data/.table", "a");
+    CHECK(file != NULL);
+    fputs("data/table_legacy_sql\n", file);
+    fclose(file);
+    file = fopen("data/table_legacy", "w");
+    CHECK(file != NULL);
+    fclose(file);
+    NodeList tableList = loadTables();
+    Node *node = getNodeFromList(&tableList, "legacy");
+    CHECK(node != NULL);
+    CHECK(node->colsLen == 2);
+    return 0;
+}
+
+int main(){
+    if(!testSetUp("catalog")){
+        return 1;
+    }
+    int failed = testMultiLineCreate();
+    failed += testMultiLineDefinitionFile();
+    printf("catalog_test: %s\n", failed == 0 ? "passed" : "failed");
+    return failed != 0;
+}
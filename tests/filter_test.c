@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include <string.h>
+#include "test.h"
+#include "lexer.h"
+
+/**
+ * Counts the rows of a select
+ * @param sql Select
+ * @param tableList List of every table
+ * @return Number of rows or -1 if the select failed
+ */
+static int countRows(const char *sql, NodeList *tableList){
+    StringBuilder rows = createStringBuilder();
+    int count = testExec(sql, tableList, &rows) ? 0 : -1;
+    for (size_t i = 0; count >= 0 && i < rows.len; ++i) {
+        count += rows.data[i] == '\n';
+    }
+    clearStringBuilder(&rows);
+    return count;
+}
+
+/**
+ * `>=`, `<=` and `!=` are lexed as a single symbol
+ * @return 0 if the test passed
+ */
+static int testComparisonTokens(){
+    char sql[] = "SELECT * FROM t WHERE id>=5 AND id <= 7 AND name != 'a>=b';";
+    TokenRet tokenRet = lexAnalyze(sql);
+    const char *symbols[] = {">=", "<=", "!="};
+    size_t found = 0;
+    for (size_t t = 0; t < tokenRet.len; ++t) {
+        if(tokenRet.tokens[t].type == TOKEN_SYMBOL && strcmp(tokenRet.tokens[t].value, "*") != 0){
+            CHECK(found < 3 && strcmp(tokenRet.tokens[t].value, symbols[found]) == 0);
+            found++;
+        }
+    }
+    CHECK(found == 3);
+    freeTokenRet(&tokenRet);
+    return 0;
+}
+
+/**
+ * Inclusive bounds on the id read the right rows of the primary key index, for both storage formats
+ * @return 0 if the test passed
+ */
+static int testIdBounds(){
+    NodeList tableList = emptyNodeList();
+    const char *creates[] = {
+        "CREATE TABLE texts (id INTEGER PRIMARY KEY, name VARCHAR);",
+        "CREATE TABLE pages (id INTEGER PRIMARY KEY, name VARCHAR) STORAGE PAGE;"
+    };
+    const char *tables[] = {"texts", "pages"};
+    for (int i = 0; i < 2; ++i) {
+        char sql[256];
+        CHECK(testExec(creates[i], &tableList, NULL));
+        for (int row = 0; row < 10; ++row) {
+            snprintf(sql, sizeof(sql), "INSERT INTO %s (name) VALUES ('%c');", tables[i], 'a' + row);
+            CHECK(testExec(sql, &tableList, NULL));
+        }
+        // The ids of a new table start at 2
+        snprintf(sql, sizeof(sql), "SELECT * FROM %s WHERE id >= 5;", tables[i]);
+        CHECK(countRows(sql, &tableList) == 7);
+        snprintf(sql, sizeof(sql), "SELECT * FROM %s WHERE id <= 5;", tables[i]);
+        CHECK(countRows(sql, &tableList) == 4);
+        snprintf(sql, sizeof(sql), "SELECT * FROM %s WHERE id >= 4 AND id <= 6;", tables[i]);
+        CHECK(countRows(sql, &tableList) == 3);
+        snprintf(sql, sizeof(sql), "SELECT * FROM %s WHERE id >= 11 AND id <= 11;", tables[i]);
+        CHECK(countRows(sql, &tableList) == 1);
+        snprintf(sql, sizeof(sql), "SELECT * FROM %s WHERE id >= 12;", tables[i]);
+        CHECK(countRows(sql, &tableList) == 0);
+        snprintf(sql, sizeof(sql), "SELECT * FROM %s WHERE name != 'c';", tables[i]);
+        CHECK(countRows(sql, &tableList) == 9);
+    }
+    return 0;
+}
+
+int main(){
+    if(!testSetUp("filter")){
+        return 1;
+    }
+    int failed = testComparisonTokens();
+    failed += testIdBounds();
+    printf("filter_test: %s\n", failed == 0 ? "passed" : "failed");
+    return failed != 0;
+}
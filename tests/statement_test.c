@@ -0,0 +1,49 @@
+#include <stdio.h>
+#include <string.h>
+#include "test.h"
+#include "statement.h"
+
+/**
+ * Two statements prepared from the same text share a plan but keep their own bound values
+ * @return 0 if the test passed
+ */
+static int testSharedPlan(){
+    NodeList tableList = emptyNodeList();
+    CHECK(testExec("CREATE TABLE people (id INTEGER PRIMARY KEY, name VARCHAR);", &tableList, NULL));
+    CHECK(testExec("INSERT INTO people (name) VALUES ('ada'), ('linus');", &tableList, NULL));
+    PreparedStatement *first = statementPrepare("SELECT name FROM people WHERE name = ?;");
+    PreparedStatement *second = statementPrepare("SELECT  name FROM people WHERE name = ?");
+    CHECK(first != NULL && second != NULL);
+    CHECK(first != second);
+    CHECK(first->plan == second->plan);
+    CHECK(statementBindText(first, 0, "ada"));
+    CHECK(statementBindText(second, 0, "linus"));
+    const char *expected[] = {"ada", "linus", "ada"};
+    PreparedStatement *order[] = {first, second, first};
+    for (int i = 0; i < 3; ++i) {
+        DBOp dbOp = statementExecute(order[i], &tableList);
+        const char *value;
+        size_t len;
+        CHECK(dbOp.cursor != NULL && cursorNext(dbOp.cursor));
+        CHECK(cursorField(dbOp.cursor, 0, &value, &len));
+        CHECK(len == strlen(expected[i]) && memcmp(value, expected[i], len) == 0);
+        CHECK(!cursorNext(dbOp.cursor));
+        clearDBOp(&dbOp);
+    }
+    statementRelease(first);
+    // The plan stays usable by the statement still holding it
+    DBOp dbOp = statementExecute(second, &tableList);
+    CHECK(dbOp.cursor != NULL && cursorNext(dbOp.cursor));
+    clearDBOp(&dbOp);
+    statementRelease(second);
+    return 0;
+}
+
+int main(){
+    if(!testSetUp("statement")){
+        return 1;
+    }
+    int failed = testSharedPlan();
+    printf("statement_test: %s\n", failed == 0 ? "passed" : "failed");
+    return failed != 0;
+}
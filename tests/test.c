@@ -0,0 +1,53 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "test.h"
+#include "const.h"
+#include "filesystem.h"
+#include "bufferpool.h"
+#include "workerpool.h"
+
+/**
+ * Moves a test to an empty directory holding a new data directory
+ * @param name Test name, used in the name of the directory
+ * @return 1 if the database is ready, 0 otherwise
+ */
+int testSetUp(const char *name){
+    char dir[256];
+    snprintf(dir, sizeof(dir), "/tmp/minisql_%s_XXXXXX", name);
+    if(mkdtemp(dir) == NULL || chdir(dir) != 0 || !create_directory(DATA_DIR)){
+        fprintf(stderr, "Test directory for `%s` couldn't be created\n", name);
+        return 0;
+    }
+    bufferPoolInit(BUFFER_POOL_DEFAULT_SIZE);
+    workerPoolInit(0);
+    return 1;
+}
+
+/**
+ * Runs a statement the way the prompt does
+ * @param sql Statement
+ * @param tableList List of every table
+ * @param rows Rows of a select in the result format, NULL when they are not needed
+ * @return 1 if the statement succeeded, 0 otherwise
+ */
+int testExec(const char *sql, NodeList *tableList, StringBuilder *rows){
+    char *input = strdup(sql);
+    DBOp dbOp = execSQL(input, tableList);
+    int ok = dbOp.code == SUCCESS;
+    if(rows != NULL){
+        StringBuilder batch = createStringBuilder();
+        resetStringBuilder(rows);
+        while(dbOp.cursor != NULL && cursorFetch(dbOp.cursor, &batch, CURSOR_BATCH_ROWS, NULL) > 0){
+            appendRawToBuilder(rows, batch.data, batch.len);
+        }
+        clearStringBuilder(&batch);
+    }
+    if(!ok){
+        fprintf(stderr, "`%s` failed: %s\n", sql, dbOp.error.data != NULL ? dbOp.error.data : "");
+    }
+    clearDBOp(&dbOp);
+    free(input);
+    return ok;
+}
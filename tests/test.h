@@ -0,0 +1,19 @@
+#include <stdio.h>
+#include "database.h"
+#include "utils.h"
+
+#ifndef MINISQL_TEST_H
+#define MINISQL_TEST_H
+
+// Stops the test with the failed condition and its line
+#define CHECK(condition) do { \
+    if(!(condition)){ \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+        return 1; \
+    } \
+} while(0)
+
+int testSetUp(const char *name);
+int testExec(const char *sql, NodeList *tableList, StringBuilder *rows);
+
+#endif //MINISQL_TEST_H